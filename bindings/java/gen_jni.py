@@ -109,6 +109,7 @@ HEADERS = [
     'owr_message_origin.h',
     'owr_payload.h',
     'owr_remote_media_source.h',
+    'owr_send_encoding.h',
     'owr_session.h',
     'owr_transport_agent.h',
     'owr_types.h',
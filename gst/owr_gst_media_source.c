@@ -51,6 +51,7 @@ static void owr_gst_media_source_get_property(GObject *object, guint property_id
     GValue *value, GParamSpec *pspec);
 
 static GstElement *owr_gst_media_source_request_source(OwrMediaSource *media_source, GstCaps *caps);
+static OwrCodecType owr_gst_media_source_get_codec_type(OwrMediaSource *media_source);
 
 struct _OwrGstMediaSourcePrivate {
     GstElement *source;
@@ -86,6 +87,7 @@ static void owr_gst_media_source_class_init(OwrGstMediaSourceClass *klass)
     gobject_class->dispose = owr_gst_media_source_dispose;
 
     media_source_class->request_source = (void *(*)(OwrMediaSource *, void *))owr_gst_media_source_request_source;
+    media_source_class->get_codec_type = owr_gst_media_source_get_codec_type;
 
     g_object_class_install_properties(gobject_class, N_PROPERTIES, obj_properties);
 }
@@ -141,12 +143,62 @@ static void owr_gst_media_source_get_property(GObject *object, guint property_id
     }
 }
 
+static OwrCodecType get_source_codec_type(GstElement *source)
+{
+    static const struct {
+        const gchar *name;
+        OwrCodecType codec_type;
+    } encoded_formats[] = {
+        { "audio/x-mulaw", OWR_CODEC_TYPE_PCMU },
+        { "audio/x-alaw", OWR_CODEC_TYPE_PCMA },
+        { "audio/x-opus", OWR_CODEC_TYPE_OPUS },
+        { "video/x-h264", OWR_CODEC_TYPE_H264 },
+        { "video/x-vp8", OWR_CODEC_TYPE_VP8 },
+        { "video/x-vp9", OWR_CODEC_TYPE_VP9 }
+    };
+    OwrCodecType codec_type = OWR_CODEC_TYPE_NONE;
+    GstStructure *structure;
+    GstCaps *caps;
+    GstPad *srcpad;
+    guint i;
+
+    if (!GST_IS_ELEMENT(source))
+        return OWR_CODEC_TYPE_NONE;
+
+    srcpad = gst_element_get_static_pad(source, "src");
+    if (!srcpad)
+        return OWR_CODEC_TYPE_NONE;
+
+    caps = gst_pad_query_caps(srcpad, NULL);
+    gst_object_unref(srcpad);
+
+    /* Only sources that can produce nothing but one encoded format are sent
+     * without re-encoding */
+    if (caps && gst_caps_get_size(caps) == 1 && !gst_caps_is_any(caps)) {
+        structure = gst_caps_get_structure(caps, 0);
+        for (i = 0; i < G_N_ELEMENTS(encoded_formats); i++) {
+            if (gst_structure_has_name(structure, encoded_formats[i].name)) {
+                codec_type = encoded_formats[i].codec_type;
+                break;
+            }
+        }
+    }
+    if (caps)
+        gst_caps_unref(caps);
+
+    return codec_type;
+}
+
 /**
  * owr_gst_media_source_new: (constructor)
  * @media_type:
  * @source_type:
  * @source:
  *
+ * If the src pad of @source can only produce H.264, VP8, VP9, Opus, PCMU or
+ * PCMA the source is marked as encoded and its media is sent without being
+ * decoded and re-encoded when it matches the send payload.
+ *
  * Returns: The new #OwrGstMediaSource
  */
 OwrGstMediaSource *owr_gst_media_source_new(OwrMediaType media_type, OwrSourceType source_type, GstElement *source)
@@ -158,29 +210,39 @@ OwrGstMediaSource *owr_gst_media_source_new(OwrMediaType media_type, OwrSourceTy
         NULL);
 }
 
+static OwrCodecType owr_gst_media_source_get_codec_type(OwrMediaSource *media_source)
+{
+    return get_source_codec_type(OWR_GST_MEDIA_SOURCE(media_source)->priv->source);
+}
+
 static GstElement *owr_gst_media_source_request_source(OwrMediaSource *media_source, GstCaps *caps)
 {
     OwrGstMediaSourcePrivate *priv = OWR_GST_MEDIA_SOURCE(media_source)->priv;
     OwrMediaType media_type = OWR_MEDIA_TYPE_UNKNOWN;
+    OwrCodecType codec_type = OWR_CODEC_TYPE_NONE;
     GstStructure *structure;
 
     g_assert(priv->source);
     g_assert(caps);
 
-    g_object_get(media_source, "media-type", &media_type, NULL);
+    g_object_get(media_source, "media-type", &media_type, "codec-type", &codec_type, NULL);
     if (media_type == OWR_MEDIA_TYPE_UNKNOWN) {
         GST_ERROR_OBJECT(media_source,
                 "Cannot connect source with unknown media type to other component");
         return NULL;
     }
 
+    /* Encoded sources are passed through as they are, the consumer takes
+     * care of parsing or decoding */
     structure = gst_caps_get_structure(caps, 0);
     switch (media_type) {
     case OWR_MEDIA_TYPE_AUDIO:
-        g_return_val_if_fail(gst_structure_has_name(structure, "audio/x-raw"), NULL);
+        g_return_val_if_fail(codec_type != OWR_CODEC_TYPE_NONE
+            || gst_structure_has_name(structure, "audio/x-raw"), NULL);
         break;
     case OWR_MEDIA_TYPE_VIDEO:
-        g_return_val_if_fail(gst_structure_has_name(structure, "video/x-raw"), NULL);
+        g_return_val_if_fail(codec_type != OWR_CODEC_TYPE_NONE
+            || gst_structure_has_name(structure, "video/x-raw"), NULL);
         break;
     case OWR_MEDIA_TYPE_UNKNOWN:
     default:
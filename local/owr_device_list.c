@@ -35,6 +35,7 @@
 #endif
 
 #include "owr_device_list_private.h"
+#include "owr_device_registry_private.h"
 #include "owr_local_media_source_private.h"
 #include "owr_media_source.h"
 #include "owr_private.h"
@@ -145,46 +146,13 @@ static gboolean enumerate_audio_source_devices(GClosure *callback)
 
 #if (defined(__linux__) && !defined(__ANDROID__))
 
+/* The device registry is kept up to date by a device monitor, so the devices
+ * are not probed again on every call */
 static gboolean enumerate_source_devices(OwrMediaType type, GClosure *callback)
 {
-    OwrLocalMediaSource *source;
-    GList *sources = NULL;
-    GstDeviceMonitor *monitor;
-    GstCaps *caps;
-    GList *list, *l;
-    const gchar *klass;
-
-    if (type == OWR_MEDIA_TYPE_AUDIO)
-        klass = "Source/Audio";
-    else if (type == OWR_MEDIA_TYPE_VIDEO)
-        klass = "Source/Video";
-    else
-        g_assert_not_reached();
-
-    monitor = gst_device_monitor_new();
-    caps = gst_caps_new_any();
-
-    gst_device_monitor_add_filter(monitor, klass, caps);
-    gst_caps_unref(caps);
-
-    list = gst_device_monitor_get_devices(monitor);
-
-    for (l = list; l; l = l->next) {
-        GstDevice *device = GST_DEVICE(l->data);
-
-        gchar *name = gst_device_get_display_name(device);
-
-        source = _owr_local_media_source_new_cached(-1,
-                name, type,
-                OWR_SOURCE_TYPE_CAPTURE,
-                device,
-                OWR_MEDIA_SOURCE_SUPPORTS_NONE);
-        g_free(name);
-        sources = g_list_prepend(sources, source);
-    }
+    GList *sources;
 
-    g_list_free(list);
-    g_object_unref(monitor);
+    sources = _owr_device_registry_get_sources(owr_device_registry_get(), type);
 
     _owr_utils_call_closure_with_list(callback, sources);
     g_list_free_full(sources, g_object_unref);
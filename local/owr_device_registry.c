@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*/
+\*\ OwrDeviceRegistry
+/*/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "owr_device_registry.h"
+
+#include "owr_device_registry_private.h"
+#include "owr_local_media_source.h"
+#include "owr_local_media_source_private.h"
+#include "owr_private.h"
+#include "owr_utils.h"
+
+#include <gst/gst.h>
+
+GST_DEBUG_CATEGORY_EXTERN(_owrdevicelist_debug);
+#define GST_CAT_DEFAULT _owrdevicelist_debug
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#define USE_DEVICE_MONITOR 1
+#endif
+
+#define OWR_DEVICE_REGISTRY_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE((obj), \
+    OWR_TYPE_DEVICE_REGISTRY, OwrDeviceRegistryPrivate))
+
+G_DEFINE_TYPE(OwrDeviceRegistry, owr_device_registry, G_TYPE_OBJECT)
+
+static OwrDeviceRegistry *owr_device_registry_instance = NULL;
+
+G_LOCK_DEFINE_STATIC(owr_device_registry_mutex);
+
+enum {
+    SIGNAL_ON_DEVICES_CHANGED,
+    LAST_SIGNAL
+};
+
+static guint device_registry_signals[LAST_SIGNAL] = { 0 };
+
+typedef struct {
+    GstDevice *device;
+    OwrLocalMediaSource *source;
+    OwrMediaType media_type;
+} DeviceEntry;
+
+struct _OwrDeviceRegistryPrivate {
+#ifdef USE_DEVICE_MONITOR
+    GstDeviceMonitor *monitor;
+#endif
+    /* DeviceEntry, in the order the devices appeared */
+    GList *entries;
+    gboolean started;
+};
+
+static void device_entry_free(DeviceEntry *entry)
+{
+    gst_object_unref(entry->device);
+    g_object_unref(entry->source);
+    g_slice_free(DeviceEntry, entry);
+}
+
+static void owr_device_registry_finalize(GObject *object)
+{
+    OwrDeviceRegistry *registry = OWR_DEVICE_REGISTRY(object);
+    OwrDeviceRegistryPrivate *priv = registry->priv;
+
+    g_warn_if_reached();
+
+    G_LOCK(owr_device_registry_mutex);
+
+    if (registry == owr_device_registry_instance)
+        owr_device_registry_instance = NULL;
+
+    G_UNLOCK(owr_device_registry_mutex);
+
+#ifdef USE_DEVICE_MONITOR
+    if (priv->monitor) {
+        gst_device_monitor_stop(priv->monitor);
+        gst_object_unref(priv->monitor);
+    }
+#endif
+    g_list_free_full(priv->entries, (GDestroyNotify) device_entry_free);
+
+    G_OBJECT_CLASS(owr_device_registry_parent_class)->finalize(object);
+}
+
+static void owr_device_registry_class_init(OwrDeviceRegistryClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+    g_type_class_add_private(klass, sizeof(OwrDeviceRegistryPrivate));
+
+    /**
+    * OwrDeviceRegistry::on-devices-changed:
+    * @registry: the object which received the signal
+    * @media_type: the media type of the added or removed device
+    *
+    * Notify that a capture device has been plugged in or removed. A new call
+    * to owr_get_capture_sources() returns the updated list of sources.
+    * Devices are monitored from the first owr_device_registry_get() call, so
+    * the signal fires without owr_get_capture_sources() having been called.
+    */
+    device_registry_signals[SIGNAL_ON_DEVICES_CHANGED] = g_signal_new("on-devices-changed",
+        G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST,
+        G_STRUCT_OFFSET(OwrDeviceRegistryClass, on_devices_changed), NULL, NULL,
+        NULL, G_TYPE_NONE, 1, OWR_TYPE_MEDIA_TYPE);
+
+    gobject_class->finalize = owr_device_registry_finalize;
+}
+
+static void owr_device_registry_init(OwrDeviceRegistry *registry)
+{
+    OwrDeviceRegistryPrivate *priv = registry->priv =
+        OWR_DEVICE_REGISTRY_GET_PRIVATE(registry);
+
+#ifdef USE_DEVICE_MONITOR
+    priv->monitor = NULL;
+#endif
+    priv->entries = NULL;
+    priv->started = FALSE;
+}
+
+#ifdef USE_DEVICE_MONITOR
+
+/* Devices that are present when the monitor starts are both returned by
+ * gst_device_monitor_get_devices() and announced on the bus, the second one
+ * is ignored */
+static gboolean add_device(OwrDeviceRegistry *registry, GstDevice *device)
+{
+    DeviceEntry *entry;
+    GList *item;
+    gchar *name;
+
+    for (item = registry->priv->entries; item; item = item->next) {
+        entry = item->data;
+        if (entry->device == device)
+            return FALSE;
+    }
+
+    entry = g_slice_new0(DeviceEntry);
+    entry->device = gst_object_ref(device);
+    entry->media_type = gst_device_has_classes(device, "Source/Video") ?
+        OWR_MEDIA_TYPE_VIDEO : OWR_MEDIA_TYPE_AUDIO;
+
+    name = gst_device_get_display_name(device);
+    entry->source = _owr_local_media_source_new(-1, name, entry->media_type,
+        OWR_SOURCE_TYPE_CAPTURE, gst_object_ref(device), OWR_MEDIA_SOURCE_SUPPORTS_NONE);
+    GST_DEBUG("Device added: %s", name);
+    g_free(name);
+
+    registry->priv->entries = g_list_append(registry->priv->entries, entry);
+
+    return TRUE;
+}
+
+static OwrMediaType remove_device(OwrDeviceRegistry *registry, GstDevice *device)
+{
+    OwrMediaType media_type = OWR_MEDIA_TYPE_UNKNOWN;
+    GList *item, *next;
+
+    for (item = registry->priv->entries; item; item = next) {
+        DeviceEntry *entry = item->data;
+
+        next = item->next;
+        if (entry->device != device)
+            continue;
+
+        GST_DEBUG("Device removed: %s", GST_OBJECT_NAME(device));
+        media_type = entry->media_type;
+        _owr_local_media_source_forget_device_caps(entry->source);
+        registry->priv->entries = g_list_delete_link(registry->priv->entries, item);
+        device_entry_free(entry);
+    }
+
+    return media_type;
+}
+
+static gboolean on_monitor_message(GstBus *bus, GstMessage *message, OwrDeviceRegistry *registry)
+{
+    OwrMediaType media_type = OWR_MEDIA_TYPE_UNKNOWN;
+    GstDevice *device = NULL;
+
+    OWR_UNUSED(bus);
+
+    switch (GST_MESSAGE_TYPE(message)) {
+    case GST_MESSAGE_DEVICE_ADDED:
+        gst_message_parse_device_added(message, &device);
+        if (add_device(registry, device)) {
+            media_type = gst_device_has_classes(device, "Source/Video") ?
+                OWR_MEDIA_TYPE_VIDEO : OWR_MEDIA_TYPE_AUDIO;
+        }
+        break;
+    case GST_MESSAGE_DEVICE_REMOVED:
+        gst_message_parse_device_removed(message, &device);
+        media_type = remove_device(registry, device);
+        break;
+    default:
+        break;
+    }
+
+    if (device)
+        gst_object_unref(device);
+
+    if (media_type != OWR_MEDIA_TYPE_UNKNOWN)
+        g_signal_emit(registry, device_registry_signals[SIGNAL_ON_DEVICES_CHANGED], 0, media_type);
+
+    return G_SOURCE_CONTINUE;
+}
+
+/* Builds the registry from the devices present now and keeps it up to date
+ * from the monitor's add and remove messages */
+static void start_monitor(OwrDeviceRegistry *registry)
+{
+    OwrDeviceRegistryPrivate *priv = registry->priv;
+    GList *devices, *item;
+    GSource *bus_source;
+    GstBus *bus;
+    GstCaps *caps;
+
+    priv->monitor = gst_device_monitor_new();
+    caps = gst_caps_new_any();
+    gst_device_monitor_add_filter(priv->monitor, "Source/Audio", caps);
+    gst_device_monitor_add_filter(priv->monitor, "Source/Video", caps);
+    gst_caps_unref(caps);
+
+    bus = gst_device_monitor_get_bus(priv->monitor);
+    bus_source = gst_bus_create_watch(bus);
+    g_source_set_callback(bus_source, (GSourceFunc) on_monitor_message, registry, NULL);
+    g_source_attach(bus_source, _owr_get_main_context());
+    g_source_unref(bus_source);
+    gst_object_unref(bus);
+
+    if (!gst_device_monitor_start(priv->monitor))
+        GST_WARNING("Failed to start the device monitor, devices will not be updated");
+
+    devices = gst_device_monitor_get_devices(priv->monitor);
+    for (item = devices; item; item = item->next)
+        add_device(registry, GST_DEVICE(item->data));
+    g_list_free_full(devices, gst_object_unref);
+}
+
+#endif /* USE_DEVICE_MONITOR */
+
+/* call from the main context */
+static void ensure_started(OwrDeviceRegistry *registry)
+{
+    OwrDeviceRegistryPrivate *priv = registry->priv;
+
+    if (priv->started)
+        return;
+
+#ifdef USE_DEVICE_MONITOR
+    start_monitor(registry);
+#endif
+    priv->started = TRUE;
+}
+
+static gboolean start_registry(OwrDeviceRegistry *registry)
+{
+    ensure_started(registry);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * owr_device_registry_get:
+ *
+ * Returns: (transfer none):
+ */
+OwrDeviceRegistry *owr_device_registry_get(void)
+{
+    G_LOCK(owr_device_registry_mutex);
+
+    if (!owr_device_registry_instance) {
+        owr_device_registry_instance = g_object_new(OWR_TYPE_DEVICE_REGISTRY, NULL);
+        /* Start monitoring right away so that handlers connected to
+         * on-devices-changed are called */
+        _owr_schedule_with_user_data((GSourceFunc) start_registry, owr_device_registry_instance);
+    }
+
+    G_UNLOCK(owr_device_registry_mutex);
+
+    return owr_device_registry_instance;
+}
+
+/* call from the main context */
+/**
+ * _owr_device_registry_get_sources:
+ * @registry:
+ * @media_type:
+ *
+ * Returns: (transfer full) (element-type OwrLocalMediaSource):
+ */
+GList *_owr_device_registry_get_sources(OwrDeviceRegistry *registry, OwrMediaType media_type)
+{
+    OwrDeviceRegistryPrivate *priv;
+    GList *sources = NULL, *item;
+
+    g_return_val_if_fail(OWR_IS_DEVICE_REGISTRY(registry), NULL);
+    priv = registry->priv;
+
+    ensure_started(registry);
+
+    for (item = priv->entries; item; item = item->next) {
+        DeviceEntry *entry = item->data;
+
+        if (entry->media_type & media_type)
+            sources = g_list_prepend(sources, g_object_ref(entry->source));
+    }
+
+    return g_list_reverse(sources);
+}
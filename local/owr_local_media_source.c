@@ -112,9 +112,18 @@ struct _OwrLocalMediaSourcePrivate {
     gboolean mute;
     /* Device from device monitor */
     GstDevice *device;
+    /* Identifies the device across sources, see make_device_id() */
+    gchar *device_id;
+
+    /* Capture caps selection for video sources, see update_capture_caps() */
+    GstElement *source_capsfilter;
+    GstCaps *device_caps;
+    /* Requested source bin => GstCaps requested by that consumer */
+    GHashTable *consumer_caps;
 };
 
 static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_source, GstCaps *caps);
+static void owr_local_media_source_release_source(OwrMediaSource *media_source, GstElement *source);
 
 static void owr_local_media_source_set_property(GObject *object, guint property_id,
     const GValue *value, GParamSpec *pspec);
@@ -140,6 +149,13 @@ static void owr_local_media_source_finalize(GObject *object)
 
     if (source->priv->device != NULL)
         gst_object_unref(source->priv->device);
+    g_free(source->priv->device_id);
+
+    if (source->priv->source_capsfilter)
+        gst_object_unref(source->priv->source_capsfilter);
+    if (source->priv->device_caps)
+        gst_caps_unref(source->priv->device_caps);
+    g_hash_table_destroy(source->priv->consumer_caps);
 }
 
 static void owr_local_media_source_class_init(OwrLocalMediaSourceClass *klass)
@@ -155,6 +171,7 @@ static void owr_local_media_source_class_init(OwrLocalMediaSourceClass *klass)
     g_type_class_add_private(klass, sizeof(OwrLocalMediaSourcePrivate));
 
     media_source_class->request_source = (void *(*)(OwrMediaSource *, void *))owr_local_media_source_request_source;
+    media_source_class->release_source = (void (*)(OwrMediaSource *, void *))owr_local_media_source_release_source;
 
     g_object_class_install_property(gobject_class, PROP_DEVICE_INDEX,
         g_param_spec_int("device-index", "Device index",
@@ -194,6 +211,10 @@ static void owr_local_media_source_init(OwrLocalMediaSource *source)
     priv->source_volume = NULL;
     priv->volume = 0.8;
     priv->mute = FALSE;
+    priv->source_capsfilter = NULL;
+    priv->device_caps = NULL;
+    priv->device_id = NULL;
+    priv->consumer_caps = g_hash_table_new_full(NULL, NULL, NULL, (GDestroyNotify) gst_caps_unref);
 }
 
 static void owr_local_media_source_set_property(GObject *object, guint property_id,
@@ -468,6 +489,15 @@ static gboolean shutdown_media_source(GHashTable *args)
     _owr_media_source_set_source_bin(media_source, NULL);
     _owr_media_source_set_source_tee(media_source, NULL);
 
+    if (local_media_source->priv->source_capsfilter) {
+        gst_object_unref(local_media_source->priv->source_capsfilter);
+        local_media_source->priv->source_capsfilter = NULL;
+    }
+    if (local_media_source->priv->device_caps) {
+        gst_caps_unref(local_media_source->priv->device_caps);
+        local_media_source->priv->device_caps = NULL;
+    }
+
     gst_element_set_state(source_pipeline, GST_STATE_NULL);
     gst_object_unref(source_pipeline);
     gst_object_unref(source_tee);
@@ -558,6 +588,205 @@ done:
     return TRUE;
 }
 
+/* Caps supported by each capture device, so that the device does not have to
+ * be opened for probing every time a source pipeline is built */
+G_LOCK_DEFINE_STATIC(device_caps_cache);
+static GHashTable *device_caps_cache = NULL;
+
+static gchar *device_caps_cache_key(OwrLocalMediaSource *local_source)
+{
+    OwrMediaType media_type = OWR_MEDIA_TYPE_UNKNOWN;
+    OwrSourceType source_type = OWR_SOURCE_TYPE_UNKNOWN;
+
+    g_object_get(local_source, "media-type", &media_type, "type", &source_type, NULL);
+
+    return g_strdup_printf("%d-%d-%s", media_type, source_type, local_source->priv->device_id);
+}
+
+static void invalidate_device_caps(OwrLocalMediaSource *local_source)
+{
+    gchar *key = device_caps_cache_key(local_source);
+
+    G_LOCK(device_caps_cache);
+    if (device_caps_cache)
+        g_hash_table_remove(device_caps_cache, key);
+    G_UNLOCK(device_caps_cache);
+
+    g_free(key);
+}
+
+/* Returns the caps @source can produce, from the cache, the device monitor
+ * or, as a last resort, by probing the element in READY */
+static GstCaps *get_device_caps(OwrLocalMediaSource *local_source, GstElement *source, GstPad *srcpad)
+{
+    GstCaps *caps = NULL;
+    gchar *key;
+
+    key = device_caps_cache_key(local_source);
+
+    G_LOCK(device_caps_cache);
+    if (G_UNLIKELY(!device_caps_cache))
+        device_caps_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+            (GDestroyNotify) gst_caps_unref);
+    caps = g_hash_table_lookup(device_caps_cache, key);
+    if (caps)
+        gst_caps_ref(caps);
+    G_UNLOCK(device_caps_cache);
+
+    if (caps) {
+        GST_DEBUG_OBJECT(local_source, "Using cached device caps");
+        g_free(key);
+        return caps;
+    }
+
+    if (local_source->priv->device)
+        caps = gst_device_get_caps(local_source->priv->device);
+    if (!caps || gst_caps_is_empty(caps) || gst_caps_is_any(caps)) {
+        if (caps)
+            gst_caps_unref(caps);
+        gst_element_set_state(source, GST_STATE_READY);
+        caps = gst_pad_query_caps(srcpad, NULL);
+    }
+
+    /* Don't remember failed probes */
+    if (gst_caps_is_empty(caps) || gst_caps_is_any(caps)) {
+        g_free(key);
+        return caps;
+    }
+
+    G_LOCK(device_caps_cache);
+    g_hash_table_insert(device_caps_cache, key, gst_caps_ref(caps));
+    G_UNLOCK(device_caps_cache);
+
+    return caps;
+}
+
+/* Picks the smallest raw format offered by the device that covers the
+ * largest resolution and framerate requested by any consumer, or the largest
+ * format if none covers them. Returns NULL if no choice can be made. */
+static GstCaps *select_capture_caps(GstCaps *device_caps, GList *consumers)
+{
+    GstStructure *best = NULL;
+    gboolean best_covers = FALSE;
+    gint width = 0, height = 0, fps_n = 0, fps_d = 1;
+    gint best_area = 0, best_fps_n = 0, best_fps_d = 1;
+    GstCaps *caps;
+    GList *item;
+    guint i;
+
+    if (!device_caps || gst_caps_is_any(device_caps))
+        return NULL;
+
+    for (item = consumers; item; item = item->next) {
+        GstStructure *s;
+        gint value, n, d;
+
+        if (gst_caps_is_empty(item->data) || gst_caps_is_any(item->data))
+            continue;
+        s = gst_caps_get_structure(item->data, 0);
+        if (!gst_structure_has_name(s, "video/x-raw"))
+            continue;
+
+        if (gst_structure_get_int(s, "width", &value))
+            width = MAX(width, value);
+        if (gst_structure_get_int(s, "height", &value))
+            height = MAX(height, value);
+        if (gst_structure_get_fraction(s, "framerate", &n, &d) && d
+            && gst_util_fraction_compare(n, d, fps_n, fps_d) > 0) {
+            fps_n = n;
+            fps_d = d;
+        }
+    }
+
+    if (!width || !height)
+        return NULL;
+
+    for (i = 0; i < gst_caps_get_size(device_caps); i++) {
+        GstStructure *candidate;
+        gint w = 0, h = 0, n = 0, d = 1, area;
+        gboolean covers;
+
+        if (!gst_structure_has_name(gst_caps_get_structure(device_caps, i), "video/x-raw"))
+            continue;
+
+        candidate = gst_structure_copy(gst_caps_get_structure(device_caps, i));
+        gst_structure_fixate_field_nearest_int(candidate, "width", width);
+        gst_structure_fixate_field_nearest_int(candidate, "height", height);
+        if (fps_n)
+            gst_structure_fixate_field_nearest_fraction(candidate, "framerate", fps_n, fps_d);
+        gst_structure_fixate(candidate);
+
+        gst_structure_get_int(candidate, "width", &w);
+        gst_structure_get_int(candidate, "height", &h);
+        if (!gst_structure_get_fraction(candidate, "framerate", &n, &d) || !d) {
+            n = fps_n;
+            d = fps_d;
+        }
+        area = w * h;
+        covers = w >= width && h >= height && gst_util_fraction_compare(n, d, fps_n, fps_d) >= 0;
+
+        if (!best || (covers && !best_covers)
+            || (covers && (area < best_area || (area == best_area
+                && gst_util_fraction_compare(n, d, best_fps_n, best_fps_d) < 0)))
+            || (!covers && !best_covers && area > best_area)) {
+            if (best)
+                gst_structure_free(best);
+            best = candidate;
+            best_covers = covers;
+            best_area = area;
+            best_fps_n = n;
+            best_fps_d = d;
+        } else
+            gst_structure_free(candidate);
+    }
+
+    if (!best)
+        return NULL;
+
+    caps = gst_caps_new_empty();
+    gst_caps_append_structure(caps, best);
+    gst_caps_set_features(caps, 0, gst_caps_features_new_any());
+
+#if defined(__APPLE__) && TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR
+    /* See owr_local_media_source_request_source() */
+    gst_caps_set_simple(caps, "format", G_TYPE_STRING, "NV12", NULL);
+#endif
+
+    return caps;
+}
+
+/* Call with the media_source lock. Renegotiates the capture format whenever
+ * the set of consumers changes, @new_consumer_caps being the caps of a
+ * consumer about to be added. */
+static void update_capture_caps(OwrLocalMediaSource *local_source, GstCaps *new_consumer_caps)
+{
+    OwrLocalMediaSourcePrivate *priv = local_source->priv;
+    GstCaps *capture_caps, *current_caps = NULL;
+    GList *consumers;
+
+    if (!priv->source_capsfilter)
+        return;
+
+    consumers = g_hash_table_get_values(priv->consumer_caps);
+    if (new_consumer_caps)
+        consumers = g_list_prepend(consumers, new_consumer_caps);
+    capture_caps = select_capture_caps(priv->device_caps, consumers);
+    g_list_free(consumers);
+
+    if (!capture_caps)
+        return;
+
+    g_object_get(priv->source_capsfilter, "caps", &current_caps, NULL);
+    if (!current_caps || !gst_caps_is_equal(current_caps, capture_caps)) {
+        GST_INFO_OBJECT(local_source, "Reconfiguring capture to %" GST_PTR_FORMAT, capture_caps);
+        g_object_set(priv->source_capsfilter, "caps", capture_caps, NULL);
+    }
+
+    if (current_caps)
+        gst_caps_unref(current_caps);
+    gst_caps_unref(capture_caps);
+}
+
 static void on_caps(GstElement *source, GParamSpec *pspec, OwrMediaSource *media_source)
 {
     gchar *media_source_name;
@@ -636,6 +865,7 @@ static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_s
     OwrLocalMediaSourcePrivate *priv;
     GstElement *source_element = NULL;
     GstElement *source_pipeline;
+    GstCaps *consumer_caps;
     GHashTable *event_data;
     GValue *value;
 
@@ -756,7 +986,8 @@ static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_s
         case OWR_MEDIA_TYPE_VIDEO:
         {
             GstPad *srcpad;
-            GstCaps *device_caps;
+            GstCaps *device_caps, *supported_caps;
+            GList *consumers;
 
             switch (source_type) {
             case OWR_SOURCE_TYPE_CAPTURE:
@@ -825,7 +1056,20 @@ static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_s
                 goto done;
             }
 
-            /* First try to see if we can just get the format we want directly */
+            /* Pick the capture format from what the device can really
+             * produce, so that it can follow the consumers later */
+            srcpad = gst_element_get_static_pad(source, "src");
+            supported_caps = get_device_caps(local_source, source, srcpad);
+            consumers = g_list_prepend(NULL, caps);
+            source_caps = select_capture_caps(supported_caps, consumers);
+            g_list_free(consumers);
+
+            if (source_caps) {
+                priv->device_caps = supported_caps;
+                goto have_source_caps;
+            }
+
+            /* Otherwise try to see if we can just get the format we want directly */
 
             source_caps = gst_caps_new_empty();
 #if GST_CHECK_VERSION(1, 5, 0)
@@ -833,10 +1077,7 @@ static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_s
 #else
             _owr_gst_caps_foreach(caps, fix_video_caps_framerate, source_caps);
 #endif
-            /* Now see what the device can really produce */
-            srcpad = gst_element_get_static_pad(source, "src");
-            gst_element_set_state(source, GST_STATE_READY);
-            device_caps = gst_pad_query_caps(srcpad, source_caps);
+            device_caps = gst_caps_intersect_full(source_caps, supported_caps, GST_CAPS_INTERSECT_FIRST);
 
             if (gst_caps_is_empty(device_caps)) {
                 /* Let's see if it works when we drop format constraints (which can be dealt with downsteram) */
@@ -850,7 +1091,7 @@ static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_s
                 gst_caps_unref(tmp);
 
                 gst_caps_unref(device_caps);
-                device_caps = gst_pad_query_caps(srcpad, source_caps);
+                device_caps = gst_caps_intersect_full(source_caps, supported_caps, GST_CAPS_INTERSECT_FIRST);
 
                 if (gst_caps_is_empty(device_caps)) {
                     /* Accepting any format didn't work, we're going to hope that scaling fixes it */
@@ -860,7 +1101,7 @@ static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_s
             }
 
             gst_caps_unref(device_caps);
-            gst_object_unref(srcpad);
+            gst_caps_unref(supported_caps);
 
 #if defined(__APPLE__) && TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR
             /* Force NV12 on iOS else the source can negotiate BGRA
@@ -869,10 +1110,15 @@ static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_s
             gst_caps_set_simple(source_caps, "format", G_TYPE_STRING, "NV12", NULL);
 #endif
 
+have_source_caps:
+            gst_object_unref(srcpad);
+
             CREATE_ELEMENT(capsfilter, "capsfilter", "video-source-capsfilter");
             g_object_set(capsfilter, "caps", source_caps, NULL);
             gst_caps_unref(source_caps);
             gst_bin_add(GST_BIN(source_pipeline), capsfilter);
+            if (priv->device_caps)
+                priv->source_capsfilter = gst_object_ref(capsfilter);
 
             break;
         }
@@ -892,11 +1138,10 @@ static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_s
 
         gst_bin_add_many(GST_BIN(source_pipeline), source, tee, NULL);
 
-        /* Many sources don't like reconfiguration and it's pointless
-         * here anyway right now. No need to reconfigure whenever something
-         * is added to the tee or removed.
-         * We will have to implement reconfiguration differently later by
-         * selecting the best caps based on all consumers.
+        /* Many sources don't like reconfiguration, so don't reconfigure
+         * whenever something is added to the tee or removed. The capture
+         * caps are instead selected based on all consumers, see
+         * update_capture_caps().
          */
         sinkpad = gst_element_get_static_pad(tee, "sink");
         gst_pad_add_probe(sinkpad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM, drop_reconfigure_event, NULL, NULL);
@@ -940,13 +1185,71 @@ static GstElement *owr_local_media_source_request_source(OwrMediaSource *media_s
     }
     gst_object_unref(source_pipeline);
 
+    /* Scale the capture up before the new consumer is attached */
+    update_capture_caps(local_source, caps);
+    consumer_caps = gst_caps_copy(caps);
+
     source_element = OWR_MEDIA_SOURCE_CLASS(owr_local_media_source_parent_class)->request_source(media_source, caps);
+    if (source_element)
+        g_hash_table_insert(priv->consumer_caps, source_element, consumer_caps);
+    else
+        gst_caps_unref(consumer_caps);
 
 done:
     return source_element;
 }
 
-static OwrLocalMediaSource *_owr_local_media_source_new(gint device_index, const gchar *name,
+static void owr_local_media_source_release_source(OwrMediaSource *media_source, GstElement *source)
+{
+    OwrLocalMediaSource *local_source = OWR_LOCAL_MEDIA_SOURCE(media_source);
+
+    OWR_MEDIA_SOURCE_CLASS(owr_local_media_source_parent_class)->release_source(media_source, source);
+
+    /* Scale the capture down to what the remaining consumers need */
+    if (g_hash_table_remove(local_source->priv->consumer_caps, source)
+        && g_hash_table_size(local_source->priv->consumer_caps))
+        update_capture_caps(local_source, NULL);
+}
+
+/* Display names are not unique, two identical cameras usually have the same
+ * one, and monitored devices have no index. Use the device node or the
+ * platform's device string when the device exposes one, otherwise the
+ * device object itself, which lives as long as the device is plugged in.
+ * Enumerated devices without a GstDevice are identified by their index. */
+static gchar *make_device_id(gint device_index, const gchar *name, GstDevice *device)
+{
+#if GST_CHECK_VERSION(1, 6, 0)
+    static const gchar *path_properties[] = {
+        "device.path", "api.v4l2.path", "object.path", "device.string"
+    };
+    GstStructure *properties;
+    const gchar *path;
+    gchar *device_id;
+    guint i;
+#endif
+
+    if (!device)
+        return g_strdup_printf("%d-%s", device_index, name);
+
+#if GST_CHECK_VERSION(1, 6, 0)
+    properties = gst_device_get_properties(device);
+    if (properties) {
+        for (i = 0; i < G_N_ELEMENTS(path_properties); i++) {
+            path = gst_structure_get_string(properties, path_properties[i]);
+            if (path) {
+                device_id = g_strdup(path);
+                gst_structure_free(properties);
+                return device_id;
+            }
+        }
+        gst_structure_free(properties);
+    }
+#endif
+
+    return g_strdup_printf("%s-%p", GST_OBJECT_NAME(device), (gpointer) device);
+}
+
+OwrLocalMediaSource *_owr_local_media_source_new(gint device_index, const gchar *name,
     OwrMediaType media_type, OwrSourceType source_type, GstDevice *device,
     OwrMediaSourceSupportedInterfaces interfaces)
 {
@@ -958,6 +1261,7 @@ static OwrLocalMediaSource *_owr_local_media_source_new(gint device_index, const
         "device-index", device_index,
         NULL);
     source->priv->device = device;
+    source->priv->device_id = make_device_id(device_index, name, device);
 
     _owr_media_source_set_type(OWR_MEDIA_SOURCE(source), source_type);
     _owr_media_source_set_supported_interfaces(OWR_MEDIA_SOURCE(source), interfaces);
@@ -965,6 +1269,13 @@ static OwrLocalMediaSource *_owr_local_media_source_new(gint device_index, const
     return source;
 }
 
+void _owr_local_media_source_forget_device_caps(OwrLocalMediaSource *source)
+{
+    g_return_if_fail(OWR_IS_LOCAL_MEDIA_SOURCE(source));
+
+    invalidate_device_caps(source);
+}
+
 OwrLocalMediaSource *_owr_local_media_source_new_cached(gint device_index, const gchar *name,
     OwrMediaType media_type, OwrSourceType source_type, GstDevice *device,
     OwrMediaSourceSupportedInterfaces interfaces)
@@ -1000,6 +1311,7 @@ OwrLocalMediaSource *_owr_local_media_source_new_cached(gint device_index, const
 
             if (!g_str_equal(name, cached_name)) {
                 /* Device at this index seems to have changed, throw the old one away */
+                invalidate_device_caps(ret);
                 g_object_unref(ret);
                 ret = NULL;
             }
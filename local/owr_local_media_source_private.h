@@ -44,9 +44,13 @@
 
 G_BEGIN_DECLS
 
+OwrLocalMediaSource *_owr_local_media_source_new(gint device_index,
+    const gchar *name, OwrMediaType media_type, OwrSourceType source_type, GstDevice *device,
+    OwrMediaSourceSupportedInterfaces interfaces);
 OwrLocalMediaSource *_owr_local_media_source_new_cached(gint device_index,
     const gchar *name, OwrMediaType media_type, OwrSourceType source_type, GstDevice *device,
     OwrMediaSourceSupportedInterfaces interfaces);
+void _owr_local_media_source_forget_device_caps(OwrLocalMediaSource *source);
 void _owr_local_media_source_set_capture_device_index(OwrLocalMediaSource *source, guint index);
 
 G_END_DECLS
@@ -461,6 +461,8 @@ void _owr_media_renderer_set_sink(OwrMediaRenderer *renderer, gpointer sink_ptr)
     g_mutex_lock(&priv->media_renderer_lock);
 
     if (priv->sink) {
+        if (GST_IS_BIN(priv->sink))
+            _owr_codec_pool_release_from_bin(GST_BIN(priv->sink));
         gst_element_set_state(priv->pipeline, GST_STATE_NULL);
         gst_bin_remove(GST_BIN(priv->pipeline), priv->sink);
         priv->sink = NULL;
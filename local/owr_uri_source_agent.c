@@ -48,6 +48,8 @@
 
 #define DEFAULT_URI NULL
 
+#define URIDECODEBIN_CAPS "audio/x-raw; video/x-raw; video/x-h264; video/x-vp8; video/x-vp9"
+
 enum {
     PROP_0,
     PROP_URI,
@@ -199,6 +201,7 @@ static void owr_uri_source_agent_init(OwrURISourceAgent *uri_source_agent)
     OwrURISourceAgentPrivate *priv;
     GstBus *bus;
     GSource *bus_source;
+    GstCaps *caps;
     gchar *pipeline_name, *uridecodebin_name;
 
     uri_source_agent->priv = priv = OWR_URI_SOURCE_AGENT_GET_PRIVATE(uri_source_agent);
@@ -229,6 +232,11 @@ static void owr_uri_source_agent_init(OwrURISourceAgent *uri_source_agent)
     g_free(uridecodebin_name);
     g_signal_connect(priv->uridecodebin, "pad-added", G_CALLBACK(on_uridecodebin_pad_added), uri_source_agent);
 
+    /* Stop decoding at encoded video that can be sent as it is */
+    caps = gst_caps_from_string(URIDECODEBIN_CAPS);
+    g_object_set(priv->uridecodebin, "caps", caps, NULL);
+    gst_caps_unref(caps);
+
     gst_bin_add(GST_BIN(priv->pipeline), priv->uridecodebin);
 }
 
@@ -329,8 +337,9 @@ static void on_uridecodebin_pad_added(GstElement *uridecodebin, GstPad *new_pad,
 {
     gchar *new_pad_name;
     OwrMediaType media_type = OWR_MEDIA_TYPE_UNKNOWN;
+    OwrCodecType codec_type = OWR_CODEC_TYPE_NONE;
     guint stream_id = 0;
-    GstCaps *caps, *audio_raw_caps, *video_raw_caps;
+    GstCaps *caps, *audio_raw_caps, *video_raw_caps, *video_encoded_caps;
 
     g_return_if_fail(GST_IS_BIN(uridecodebin));
     g_return_if_fail(GST_IS_PAD(new_pad));
@@ -343,14 +352,20 @@ static void on_uridecodebin_pad_added(GstElement *uridecodebin, GstPad *new_pad,
 
     audio_raw_caps = gst_caps_from_string("audio/x-raw");
     video_raw_caps = gst_caps_from_string("video/x-raw");
+    video_encoded_caps = gst_caps_from_string("video/x-h264; video/x-vp8; video/x-vp9");
 
     if (gst_caps_can_intersect(caps, audio_raw_caps))
         media_type = OWR_MEDIA_TYPE_AUDIO;
     else if (gst_caps_can_intersect(caps, video_raw_caps))
         media_type = OWR_MEDIA_TYPE_VIDEO;
+    else if (gst_caps_can_intersect(caps, video_encoded_caps)) {
+        media_type = OWR_MEDIA_TYPE_VIDEO;
+        codec_type = _owr_caps_to_codec_type(caps);
+    }
 
     gst_caps_unref(audio_raw_caps);
     gst_caps_unref(video_raw_caps);
+    gst_caps_unref(video_encoded_caps);
 
     if (media_type != OWR_MEDIA_TYPE_UNKNOWN) {
         if (uri_source_agent->priv->offset == GST_CLOCK_TIME_NONE) {
@@ -368,7 +383,7 @@ static void on_uridecodebin_pad_added(GstElement *uridecodebin, GstPad *new_pad,
 
         gst_pad_set_offset(new_pad, uri_source_agent->priv->offset);
 
-        signal_new_source(media_type, uri_source_agent, stream_id, OWR_CODEC_TYPE_NONE);
+        signal_new_source(media_type, uri_source_agent, stream_id, codec_type);
     }
 
     g_free(new_pad_name);
@@ -41,6 +41,8 @@
 #endif
 
 #include "owr.h"
+#include "owr_message_origin.h"
+#include "owr_message_origin_private.h"
 #include "owr_private.h"
 #include "owr_utils.h"
 
@@ -65,6 +67,29 @@ static GMainLoop *owr_main_loop = NULL;
 G_LOCK_DEFINE_STATIC(base_time);
 static GstClockTime owr_base_time = GST_CLOCK_TIME_NONE;
 
+enum {
+    INIT_PHASE_SYMBOL_CHECK,
+    INIT_PHASE_GST_INIT,
+    INIT_PHASE_DEBUG_CATEGORIES,
+    INIT_PHASE_PLUGIN_REGISTRATION,
+    INIT_PHASE_MAIN_CONTEXT,
+    INIT_PHASE_CODEC_DETECTION,
+    N_INIT_PHASES
+};
+
+static const gchar *init_phase_names[N_INIT_PHASES] = {
+    "symbol_check_duration",
+    "gst_init_duration",
+    "debug_categories_duration",
+    "plugin_registration_duration",
+    "main_context_duration",
+    "codec_detection_duration"
+};
+
+static gint64 init_phase_durations[N_INIT_PHASES];
+static gint64 init_start_time = 0;
+static gint64 init_end_time = 0;
+
 GST_DEBUG_CATEGORY(_owraudiopayload_debug);
 GST_DEBUG_CATEGORY(_owraudiorenderer_debug);
 GST_DEBUG_CATEGORY(_owrbridge_debug);
@@ -83,7 +108,9 @@ GST_DEBUG_CATEGORY(_owrmediasession_debug);
 GST_DEBUG_CATEGORY(_owrmediasource_debug);
 GST_DEBUG_CATEGORY(_owrpayload_debug);
 GST_DEBUG_CATEGORY(_owrremotemediasource_debug);
+GST_DEBUG_CATEGORY(_owrrtpforward_debug);
 GST_DEBUG_CATEGORY(_owrsession_debug);
+GST_DEBUG_CATEGORY(_owrsharedencoder_debug);
 GST_DEBUG_CATEGORY(_owrtransportagent_debug);
 GST_DEBUG_CATEGORY(_owrvideopayload_debug);
 GST_DEBUG_CATEGORY(_owrvideorenderer_debug);
@@ -190,6 +217,147 @@ static void gst_log_android_handler(GstDebugCategory *category,
 #endif
 
 
+/* OwrLibraryOrigin is the message origin for messages that are not tied to
+ * any other object, such as the initialization stats. */
+
+#define OWR_TYPE_LIBRARY_ORIGIN (owr_library_origin_get_type())
+
+typedef struct {
+    GObject parent_instance;
+
+    OwrMessageOriginBusSet *bus_set;
+} OwrLibraryOrigin;
+
+typedef struct {
+    GObjectClass parent_class;
+} OwrLibraryOriginClass;
+
+static GType owr_library_origin_get_type(void) G_GNUC_CONST;
+static void owr_library_origin_interface_init(OwrMessageOriginInterface *interface);
+
+G_DEFINE_TYPE_WITH_CODE(OwrLibraryOrigin, owr_library_origin, G_TYPE_OBJECT,
+    G_IMPLEMENT_INTERFACE(OWR_TYPE_MESSAGE_ORIGIN, owr_library_origin_interface_init))
+
+static void owr_library_origin_class_init(OwrLibraryOriginClass *klass)
+{
+    OWR_UNUSED(klass);
+}
+
+static void owr_library_origin_init(OwrLibraryOrigin *origin)
+{
+    origin->bus_set = owr_message_origin_bus_set_new();
+}
+
+static gpointer owr_library_origin_get_bus_set(OwrMessageOrigin *origin)
+{
+    return ((OwrLibraryOrigin *) origin)->bus_set;
+}
+
+static void owr_library_origin_interface_init(OwrMessageOriginInterface *interface)
+{
+    interface->get_bus_set = owr_library_origin_get_bus_set;
+}
+
+static gpointer create_library_origin(gpointer data)
+{
+    OWR_UNUSED(data);
+    return g_object_new(OWR_TYPE_LIBRARY_ORIGIN, NULL);
+}
+
+/**
+ * owr_get_message_origin:
+ *
+ * Gets the message origin for library wide messages, such as the
+ * #OWR_STATS_TYPE_INIT message that is posted once the main loop
+ * has started after owr_init().
+ *
+ * Returns: (transfer none): the library wide #OwrMessageOrigin
+ */
+OwrMessageOrigin *owr_get_message_origin(void)
+{
+    static GOnce origin_once = G_ONCE_INIT;
+
+    g_once(&origin_once, create_library_origin, NULL);
+
+    return OWR_MESSAGE_ORIGIN(origin_once.retval);
+}
+
+static gint64 init_phase_done(guint phase, gint64 phase_start_time)
+{
+    gint64 now = g_get_monotonic_time();
+
+    init_phase_durations[phase] = now - phase_start_time;
+
+    return now;
+}
+
+static GHashTable *create_init_stats_table(void)
+{
+    GHashTable *stats_table;
+    GValue *value;
+    guint i;
+
+    stats_table = _owr_value_table_new();
+
+    value = _owr_value_table_add(stats_table, "start_time", G_TYPE_INT64);
+    g_value_set_int64(value, init_start_time);
+
+    value = _owr_value_table_add(stats_table, "end_time", G_TYPE_INT64);
+    g_value_set_int64(value, init_end_time);
+
+    for (i = 0; i < N_INIT_PHASES; i++) {
+        value = _owr_value_table_add(stats_table, init_phase_names[i], G_TYPE_INT64);
+        g_value_set_int64(value, init_phase_durations[i]);
+    }
+
+    return stats_table;
+}
+
+static gboolean post_init_stats(gpointer user_data)
+{
+    OWR_UNUSED(user_data);
+
+    OWR_POST_STATS(owr_get_message_origin(), INIT, create_init_stats_table());
+
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * owr_get_init_stats:
+ *
+ * Gets the time spent in each phase of owr_init(). The same information is
+ * posted as an #OWR_STATS_TYPE_INIT message from the origin returned by
+ * owr_get_message_origin().
+ *
+ * Returns: (element-type utf8 GValue) (transfer full): a table with the
+ * monotonic start and end time of owr_init() and the duration of each phase
+ * in microseconds.
+ */
+GHashTable *owr_get_init_stats(void)
+{
+    g_return_val_if_fail(owr_initialized, NULL);
+
+    return create_init_stats_table();
+}
+
+/**
+ * owr_get_codec_pool_stats:
+ *
+ * Gets statistics for the pool of idle encoders and decoders that is shared
+ * by all sessions and renderers in the process.
+ *
+ * Returns: (element-type utf8 GValue) (transfer full): a table with the
+ * number of "hits" and "misses" when looking for a pooled element, the number
+ * of elements "returned" to and "discarded" by the pool, and the number of
+ * "idle" elements currently held.
+ */
+GHashTable *owr_get_codec_pool_stats(void)
+{
+    g_return_val_if_fail(owr_initialized, NULL);
+
+    return _owr_codec_pool_get_stats();
+}
+
 /**
  * owr_init:
  * @ctx: #GMainContext to use inside OpenWebRTC, if NULL is passed the default main context is used.
@@ -199,9 +367,12 @@ static void gst_log_android_handler(GstDebugCategory *category,
 void owr_init(GMainContext *main_context)
 {
     static GOnce g_once = G_ONCE_INIT;
+    gint64 phase_start_time;
 
     g_return_if_fail(!owr_initialized);
 
+    init_start_time = phase_start_time = g_get_monotonic_time();
+
 #ifdef __ANDROID__
     g_set_print_handler((GPrintFunc)g_print_android_handler);
     g_set_printerr_handler((GPrintFunc)g_printerr_android_handler);
@@ -216,9 +387,11 @@ void owr_init(GMainContext *main_context)
       abort();
     }
 #endif
+    phase_start_time = init_phase_done(INIT_PHASE_SYMBOL_CHECK, phase_start_time);
 
     gst_init(NULL, NULL);
     owr_initialized = TRUE;
+    phase_start_time = init_phase_done(INIT_PHASE_GST_INIT, phase_start_time);
 
     GST_DEBUG_CATEGORY_INIT(_owraudiopayload_debug, "owraudiopayload", 0,
         "OpenWebRTC Audio Payload");
@@ -256,8 +429,12 @@ void owr_init(GMainContext *main_context)
         "OpenWebRTC Payload");
     GST_DEBUG_CATEGORY_INIT(_owrremotemediasource_debug, "owrremotemediasource", 0,
         "OpenWebRTC Remote Media Source");
+    GST_DEBUG_CATEGORY_INIT(_owrrtpforward_debug, "owrrtpforward", 0,
+        "OpenWebRTC RTP Forward");
     GST_DEBUG_CATEGORY_INIT(_owrsession_debug, "owrsession", 0,
         "OpenWebRTC Session");
+    GST_DEBUG_CATEGORY_INIT(_owrsharedencoder_debug, "owrsharedencoder", 0,
+        "OpenWebRTC Shared Encoder");
     GST_DEBUG_CATEGORY_INIT(_owrtransportagent_debug, "owrtransportagent", 0,
         "OpenWebRTC Transport Agent");
     GST_DEBUG_CATEGORY_INIT(_owrvideopayload_debug, "owrvideopayload", 0,
@@ -266,6 +443,7 @@ void owr_init(GMainContext *main_context)
         "OpenWebRTC Video Renderer");
     GST_DEBUG_CATEGORY_INIT(_owrwindowregistry_debug, "owrwindowregistry", 0,
         "OpenWebRTC Window Registry");
+    phase_start_time = init_phase_done(INIT_PHASE_DEBUG_CATEGORIES, phase_start_time);
 
 #ifdef OWR_STATIC
     GST_PLUGIN_STATIC_REGISTER(alaw);
@@ -315,6 +493,7 @@ void owr_init(GMainContext *main_context)
 #endif
 
 #endif
+    phase_start_time = init_phase_done(INIT_PHASE_PLUGIN_REGISTRATION, phase_start_time);
 
     owr_main_context = main_context;
 
@@ -322,8 +501,12 @@ void owr_init(GMainContext *main_context)
         owr_main_context = g_main_context_ref_thread_default();
     else
         g_main_context_ref(owr_main_context);
+    phase_start_time = init_phase_done(INIT_PHASE_MAIN_CONTEXT, phase_start_time);
 
     g_once(&g_once, _owr_detect_codecs, NULL);
+    init_end_time = init_phase_done(INIT_PHASE_CODEC_DETECTION, phase_start_time);
+
+    _owr_schedule_with_user_data(post_init_stats, NULL);
 }
 
 static gboolean owr_running_callback(GAsyncQueue *msg_queue)
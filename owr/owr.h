@@ -28,6 +28,8 @@
 #ifndef __OWR_H__
 #define __OWR_H__
 
+#include "owr_message_origin.h"
+
 #include <glib.h>
 
 G_BEGIN_DECLS
@@ -36,6 +38,9 @@ void owr_init(GMainContext *main_context);
 void owr_run(void);
 void owr_run_in_background(void);
 void owr_quit(void);
+GHashTable *owr_get_init_stats(void);
+GHashTable *owr_get_codec_pool_stats(void);
+OwrMessageOrigin *owr_get_message_origin(void);
 
 G_END_DECLS
 
@@ -378,6 +378,7 @@ GType owr_message_sub_type_get_type(void)
         {OWR_STATS_TYPE_SCHEDULE, "Schedule", "schedule"},
         {OWR_STATS_TYPE_SEND_PIPELINE_ADDED, "Send pipeline added", "send-pipeline-added"},
         {OWR_STATS_TYPE_SEND_PIPELINE_REMOVED, "Send pipeline removed", "send-pipeline-removed"},
+        {OWR_STATS_TYPE_INIT, "Init", "init"},
         {OWR_EVENT_TYPE_TEST, "Event Test", "event-test"},
         {OWR_EVENT_TYPE_RENDERER_STARTED, "Renderer started", "renderer-started"},
         {OWR_EVENT_TYPE_RENDERER_STOPPED, "Renderer stopped", "renderer-stopped"},
@@ -63,6 +63,17 @@ typedef enum {
  * - @start_time: #gint64 monotonic time when the pipeline teardown began
  * - @end_time: #gint64 monotonic time when the pipeline teardown was completed
  *
+ * @OWR_STATS_TYPE_INIT: owr_init() has completed, posted from owr_get_message_origin()
+ * once the main loop is running
+ * - @start_time: #gint64 monotonic time when owr_init() was called
+ * - @end_time: #gint64 monotonic time when owr_init() returned
+ * - @symbol_check_duration: #gint64 microseconds spent checking required symbols (static builds)
+ * - @gst_init_duration: #gint64 microseconds spent in gst_init()
+ * - @debug_categories_duration: #gint64 microseconds spent registering debug categories
+ * - @plugin_registration_duration: #gint64 microseconds spent registering static plugins
+ * - @main_context_duration: #gint64 microseconds spent setting up the main context
+ * - @codec_detection_duration: #gint64 microseconds spent detecting available codecs
+ *
  * @OWR_EVENT_TYPE_RENDERER_STARTED: a renderer was started
  *
  * @OWR_EVENT_TYPE_RENDERER_STOPPED: a renderer was stopped
@@ -82,6 +93,7 @@ typedef enum {
     OWR_STATS_TYPE_SCHEDULE,
     OWR_STATS_TYPE_SEND_PIPELINE_ADDED,
     OWR_STATS_TYPE_SEND_PIPELINE_REMOVED,
+    OWR_STATS_TYPE_INIT,
     OWR_EVENT_TYPE_TEST = 0x3000,
     OWR_EVENT_TYPE_RENDERER_STARTED,
     OWR_EVENT_TYPE_RENDERER_STOPPED,
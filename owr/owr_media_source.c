@@ -73,12 +73,26 @@ GST_DEBUG_CATEGORY_EXTERN(_owrmediasource_debug);
 #define DEFAULT_NAME NULL
 #define DEFAULT_MEDIA_TYPE OWR_MEDIA_TYPE_UNKNOWN
 #define DEFAULT_TYPE OWR_SOURCE_TYPE_UNKNOWN
+#define DEFAULT_CODEC_TYPE OWR_CODEC_TYPE_NONE
+#define DEFAULT_CONVERSION_THREADS 0
+#define DEFAULT_SCALE_METHOD OWR_SCALE_METHOD_AUTO
+
+/* Values of GstVideoScaleMethod used by videoscale's "method" */
+#define VIDEOSCALE_METHOD_NEAREST 0
+#define VIDEOSCALE_METHOD_BILINEAR 1
+#define VIDEOSCALE_METHOD_4TAP 2
+
+/* Outputs up to this size get the 4-tap filter in auto mode */
+#define AUTO_4TAP_MAX_PIXELS (640 * 480)
 
 enum {
     PROP_0,
     PROP_NAME,
     PROP_MEDIA_TYPE,
     PROP_TYPE,
+    PROP_CODEC_TYPE,
+    PROP_CONVERSION_THREADS,
+    PROP_SCALE_METHOD,
     N_PROPERTIES
 };
 
@@ -116,15 +130,37 @@ struct _OwrMediaSourcePrivate {
 
     OwrSourceType type;
     OwrCodecType codec_type;
+    /* Whether an Opus decoder recovers losses from the in-band FEC */
+    gboolean decoder_inband_fec;
+
+    guint conversion_threads;
+    OwrScaleMethod scale_method;
 
     /* The bin or pipeline that contains the data producers */
     GstElement *source_bin;
     /* Tee element from which we can tap the source for multiple consumers */
     GstElement *source_tee;
+    /* Caps string => OwrConversionBranch shared by consumers of those caps */
+    GHashTable *conversion_branches;
 
     OwrMediaSourceSupportedInterfaces supported_interfaces;
 };
 
+typedef struct {
+    GstElement *bin;
+    GstElement *tee;
+    guint ref_count;
+} OwrConversionBranch;
+
+#define CONVERSION_BRANCH_KEY "owr-conversion-branch-caps"
+
+static void conversion_branch_free(OwrConversionBranch *branch)
+{
+    gst_object_unref(branch->tee);
+    gst_object_unref(branch->bin);
+    g_slice_free(OwrConversionBranch, branch);
+}
+
 static void owr_media_source_set_property(GObject *object, guint property_id,
     const GValue *value, GParamSpec *pspec);
 static void owr_media_source_get_property(GObject *object, guint property_id,
@@ -151,12 +187,27 @@ static void owr_media_source_finalize(GObject *object)
         gst_object_unref(priv->source_tee);
         priv->source_tee = NULL;
     }
+    g_hash_table_destroy(priv->conversion_branches);
 
     g_mutex_clear(&source->lock);
 
     G_OBJECT_CLASS(owr_media_source_parent_class)->finalize(object);
 }
 
+static void owr_media_source_constructed(GObject *object)
+{
+    OwrMediaSource *media_source = OWR_MEDIA_SOURCE(object);
+    OwrMediaSourceClass *klass = OWR_MEDIA_SOURCE_GET_CLASS(media_source);
+
+    /* Subclasses that know their media up front report the codec here, the
+     * others update it with _owr_media_source_set_codec() once detected */
+    if (klass->get_codec_type)
+        media_source->priv->codec_type = klass->get_codec_type(media_source);
+
+    if (G_OBJECT_CLASS(owr_media_source_parent_class)->constructed)
+        G_OBJECT_CLASS(owr_media_source_parent_class)->constructed(object);
+}
+
 static void owr_media_source_class_init(OwrMediaSourceClass *klass)
 {
     GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
@@ -177,9 +228,26 @@ static void owr_media_source_class_init(OwrMediaSourceClass *klass)
         OWR_TYPE_SOURCE_TYPE, DEFAULT_TYPE,
         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
 
+    obj_properties[PROP_CODEC_TYPE] = g_param_spec_enum("codec-type", "codec-type",
+        "The codec of the media provided by this source, none for raw media"
+        " (NOTE: may change once the source has detected its media)",
+        OWR_TYPE_CODEC_TYPE, DEFAULT_CODEC_TYPE,
+        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_CONVERSION_THREADS] = g_param_spec_uint("conversion-threads", "conversion-threads",
+        "Number of threads used to convert and scale video for consumers (0 = auto)",
+        0, G_MAXUINT16, DEFAULT_CONVERSION_THREADS,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_SCALE_METHOD] = g_param_spec_enum("scale-method", "scale-method",
+        "The method used to scale video for consumers",
+        OWR_TYPE_SCALE_METHOD, DEFAULT_SCALE_METHOD,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
     gobject_class->set_property = owr_media_source_set_property;
     gobject_class->get_property = owr_media_source_get_property;
 
+    gobject_class->constructed = owr_media_source_constructed;
     gobject_class->finalize = owr_media_source_finalize;
 
     g_object_class_install_properties(gobject_class, N_PROPERTIES, obj_properties);
@@ -196,9 +264,14 @@ static void owr_media_source_init(OwrMediaSource *source)
     priv->name = DEFAULT_NAME;
     priv->media_type = DEFAULT_MEDIA_TYPE;
     priv->type = DEFAULT_TYPE;
+    priv->codec_type = DEFAULT_CODEC_TYPE;
+    priv->conversion_threads = DEFAULT_CONVERSION_THREADS;
+    priv->scale_method = DEFAULT_SCALE_METHOD;
 
     priv->source_bin = NULL;
     priv->source_tee = NULL;
+    priv->conversion_branches = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) conversion_branch_free);
     priv->supported_interfaces = OWR_MEDIA_SOURCE_SUPPORTS_NONE;
 
     g_mutex_init(&source->lock);
@@ -223,6 +296,12 @@ static void owr_media_source_set_property(GObject *object, guint property_id,
     case PROP_TYPE:
         priv->type = g_value_get_enum(value);
         break;
+    case PROP_CONVERSION_THREADS:
+        priv->conversion_threads = g_value_get_uint(value);
+        break;
+    case PROP_SCALE_METHOD:
+        priv->scale_method = g_value_get_enum(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -247,6 +326,15 @@ static void owr_media_source_get_property(GObject *object, guint property_id,
     case PROP_TYPE:
         g_value_set_enum(value, priv->type);
         break;
+    case PROP_CODEC_TYPE:
+        g_value_set_enum(value, priv->codec_type);
+        break;
+    case PROP_CONVERSION_THREADS:
+        g_value_set_uint(value, priv->conversion_threads);
+        break;
+    case PROP_SCALE_METHOD:
+        g_value_set_enum(value, priv->scale_method);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -254,8 +342,168 @@ static void owr_media_source_get_property(GObject *object, guint property_id,
 }
 
 /*
- * The following chain is created after the tee for each output from the
- * source:
+ * Consumers of raw media that request identical caps share one conversion
+ * branch in the source pipeline, so each frame is only converted once per
+ * set of caps:
+ *
+ * +-----+   +-------------------------------------+   +------------------------+
+ * | tee +---+ queue/converters/capsfilter/tee     +---+ queue/inter*sink (each |
+ * +-----+   +-------------------------------------+   | consumer)              |
+ *                                                     +------------------------+
+ *
+ * Branches are refcounted by their consumers and removed with the last one.
+ */
+/* Threads and scaling method are picked from the output size unless set on
+ * the source. Elements without the n-threads property (GStreamer < 1.10)
+ * convert on a single thread. */
+static void configure_video_converters(OwrMediaSource *media_source, GstElement *videoscale,
+    GstElement *videoconvert, GstCaps *caps)
+{
+    OwrMediaSourcePrivate *priv = media_source->priv;
+    GstStructure *s = gst_caps_get_structure(caps, 0);
+    gint width = 0, height = 0, pixels;
+    guint n_threads;
+    gint method;
+
+    gst_structure_get_int(s, "width", &width);
+    gst_structure_get_int(s, "height", &height);
+    pixels = width * height;
+
+    n_threads = priv->conversion_threads;
+    if (!n_threads) {
+        if (pixels >= 1920 * 1080)
+            n_threads = 4;
+        else if (pixels >= 1280 * 720)
+            n_threads = 2;
+        else
+            n_threads = 1;
+        n_threads = MIN(n_threads, (guint) g_get_num_processors());
+    }
+
+    switch (priv->scale_method) {
+    case OWR_SCALE_METHOD_NEAREST:
+        method = VIDEOSCALE_METHOD_NEAREST;
+        break;
+    case OWR_SCALE_METHOD_BILINEAR:
+        method = VIDEOSCALE_METHOD_BILINEAR;
+        break;
+    case OWR_SCALE_METHOD_4TAP:
+        method = VIDEOSCALE_METHOD_4TAP;
+        break;
+    case OWR_SCALE_METHOD_AUTO:
+    default:
+        method = pixels && pixels <= AUTO_4TAP_MAX_PIXELS ?
+            VIDEOSCALE_METHOD_4TAP : VIDEOSCALE_METHOD_BILINEAR;
+        break;
+    }
+
+    g_object_set(videoscale, "method", method, NULL);
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(videoscale), "n-threads"))
+        g_object_set(videoscale, "n-threads", n_threads, NULL);
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(videoconvert), "n-threads"))
+        g_object_set(videoconvert, "n-threads", n_threads, NULL);
+
+    GST_DEBUG_OBJECT(media_source, "Converting %dx%d with %u threads, scale method %d",
+        width, height, n_threads, method);
+}
+
+static OwrConversionBranch *conversion_branch_new(OwrMediaSource *media_source, OwrMediaType media_type,
+    GstCaps *caps, guint source_id)
+{
+    OwrConversionBranch *branch;
+    GstElement *bin, *queue, *capsfilter, *tee;
+    GstPad *sinkpad, *bin_pad;
+    gchar *bin_name;
+
+    bin_name = g_strdup_printf("source-conversion-bin-%u", source_id);
+    bin = gst_bin_new(bin_name);
+    g_free(bin_name);
+
+    CREATE_ELEMENT_WITH_ID(queue, "queue", "source-queue", source_id);
+    CREATE_ELEMENT_WITH_ID(capsfilter, "capsfilter", "source-output-capsfilter", source_id);
+    CREATE_ELEMENT_WITH_ID(tee, "tee", "source-output-tee", source_id);
+    gst_bin_add_many(GST_BIN(bin), queue, capsfilter, tee, NULL);
+
+    if (media_type == OWR_MEDIA_TYPE_AUDIO) {
+        GstElement *audioresample, *audioconvert, *decoder = NULL;
+        OwrCodecType codec_type = _owr_media_source_get_codec(media_source);
+
+        g_object_set(capsfilter, "caps", caps, NULL);
+
+        CREATE_ELEMENT_WITH_ID(audioresample, "audioresample", "source-audio-resample", source_id);
+        CREATE_ELEMENT_WITH_ID(audioconvert, "audioconvert", "source-audio-convert", source_id);
+
+        gst_bin_add_many(GST_BIN(bin), audioconvert, audioresample, NULL);
+        if (!_owr_codec_type_is_raw(codec_type))
+            decoder = _owr_create_decoder(codec_type);
+        /* Pooled decoders keep their properties, so set it either way */
+        if (decoder && codec_type == OWR_CODEC_TYPE_OPUS)
+            g_object_set(decoder, "use-inband-fec", media_source->priv->decoder_inband_fec, NULL);
+        if (decoder) {
+            gst_bin_add(GST_BIN(bin), decoder);
+            LINK_ELEMENTS(queue, decoder);
+            LINK_ELEMENTS(decoder, audioconvert);
+        } else {
+            LINK_ELEMENTS(queue, audioconvert);
+        }
+        LINK_ELEMENTS(audioconvert, audioresample);
+        LINK_ELEMENTS(audioresample, capsfilter);
+    } else {
+        GstElement *videorate = NULL, *gldownload, *videoscale, *videoconvert;
+        GstCaps *filter_caps;
+        GstStructure *s;
+
+        filter_caps = gst_caps_copy(caps);
+        s = gst_caps_get_structure(filter_caps, 0);
+        if (gst_structure_has_field(s, "framerate")) {
+            gint fps_n = 0, fps_d = 0;
+
+            gst_structure_get_fraction(s, "framerate", &fps_n, &fps_d);
+            g_assert(fps_d);
+
+            CREATE_ELEMENT_WITH_ID(videorate, "videorate", "source-video-rate", source_id);
+            g_object_set(videorate, "drop-only", TRUE, "max-rate", fps_n / fps_d, NULL);
+
+            gst_structure_remove_field(s, "framerate");
+            gst_bin_add(GST_BIN(bin), videorate);
+        }
+        g_object_set(capsfilter, "caps", filter_caps, NULL);
+        gst_caps_unref(filter_caps);
+
+        CREATE_ELEMENT_WITH_ID(gldownload, "gldownload", "source-gldownload", source_id);
+        CREATE_ELEMENT_WITH_ID(videoscale, "videoscale", "source-video-scale", source_id);
+        CREATE_ELEMENT_WITH_ID(videoconvert, VIDEO_CONVERT, "source-video-convert", source_id);
+        configure_video_converters(media_source, videoscale, videoconvert, caps);
+        gst_bin_add_many(GST_BIN(bin), gldownload, videoscale, videoconvert, NULL);
+
+        if (videorate) {
+            LINK_ELEMENTS(queue, videorate);
+            LINK_ELEMENTS(videorate, gldownload);
+        } else {
+            LINK_ELEMENTS(queue, gldownload);
+        }
+        LINK_ELEMENTS(gldownload, videoscale);
+        LINK_ELEMENTS(videoscale, videoconvert);
+        LINK_ELEMENTS(videoconvert, capsfilter);
+    }
+    LINK_ELEMENTS(capsfilter, tee);
+
+    sinkpad = gst_element_get_static_pad(queue, "sink");
+    bin_pad = gst_ghost_pad_new("sink", sinkpad);
+    gst_object_unref(sinkpad);
+    gst_pad_set_active(bin_pad, TRUE);
+    gst_element_add_pad(bin, bin_pad);
+
+    branch = g_slice_new0(OwrConversionBranch);
+    branch->bin = gst_object_ref(bin);
+    branch->tee = gst_object_ref(tee);
+
+    return branch;
+}
+
+/*
+ * The following chain is created after the tee (or the tee of a shared
+ * conversion branch) for each output from the source:
  *
  * +-----------+   +-------------------------------+   +----------+
  * | inter*src +---+ converters/queues/capsfilters +---+ ghostpad |
@@ -264,21 +512,23 @@ static void owr_media_source_get_property(GObject *object, guint property_id,
  */
 static GstElement *owr_media_source_request_source_default(OwrMediaSource *media_source, GstCaps *caps)
 {
+    OwrMediaSourcePrivate *priv = media_source->priv;
     OwrMediaType media_type;
     GstElement *source_pipeline, *tee;
     GstElement *source_bin, *source = NULL, *queue_pre = NULL, *queue_post = NULL;
-    GstElement *capsfilter;
     GstElement *sink, *sink_queue, *sink_bin;
     GstPad *bin_pad = NULL, *srcpad, *sinkpad;
-    gchar *bin_name;
+    OwrConversionBranch *branch = NULL;
+    gboolean new_branch = FALSE;
+    gchar *bin_name, *caps_key = NULL;
     guint source_id;
     gchar *sink_name, *source_name;
 
-    g_return_val_if_fail(media_source->priv->source_bin, NULL);
-    g_return_val_if_fail(media_source->priv->source_tee, NULL);
+    g_return_val_if_fail(priv->source_bin, NULL);
+    g_return_val_if_fail(priv->source_tee, NULL);
 
-    source_pipeline = gst_object_ref(media_source->priv->source_bin);
-    tee = gst_object_ref(media_source->priv->source_tee);
+    source_pipeline = gst_object_ref(priv->source_bin);
+    tee = gst_object_ref(priv->source_tee);
 
     source_id = g_atomic_int_add(&unique_bin_id, 1);
 
@@ -292,33 +542,39 @@ static GstElement *owr_media_source_request_source_default(OwrMediaSource *media
     g_object_get(media_source, "media-type", &media_type, NULL);
     switch (media_type) {
     case OWR_MEDIA_TYPE_AUDIO:
-        {
-        GstElement *audioresample, *audioconvert;
-
-        CREATE_ELEMENT_WITH_ID(capsfilter, "capsfilter", "source-output-capsfilter", source_id);
-        g_object_set(capsfilter, "caps", caps, NULL);
-
-        CREATE_ELEMENT_WITH_ID(queue_pre, "queue", "source-queue", source_id);
-        CREATE_ELEMENT_WITH_ID(queue_post, "queue", "source-output-queue", source_id);
-
-        CREATE_ELEMENT_WITH_ID(audioresample, "audioresample", "source-audio-resample", source_id);
-        CREATE_ELEMENT_WITH_ID(audioconvert, "audioconvert", "source-audio-convert", source_id);
-
-        gst_bin_add_many(GST_BIN(source_bin),
-            queue_pre, audioconvert, audioresample, capsfilter, queue_post, NULL);
-        LINK_ELEMENTS(capsfilter, queue_post);
-        LINK_ELEMENTS(audioresample, capsfilter);
-        LINK_ELEMENTS(audioconvert, audioresample);
-        LINK_ELEMENTS(queue_pre, audioconvert);
-
-        break;
-        }
     case OWR_MEDIA_TYPE_VIDEO:
         {
-        if (_owr_codec_type_is_raw(_owr_media_source_get_codec(media_source))) {
-            GstElement *videorate = NULL, *videoscale = NULL, *videoconvert;
+        GstCapsFeatures *features = gst_caps_get_features(caps, 0);
+
+        /* Encoded audio is only decoded, in a conversion branch, for
+         * consumers asking for raw audio */
+        if (!_owr_codec_type_is_raw(_owr_media_source_get_codec(media_source))
+            && (media_type == OWR_MEDIA_TYPE_VIDEO
+                || !gst_structure_has_name(gst_caps_get_structure(caps, 0), "audio/x-raw")))
+            break;
+
+        if (media_type == OWR_MEDIA_TYPE_AUDIO
+            || !gst_caps_features_contains(features, GST_CAPS_FEATURE_MEMORY_GL_MEMORY)) {
+            caps_key = gst_caps_to_string(caps);
+            branch = g_hash_table_lookup(priv->conversion_branches, caps_key);
+            if (!branch) {
+                branch = conversion_branch_new(media_source, media_type, caps, source_id);
+                g_hash_table_insert(priv->conversion_branches, g_strdup(caps_key), branch);
+                gst_bin_add(GST_BIN(source_pipeline), branch->bin);
+                new_branch = TRUE;
+                GST_DEBUG_OBJECT(media_source, "Created conversion branch for %s", caps_key);
+            } else
+                GST_DEBUG_OBJECT(media_source, "Reusing conversion branch for %s", caps_key);
+            branch->ref_count++;
+
+            CREATE_ELEMENT_WITH_ID(queue_post, "queue", "source-output-queue", source_id);
+            gst_bin_add(GST_BIN(source_bin), queue_post);
+            queue_pre = queue_post;
+        } else {
+            /* GL memory is converted in the consumer's pipeline, which
+             * owns the GL context */
+            GstElement *videorate = NULL, *videoscale, *videoconvert, *glupload;
             GstStructure *s;
-            GstCapsFeatures *features;
 
             CREATE_ELEMENT_WITH_ID(queue_pre, "queue", "source-queue", source_id);
             CREATE_ELEMENT_WITH_ID(queue_post, "queue", "source-output-queue", source_id);
@@ -337,48 +593,22 @@ static GstElement *owr_media_source_request_source_default(OwrMediaSource *media
                 gst_bin_add(GST_BIN(source_bin), videorate);
             }
 
-            features = gst_caps_get_features(caps, 0);
-            if (gst_caps_features_contains(features, GST_CAPS_FEATURE_MEMORY_GL_MEMORY)) {
-                GstElement *glupload;
-
-                CREATE_ELEMENT_WITH_ID(glupload, "glupload", "source-glupload", source_id);
-                CREATE_ELEMENT_WITH_ID(videoscale, "gleffects_identity", "source-glcolorscale", source_id);
-                CREATE_ELEMENT_WITH_ID(videoconvert, "glcolorconvert", "source-glcolorconvert", source_id);
-
-                gst_bin_add_many(GST_BIN(source_bin),
-                                 queue_pre, glupload, videoconvert, videoscale, queue_post, NULL);
-
-                if (videorate) {
-                    LINK_ELEMENTS(queue_pre, videorate);
-                    LINK_ELEMENTS(videorate, glupload);
-                } else {
-                    LINK_ELEMENTS(queue_pre, glupload);
-                }
-                LINK_ELEMENTS(glupload, videoconvert);
-                LINK_ELEMENTS(videoconvert, videoscale);
-                LINK_ELEMENTS(videoscale, queue_post);
+            CREATE_ELEMENT_WITH_ID(glupload, "glupload", "source-glupload", source_id);
+            CREATE_ELEMENT_WITH_ID(videoscale, "gleffects_identity", "source-glcolorscale", source_id);
+            CREATE_ELEMENT_WITH_ID(videoconvert, "glcolorconvert", "source-glcolorconvert", source_id);
+
+            gst_bin_add_many(GST_BIN(source_bin),
+                             queue_pre, glupload, videoconvert, videoscale, queue_post, NULL);
+
+            if (videorate) {
+                LINK_ELEMENTS(queue_pre, videorate);
+                LINK_ELEMENTS(videorate, glupload);
             } else {
-                GstElement *gldownload;
-
-                CREATE_ELEMENT_WITH_ID(capsfilter, "capsfilter", "source-output-capsfilter", source_id);
-                g_object_set(capsfilter, "caps", caps, NULL);
-
-                CREATE_ELEMENT_WITH_ID(gldownload, "gldownload", "source-gldownload", source_id);
-                CREATE_ELEMENT_WITH_ID(videoscale,  "videoscale", "source-video-scale", source_id);
-                CREATE_ELEMENT_WITH_ID(videoconvert, VIDEO_CONVERT, "source-video-convert", source_id);
-                gst_bin_add_many(GST_BIN(source_bin),
-                                 queue_pre, gldownload, videoscale, videoconvert, capsfilter, queue_post, NULL);
-                if (videorate) {
-                    LINK_ELEMENTS(queue_pre, videorate);
-                    LINK_ELEMENTS(videorate, gldownload);
-                } else {
-                    LINK_ELEMENTS(queue_pre, gldownload);
-                }
-                LINK_ELEMENTS(gldownload, videoscale);
-                LINK_ELEMENTS(videoscale, videoconvert);
-                LINK_ELEMENTS(videoconvert, capsfilter);
-                LINK_ELEMENTS(capsfilter, queue_post);
+                LINK_ELEMENTS(queue_pre, glupload);
             }
+            LINK_ELEMENTS(glupload, videoconvert);
+            LINK_ELEMENTS(videoconvert, videoscale);
+            LINK_ELEMENTS(videoscale, queue_post);
         }
         break;
         }
@@ -399,7 +629,8 @@ static GstElement *owr_media_source_request_source_default(OwrMediaSource *media
     g_weak_ref_set(&OWR_INTER_SRC(source)->sink_sinkpad, OWR_INTER_SINK(sink)->sinkpad);
     g_weak_ref_set(&OWR_INTER_SINK(sink)->src_srcpad, OWR_INTER_SRC(source)->internal_srcpad);
 
-    /* Add and link the inter*sink to the actual source pipeline */
+    /* Add and link the inter*sink to the actual source pipeline, or to the
+     * conversion branch shared with other consumers */
     bin_name = g_strdup_printf("source-sink-bin-%u", source_id);
     sink_bin = gst_bin_new(bin_name);
     g_free(bin_name);
@@ -413,9 +644,23 @@ static GstElement *owr_media_source_request_source_default(OwrMediaSource *media
     gst_pad_set_active(bin_pad, TRUE);
     gst_element_add_pad(sink_bin, bin_pad);
     bin_pad = NULL;
-    gst_bin_add(GST_BIN(source_pipeline), sink_bin);
-    gst_element_sync_state_with_parent(sink_bin);
-    LINK_ELEMENTS(tee, sink_bin);
+    if (branch) {
+        g_object_set_data_full(G_OBJECT(sink_bin), CONVERSION_BRANCH_KEY, caps_key, g_free);
+        gst_bin_add(GST_BIN(branch->bin), sink_bin);
+        gst_element_sync_state_with_parent(sink_bin);
+        LINK_ELEMENTS(branch->tee, sink_bin);
+
+        /* Only link a new branch once it has a consumer, so that its tee
+         * never runs without any src pad */
+        if (new_branch) {
+            gst_element_sync_state_with_parent(branch->bin);
+            LINK_ELEMENTS(tee, branch->bin);
+        }
+    } else {
+        gst_bin_add(GST_BIN(source_pipeline), sink_bin);
+        gst_element_sync_state_with_parent(sink_bin);
+        LINK_ELEMENTS(tee, sink_bin);
+    }
 
     /* Start up our new bin and link it all */
     gst_bin_add(GST_BIN(source_bin), source);
@@ -467,6 +712,8 @@ static GstPadProbeReturn tee_idle_probe_cb(GstPad *teepad, GstPadProbeInfo *info
     parent = gst_object_get_parent(GST_OBJECT(sink_bin));
     g_assert(parent);
 
+    /* A conversion branch may hold a decoder from the pool */
+    _owr_codec_pool_release_from_bin(GST_BIN(sink_bin));
     gst_bin_remove(GST_BIN(parent), sink_bin);
     gst_element_set_state(sink_bin, GST_STATE_NULL);
     gst_object_unref(sink_bin);
@@ -481,8 +728,10 @@ static void owr_media_source_release_source_default(OwrMediaSource *media_source
 {
     GstPad *srcpad, *sinkpad;
     gchar *bin_name, *source_name;
+    const gchar *caps_key;
     guint source_id = -1;
     GstElement *sink_bin, *source_pipeline;
+    OwrConversionBranch *branch = NULL;
 
     g_return_if_fail(media_source->priv->source_bin);
     g_return_if_fail(media_source->priv->source_tee);
@@ -514,7 +763,21 @@ static void owr_media_source_release_source_default(OwrMediaSource *media_source
     g_free(bin_name);
     gst_object_unref(source_pipeline);
 
-    sinkpad = gst_element_get_static_pad(sink_bin, "sink");
+    caps_key = g_object_get_data(G_OBJECT(sink_bin), CONVERSION_BRANCH_KEY);
+    if (caps_key)
+        branch = g_hash_table_lookup(media_source->priv->conversion_branches, caps_key);
+
+    if (branch && branch->ref_count == 1) {
+        /* Last consumer, the whole conversion branch goes */
+        GST_DEBUG_OBJECT(media_source, "Removing conversion branch for %s", caps_key);
+        sinkpad = gst_element_get_static_pad(branch->bin, "sink");
+        g_hash_table_remove(media_source->priv->conversion_branches, caps_key);
+    } else {
+        if (branch)
+            branch->ref_count--;
+        sinkpad = gst_element_get_static_pad(sink_bin, "sink");
+    }
+
     /* The pad on the tee */
     srcpad = gst_pad_get_peer(sinkpad);
     gst_object_unref(sinkpad);
@@ -555,6 +818,8 @@ void _owr_media_source_set_source_bin(OwrMediaSource *media_source, GstElement *
         gst_element_set_state(media_source->priv->source_bin, GST_STATE_NULL);
         gst_object_unref(media_source->priv->source_bin);
     }
+    /* Conversion branches live in the old pipeline */
+    g_hash_table_remove_all(media_source->priv->conversion_branches);
     media_source->priv->source_bin = bin ? gst_object_ref(bin) : NULL;
 }
 
@@ -651,7 +916,16 @@ void _owr_media_source_set_codec(OwrMediaSource *media_source, OwrCodecType code
 {
     g_return_if_fail(OWR_IS_MEDIA_SOURCE(media_source));
     /* an enum is an int type so we can use atomic assignment */
-    g_atomic_int_set(&media_source->priv->codec_type, codec_type);
+    if (g_atomic_int_get(&media_source->priv->codec_type) != (gint) codec_type) {
+        g_atomic_int_set(&media_source->priv->codec_type, codec_type);
+        g_object_notify_by_pspec(G_OBJECT(media_source), obj_properties[PROP_CODEC_TYPE]);
+    }
+}
+
+void _owr_media_source_set_decoder_inband_fec(OwrMediaSource *media_source, gboolean inband_fec)
+{
+    g_return_if_fail(OWR_IS_MEDIA_SOURCE(media_source));
+    media_source->priv->decoder_inband_fec = inband_fec;
 }
 
 gchar * owr_media_source_get_dot_data(OwrMediaSource *source)
@@ -63,6 +63,7 @@ struct _OwrMediaSourceClass {
     /*< private >*/
     void *(*request_source)(OwrMediaSource *media_source, void *caps);
     void  (*release_source)(OwrMediaSource *media_source, void *source);
+    OwrCodecType (*get_codec_type)(OwrMediaSource *media_source);
 };
 
 GType owr_media_source_get_type(void) G_GNUC_CONST;
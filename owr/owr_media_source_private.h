@@ -67,6 +67,8 @@ OwrSourceType _owr_media_source_get_media_type(OwrMediaSource *source);
 void _owr_media_source_set_codec(OwrMediaSource *source, OwrCodecType codec_type);
 OwrCodecType _owr_media_source_get_codec(OwrMediaSource *source);
 
+void _owr_media_source_set_decoder_inband_fec(OwrMediaSource *source, gboolean inband_fec);
+
 void _owr_media_source_set_supported_interfaces(OwrMediaSource *source, OwrMediaSourceSupportedInterfaces interfaces);
 
 gboolean _owr_media_source_supports_interfaces(OwrMediaSource *source, OwrMediaSourceSupportedInterfaces interfaces);
@@ -126,3 +126,41 @@ if (g_once_init_enter((gsize *)&id)) {
 
 return id;
 }
+
+GType owr_scale_method_get_type(void)
+{
+    static const GEnumValue types[] = {
+        {OWR_SCALE_METHOD_AUTO, "Pick the method from the output resolution", "auto"},
+        {OWR_SCALE_METHOD_NEAREST, "Nearest neighbour", "nearest"},
+        {OWR_SCALE_METHOD_BILINEAR, "Bilinear", "bilinear"},
+        {OWR_SCALE_METHOD_4TAP, "4-tap filter", "4-tap"},
+        {0, NULL, NULL}
+    };
+    static volatile GType id = 0;
+
+    if (g_once_init_enter((gsize *)&id)) {
+        GType _id = g_enum_register_static("OwrScaleMethods", types);
+        g_once_init_leave((gsize *)&id, _id);
+    }
+
+    return id;
+}
+
+GType owr_degradation_preference_get_type(void)
+{
+    static const GEnumValue types[] = {
+        {OWR_DEGRADATION_PREFERENCE_DISABLED, "Always send the configured resolution and framerate", "disabled"},
+        {OWR_DEGRADATION_PREFERENCE_MAINTAIN_FRAMERATE, "Lower the resolution when the bitrate drops", "maintain-framerate"},
+        {OWR_DEGRADATION_PREFERENCE_MAINTAIN_RESOLUTION, "Lower the framerate when the bitrate drops", "maintain-resolution"},
+        {OWR_DEGRADATION_PREFERENCE_BALANCED, "Alternate between lowering framerate and resolution", "balanced"},
+        {0, NULL, NULL}
+    };
+    static volatile GType id = 0;
+
+    if (g_once_init_enter((gsize *)&id)) {
+        GType _id = g_enum_register_static("OwrDegradationPreferences", types);
+        g_once_init_leave((gsize *)&id, _id);
+    }
+
+    return id;
+}
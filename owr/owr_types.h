@@ -69,6 +69,20 @@ typedef enum _OwrBundlePolicyType {
     OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE
 } OwrBundlePolicyType;
 
+typedef enum _OwrScaleMethod {
+    OWR_SCALE_METHOD_AUTO,
+    OWR_SCALE_METHOD_NEAREST,
+    OWR_SCALE_METHOD_BILINEAR,
+    OWR_SCALE_METHOD_4TAP
+} OwrScaleMethod;
+
+typedef enum _OwrDegradationPreference {
+    OWR_DEGRADATION_PREFERENCE_DISABLED,
+    OWR_DEGRADATION_PREFERENCE_MAINTAIN_FRAMERATE,
+    OWR_DEGRADATION_PREFERENCE_MAINTAIN_RESOLUTION,
+    OWR_DEGRADATION_PREFERENCE_BALANCED
+} OwrDegradationPreference;
+
 #define OWR_TYPE_CODEC_TYPE (owr_codec_type_get_type())
 GType owr_codec_type_get_type(void);
 
@@ -84,6 +98,12 @@ GType owr_adaptation_type_get_type(void);
 #define OWR_TYPE_BUNDLE_POLICY_TYPE (owr_bundle_policy_type_get_type())
 GType owr_bundle_policy_type_get_type(void);
 
+#define OWR_TYPE_SCALE_METHOD (owr_scale_method_get_type())
+GType owr_scale_method_get_type(void);
+
+#define OWR_TYPE_DEGRADATION_PREFERENCE (owr_degradation_preference_get_type())
+GType owr_degradation_preference_get_type(void);
+
 
 G_END_DECLS
 
@@ -218,6 +218,10 @@ GstElement * _owr_create_decoder(OwrCodecType codec_type)
     GstElement * decoder = NULL;
     gchar *element_name = NULL;
 
+    decoder = _owr_codec_pool_acquire(OWR_CODEC_POOL_DECODER, codec_type);
+    if (decoder)
+        return decoder;
+
     switch (codec_type) {
     case OWR_CODEC_TYPE_H264:
         decoder = _owr_try_codecs(h264_decoders, "decoder");
@@ -239,6 +243,8 @@ GstElement * _owr_create_decoder(OwrCodecType codec_type)
         break;
     }
 
+    _owr_codec_pool_mark(decoder, OWR_CODEC_POOL_DECODER, codec_type);
+
     return decoder;
 }
 
@@ -510,3 +516,336 @@ GValue *_owr_value_table_add(GHashTable *table, const gchar *key, GType type)
     g_hash_table_insert(table, g_strdup(key), value);
     return value;
 }
+
+/* Idle encoders and decoders are kept in READY state so that creating a new
+ * send or receive chain does not have to go through factory lookup, element
+ * construction and (for hardware codecs) device opening again. */
+#define CODEC_POOL_MAX_IDLE_PER_KEY 2
+#define CODEC_POOL_KEY(role, codec_type) GUINT_TO_POINTER((((guint)(role) << 8) | (guint)(codec_type)) + 1)
+
+G_LOCK_DEFINE_STATIC(codec_pool);
+static GHashTable *codec_pool = NULL;
+static guint codec_pool_hits = 0;
+static guint codec_pool_misses = 0;
+static guint codec_pool_returned = 0;
+static guint codec_pool_discarded = 0;
+
+static void codec_pool_unbind(gpointer data)
+{
+    GSList *bindings = data, *item;
+    GWeakRef *ref;
+    GBinding *binding;
+
+    for (item = bindings; item; item = item->next) {
+        ref = item->data;
+        binding = g_weak_ref_get(ref);
+        if (binding) {
+            /* Dropping the reference owned by the binding removes it,
+             * g_binding_unbind() is only available from GLib 2.38 */
+            g_object_unref(binding);
+            g_object_unref(binding);
+        }
+        g_weak_ref_clear(ref);
+        g_slice_free(GWeakRef, ref);
+    }
+    g_slist_free(bindings);
+}
+
+typedef struct {
+    GstPad *pad;
+    gulong handler_id;
+} CodecPoolPadHandler;
+
+static void codec_pool_disconnect_pad_handlers(gpointer data)
+{
+    GSList *handlers = data, *item;
+    CodecPoolPadHandler *handler;
+
+    for (item = handlers; item; item = item->next) {
+        handler = item->data;
+        if (g_signal_handler_is_connected(handler->pad, handler->handler_id))
+            g_signal_handler_disconnect(handler->pad, handler->handler_id);
+        gst_object_unref(handler->pad);
+        g_slice_free(CodecPoolPadHandler, handler);
+    }
+    g_slist_free(handlers);
+}
+
+/* Properties of the codec itself are put back to their defaults so that the
+ * next user does not inherit bitrates, keyframe or layering settings that it
+ * does not set explicitly. Properties of GstObject and GstElement (such as the
+ * name) are left alone. */
+static void codec_pool_reset_settings(GstElement *element)
+{
+    GParamSpec **pspecs, *pspec;
+    guint n_pspecs, i;
+    GValue current = G_VALUE_INIT, default_value = G_VALUE_INIT;
+
+    pspecs = g_object_class_list_properties(G_OBJECT_GET_CLASS(element), &n_pspecs);
+    for (i = 0; i < n_pspecs; i++) {
+        pspec = pspecs[i];
+        if (!(pspec->flags & G_PARAM_READABLE) || !(pspec->flags & G_PARAM_WRITABLE)
+            || (pspec->flags & G_PARAM_CONSTRUCT_ONLY)
+            || g_type_is_a(GST_TYPE_ELEMENT, pspec->owner_type))
+            continue;
+
+        g_value_init(&current, pspec->value_type);
+        g_value_init(&default_value, pspec->value_type);
+        g_object_get_property(G_OBJECT(element), pspec->name, &current);
+        g_param_value_set_default(pspec, &default_value);
+        if (g_param_values_cmp(pspec, &current, &default_value))
+            g_object_set_property(G_OBJECT(element), pspec->name, &default_value);
+        g_value_unset(&current);
+        g_value_unset(&default_value);
+    }
+    g_free(pspecs);
+}
+
+/**
+ * _owr_codec_pool_acquire:
+ * @role: whether an encoder or a decoder is wanted
+ * @codec_type: the codec the element should handle
+ *
+ * Returns: (transfer full): an idle element in READY state, or NULL if the
+ * pool has none for @codec_type and the caller has to create one.
+ */
+GstElement *_owr_codec_pool_acquire(OwrCodecPoolRole role, OwrCodecType codec_type)
+{
+    GstElement *element = NULL;
+    GQueue *idle;
+
+    G_LOCK(codec_pool);
+    if (codec_pool) {
+        idle = g_hash_table_lookup(codec_pool, CODEC_POOL_KEY(role, codec_type));
+        if (idle)
+            element = g_queue_pop_head(idle);
+    }
+    if (element)
+        codec_pool_hits++;
+    else
+        codec_pool_misses++;
+    G_UNLOCK(codec_pool);
+
+    if (element)
+        GST_DEBUG("Reusing pooled codec element %s", GST_OBJECT_NAME(element));
+
+    return element;
+}
+
+/**
+ * _owr_codec_pool_mark:
+ * @element: a newly created or acquired codec element
+ * @role: whether @element is an encoder or a decoder
+ * @codec_type: the codec @element handles
+ *
+ * Marks @element so that _owr_codec_pool_release() and
+ * _owr_codec_pool_release_from_bin() know where to put it back.
+ */
+void _owr_codec_pool_mark(GstElement *element, OwrCodecPoolRole role, OwrCodecType codec_type)
+{
+    g_return_if_fail(GST_IS_ELEMENT(element));
+
+    g_object_set_qdata(G_OBJECT(element), g_quark_from_static_string("owr-codec-pool-key"),
+        CODEC_POOL_KEY(role, codec_type));
+}
+
+/**
+ * _owr_codec_pool_add_binding:
+ * @element: a pooled codec element
+ * @binding: (transfer none): a binding targeting @element
+ *
+ * Remembers @binding so that it is removed when @element is returned to the
+ * pool, the next user of the element will bind its own payload.
+ */
+void _owr_codec_pool_add_binding(GstElement *element, GBinding *binding)
+{
+    GQuark quark = g_quark_from_static_string("owr-codec-pool-bindings");
+    GSList *bindings;
+    GWeakRef *ref;
+
+    g_return_if_fail(GST_IS_ELEMENT(element));
+    g_return_if_fail(G_IS_BINDING(binding));
+
+    bindings = g_object_steal_qdata(G_OBJECT(element), quark);
+    ref = g_slice_new0(GWeakRef);
+    g_weak_ref_init(ref, binding);
+    bindings = g_slist_prepend(bindings, ref);
+    g_object_set_qdata_full(G_OBJECT(element), quark, bindings, codec_pool_unbind);
+}
+
+/**
+ * _owr_codec_pool_add_pad_handler:
+ * @element: a pooled codec element
+ * @pad: (transfer none): a pad of @element
+ * @handler_id: a signal handler connected on @pad
+ *
+ * Remembers @handler_id so that it is disconnected when @element is returned
+ * to the pool. Handlers connected by anyone else are left in place.
+ */
+void _owr_codec_pool_add_pad_handler(GstElement *element, GstPad *pad, gulong handler_id)
+{
+    GQuark quark = g_quark_from_static_string("owr-codec-pool-pad-handlers");
+    GSList *handlers;
+    CodecPoolPadHandler *handler;
+
+    g_return_if_fail(GST_IS_ELEMENT(element));
+    g_return_if_fail(GST_IS_PAD(pad));
+    g_return_if_fail(handler_id);
+
+    handlers = g_object_steal_qdata(G_OBJECT(element), quark);
+    handler = g_slice_new0(CodecPoolPadHandler);
+    handler->pad = gst_object_ref(pad);
+    handler->handler_id = handler_id;
+    handlers = g_slist_prepend(handlers, handler);
+    g_object_set_qdata_full(G_OBJECT(element), quark, handlers, codec_pool_disconnect_pad_handlers);
+}
+
+/**
+ * _owr_codec_pool_release:
+ * @element: (transfer full): a codec element without a parent
+ *
+ * Drops the bindings and pad handlers of @element, resets its settings and
+ * puts it back in the pool in READY state. Elements that were not marked with
+ * _owr_codec_pool_mark(), that fail to go to READY or that exceed the number
+ * of idle elements kept per codec are destroyed.
+ */
+void _owr_codec_pool_release(GstElement *element)
+{
+    gpointer key;
+    GQueue *idle;
+    gboolean pooled = FALSE;
+
+    g_return_if_fail(GST_IS_ELEMENT(element));
+    g_return_if_fail(!GST_OBJECT_PARENT(element));
+
+    key = g_object_get_qdata(G_OBJECT(element), g_quark_from_static_string("owr-codec-pool-key"));
+
+    g_object_set_qdata(G_OBJECT(element), g_quark_from_static_string("owr-codec-pool-bindings"), NULL);
+    g_object_set_qdata(G_OBJECT(element), g_quark_from_static_string("owr-codec-pool-pad-handlers"), NULL);
+
+    if (key && gst_element_set_state(element, GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS) {
+        codec_pool_reset_settings(element);
+        G_LOCK(codec_pool);
+        if (!codec_pool)
+            codec_pool = g_hash_table_new(NULL, NULL);
+        idle = g_hash_table_lookup(codec_pool, key);
+        if (!idle) {
+            idle = g_queue_new();
+            g_hash_table_insert(codec_pool, key, idle);
+        }
+        if (g_queue_get_length(idle) < CODEC_POOL_MAX_IDLE_PER_KEY) {
+            /* Pooled elements behave like newly created ones when added
+             * to a bin */
+            if (!g_object_is_floating(element))
+                g_object_force_floating(G_OBJECT(element));
+            g_queue_push_tail(idle, element);
+            pooled = TRUE;
+            codec_pool_returned++;
+        } else
+            codec_pool_discarded++;
+        G_UNLOCK(codec_pool);
+    }
+
+    if (pooled) {
+        GST_DEBUG("Returned codec element %s to the pool", GST_OBJECT_NAME(element));
+        return;
+    }
+
+    gst_element_set_state(element, GST_STATE_NULL);
+    gst_object_unref(element);
+}
+
+/**
+ * _owr_codec_pool_release_from_bin:
+ * @bin: a bin that is about to be shut down
+ *
+ * Takes the pooled codec elements out of @bin, including the ones in nested
+ * bins, and returns them to the pool. Must be called before @bin is set to
+ * NULL so the elements never leave READY state.
+ */
+void _owr_codec_pool_release_from_bin(GstBin *bin)
+{
+    GQuark quark = g_quark_from_static_string("owr-codec-pool-key");
+    GList *elements = NULL, *item;
+    GstElement *element;
+    GstObject *parent;
+    GstIterator *iter;
+    GValue value = G_VALUE_INIT;
+    gboolean done = FALSE;
+
+    g_return_if_fail(GST_IS_BIN(bin));
+
+    iter = gst_bin_iterate_recurse(bin);
+    while (!done) {
+        switch (gst_iterator_next(iter, &value)) {
+        case GST_ITERATOR_OK:
+            element = g_value_get_object(&value);
+            if (g_object_get_qdata(G_OBJECT(element), quark))
+                elements = g_list_prepend(elements, gst_object_ref(element));
+            g_value_reset(&value);
+            break;
+        case GST_ITERATOR_RESYNC:
+            g_list_free_full(elements, gst_object_unref);
+            elements = NULL;
+            gst_iterator_resync(iter);
+            break;
+        default:
+            done = TRUE;
+            break;
+        }
+    }
+    g_value_unset(&value);
+    gst_iterator_free(iter);
+
+    for (item = elements; item; item = item->next) {
+        element = item->data;
+        gst_element_set_locked_state(element, TRUE);
+        gst_element_set_state(element, GST_STATE_READY);
+        parent = gst_element_get_parent(element);
+        if (parent) {
+            gst_bin_remove(GST_BIN(parent), element);
+            gst_object_unref(parent);
+        }
+        gst_element_set_locked_state(element, FALSE);
+        _owr_codec_pool_release(element);
+    }
+    g_list_free(elements);
+}
+
+/**
+ * _owr_codec_pool_get_stats:
+ *
+ * Returns: (transfer full): a value table with the number of pool hits,
+ * misses, returned and discarded elements, and the number of idle elements.
+ */
+GHashTable *_owr_codec_pool_get_stats(void)
+{
+    GHashTable *stats_table;
+    GHashTableIter iter;
+    gpointer idle;
+    guint idle_count = 0;
+    GValue *value;
+
+    stats_table = _owr_value_table_new();
+
+    G_LOCK(codec_pool);
+    if (codec_pool) {
+        g_hash_table_iter_init(&iter, codec_pool);
+        while (g_hash_table_iter_next(&iter, NULL, &idle))
+            idle_count += g_queue_get_length(idle);
+    }
+    value = _owr_value_table_add(stats_table, "hits", G_TYPE_UINT);
+    g_value_set_uint(value, codec_pool_hits);
+    value = _owr_value_table_add(stats_table, "misses", G_TYPE_UINT);
+    g_value_set_uint(value, codec_pool_misses);
+    value = _owr_value_table_add(stats_table, "returned", G_TYPE_UINT);
+    g_value_set_uint(value, codec_pool_returned);
+    value = _owr_value_table_add(stats_table, "discarded", G_TYPE_UINT);
+    g_value_set_uint(value, codec_pool_discarded);
+    G_UNLOCK(codec_pool);
+
+    value = _owr_value_table_add(stats_table, "idle", G_TYPE_UINT);
+    g_value_set_uint(value, idle_count);
+
+    return stats_table;
+}
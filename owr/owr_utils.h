@@ -41,6 +41,11 @@ G_BEGIN_DECLS
 
 #define _owr_codec_type_is_raw(codec_type) (codec_type == OWR_CODEC_TYPE_NONE)
 
+typedef enum {
+    OWR_CODEC_POOL_ENCODER,
+    OWR_CODEC_POOL_DECODER
+} OwrCodecPoolRole;
+
 void *_owr_require_symbols(void);
 guint _owr_get_unique_uint_id();
 OwrCodecType _owr_caps_to_codec_type(GstCaps *caps);
@@ -78,6 +83,14 @@ int _owr_rotation_and_mirror_to_video_flip_method(guint rotation, gboolean mirro
 GHashTable *_owr_value_table_new();
 GValue *_owr_value_table_add(GHashTable *table, const gchar *key, GType type);
 
+GstElement *_owr_codec_pool_acquire(OwrCodecPoolRole role, OwrCodecType codec_type);
+void _owr_codec_pool_mark(GstElement *element, OwrCodecPoolRole role, OwrCodecType codec_type);
+void _owr_codec_pool_add_binding(GstElement *element, GBinding *binding);
+void _owr_codec_pool_add_pad_handler(GstElement *element, GstPad *pad, gulong handler_id);
+void _owr_codec_pool_release(GstElement *element);
+void _owr_codec_pool_release_from_bin(GstBin *bin);
+GHashTable *_owr_codec_pool_get_stats(void);
+
 G_END_DECLS
 
 #endif /* __GTK_DOC_IGNORE__ */
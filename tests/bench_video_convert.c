@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Measures the cost per frame of the video conversion done for media source
+ * consumers (videoconvert + videoscale) for typical capture and send
+ * resolutions, with a single thread and with the threads available.
+ */
+
+#include <gst/gst.h>
+
+#include <stdlib.h>
+
+#define NUM_FRAMES 300
+
+typedef struct {
+    gint in_width, in_height;
+    gint out_width, out_height;
+} Resolution;
+
+static const Resolution resolutions[] = {
+    { 640, 480, 320, 240 },
+    { 1280, 720, 640, 360 },
+    { 1280, 720, 1280, 720 },
+    { 1920, 1080, 1280, 720 },
+    { 1920, 1080, 1920, 1080 },
+};
+
+static gdouble run_pipeline(const gchar *description)
+{
+    GstElement *pipeline;
+    GstMessage *message;
+    GError *error = NULL;
+    gint64 start_time, end_time;
+
+    pipeline = gst_parse_launch(description, &error);
+    if (!pipeline) {
+        g_print("failed to create pipeline: %s\n", error->message);
+        g_error_free(error);
+        exit(-1);
+    }
+
+    start_time = g_get_monotonic_time();
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    message = gst_bus_timed_pop_filtered(GST_ELEMENT_BUS(pipeline), GST_CLOCK_TIME_NONE,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    end_time = g_get_monotonic_time();
+
+    if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_ERROR) {
+        g_print("pipeline failed: %s\n", description);
+        exit(-1);
+    }
+
+    gst_message_unref(message);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    return (gdouble) (end_time - start_time) / NUM_FRAMES;
+}
+
+static gdouble measure(const Resolution *resolution, guint n_threads)
+{
+    gchar *description, *threads = NULL;
+    gdouble source_cost, total_cost;
+
+    /* The cost of producing the frames is measured separately and subtracted */
+    description = g_strdup_printf("videotestsrc num-buffers=%d ! "
+        "video/x-raw,format=YUY2,width=%d,height=%d ! fakesink sync=false",
+        NUM_FRAMES, resolution->in_width, resolution->in_height);
+    source_cost = run_pipeline(description);
+    g_free(description);
+
+    if (n_threads)
+        threads = g_strdup_printf("n-threads=%u", n_threads);
+    description = g_strdup_printf("videotestsrc num-buffers=%d ! "
+        "video/x-raw,format=YUY2,width=%d,height=%d ! "
+        "videoscale %s ! videoconvert %s ! "
+        "video/x-raw,format=I420,width=%d,height=%d ! fakesink sync=false",
+        NUM_FRAMES, resolution->in_width, resolution->in_height,
+        threads ? threads : "", threads ? threads : "",
+        resolution->out_width, resolution->out_height);
+    total_cost = run_pipeline(description);
+    g_free(description);
+    g_free(threads);
+
+    return MAX(total_cost - source_cost, 0.0);
+}
+
+int main(int argc, char **argv)
+{
+    GstElement *videoconvert;
+    gboolean has_threads;
+    guint num_processors, i;
+
+    gst_init(&argc, &argv);
+
+    videoconvert = gst_element_factory_make("videoconvert", NULL);
+    if (!videoconvert) {
+        g_print("videoconvert not available\n");
+        return -1;
+    }
+    has_threads = g_object_class_find_property(G_OBJECT_GET_CLASS(videoconvert), "n-threads") != NULL;
+    gst_object_unref(videoconvert);
+
+    num_processors = g_get_num_processors();
+    g_print("YUY2 -> I420 conversion cost per frame, %u processors\n", num_processors);
+    if (!has_threads)
+        g_print("videoconvert has no n-threads property, only measuring one thread\n");
+
+    for (i = 0; i < G_N_ELEMENTS(resolutions); i++) {
+        const Resolution *resolution = &resolutions[i];
+
+        g_print("  %4dx%-4d -> %4dx%-4d  1 thread: %8.1f us",
+            resolution->in_width, resolution->in_height,
+            resolution->out_width, resolution->out_height,
+            measure(resolution, has_threads ? 1 : 0));
+        if (has_threads && num_processors > 1)
+            g_print("  %u threads: %8.1f us", num_processors, measure(resolution, num_processors));
+        g_print("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * One agent receives video from a sender whose packets are held back at
+ * random by a probe on its nicesink, and audio from a clean sender. With
+ * adaptive-jitter-buffer on the latency of the jitterbuffers must:
+ *  - grow with the video jitter, but never beyond max-jitter-buffer-latency
+ *  - stay up while the target of the stopped video sender is still fresh
+ *  - come down once that target expired, by at most the decrease step at a
+ *    time
+ *  - go back to the configured jitter-buffer-latency of the media sessions
+ *    when adaptive-jitter-buffer is turned off
+ * The jitterbuffers and nicesinks are found through the element-added signal
+ * of GstBin.
+ */
+
+#include "owr.h"
+#include "owr_audio_payload.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#include <gst/gst.h>
+
+#define WAIT_TIMEOUT 30
+#define CONFIGURED_LATENCY 77
+#define MIN_LATENCY 20
+#define MAX_LATENCY 150
+#define DECREASE_STEP 10
+/* Less than the 15 s target timeout minus the longest RTCP interval */
+#define MIN_HOLD_TIME 8
+/* Larger than RTCP, ICE and audio packets, smaller than most video packets */
+#define MIN_VIDEO_PACKET_SIZE 300
+#define DELAY_INTERVAL 8
+#define MIN_DELAY 20
+#define MAX_DELAY 80
+
+static GMutex lock;
+static GSList *jitterbuffers = NULL;
+static volatile gint jittery = FALSE;
+static volatile gint video_packets = 0;
+static gboolean watch_decrease = FALSE;
+static gboolean decreased_too_fast = FALSE;
+static guint highest_latency = 0;
+
+static GstPadProbeReturn delay_video_packets(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    (void) pad;
+    (void) user_data;
+
+    if (g_atomic_int_get(&jittery) && (info->type & GST_PAD_PROBE_TYPE_BUFFER)
+        && gst_buffer_get_size(GST_PAD_PROBE_INFO_BUFFER(info)) >= MIN_VIDEO_PACKET_SIZE
+        && !(g_atomic_int_add(&video_packets, 1) % DELAY_INTERVAL))
+        g_usleep(g_random_int_range(MIN_DELAY, MAX_DELAY) * G_TIME_SPAN_MILLISECOND);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static void on_latency(GObject *jitterbuffer, GParamSpec *pspec, guint *last_latency)
+{
+    guint latency;
+
+    (void) pspec;
+
+    g_object_get(jitterbuffer, "latency", &latency, NULL);
+
+    g_mutex_lock(&lock);
+    if (watch_decrease && latency + DECREASE_STEP < *last_latency)
+        decreased_too_fast = TRUE;
+    if (watch_decrease)
+        highest_latency = MAX(highest_latency, latency);
+    *last_latency = latency;
+    g_mutex_unlock(&lock);
+}
+
+static gboolean on_element_added(GSignalInvocationHint *hint, guint n_param_values,
+    const GValue *param_values, gpointer user_data)
+{
+    GstElement *element;
+    GstElementFactory *factory;
+    const gchar *name;
+    GstPad *pad;
+
+    (void) hint;
+    (void) user_data;
+
+    if (n_param_values < 2)
+        return TRUE;
+
+    element = g_value_get_object(&param_values[1]);
+    factory = element ? gst_element_get_factory(element) : NULL;
+    if (!factory)
+        return TRUE;
+    name = gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory));
+
+    if (!g_strcmp0(name, "nicesink")) {
+        pad = gst_element_get_static_pad(element, "sink");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, delay_video_packets, NULL, NULL);
+        gst_object_unref(pad);
+    } else if (!g_strcmp0(name, "rtpjitterbuffer")) {
+        g_signal_connect_data(element, "notify::latency", G_CALLBACK(on_latency),
+            g_new0(guint, 1), (GClosureNotify) g_free, 0);
+        g_mutex_lock(&lock);
+        jitterbuffers = g_slist_prepend(jitterbuffers, gst_object_ref(element));
+        g_mutex_unlock(&lock);
+    }
+
+    return TRUE;
+}
+
+/* The agent gives all jitterbuffers the same latency, returns the
+ * highest or lowest of them. Jitterbuffers of timed out sources are taken
+ * out of rtpbin and not looked at. */
+static guint get_latency(gboolean highest)
+{
+    GSList *item;
+    GstObject *parent;
+    guint latency, result = highest ? 0 : G_MAXUINT;
+
+    g_mutex_lock(&lock);
+    for (item = jitterbuffers; item; item = item->next) {
+        parent = gst_object_get_parent(item->data);
+        if (!parent)
+            continue;
+        gst_object_unref(parent);
+        g_object_get(item->data, "latency", &latency, NULL);
+        result = highest ? MAX(result, latency) : MIN(result, latency);
+    }
+    g_mutex_unlock(&lock);
+
+    return result;
+}
+
+static gboolean wait_for_latency(gboolean at_least, guint value, guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+
+    while (at_least ? get_latency(TRUE) < value : get_latency(TRUE) >= value) {
+        if (g_get_monotonic_time() > end_time)
+            return FALSE;
+        g_usleep(100 * 1000);
+    }
+
+    return TRUE;
+}
+
+static OwrMediaSession *create_receive_session(OwrPayload *payload, TestReceiveStats *receive_stats)
+{
+    OwrMediaSession *media_session = owr_media_session_new(FALSE);
+
+    g_object_set(media_session, "jitter-buffer-latency", CONFIGURED_LATENCY, NULL);
+    owr_media_session_add_receive_payload(media_session, payload);
+    test_watch_receive_stats(media_session, receive_stats);
+
+    return media_session;
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *video_transport_agent, *audio_transport_agent, *recv_transport_agent;
+    OwrMediaSession *video_session, *audio_session, *recv_video_session, *recv_audio_session;
+    TestReceiveStats video_stats = { 0, 0 }, audio_stats = { 0, 0 };
+    OwrMediaSource *video_source, *audio_source;
+    OwrPayload *payload;
+    guint latency;
+    gboolean too_fast;
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    g_type_class_unref(g_type_class_ref(GST_TYPE_BIN));
+    g_signal_add_emission_hook(g_signal_lookup("element-added", GST_TYPE_BIN), 0,
+        on_element_added, NULL, NULL);
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    audio_source = test_get_capture_source(OWR_MEDIA_TYPE_AUDIO);
+    if (!video_source || !audio_source) {
+        g_print("No test sources\n");
+        return -1;
+    }
+
+    video_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(video_transport_agent, "127.0.0.1");
+    audio_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(audio_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+    g_object_set(recv_transport_agent, "adaptive-jitter-buffer", TRUE,
+        "min-jitter-buffer-latency", MIN_LATENCY, "max-jitter-buffer-latency", MAX_LATENCY, NULL);
+
+    video_session = owr_media_session_new(TRUE);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+    g_object_set(payload, "width", 640, "height", 480, "framerate", 30.0, NULL);
+    owr_media_session_set_send_payload(video_session, payload);
+    owr_media_session_set_send_source(video_session, video_source);
+    recv_video_session = create_receive_session(
+        owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE), &video_stats);
+
+    audio_session = owr_media_session_new(TRUE);
+    owr_media_session_set_send_payload(audio_session, owr_audio_payload_new(OWR_CODEC_TYPE_OPUS, 100, 48000, 1));
+    owr_media_session_set_send_source(audio_session, audio_source);
+    recv_audio_session = create_receive_session(
+        owr_audio_payload_new(OWR_CODEC_TYPE_OPUS, 100, 48000, 1), &audio_stats);
+
+    test_connect_sessions(OWR_SESSION(video_session), OWR_SESSION(recv_video_session));
+    test_connect_sessions(OWR_SESSION(audio_session), OWR_SESSION(recv_audio_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_video_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_audio_session));
+    owr_transport_agent_add_session(video_transport_agent, OWR_SESSION(video_session));
+    owr_transport_agent_add_session(audio_transport_agent, OWR_SESSION(audio_session));
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(video_transport_agent);
+    owr_transport_agent_start(audio_transport_agent);
+
+    if (!test_wait_for_packets(&video_stats, 0, WAIT_TIMEOUT)
+        || !test_wait_for_packets(&audio_stats, 0, WAIT_TIMEOUT)) {
+        g_print("Nothing was received\n");
+        return 1;
+    }
+
+    /* Grow, up to the maximum */
+    g_mutex_lock(&lock);
+    watch_decrease = TRUE;
+    g_mutex_unlock(&lock);
+    g_atomic_int_set(&jittery, TRUE);
+    if (!wait_for_latency(TRUE, MAX_LATENCY, WAIT_TIMEOUT)) {
+        g_print("The latency did not grow to %u ms with jitter, it is %u ms\n", MAX_LATENCY,
+            get_latency(TRUE));
+        failures++;
+    }
+
+    /* Hold while the video target is fresh, then shrink gradually */
+    owr_media_session_set_send_source(video_session, NULL);
+    g_atomic_int_set(&jittery, FALSE);
+    g_usleep(MIN_HOLD_TIME * G_USEC_PER_SEC);
+    latency = get_latency(TRUE);
+    if (latency < MAX_LATENCY) {
+        g_print("The latency dropped to %u ms before the video target expired\n", latency);
+        failures++;
+    }
+    if (!wait_for_latency(FALSE, MAX_LATENCY - DECREASE_STEP, 2 * WAIT_TIMEOUT)) {
+        g_print("The latency did not come down after the video target expired\n");
+        failures++;
+    }
+
+    g_mutex_lock(&lock);
+    watch_decrease = FALSE;
+    too_fast = decreased_too_fast;
+    latency = highest_latency;
+    g_mutex_unlock(&lock);
+    if (latency > MAX_LATENCY) {
+        g_print("The latency went up to %u ms, above the maximum\n", latency);
+        failures++;
+    }
+    if (too_fast) {
+        g_print("The latency came down by more than %u ms at once\n", DECREASE_STEP);
+        failures++;
+    }
+
+    /* Back to what the media sessions were configured with */
+    g_object_set(recv_transport_agent, "adaptive-jitter-buffer", FALSE, NULL);
+    if (get_latency(TRUE) != CONFIGURED_LATENCY || get_latency(FALSE) != CONFIGURED_LATENCY) {
+        g_print("The configured latency was not restored, %u..%u ms instead of %u ms\n",
+            get_latency(FALSE), get_latency(TRUE), CONFIGURED_LATENCY);
+        failures++;
+    }
+
+    g_print("\n%s\n", failures ? "FAILED" : "OK");
+
+    g_object_unref(video_source);
+    g_object_unref(audio_source);
+
+    return failures;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Receives Opus from one agent and sends the remote source on to a third
+ * agent with the same Opus payload. Nothing asks for raw audio, so the
+ * stream must reach the third agent without being decoded anywhere.
+ */
+
+#include "owr.h"
+#include "owr_audio_payload.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "test_utils.h"
+
+#define WAIT_TIMEOUT 20
+#define DECODER_TYPE "OpusDec"
+
+static GMutex lock;
+static GCond cond;
+static OwrMediaSource *remote_source = NULL;
+
+static OwrMediaSession *create_session(gboolean send)
+{
+    OwrMediaSession *media_session = owr_media_session_new(send);
+    OwrPayload *payload = owr_audio_payload_new(OWR_CODEC_TYPE_OPUS, 100, 48000, 1);
+
+    if (send)
+        owr_media_session_set_send_payload(media_session, payload);
+    else
+        owr_media_session_add_receive_payload(media_session, payload);
+
+    return media_session;
+}
+
+static void got_remote_source(OwrMediaSession *media_session, OwrMediaSource *source, gpointer user_data)
+{
+    (void) media_session;
+    (void) user_data;
+
+    g_mutex_lock(&lock);
+    if (!remote_source)
+        remote_source = g_object_ref(source);
+    g_cond_broadcast(&cond);
+    g_mutex_unlock(&lock);
+}
+
+static OwrMediaSource *wait_for_remote_source(guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+    OwrMediaSource *source;
+
+    g_mutex_lock(&lock);
+    while (!remote_source && g_cond_wait_until(&cond, &lock, end_time));
+    source = remote_source;
+    g_mutex_unlock(&lock);
+
+    return source;
+}
+
+static gboolean has_decoder(const gchar *name, gchar *dot_data)
+{
+    guint decoders = test_count_occurrences(dot_data, DECODER_TYPE);
+
+    g_free(dot_data);
+    if (decoders)
+        g_print("%s decodes the forwarded audio\n", name);
+
+    return decoders > 0;
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *send_transport_agent, *forward_transport_agent, *recv_transport_agent;
+    OwrMediaSession *send_session, *forwarded_session, *forward_session, *recv_session;
+    TestReceiveStats receive_stats = { 0, 0 };
+    OwrMediaSource *audio_source, *source;
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    audio_source = test_get_capture_source(OWR_MEDIA_TYPE_AUDIO);
+    if (!audio_source) {
+        g_print("No audio test source\n");
+        return -1;
+    }
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    forward_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(forward_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+
+    send_session = create_session(TRUE);
+    owr_media_session_set_send_source(send_session, audio_source);
+    forwarded_session = create_session(FALSE);
+    g_signal_connect(forwarded_session, "on-incoming-source", G_CALLBACK(got_remote_source), NULL);
+    test_connect_sessions(OWR_SESSION(send_session), OWR_SESSION(forwarded_session));
+    owr_transport_agent_add_session(forward_transport_agent, OWR_SESSION(forwarded_session));
+    owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_session));
+
+    forward_session = create_session(TRUE);
+    recv_session = create_session(FALSE);
+    test_watch_receive_stats(recv_session, &receive_stats);
+    test_connect_sessions(OWR_SESSION(forward_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(forward_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    source = wait_for_remote_source(WAIT_TIMEOUT);
+    if (!source) {
+        g_print("No remote audio source\n");
+        return 1;
+    }
+
+    owr_media_session_set_send_source(forward_session, source);
+    owr_transport_agent_add_session(forward_transport_agent, OWR_SESSION(forward_session));
+
+    if (!test_wait_for_packets(&receive_stats, 0, WAIT_TIMEOUT)) {
+        g_print("The forwarded audio was not received\n");
+        failures++;
+    }
+
+    failures += has_decoder("The remote source", owr_media_source_get_dot_data(source));
+    failures += has_decoder("The receiving agent", owr_transport_agent_get_dot_data(forward_transport_agent));
+    failures += has_decoder("The final agent", owr_transport_agent_get_dot_data(recv_transport_agent));
+
+    g_print("\n%s\n", failures ? "FAILED" : "OK");
+
+    g_object_unref(source);
+    g_object_unref(audio_source);
+
+    return failures;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Checks that encoders and decoders go back to the codec pool and are taken
+ * from it again: a second support probe and a second send session must be
+ * served from the pool without creating new elements.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_payload.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#define WAIT_TIMEOUT 20
+
+static OwrTransportAgent *send_transport_agent = NULL;
+static OwrTransportAgent *recv_transport_agent = NULL;
+static OwrMediaSource *video_source = NULL;
+
+typedef struct {
+    guint hits, misses, returned, idle;
+} PoolStats;
+
+static PoolStats get_pool_stats(void)
+{
+    GHashTable *stats = owr_get_codec_pool_stats();
+    PoolStats pool_stats;
+
+    pool_stats.hits = test_get_uint_stat(stats, "hits");
+    pool_stats.misses = test_get_uint_stat(stats, "misses");
+    pool_stats.returned = test_get_uint_stat(stats, "returned");
+    pool_stats.idle = test_get_uint_stat(stats, "idle");
+    g_hash_table_unref(stats);
+
+    return pool_stats;
+}
+
+/* owr_payload_supported() takes an encoder and a decoder and gives them
+ * back, so the second probe must find both in the pool */
+static gboolean test_probe_reuse(void)
+{
+    PoolStats before, after;
+
+    owr_payload_supported(OWR_CODEC_TYPE_VP8);
+    before = get_pool_stats();
+    owr_payload_supported(OWR_CODEC_TYPE_VP8);
+    after = get_pool_stats();
+
+    g_print("Second probe: %u hits, %u misses\n", after.hits - before.hits,
+        after.misses - before.misses);
+
+    return after.hits - before.hits == 2 && after.misses == before.misses
+        && after.idle == before.idle;
+}
+
+/* Sends until media arrives and removes the sessions again */
+static gboolean run_send_cycle(void)
+{
+    OwrMediaSession *send_session, *recv_session;
+    OwrPayload *payload;
+    TestReceiveStats receive_stats = { 0, 0 };
+    gboolean received;
+
+    send_session = owr_media_session_new(TRUE);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+    g_object_set(payload, "width", 320, "height", 240, "framerate", 15.0, NULL);
+    owr_media_session_set_send_payload(send_session, payload);
+    owr_media_session_set_send_source(send_session, video_source);
+
+    recv_session = owr_media_session_new(FALSE);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+    owr_media_session_add_receive_payload(recv_session, payload);
+    test_watch_receive_stats(recv_session, &receive_stats);
+
+    test_connect_sessions(OWR_SESSION(send_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_session));
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    received = test_wait_for_packets(&receive_stats, 0, WAIT_TIMEOUT);
+
+    g_signal_handlers_disconnect_by_data(recv_session, &receive_stats);
+    owr_transport_agent_remove_session(send_transport_agent, OWR_SESSION(send_session));
+    owr_transport_agent_remove_session(recv_transport_agent, OWR_SESSION(recv_session));
+    g_object_unref(send_session);
+    g_object_unref(recv_session);
+    test_sync_main_context(WAIT_TIMEOUT);
+
+    return received;
+}
+
+static gboolean test_session_reuse(void)
+{
+    PoolStats before, removed, after;
+
+    before = get_pool_stats();
+    if (!run_send_cycle()) {
+        g_print("First session received nothing\n");
+        return FALSE;
+    }
+    removed = get_pool_stats();
+    g_print("First session: %u elements returned\n", removed.returned - before.returned);
+    if (removed.returned == before.returned)
+        return FALSE;
+
+    if (!run_send_cycle()) {
+        g_print("Second session received nothing\n");
+        return FALSE;
+    }
+    after = get_pool_stats();
+    g_print("Second session: %u hits, %u misses\n", after.hits - removed.hits,
+        after.misses - removed.misses);
+
+    return after.hits > removed.hits && after.misses == removed.misses;
+}
+
+int main(int argc, char **argv)
+{
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+
+    failures += !test_probe_reuse();
+    failures += !test_session_reuse();
+
+    g_print("\n%d / 2 tests were successful\n", 2 - failures);
+
+    g_object_unref(video_source);
+
+    return failures;
+}
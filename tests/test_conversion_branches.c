@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Sends one raw video source to three peers, two of them at the same
+ * resolution. The source must convert once per distinct set of caps, so two
+ * conversion branches are expected, and both must go away with the last
+ * consumer.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#define WAIT_TIMEOUT 20
+#define SESSIONS 3
+#define EXPECTED_BRANCHES 2
+
+static const guint widths[SESSIONS] = { 640, 640, 320 };
+static const guint heights[SESSIONS] = { 480, 480, 240 };
+
+static guint count_branches(OwrMediaSource *source)
+{
+    gchar *dot_data = owr_media_source_get_dot_data(source);
+    guint count = test_count_occurrences(dot_data, "source-conversion-bin-");
+
+    g_free(dot_data);
+
+    return count;
+}
+
+/* The branches are removed from an idle probe on the source tee */
+static gboolean wait_for_branches(OwrMediaSource *source, guint expected, guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+
+    while (count_branches(source) != expected) {
+        if (g_get_monotonic_time() > end_time)
+            return FALSE;
+        g_usleep(100 * 1000);
+    }
+
+    return TRUE;
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *send_transport_agent, *recv_transport_agent;
+    OwrMediaSession *send_sessions[SESSIONS], *recv_sessions[SESSIONS];
+    TestReceiveStats receive_stats[SESSIONS];
+    OwrMediaSource *video_source;
+    OwrPayload *payload;
+    guint i, branches;
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+
+    for (i = 0; i < SESSIONS; i++) {
+        send_sessions[i] = owr_media_session_new(TRUE);
+        payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+        g_object_set(payload, "width", widths[i], "height", heights[i], "framerate", 30.0,
+            "shared-encoder", FALSE, NULL);
+        owr_media_session_set_send_payload(send_sessions[i], payload);
+        owr_media_session_set_send_source(send_sessions[i], video_source);
+
+        recv_sessions[i] = owr_media_session_new(FALSE);
+        payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+        owr_media_session_add_receive_payload(recv_sessions[i], payload);
+        receive_stats[i].packets_received = 0;
+        receive_stats[i].packets_lost = 0;
+        test_watch_receive_stats(recv_sessions[i], &receive_stats[i]);
+
+        test_connect_sessions(OWR_SESSION(send_sessions[i]), OWR_SESSION(recv_sessions[i]));
+        owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_sessions[i]));
+        owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_sessions[i]));
+    }
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    for (i = 0; i < SESSIONS; i++) {
+        if (!test_wait_for_packets(&receive_stats[i], 0, WAIT_TIMEOUT)) {
+            g_print("Peer %u (%ux%u) received nothing\n", i, widths[i], heights[i]);
+            failures++;
+        }
+    }
+
+    branches = count_branches(video_source);
+    g_print("%u conversion branches for %u consumers\n", branches, SESSIONS);
+    if (branches != EXPECTED_BRANCHES)
+        failures++;
+
+    for (i = 0; i < SESSIONS; i++) {
+        g_signal_handlers_disconnect_by_data(recv_sessions[i], &receive_stats[i]);
+        owr_transport_agent_remove_session(send_transport_agent, OWR_SESSION(send_sessions[i]));
+        owr_transport_agent_remove_session(recv_transport_agent, OWR_SESSION(recv_sessions[i]));
+        g_object_unref(send_sessions[i]);
+        g_object_unref(recv_sessions[i]);
+    }
+    test_sync_main_context(WAIT_TIMEOUT);
+
+    if (!wait_for_branches(video_source, 0, WAIT_TIMEOUT)) {
+        g_print("Conversion branches left after the last consumer went away\n");
+        failures++;
+    }
+
+    g_print("\n%s\n", failures ? "FAILED" : "OK");
+
+    g_object_unref(video_source);
+
+    return failures;
+}
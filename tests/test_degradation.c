@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Sends 640x480 video with degradation-preference maintain-framerate. At
+ * 200 kbps the encoder must get 320x240, half the resolution, and once the
+ * bitrate is back at 2 Mbps the full resolution again.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#define WAIT_TIMEOUT 20
+#define LOW_BITRATE 200000
+#define HIGH_BITRATE 2000000
+#define DEGRADED_WIDTH "width=(int)320"
+
+static OwrTransportAgent *send_transport_agent = NULL;
+
+static gboolean is_degraded(void)
+{
+    gchar *dot_data = owr_transport_agent_get_dot_data(send_transport_agent);
+    gboolean degraded = test_count_occurrences(dot_data, DEGRADED_WIDTH) > 0;
+
+    g_free(dot_data);
+
+    return degraded;
+}
+
+/* The capsfilter is updated right away but the new caps only show on the
+ * pads once the encoder has renegotiated */
+static gboolean wait_for_degraded(gboolean degraded, guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+
+    while (is_degraded() != degraded) {
+        if (g_get_monotonic_time() > end_time)
+            return FALSE;
+        g_usleep(100 * 1000);
+    }
+
+    return TRUE;
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *recv_transport_agent;
+    OwrMediaSession *send_session, *recv_session;
+    OwrMediaSource *video_source;
+    OwrPayload *send_payload, *payload;
+    TestReceiveStats receive_stats = { 0, 0 };
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+
+    send_session = owr_media_session_new(TRUE);
+    send_payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+    g_object_set(send_payload, "width", 640, "height", 480, "framerate", 30.0,
+        "bitrate", HIGH_BITRATE,
+        "degradation-preference", OWR_DEGRADATION_PREFERENCE_MAINTAIN_FRAMERATE, NULL);
+    g_object_ref(send_payload);
+    owr_media_session_set_send_payload(send_session, send_payload);
+    owr_media_session_set_send_source(send_session, video_source);
+
+    recv_session = owr_media_session_new(FALSE);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+    owr_media_session_add_receive_payload(recv_session, payload);
+    test_watch_receive_stats(recv_session, &receive_stats);
+
+    test_connect_sessions(OWR_SESSION(send_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_session));
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    if (!test_wait_for_packets(&receive_stats, 0, WAIT_TIMEOUT)) {
+        g_print("Nothing received\n");
+        return 1;
+    }
+    if (is_degraded()) {
+        g_print("Degraded at %u bps\n", HIGH_BITRATE);
+        failures++;
+    }
+
+    g_object_set(send_payload, "bitrate", LOW_BITRATE, NULL);
+    if (!wait_for_degraded(TRUE, WAIT_TIMEOUT)) {
+        g_print("Not degraded to 320x240 at %u bps\n", LOW_BITRATE);
+        failures++;
+    }
+    if (!test_wait_for_packets(&receive_stats, test_get_receive_stats(&receive_stats).packets_received,
+        WAIT_TIMEOUT)) {
+        g_print("Nothing received while degraded\n");
+        failures++;
+    }
+
+    g_object_set(send_payload, "bitrate", HIGH_BITRATE, NULL);
+    if (!wait_for_degraded(FALSE, WAIT_TIMEOUT)) {
+        g_print("Still degraded at %u bps\n", HIGH_BITRATE);
+        failures++;
+    }
+
+    g_print("\n%s\n", failures ? "FAILED" : "OK");
+
+    g_object_unref(send_payload);
+    g_object_unref(video_source);
+
+    return failures;
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Sends VP8 protected by RED/ULPFEC with adaptive-fec on over a link that
+ * loses every LOSS_INTERVAL-th media packet. The loss is made by a probe on
+ * the nicesinks, which the test finds through the element-added signal of
+ * GstBin. While the link is lossy, fec-percentage must ramp up from 0 and
+ * the receiving rtpulpfecdec must recover packets. Once the loss stops,
+ * fec-percentage must come down again, by at most FEC_DECREASE_STEP per
+ * report. There is no RTX, so FEC is the only way to recover.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#include <gst/gst.h>
+
+#define WAIT_TIMEOUT 20
+#define LOSS_INTERVAL 10
+/* Larger than RTCP and ICE packets, smaller than most video packets */
+#define MIN_MEDIA_PACKET_SIZE 300
+#define MIN_FEC_PERCENTAGE 5
+#define FEC_DECREASE_STEP 2
+#define RED_PAYLOAD_TYPE 116
+#define ULPFEC_PAYLOAD_TYPE 117
+
+static GMutex lock;
+static GCond cond;
+static GSList *fec_decoders = NULL;
+static volatile gint lossy = FALSE;
+static volatile gint media_packets = 0;
+static guint max_fec_percentage = 0;
+static guint last_fec_percentage = 0;
+static gboolean decreased_too_fast = FALSE;
+
+static gboolean should_drop(GstBuffer *buffer)
+{
+    if (!g_atomic_int_get(&lossy) || gst_buffer_get_size(buffer) < MIN_MEDIA_PACKET_SIZE)
+        return FALSE;
+
+    return !(g_atomic_int_add(&media_packets, 1) % LOSS_INTERVAL);
+}
+
+static gboolean drop_list_item(GstBuffer **buffer, guint idx, gpointer user_data)
+{
+    (void) idx;
+    (void) user_data;
+
+    if (should_drop(*buffer)) {
+        gst_buffer_unref(*buffer);
+        *buffer = NULL;
+    }
+
+    return TRUE;
+}
+
+static GstPadProbeReturn drop_media_packets(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    GstBufferList *list;
+
+    (void) pad;
+    (void) user_data;
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER)
+        return should_drop(GST_PAD_PROBE_INFO_BUFFER(info)) ? GST_PAD_PROBE_DROP : GST_PAD_PROBE_OK;
+
+    list = gst_buffer_list_make_writable(GST_PAD_PROBE_INFO_BUFFER_LIST(info));
+    GST_PAD_PROBE_INFO_DATA(info) = list;
+    gst_buffer_list_foreach(list, drop_list_item, NULL);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static gboolean on_element_added(GSignalInvocationHint *hint, guint n_param_values,
+    const GValue *param_values, gpointer user_data)
+{
+    GstElement *element;
+    GstElementFactory *factory;
+    const gchar *name;
+    GstPad *pad;
+
+    (void) hint;
+    (void) user_data;
+
+    if (n_param_values < 2)
+        return TRUE;
+
+    element = g_value_get_object(&param_values[1]);
+    factory = element ? gst_element_get_factory(element) : NULL;
+    if (!factory)
+        return TRUE;
+    name = gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory));
+
+    if (!g_strcmp0(name, "nicesink")) {
+        pad = gst_element_get_static_pad(element, "sink");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+            drop_media_packets, NULL, NULL);
+        gst_object_unref(pad);
+    } else if (!g_strcmp0(name, "rtpulpfecdec")) {
+        g_mutex_lock(&lock);
+        fec_decoders = g_slist_prepend(fec_decoders, gst_object_ref(element));
+        g_mutex_unlock(&lock);
+    }
+
+    return TRUE;
+}
+
+static void on_fec_percentage(OwrPayload *payload, GParamSpec *pspec, gpointer user_data)
+{
+    guint fec_percentage;
+
+    (void) pspec;
+    (void) user_data;
+
+    g_object_get(payload, "fec-percentage", &fec_percentage, NULL);
+
+    g_mutex_lock(&lock);
+    if (fec_percentage + FEC_DECREASE_STEP < last_fec_percentage)
+        decreased_too_fast = TRUE;
+    last_fec_percentage = fec_percentage;
+    max_fec_percentage = MAX(max_fec_percentage, fec_percentage);
+    g_cond_broadcast(&cond);
+    g_mutex_unlock(&lock);
+}
+
+static gboolean wait_for_fec_percentage(gboolean above, guint value, guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+    gboolean reached;
+
+    g_mutex_lock(&lock);
+    while (!(reached = above ? last_fec_percentage >= value : last_fec_percentage < value)
+        && g_cond_wait_until(&cond, &lock, end_time));
+    g_mutex_unlock(&lock);
+
+    return reached;
+}
+
+static guint get_recovered_packets(void)
+{
+    GSList *item;
+    guint recovered, total = 0;
+
+    g_mutex_lock(&lock);
+    for (item = fec_decoders; item; item = item->next) {
+        g_object_get(item->data, "recovered", &recovered, NULL);
+        total += recovered;
+    }
+    g_mutex_unlock(&lock);
+
+    return total;
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *send_transport_agent, *recv_transport_agent;
+    OwrMediaSession *send_session, *recv_session;
+    TestReceiveStats receive_stats = { 0, 0 };
+    OwrMediaSource *video_source;
+    OwrPayload *send_payload, *payload;
+    guint recovered, peak;
+    gboolean too_fast;
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    g_type_class_unref(g_type_class_ref(GST_TYPE_BIN));
+    g_signal_add_emission_hook(g_signal_lookup("element-added", GST_TYPE_BIN), 0,
+        on_element_added, NULL, NULL);
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+
+    send_session = owr_media_session_new(TRUE);
+    send_payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, TRUE);
+    g_object_set(send_payload, "width", 640, "height", 480, "framerate", 30.0,
+        "red-payload-type", RED_PAYLOAD_TYPE, "ulpfec-payload-type", ULPFEC_PAYLOAD_TYPE,
+        "adaptive-fec", TRUE, NULL);
+    g_signal_connect(send_payload, "notify::fec-percentage", G_CALLBACK(on_fec_percentage), NULL);
+    owr_media_session_set_send_payload(send_session, g_object_ref(send_payload));
+    owr_media_session_set_send_source(send_session, video_source);
+
+    recv_session = owr_media_session_new(FALSE);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, TRUE);
+    g_object_set(payload, "red-payload-type", RED_PAYLOAD_TYPE,
+        "ulpfec-payload-type", ULPFEC_PAYLOAD_TYPE, NULL);
+    owr_media_session_add_receive_payload(recv_session, payload);
+    test_watch_receive_stats(recv_session, &receive_stats);
+
+    test_connect_sessions(OWR_SESSION(send_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_session));
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    if (!test_wait_for_packets(&receive_stats, 0, WAIT_TIMEOUT)) {
+        g_print("Nothing was received\n");
+        return 1;
+    }
+
+    g_atomic_int_set(&lossy, TRUE);
+    if (!wait_for_fec_percentage(TRUE, MIN_FEC_PERCENTAGE, WAIT_TIMEOUT)) {
+        g_print("fec-percentage did not ramp up with %d%% loss\n", 100 / LOSS_INTERVAL);
+        failures++;
+    }
+    /* Give the raised protection time to cover some losses */
+    g_usleep(TEST_PHASE_DURATION * G_USEC_PER_SEC);
+    recovered = get_recovered_packets();
+    g_atomic_int_set(&lossy, FALSE);
+
+    g_mutex_lock(&lock);
+    peak = max_fec_percentage;
+    g_mutex_unlock(&lock);
+    g_print("fec-percentage reached %u%%, %u packets recovered\n", peak, recovered);
+    if (!recovered) {
+        g_print("No packet was recovered by ULPFEC\n");
+        failures++;
+    }
+
+    if (peak && !wait_for_fec_percentage(FALSE, peak, WAIT_TIMEOUT)) {
+        g_print("fec-percentage did not come down once the loss stopped\n");
+        failures++;
+    }
+    g_mutex_lock(&lock);
+    too_fast = decreased_too_fast;
+    g_mutex_unlock(&lock);
+    if (too_fast) {
+        g_print("fec-percentage dropped by more than %u%% in one report\n", FEC_DECREASE_STEP);
+        failures++;
+    }
+
+    g_print("\n%s\n", failures ? "FAILED" : "OK");
+
+    g_object_unref(send_payload);
+    g_object_unref(video_source);
+
+    return failures;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Two streams are sent to a middle agent, which forwards one of them at a
+ * time to a third agent with owr_media_session_set_forward_session(). The
+ * third agent must keep receiving when the forwarded stream is switched,
+ * without the jump in sequence numbers that restarting the forwarding would
+ * cause.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_media_source.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+/* Far less than the seqnum jump between two independent streams would be */
+#define MAX_PACKETS_LOST 100
+
+static OwrMediaSession *forwarded_sessions[2] = { NULL, };
+static OwrMediaSession *forward_session = NULL;
+
+static TestReceiveStats forwarded_stats[2];
+static TestReceiveStats recv_stats;
+
+static OwrMediaSession *create_session(gboolean send, TestReceiveStats *receive_stats)
+{
+    OwrMediaSession *media_session;
+    OwrPayload *payload;
+
+    /* The sending side is the DTLS client */
+    media_session = owr_media_session_new(send);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, TRUE);
+    if (send) {
+        g_object_set(payload, "width", 640, "height", 480, "framerate", 30.0, NULL);
+        owr_media_session_set_send_payload(media_session, payload);
+    } else {
+        owr_media_session_add_receive_payload(media_session, payload);
+    }
+    if (receive_stats)
+        test_watch_receive_stats(media_session, receive_stats);
+
+    return media_session;
+}
+
+/* Forwards one of the received streams, the receiver must keep seeing one
+ * continuous stream */
+static gboolean run_phase(guint index)
+{
+    TestReceiveStats before, after;
+
+    before = test_get_receive_stats(&recv_stats);
+    owr_media_session_set_forward_session(forward_session, forwarded_sessions[index]);
+
+    g_usleep(TEST_PHASE_DURATION * G_USEC_PER_SEC);
+
+    test_wait_for_packets(&recv_stats, before.packets_received, TEST_PHASE_DURATION);
+    after = test_get_receive_stats(&recv_stats);
+
+    g_print("Forwarding stream %u: %" G_GUINT64_FORMAT " packets, %d lost\n", index,
+        after.packets_received - before.packets_received, after.packets_lost - before.packets_lost);
+
+    return after.packets_received > before.packets_received
+        && ABS(after.packets_lost - before.packets_lost) < MAX_PACKETS_LOST;
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *send_transport_agent, *forward_transport_agent, *recv_transport_agent;
+    OwrMediaSession *send_sessions[2], *recv_session;
+    OwrMediaSource *source;
+    gint failures = 0;
+    guint i;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!source) {
+        g_print("No video test source\n");
+        return 1;
+    }
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    /* Controlled towards the senders and controlling towards the receiver is
+     * not possible for one agent, so the receiver controls */
+    forward_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(forward_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+
+    for (i = 0; i < 2; i++) {
+        send_sessions[i] = create_session(TRUE, NULL);
+        forwarded_sessions[i] = create_session(FALSE, &forwarded_stats[i]);
+        test_connect_sessions(OWR_SESSION(send_sessions[i]), OWR_SESSION(forwarded_sessions[i]));
+        owr_media_session_set_send_source(send_sessions[i], source);
+        owr_transport_agent_add_session(forward_transport_agent, OWR_SESSION(forwarded_sessions[i]));
+        owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_sessions[i]));
+    }
+    forward_session = create_session(TRUE, NULL);
+    recv_session = create_session(FALSE, &recv_stats);
+    test_connect_sessions(OWR_SESSION(forward_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(forward_transport_agent, OWR_SESSION(forward_session));
+
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(forward_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    for (i = 0; i < 2; i++) {
+        if (!test_wait_for_packets(&forwarded_stats[i], 0, 20)) {
+            g_print("Stream %u was not received\n", i);
+            return 1;
+        }
+    }
+
+    failures += !run_phase(0);
+    failures += !run_phase(1);
+    failures += !run_phase(0);
+
+    owr_media_session_set_forward_session(forward_session, NULL);
+    g_object_unref(source);
+
+    g_print("\n%d / 3 phases were successful\n", 3 - failures);
+
+    return failures;
+}
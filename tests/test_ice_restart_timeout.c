@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * The receiving agent has an ICE restart timeout. When the sender stops,
+ * nothing arrives on the selected pair any more and the agent must restart
+ * ICE on its own and emit on-ice-restart. The test then does the signalling
+ * an application has to do, restarting ICE on the peer, and media must flow
+ * again once the sender is back.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#define WAIT_TIMEOUT 20
+#define ICE_RESTART_TIMEOUT 1000
+
+static GMutex lock;
+static GCond cond;
+static gboolean ice_restarted = FALSE;
+
+static void on_ice_restart(OwrSession *session, OwrSession *peer_session)
+{
+    (void) session;
+
+    /* What signalling would do: the peer restarts with the new credentials */
+    owr_session_restart_ice(peer_session);
+
+    g_mutex_lock(&lock);
+    ice_restarted = TRUE;
+    g_cond_broadcast(&cond);
+    g_mutex_unlock(&lock);
+}
+
+static gboolean wait_for_ice_restart(guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+    gboolean restarted;
+
+    g_mutex_lock(&lock);
+    while (!ice_restarted && g_cond_wait_until(&cond, &lock, end_time));
+    restarted = ice_restarted;
+    g_mutex_unlock(&lock);
+
+    return restarted;
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *send_transport_agent, *recv_transport_agent;
+    OwrMediaSession *send_session, *recv_session;
+    TestReceiveStats receive_stats = { 0, 0 }, before;
+    OwrMediaSource *video_source;
+    OwrPayload *payload;
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+    g_object_set(recv_transport_agent, "ice-restart-timeout", ICE_RESTART_TIMEOUT, NULL);
+
+    send_session = owr_media_session_new(TRUE);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+    g_object_set(payload, "width", 320, "height", 240, "framerate", 30.0, NULL);
+    owr_media_session_set_send_payload(send_session, payload);
+    owr_media_session_set_send_source(send_session, video_source);
+
+    recv_session = owr_media_session_new(FALSE);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+    owr_media_session_add_receive_payload(recv_session, payload);
+    test_watch_receive_stats(recv_session, &receive_stats);
+    g_signal_connect(recv_session, "on-ice-restart", G_CALLBACK(on_ice_restart), send_session);
+
+    test_connect_sessions(OWR_SESSION(send_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_session));
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    if (!test_wait_for_packets(&receive_stats, 0, WAIT_TIMEOUT)) {
+        g_print("Nothing was received\n");
+        return 1;
+    }
+
+    /* Only sparse RTCP is left on the pair, far less often than the
+     * timeout */
+    owr_media_session_set_send_source(send_session, NULL);
+    if (!wait_for_ice_restart(WAIT_TIMEOUT)) {
+        g_print("ICE was not restarted after the sender stopped\n");
+        failures++;
+    }
+
+    before = test_get_receive_stats(&receive_stats);
+    owr_media_session_set_send_source(send_session, video_source);
+    if (!test_wait_for_connected(OWR_SESSION(send_session), OWR_SESSION(recv_session), WAIT_TIMEOUT)) {
+        g_print("The sessions did not connect again after the restart\n");
+        failures++;
+    } else if (!test_wait_for_packets(&receive_stats, before.packets_received, WAIT_TIMEOUT)) {
+        g_print("Nothing was received after the restart\n");
+        failures++;
+    }
+
+    g_print("\n%s\n", failures ? "FAILED" : "OK");
+
+    g_object_unref(video_source);
+
+    return failures;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Connects one pair of agents with ice-tcp on and one with it off, and
+ * counts the sockets each pair opens. Without TCP candidates the agents
+ * must use fewer sockets. Linux only, the sockets are counted in
+ * /proc/self/fd.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#define WAIT_TIMEOUT 20
+#define FD_DIR "/proc/self/fd"
+
+static gint count_sockets(void)
+{
+    GDir *dir;
+    const gchar *name;
+    gchar *path, *target;
+    gint count = 0;
+
+    dir = g_dir_open(FD_DIR, 0, NULL);
+    if (!dir)
+        return -1;
+
+    while ((name = g_dir_read_name(dir))) {
+        path = g_build_filename(FD_DIR, name, NULL);
+        target = g_file_read_link(path, NULL);
+        if (target && g_str_has_prefix(target, "socket:"))
+            count++;
+        g_free(target);
+        g_free(path);
+    }
+    g_dir_close(dir);
+
+    return count;
+}
+
+static OwrTransportAgent *create_agent(gboolean ice_controlling_mode, gboolean ice_tcp)
+{
+    OwrTransportAgent *transport_agent;
+
+    transport_agent = g_object_new(OWR_TYPE_TRANSPORT_AGENT,
+        "ice-controlling-mode", ice_controlling_mode,
+        "bundle-policy", OWR_BUNDLE_POLICY_TYPE_BALANCED,
+        "ice-tcp", ice_tcp, NULL);
+    owr_transport_agent_add_local_address(transport_agent, "127.0.0.1");
+
+    return transport_agent;
+}
+
+/* Returns the number of sockets a connected pair of agents added, or -1 */
+static gint connect_pair(gboolean ice_tcp)
+{
+    OwrTransportAgent *send_transport_agent, *recv_transport_agent;
+    OwrMediaSession *send_session, *recv_session;
+    gint sockets_before, sockets_after;
+
+    sockets_before = count_sockets();
+
+    send_transport_agent = create_agent(TRUE, ice_tcp);
+    recv_transport_agent = create_agent(FALSE, ice_tcp);
+
+    send_session = owr_media_session_new(TRUE);
+    owr_media_session_set_send_payload(send_session,
+        owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE));
+    recv_session = owr_media_session_new(FALSE);
+    owr_media_session_add_receive_payload(recv_session,
+        owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE));
+
+    test_connect_sessions(OWR_SESSION(send_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_session));
+
+    if (!test_wait_for_connected(OWR_SESSION(send_session), OWR_SESSION(recv_session), WAIT_TIMEOUT)) {
+        g_print("ice-tcp=%d: the sessions did not connect\n", ice_tcp);
+        return -1;
+    }
+
+    /* The agents are kept alive so that their sockets stay open while the
+     * other pair is counted */
+    sockets_after = count_sockets();
+    g_print("ice-tcp=%d: %d sockets\n", ice_tcp, sockets_after - sockets_before);
+
+    return sockets_after - sockets_before;
+}
+
+int main(int argc, char **argv)
+{
+    gint tcp_sockets, udp_sockets;
+
+    (void) argc;
+    (void) argv;
+
+    if (count_sockets() < 0) {
+        g_print("Cannot count sockets without " FD_DIR ", skipping\n");
+        return 0;
+    }
+
+    owr_init(NULL);
+    owr_run_in_background();
+
+    tcp_sockets = connect_pair(TRUE);
+    udp_sockets = connect_pair(FALSE);
+    if (tcp_sockets < 0 || udp_sockets < 0)
+        return 1;
+
+    if (udp_sockets >= tcp_sockets) {
+        g_print("\nFAILED: turning ice-tcp off did not save any socket\n");
+        return 1;
+    }
+
+    g_print("\nOK\n");
+
+    return 0;
+}
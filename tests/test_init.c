@@ -24,6 +24,7 @@
  */
 
 #include "owr.h"
+#include "owr_bus.h"
 
 #include <stdlib.h>
 
@@ -31,6 +32,7 @@ static GCond timeout_thread_cond;
 static GMutex timeout_thread_mutex;
 static gboolean done = FALSE;
 static gchar *expected_log_string;
+static volatile gint init_stats_received = 0;
 
 void expect_assert(const gchar *function, const gchar* assertion)
 {
@@ -132,8 +134,36 @@ void log_handler(const gchar *log_domain, GLogLevelFlags log_level, const gchar
     }
 }
 
+static void print_init_stats(GHashTable *stats)
+{
+    GHashTableIter iter;
+    const gchar *name;
+    GValue *value;
+
+    g_hash_table_iter_init(&iter, stats);
+    while (g_hash_table_iter_next(&iter, (gpointer *) &name, (gpointer *) &value)) {
+        if (g_str_has_suffix(name, "_duration"))
+            g_print("  %-30s %8" G_GINT64_FORMAT " us\n", name, g_value_get_int64(value));
+    }
+}
+
+static void on_bus_message(OwrMessageOrigin *origin, OwrMessageType type, OwrMessageSubType sub_type, GHashTable *data, gpointer user_data)
+{
+    (void) origin;
+    (void) user_data;
+
+    if (type == OWR_MESSAGE_TYPE_STATS && sub_type == OWR_STATS_TYPE_INIT) {
+        g_print("received init stats message\n");
+        print_init_stats(data);
+        g_atomic_int_inc(&init_stats_received);
+    }
+}
+
 int main()
 {
+    OwrBus *bus;
+    GHashTable *init_stats;
+
     g_log_set_handler(NULL, G_LOG_LEVEL_CRITICAL | G_LOG_FLAG_FATAL, log_handler, NULL);
     g_print("first we make sure that run and quit doesn't work before owr_init");
 
@@ -149,6 +179,17 @@ int main()
     g_print("calling owr_init\n");
     owr_init(NULL);
 
+    init_stats = owr_get_init_stats();
+    g_print("owr_init took %" G_GINT64_FORMAT " us:\n",
+        g_value_get_int64(g_hash_table_lookup(init_stats, "end_time"))
+        - g_value_get_int64(g_hash_table_lookup(init_stats, "start_time")));
+    print_init_stats(init_stats);
+    g_hash_table_unref(init_stats);
+
+    bus = owr_bus_new();
+    owr_bus_set_message_callback(bus, on_bus_message, NULL, NULL);
+    owr_bus_add_message_origin(bus, owr_get_message_origin());
+
     start_timeout_thread();
     g_print("running mainloop for 100ms\n");
     quit_mainloop_after(100);
@@ -156,6 +197,12 @@ int main()
     g_print("mainloop quit successfully\n");
     stop_timeout_thread();
 
+    g_object_unref(bus);
+    if (g_atomic_int_get(&init_stats_received) != 1) {
+        g_print("** ERROR ** expected exactly one init stats message\n");
+        return -1;
+    }
+
     start_timeout_thread();
     g_print("running mainloop in background for 100ms\n");
     quit_mainloop_after(100);
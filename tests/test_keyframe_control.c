@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Sends a burst of keyframe requests to a VP8 send stream, the way a
+ * receiver asking for PLI/FIR would, and checks with the keyframe-requests
+ * and keyframes-produced properties of the payload that every request was
+ * seen but the encoder only produced one keyframe per
+ * min-keyframe-interval. The requests are sent from the payloader, which
+ * the test finds through the element-added signal of GstBin.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#include <gst/gst.h>
+#include <gst/video/video.h>
+
+#define WAIT_TIMEOUT 20
+#define MIN_KEYFRAME_INTERVAL 1000
+#define BURST_DURATION 3000
+#define BURST_REQUEST_INTERVAL 50
+#define PAYLOADER_NAME "rtpvp8pay"
+
+static GMutex lock;
+static GstElement *payloader = NULL;
+
+static gboolean on_element_added(GSignalInvocationHint *hint, guint n_param_values,
+    const GValue *param_values, gpointer user_data)
+{
+    GstElement *element;
+    GstElementFactory *factory;
+
+    (void) hint;
+    (void) user_data;
+
+    if (n_param_values < 2)
+        return TRUE;
+
+    element = g_value_get_object(&param_values[1]);
+    factory = element ? gst_element_get_factory(element) : NULL;
+    if (!factory || g_strcmp0(gst_plugin_feature_get_name(GST_PLUGIN_FEATURE(factory)), PAYLOADER_NAME))
+        return TRUE;
+
+    g_mutex_lock(&lock);
+    if (!payloader)
+        payloader = gst_object_ref(element);
+    g_mutex_unlock(&lock);
+
+    return TRUE;
+}
+
+static GstElement *get_payloader(void)
+{
+    GstElement *element;
+
+    g_mutex_lock(&lock);
+    element = payloader ? gst_object_ref(payloader) : NULL;
+    g_mutex_unlock(&lock);
+
+    return element;
+}
+
+static void get_keyframe_counts(OwrPayload *payload, guint *requests, guint *produced)
+{
+    g_object_get(payload, "keyframe-requests", requests, "keyframes-produced", produced, NULL);
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *send_transport_agent, *recv_transport_agent;
+    OwrMediaSession *send_session, *recv_session;
+    TestReceiveStats receive_stats = { 0, 0 };
+    OwrMediaSource *video_source;
+    OwrPayload *send_payload, *payload;
+    GstElement *element;
+    GstPad *sink_pad;
+    guint requests_before, requests_after, produced_before, produced_after, sent = 0;
+    guint max_keyframes;
+    gint64 end_time;
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    g_type_class_unref(g_type_class_ref(GST_TYPE_BIN));
+    g_signal_add_emission_hook(g_signal_lookup("element-added", GST_TYPE_BIN), 0,
+        on_element_added, NULL, NULL);
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+
+    send_session = owr_media_session_new(TRUE);
+    send_payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, TRUE);
+    g_object_set(send_payload, "width", 320, "height", 240, "framerate", 30.0,
+        "shared-encoder", FALSE, "min-keyframe-interval", MIN_KEYFRAME_INTERVAL, NULL);
+    owr_media_session_set_send_payload(send_session, g_object_ref(send_payload));
+    owr_media_session_set_send_source(send_session, video_source);
+
+    recv_session = owr_media_session_new(FALSE);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, TRUE);
+    owr_media_session_add_receive_payload(recv_session, payload);
+    test_watch_receive_stats(recv_session, &receive_stats);
+
+    test_connect_sessions(OWR_SESSION(send_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_session));
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    if (!test_wait_for_packets(&receive_stats, 0, WAIT_TIMEOUT)) {
+        g_print("Nothing was received\n");
+        return 1;
+    }
+    element = get_payloader();
+    if (!element) {
+        g_print("No " PAYLOADER_NAME " was added\n");
+        return 1;
+    }
+    sink_pad = gst_element_get_static_pad(element, "sink");
+
+    /* Let the keyframes of the stream start pass */
+    g_usleep(2 * MIN_KEYFRAME_INTERVAL * G_TIME_SPAN_MILLISECOND);
+    get_keyframe_counts(send_payload, &requests_before, &produced_before);
+
+    end_time = g_get_monotonic_time() + BURST_DURATION * G_TIME_SPAN_MILLISECOND;
+    while (g_get_monotonic_time() < end_time) {
+        gst_pad_push_event(sink_pad, gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE,
+            FALSE, 0));
+        sent++;
+        g_usleep(BURST_REQUEST_INTERVAL * G_TIME_SPAN_MILLISECOND);
+    }
+
+    /* The requests merged at the end of the burst are still due */
+    g_usleep(2 * MIN_KEYFRAME_INTERVAL * G_TIME_SPAN_MILLISECOND);
+    get_keyframe_counts(send_payload, &requests_after, &produced_after);
+
+    /* One keyframe per interval of the burst, and one for the requests
+     * merged at its end */
+    max_keyframes = BURST_DURATION / MIN_KEYFRAME_INTERVAL + 1;
+    g_print("%u requests sent, %u seen, %u keyframes produced (at most %u expected)\n", sent,
+        requests_after - requests_before, produced_after - produced_before, max_keyframes);
+
+    if (requests_after - requests_before < sent) {
+        g_print("Not every request was counted\n");
+        failures++;
+    }
+    if (produced_after - produced_before < 2) {
+        g_print("The requests did not produce keyframes\n");
+        failures++;
+    }
+    if (produced_after - produced_before > max_keyframes) {
+        g_print("The requests were not limited to one keyframe per interval\n");
+        failures++;
+    }
+
+    g_print("\n%s\n", failures ? "FAILED" : "OK");
+
+    gst_object_unref(sink_pad);
+    gst_object_unref(element);
+    g_object_unref(send_payload);
+    g_object_unref(video_source);
+
+    return failures;
+}
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Adds and removes sessions on two running transport agents. Media sessions
+ * send video from a test source, so that the send path, the encoder and the
+ * rtpbin request pads are set up, and everything has to be gone again after
+ * owr_transport_agent_remove_session(). Memory use has to stay flat over the
+ * cycles after the first ones.
+ */
+
+#include "owr.h"
+#include "owr_audio_payload.h"
+#include "owr_data_session.h"
+#include "owr_media_session.h"
+#include "owr_media_source.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define WAIT_TIMEOUT 10
+/* One media and one data cycle to let caches and pools settle */
+#define WARMUP_CYCLES 2
+
+static gint cycles = 6;
+static gint max_growth = 1024;
+
+static GOptionEntry entries[] = {
+    { "cycles", 'c', 0, G_OPTION_ARG_INT, &cycles, "Number of add/remove cycles", NULL },
+    { "max-growth", 'm', 0, G_OPTION_ARG_INT, &max_growth,
+        "Allowed resident memory growth per cycle after warmup in KiB", NULL },
+    { NULL, }
+};
+
+/* Request pads of rtpbin, named the same in the dot output of every version */
+static const gchar *pad_names[] = {
+    "send_rtp_sink_", "send_rtp_src_", "send_rtcp_src_", "recv_rtp_sink_", "recv_rtcp_sink_", NULL
+};
+
+static OwrTransportAgent *left_transport_agent = NULL;
+static OwrTransportAgent *right_transport_agent = NULL;
+static OwrMediaSource *video_source = NULL;
+
+static GMutex lock;
+static GCond cond;
+static gint finalized_sessions = 0;
+
+static void on_session_finalized(gpointer data, GObject *where_the_object_was)
+{
+    (void) data;
+    (void) where_the_object_was;
+
+    g_mutex_lock(&lock);
+    finalized_sessions++;
+    g_cond_broadcast(&cond);
+    g_mutex_unlock(&lock);
+}
+
+/* Every element and bin shows up as one cluster in the dot output */
+static guint count_elements(OwrTransportAgent *transport_agent)
+{
+    gchar *dot_data = owr_transport_agent_get_dot_data(transport_agent);
+    guint count = test_count_occurrences(dot_data, "subgraph cluster_");
+
+    g_free(dot_data);
+
+    return count;
+}
+
+static guint count_pads(OwrTransportAgent *transport_agent)
+{
+    gchar *dot_data = owr_transport_agent_get_dot_data(transport_agent);
+    guint i, count = 0;
+
+    for (i = 0; pad_names[i]; i++)
+        count += test_count_occurrences(dot_data, pad_names[i]);
+    g_free(dot_data);
+
+    return count;
+}
+
+static guint get_resident_kib(void)
+{
+    gchar *status = NULL, *line;
+    guint resident = 0;
+
+    if (!g_file_get_contents("/proc/self/status", &status, NULL, NULL))
+        return 0;
+    line = strstr(status, "VmRSS:");
+    if (line)
+        sscanf(line, "VmRSS: %u", &resident);
+    g_free(status);
+
+    return resident;
+}
+
+static OwrSession *create_session(gboolean media, gboolean send)
+{
+    OwrSession *session;
+    OwrPayload *payload;
+
+    if (!media) {
+        session = OWR_SESSION(owr_data_session_new(send));
+        g_object_set(session, "sctp-local-port", 5000, "sctp-remote-port", 5000, NULL);
+    } else {
+        session = OWR_SESSION(owr_media_session_new(send));
+        if (send) {
+            payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+            g_object_set(payload, "width", 320, "height", 240, "framerate", 15.0, NULL);
+            owr_media_session_set_send_payload(OWR_MEDIA_SESSION(session), payload);
+            owr_media_session_set_send_source(OWR_MEDIA_SESSION(session), video_source);
+        } else {
+            payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+            owr_media_session_add_receive_payload(OWR_MEDIA_SESSION(session), payload);
+            payload = owr_audio_payload_new(OWR_CODEC_TYPE_OPUS, 100, 48000, 1);
+            owr_media_session_add_receive_payload(OWR_MEDIA_SESSION(session), payload);
+        }
+    }
+    g_object_weak_ref(G_OBJECT(session), on_session_finalized, NULL);
+
+    return session;
+}
+
+static gboolean wait_for_finalized_sessions(gint expected)
+{
+    gint64 end_time = g_get_monotonic_time() + WAIT_TIMEOUT * G_TIME_SPAN_SECOND;
+    gboolean finalized;
+
+    g_mutex_lock(&lock);
+    while (finalized_sessions < expected && g_cond_wait_until(&cond, &lock, end_time));
+    finalized = finalized_sessions == expected;
+    g_mutex_unlock(&lock);
+
+    return finalized;
+}
+
+static gboolean run_cycle(gint cycle, gboolean media, guint left_baseline, guint right_baseline)
+{
+    OwrSession *left_session, *right_session;
+    guint left_elements, right_elements, left_pads, right_pads;
+    gboolean ok = TRUE;
+
+    left_session = create_session(media, TRUE);
+    right_session = create_session(media, FALSE);
+
+    test_connect_sessions(left_session, right_session);
+
+    owr_transport_agent_add_session(left_transport_agent, left_session);
+    owr_transport_agent_add_session(right_transport_agent, right_session);
+    /* The first sessions start the agents, later ones are added right away */
+    owr_transport_agent_start(left_transport_agent);
+    owr_transport_agent_start(right_transport_agent);
+
+    if (!test_wait_for_connected(left_session, right_session, WAIT_TIMEOUT)) {
+        g_print("[%d] ICE did not connect\n", cycle);
+        ok = FALSE;
+    }
+
+    if (count_elements(left_transport_agent) <= left_baseline) {
+        g_print("[%d] session elements were never added\n", cycle);
+        ok = FALSE;
+    }
+    if (media && !count_pads(left_transport_agent)) {
+        g_print("[%d] rtpbin pads were never requested\n", cycle);
+        ok = FALSE;
+    }
+
+    g_signal_handlers_disconnect_by_data(left_session, right_session);
+    g_signal_handlers_disconnect_by_data(right_session, left_session);
+
+    owr_transport_agent_remove_session(left_transport_agent, left_session);
+    owr_transport_agent_remove_session(right_transport_agent, right_session);
+    g_object_unref(left_session);
+    g_object_unref(right_session);
+
+    if (!wait_for_finalized_sessions(2 * (cycle + 1))) {
+        g_print("[%d] sessions were not finalized\n", cycle);
+        ok = FALSE;
+    }
+    /* The removal of the session elements is scheduled on the main context */
+    if (!test_sync_main_context(WAIT_TIMEOUT)) {
+        g_print("[%d] main context did not run\n", cycle);
+        ok = FALSE;
+    }
+
+    left_elements = count_elements(left_transport_agent);
+    right_elements = count_elements(right_transport_agent);
+    if (left_elements != left_baseline || right_elements != right_baseline) {
+        g_print("[%d] element count is %u / %u, expected %u / %u\n", cycle,
+            left_elements, right_elements, left_baseline, right_baseline);
+        ok = FALSE;
+    }
+
+    left_pads = count_pads(left_transport_agent);
+    right_pads = count_pads(right_transport_agent);
+    if (left_pads || right_pads) {
+        g_print("[%d] %u / %u rtpbin request pads were not released\n", cycle, left_pads, right_pads);
+        ok = FALSE;
+    }
+
+    g_print("[%d] %s session cycle %s (%u KiB resident)\n", cycle, media ? "media" : "data",
+        ok ? "passed" : "failed", get_resident_kib());
+
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    GOptionContext *options;
+    GError *error = NULL;
+    guint left_baseline, right_baseline, warm_resident = 0, resident, growth;
+    gint i, failures = 0;
+    gboolean leaking = FALSE;
+
+    options = g_option_context_new(NULL);
+    g_option_context_add_main_entries(options, entries, NULL);
+    if (!g_option_context_parse(options, &argc, &argv, &error)) {
+        g_print("Failed to parse options: %s\n", error->message);
+        return -2;
+    }
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+
+    left_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(left_transport_agent, "127.0.0.1");
+    right_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(right_transport_agent, "127.0.0.1");
+
+    left_baseline = count_elements(left_transport_agent);
+    right_baseline = count_elements(right_transport_agent);
+    g_print("Baseline element count: %u / %u\n", left_baseline, right_baseline);
+
+    for (i = 0; i < cycles; i++) {
+        failures += !run_cycle(i, i % 2 == 0, left_baseline, right_baseline);
+        if (i == WARMUP_CYCLES - 1)
+            warm_resident = get_resident_kib();
+    }
+
+    /* Without /proc there is nothing to compare */
+    resident = get_resident_kib();
+    if (warm_resident && resident && cycles > WARMUP_CYCLES) {
+        growth = resident > warm_resident ? resident - warm_resident : 0;
+        g_print("Resident memory grew %u KiB over %d cycles after warmup\n", growth,
+            cycles - WARMUP_CYCLES);
+        if (growth > (guint) max_growth * (cycles - WARMUP_CYCLES)) {
+            g_print("Memory grew more than %d KiB per cycle\n", max_growth);
+            leaking = TRUE;
+        }
+    }
+
+    g_print("\n%d / %d cycles were successful\n", cycles - failures, cycles);
+
+    g_object_unref(video_source);
+
+    return failures + leaking;
+}
@@ -63,7 +63,8 @@ static OwrBus *bus = NULL;
 static OwrURISourceAgent *uri_source_agent = NULL;
 
 static gchar *uri = NULL;
-static gboolean disable_video = FALSE, disable_audio = FALSE, print_messages = FALSE, adaptation = FALSE;
+static gboolean disable_video = FALSE, disable_audio = FALSE, print_messages = FALSE, adaptation = FALSE, ice_lite = FALSE;
+static gboolean fec = FALSE, adaptive_jitter_buffer = FALSE;
 static gchar *local_addr = NULL, *remote_addr = NULL;
 static const char *stun_pass = "5f1f2614f722cd60fbae275193608d4e";
 
@@ -75,6 +76,9 @@ static GOptionEntry entries[] = {
     { "local-address", 'l', 0, G_OPTION_ARG_STRING, &local_addr, "Local candidate address", NULL },
     { "remote-address", 'r', 0, G_OPTION_ARG_STRING, &remote_addr, "Remote candidate address", NULL },
     { "adaptation", 'a', 0, G_OPTION_ARG_NONE, &adaptation, "Enable bitrate adaptation", NULL },
+    { "ice-lite", 0, 0, G_OPTION_ARG_NONE, &ice_lite, "Run ICE-lite on the receiving agent", NULL },
+    { "fec", 0, 0, G_OPTION_ARG_NONE, &fec, "Protect video with RED/ULPFEC", NULL },
+    { "adaptive-jitter-buffer", 0, 0, G_OPTION_ARG_NONE, &adaptive_jitter_buffer, "Adapt the receiving jitter buffer latency to the measured jitter", NULL },
     { NULL, }
 };
 
@@ -241,6 +245,9 @@ static void got_sources(GList *sources, gpointer user_data)
             g_object_set(payload, "rtx-payload-type", 123, NULL);
             if (adaptation)
                 g_object_set(payload, "adaptation", TRUE, NULL);
+            if (fec)
+                g_object_set(payload, "red-payload-type", 116, "ulpfec-payload-type", 117,
+                    "adaptive-fec", TRUE, NULL);
 
             owr_media_session_set_send_payload(send_session_video, payload);
 
@@ -414,7 +421,9 @@ int main(int argc, char **argv)
 
     owr_bus_add_message_origin(bus, OWR_MESSAGE_ORIGIN(owr_window_registry_get()));
 
-    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    recv_transport_agent = g_object_new(OWR_TYPE_TRANSPORT_AGENT, "ice-controlling-mode", FALSE,
+        "bundle-policy", OWR_BUNDLE_POLICY_TYPE_BALANCED, "ice-lite", ice_lite,
+        "adaptive-jitter-buffer", adaptive_jitter_buffer, NULL);
     g_assert(OWR_IS_TRANSPORT_AGENT(recv_transport_agent));
     owr_bus_add_message_origin(bus, OWR_MESSAGE_ORIGIN(recv_transport_agent));
 
@@ -479,6 +488,8 @@ int main(int argc, char **argv)
         g_object_set(receive_payload, "rtx-payload-type", 123, NULL);
         if (adaptation)
             g_object_set(receive_payload, "adaptation", TRUE, NULL);
+        if (fec)
+            g_object_set(receive_payload, "red-payload-type", 116, "ulpfec-payload-type", 117, NULL);
 
         owr_media_session_add_receive_payload(recv_session_video, receive_payload);
     }
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Sends one video source to two peers with compatible payloads. With
+ * "shared-encoder" set the source must be encoded once for both, without
+ * it each send session encodes on its own.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#define WAIT_TIMEOUT 20
+#define SESSIONS 2
+
+static OwrTransportAgent *send_transport_agent = NULL;
+static OwrTransportAgent *recv_transport_agent = NULL;
+static OwrMediaSource *video_source = NULL;
+
+static guint get_pool_acquisitions(void)
+{
+    GHashTable *stats = owr_get_codec_pool_stats();
+    guint acquisitions;
+
+    acquisitions = test_get_uint_stat(stats, "hits") + test_get_uint_stat(stats, "misses");
+    g_hash_table_unref(stats);
+
+    return acquisitions;
+}
+
+static guint count_encoders(OwrTransportAgent *transport_agent)
+{
+    gchar *dot_data = owr_transport_agent_get_dot_data(transport_agent);
+    guint count = test_count_occurrences(dot_data, "GstVP8Enc");
+
+    g_free(dot_data);
+
+    return count;
+}
+
+/* Expects @expected_encoders encoders taken from the pool, and in the send
+ * sessions' own bins @expected_session_encoders of them */
+static gboolean run_phase(gboolean shared_encoder, guint expected_encoders,
+    guint expected_session_encoders)
+{
+    OwrMediaSession *send_sessions[SESSIONS], *recv_sessions[SESSIONS];
+    TestReceiveStats receive_stats[SESSIONS];
+    OwrPayload *payload;
+    guint i, acquisitions, session_encoders;
+    gboolean ok = TRUE;
+
+    acquisitions = get_pool_acquisitions();
+
+    for (i = 0; i < SESSIONS; i++) {
+        send_sessions[i] = owr_media_session_new(TRUE);
+        payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+        g_object_set(payload, "width", 640, "height", 480, "framerate", 30.0,
+            "shared-encoder", shared_encoder, NULL);
+        owr_media_session_set_send_payload(send_sessions[i], payload);
+        owr_media_session_set_send_source(send_sessions[i], video_source);
+
+        recv_sessions[i] = owr_media_session_new(FALSE);
+        payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+        owr_media_session_add_receive_payload(recv_sessions[i], payload);
+        receive_stats[i].packets_received = 0;
+        receive_stats[i].packets_lost = 0;
+        test_watch_receive_stats(recv_sessions[i], &receive_stats[i]);
+
+        test_connect_sessions(OWR_SESSION(send_sessions[i]), OWR_SESSION(recv_sessions[i]));
+        owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_sessions[i]));
+        owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_sessions[i]));
+    }
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    for (i = 0; i < SESSIONS; i++) {
+        if (!test_wait_for_packets(&receive_stats[i], 0, WAIT_TIMEOUT)) {
+            g_print("Peer %u received nothing\n", i);
+            ok = FALSE;
+        }
+    }
+
+    acquisitions = get_pool_acquisitions() - acquisitions;
+    session_encoders = count_encoders(send_transport_agent);
+    g_print("%s encoder: %u encoders created, %u in the send sessions\n",
+        shared_encoder ? "Shared" : "Own", acquisitions, session_encoders);
+    ok &= acquisitions == expected_encoders && session_encoders == expected_session_encoders;
+
+    for (i = 0; i < SESSIONS; i++) {
+        g_signal_handlers_disconnect_by_data(recv_sessions[i], &receive_stats[i]);
+        owr_transport_agent_remove_session(send_transport_agent, OWR_SESSION(send_sessions[i]));
+        owr_transport_agent_remove_session(recv_transport_agent, OWR_SESSION(recv_sessions[i]));
+        g_object_unref(send_sessions[i]);
+        g_object_unref(recv_sessions[i]);
+    }
+    test_sync_main_context(WAIT_TIMEOUT);
+
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+
+    failures += !run_phase(TRUE, 1, 0);
+    failures += !run_phase(FALSE, SESSIONS, SESSIONS);
+
+    g_print("\n%d / 2 phases were successful\n", 2 - failures);
+
+    g_object_unref(video_source);
+
+    return failures;
+}
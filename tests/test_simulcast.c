@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Sends 640x480 video as three simulcast layers, the largest one inactive,
+ * to a peer receiving one media session. Each active layer must arrive with
+ * its own SSRC, the inactive layer must send nothing and must not see the
+ * keyframe requests the receiver sends for the other layers. Once it is
+ * activated its SSRC must show up as well.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_send_encoding.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#define WAIT_TIMEOUT 20
+#define LAYERS 3
+#define INACTIVE_LAYER 2
+
+static const guint layer_ssrcs[LAYERS] = { 1111, 2222, 3333 };
+static const gdouble layer_scales[LAYERS] = { 4.0, 2.0, 1.0 };
+static const guint layer_bitrates[LAYERS] = { 150000, 500000, 1500000 };
+
+static GMutex stats_lock;
+static GCond stats_cond;
+/* SSRC => packets received */
+static GHashTable *ssrc_packets = NULL;
+
+static void on_new_stats(OwrMediaSession *media_session, GHashTable *stats, gpointer user_data)
+{
+    GValue *ssrc_value, *packets_value;
+
+    (void) media_session;
+    (void) user_data;
+
+    ssrc_value = g_hash_table_lookup(stats, "ssrc");
+    packets_value = g_hash_table_lookup(stats, "packets-received");
+    if (!ssrc_value || !G_VALUE_HOLDS_UINT(ssrc_value)
+        || !packets_value || !G_VALUE_HOLDS_UINT64(packets_value))
+        return;
+
+    g_mutex_lock(&stats_lock);
+    g_hash_table_insert(ssrc_packets, GUINT_TO_POINTER(g_value_get_uint(ssrc_value)),
+        GUINT_TO_POINTER((guint) g_value_get_uint64(packets_value)));
+    g_cond_broadcast(&stats_cond);
+    g_mutex_unlock(&stats_lock);
+}
+
+static guint get_packets(guint ssrc)
+{
+    guint packets;
+
+    g_mutex_lock(&stats_lock);
+    packets = GPOINTER_TO_UINT(g_hash_table_lookup(ssrc_packets, GUINT_TO_POINTER(ssrc)));
+    g_mutex_unlock(&stats_lock);
+
+    return packets;
+}
+
+static gboolean wait_for_ssrc(guint ssrc, guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+    gboolean received;
+
+    g_mutex_lock(&stats_lock);
+    while (!(received = g_hash_table_lookup(ssrc_packets, GUINT_TO_POINTER(ssrc)) != NULL)
+        && g_cond_wait_until(&stats_cond, &stats_lock, end_time));
+    g_mutex_unlock(&stats_lock);
+
+    return received;
+}
+
+static guint get_keyframe_requests(OwrSendEncoding *send_encoding)
+{
+    OwrPayload *payload = NULL;
+    guint requests = 0;
+
+    g_object_get(send_encoding, "payload", &payload, NULL);
+    if (payload) {
+        g_object_get(payload, "keyframe-requests", &requests, NULL);
+        g_object_unref(payload);
+    }
+
+    return requests;
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *send_transport_agent, *recv_transport_agent;
+    OwrMediaSession *send_session, *recv_session;
+    OwrSendEncoding *send_encodings[LAYERS];
+    OwrMediaSource *video_source;
+    OwrPayload *payload;
+    guint i, requests;
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+    ssrc_packets = g_hash_table_new(NULL, NULL);
+
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+
+    send_session = owr_media_session_new(TRUE);
+    for (i = 0; i < LAYERS; i++) {
+        send_encodings[i] = owr_send_encoding_new(layer_ssrcs[i], layer_scales[i],
+            layer_bitrates[i], 0.0);
+        g_object_set(send_encodings[i], "active", i != INACTIVE_LAYER, NULL);
+        owr_media_session_add_send_encoding(send_session, g_object_ref(send_encodings[i]));
+    }
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+    g_object_set(payload, "width", 640, "height", 480, "framerate", 30.0, NULL);
+    owr_media_session_set_send_payload(send_session, payload);
+    owr_media_session_set_send_source(send_session, video_source);
+
+    recv_session = owr_media_session_new(FALSE);
+    payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, FALSE);
+    owr_media_session_add_receive_payload(recv_session, payload);
+    g_signal_connect(recv_session, "on-new-stats", G_CALLBACK(on_new_stats), NULL);
+
+    test_connect_sessions(OWR_SESSION(send_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_session));
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    for (i = 0; i < LAYERS; i++) {
+        if (i == INACTIVE_LAYER)
+            continue;
+        if (!wait_for_ssrc(layer_ssrcs[i], WAIT_TIMEOUT)) {
+            g_print("Nothing received with SSRC %u\n", layer_ssrcs[i]);
+            failures++;
+        }
+    }
+
+    /* Give the receiver's keyframe requests for the active layers time to
+     * arrive */
+    g_usleep(TEST_PHASE_DURATION * G_USEC_PER_SEC);
+
+    if (get_packets(layer_ssrcs[INACTIVE_LAYER])) {
+        g_print("Inactive layer sent %u packets\n", get_packets(layer_ssrcs[INACTIVE_LAYER]));
+        failures++;
+    }
+    requests = get_keyframe_requests(send_encodings[INACTIVE_LAYER]);
+    if (requests) {
+        g_print("Inactive layer got %u keyframe requests meant for other layers\n", requests);
+        failures++;
+    }
+
+    g_object_set(send_encodings[INACTIVE_LAYER], "active", TRUE, NULL);
+    if (!wait_for_ssrc(layer_ssrcs[INACTIVE_LAYER], WAIT_TIMEOUT)) {
+        g_print("Nothing received with SSRC %u once activated\n", layer_ssrcs[INACTIVE_LAYER]);
+        failures++;
+    }
+
+    for (i = 0; i < LAYERS; i++)
+        g_print("SSRC %u: %u packets, %u keyframe requests\n", layer_ssrcs[i],
+            get_packets(layer_ssrcs[i]), get_keyframe_requests(send_encodings[i]));
+
+    g_print("\n%s\n", failures ? "FAILED" : "OK");
+
+    for (i = 0; i < LAYERS; i++)
+        g_object_unref(send_encodings[i]);
+    g_object_unref(video_source);
+
+    return failures;
+}
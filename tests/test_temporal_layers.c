@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*
+ * Sends VP8 with three temporal layers from a test source and lowers the
+ * bitrate below what the enhancement layers need. The enhancement layers are
+ * then dropped before packetization, which must neither stop the stream nor
+ * make the receiver ask for keyframes, as no frame that is still sent
+ * references a dropped one. Needs vp8enc from GStreamer 1.20, which marks
+ * the layer of each frame.
+ */
+
+#include "owr.h"
+#include "owr_media_session.h"
+#include "owr_session.h"
+#include "owr_transport_agent.h"
+#include "owr_video_payload.h"
+#include "test_utils.h"
+
+#define HIGH_BITRATE 1000000
+/* Enough for the base layer of 640x480 at 30 fps only */
+#define LOW_BITRATE 100000
+#define WAIT_TIMEOUT 20
+
+static OwrPayload *send_payload = NULL;
+static TestReceiveStats receive_stats = { 0, 0 };
+
+/* Runs one bitrate phase, the stream must keep flowing without a single
+ * keyframe request */
+static gboolean run_phase(const gchar *name, guint bitrate)
+{
+    guint64 packets_before, packets_after;
+    guint keyframe_requests_before = 0, keyframe_requests_after = 0;
+
+    g_object_set(send_payload, "bitrate", bitrate, NULL);
+    packets_before = test_get_receive_stats(&receive_stats).packets_received;
+    g_object_get(send_payload, "keyframe-requests", &keyframe_requests_before, NULL);
+
+    g_usleep(TEST_PHASE_DURATION * G_USEC_PER_SEC);
+
+    test_wait_for_packets(&receive_stats, packets_before, TEST_PHASE_DURATION);
+    packets_after = test_get_receive_stats(&receive_stats).packets_received;
+    g_object_get(send_payload, "keyframe-requests", &keyframe_requests_after, NULL);
+
+    g_print("%s bitrate: %" G_GUINT64_FORMAT " packets, %u keyframe requests\n", name,
+        packets_after - packets_before, keyframe_requests_after - keyframe_requests_before);
+
+    return packets_after > packets_before && keyframe_requests_after == keyframe_requests_before;
+}
+
+int main(int argc, char **argv)
+{
+    OwrTransportAgent *send_transport_agent, *recv_transport_agent;
+    OwrMediaSession *send_session, *recv_session;
+    OwrMediaSource *video_source;
+    OwrPayload *receive_payload;
+    gint failures = 0;
+
+    (void) argc;
+    (void) argv;
+
+    g_setenv("OWR_USE_TEST_SOURCES", "1", TRUE);
+    owr_init(NULL);
+    owr_run_in_background();
+
+    video_source = test_get_capture_source(OWR_MEDIA_TYPE_VIDEO);
+    if (!video_source) {
+        g_print("No video test source\n");
+        return -1;
+    }
+
+    recv_transport_agent = owr_transport_agent_new(FALSE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(recv_transport_agent, "127.0.0.1");
+    send_transport_agent = owr_transport_agent_new(TRUE, OWR_BUNDLE_POLICY_TYPE_BALANCED);
+    owr_transport_agent_add_local_address(send_transport_agent, "127.0.0.1");
+
+    recv_session = owr_media_session_new(FALSE);
+    receive_payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, TRUE);
+    owr_media_session_add_receive_payload(recv_session, receive_payload);
+    test_watch_receive_stats(recv_session, &receive_stats);
+
+    send_session = owr_media_session_new(TRUE);
+    send_payload = owr_video_payload_new(OWR_CODEC_TYPE_VP8, 103, 90000, TRUE, TRUE);
+    g_object_set(send_payload, "width", 640, "height", 480, "framerate", 30.0,
+        "bitrate", HIGH_BITRATE, "temporal-layers", 3, NULL);
+    g_object_ref(send_payload);
+    owr_media_session_set_send_payload(send_session, send_payload);
+    owr_media_session_set_send_source(send_session, video_source);
+
+    test_connect_sessions(OWR_SESSION(send_session), OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(recv_transport_agent, OWR_SESSION(recv_session));
+    owr_transport_agent_add_session(send_transport_agent, OWR_SESSION(send_session));
+    owr_transport_agent_start(recv_transport_agent);
+    owr_transport_agent_start(send_transport_agent);
+
+    if (!test_wait_for_packets(&receive_stats, 0, WAIT_TIMEOUT)) {
+        g_print("No media was received\n");
+        return 1;
+    }
+    /* Let the keyframe requests of the stream start settle */
+    g_usleep(G_USEC_PER_SEC);
+
+    failures += !run_phase("High", HIGH_BITRATE);
+    failures += !run_phase("Low", LOW_BITRATE);
+    failures += !run_phase("Restored", HIGH_BITRATE);
+
+    g_print("\n%d / 3 phases were successful\n", 3 - failures);
+
+    g_object_unref(send_payload);
+    g_object_unref(video_source);
+
+    return failures;
+}
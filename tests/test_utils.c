@@ -30,6 +30,20 @@
 #endif
 #include "test_utils.h"
 
+#include "owr_local.h"
+
+#include <string.h>
+
+typedef struct {
+    OwrMediaType media_type;
+    OwrMediaSource *source;
+    gboolean listed;
+} CaptureSourceRequest;
+
+static GMutex test_lock;
+static GCond test_cond;
+static gboolean main_context_synced = FALSE;
+
 void write_dot_file(const gchar *base_file_name, gchar *dot_data, gboolean with_timestamp)
 {
     GTimeVal time;
@@ -138,3 +152,190 @@ void bus_message_print_callback(OwrMessageOrigin *origin,
     g_free(origin_name);
     g_free(data_string);
 }
+
+
+static void got_capture_sources(GList *sources, CaptureSourceRequest *request)
+{
+    OwrMediaType media_type = OWR_MEDIA_TYPE_UNKNOWN;
+
+    g_mutex_lock(&test_lock);
+    for (; sources && !request->source; sources = sources->next) {
+        g_object_get(sources->data, "media-type", &media_type, NULL);
+        if (media_type == request->media_type)
+            request->source = g_object_ref(sources->data);
+    }
+    request->listed = TRUE;
+    g_cond_broadcast(&test_cond);
+    g_mutex_unlock(&test_lock);
+}
+
+/* Returns the first capture source of @media_type, a reference the caller
+ * owns, or NULL. Tests set OWR_USE_TEST_SOURCES to get test sources. */
+OwrMediaSource *test_get_capture_source(OwrMediaType media_type)
+{
+    CaptureSourceRequest request = { media_type, NULL, FALSE };
+
+    owr_get_capture_sources(media_type, (OwrCaptureSourcesCallback) got_capture_sources, &request);
+
+    g_mutex_lock(&test_lock);
+    while (!request.listed)
+        g_cond_wait(&test_cond, &test_lock);
+    g_mutex_unlock(&test_lock);
+
+    return request.source;
+}
+
+static void got_candidate(OwrSession *session_a, OwrCandidate *candidate, OwrSession *session_b)
+{
+    (void) session_a;
+    owr_session_add_remote_candidate(session_b, candidate);
+}
+
+static void on_ice_state_changed(GObject *session, GParamSpec *pspec, gpointer user_data)
+{
+    (void) session;
+    (void) pspec;
+    (void) user_data;
+
+    g_mutex_lock(&test_lock);
+    g_cond_broadcast(&test_cond);
+    g_mutex_unlock(&test_lock);
+}
+
+/* Hands the local candidates of each session to the other one */
+void test_connect_sessions(OwrSession *session_a, OwrSession *session_b)
+{
+    g_signal_connect(session_a, "on-new-candidate", G_CALLBACK(got_candidate), session_b);
+    g_signal_connect(session_b, "on-new-candidate", G_CALLBACK(got_candidate), session_a);
+    g_signal_connect(session_a, "notify::ice-connection-state", G_CALLBACK(on_ice_state_changed), NULL);
+    g_signal_connect(session_b, "notify::ice-connection-state", G_CALLBACK(on_ice_state_changed), NULL);
+}
+
+static gboolean is_connected(OwrSession *session)
+{
+    OwrIceState ice_state = OWR_ICE_STATE_DISCONNECTED;
+
+    g_object_get(session, "ice-connection-state", &ice_state, NULL);
+
+    return ice_state == OWR_ICE_STATE_CONNECTED || ice_state == OWR_ICE_STATE_READY;
+}
+
+gboolean test_wait_for_connected(OwrSession *session_a, OwrSession *session_b, guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+    gboolean connected;
+
+    g_mutex_lock(&test_lock);
+    while (!(connected = is_connected(session_a) && is_connected(session_b))
+        && g_cond_wait_until(&test_cond, &test_lock, end_time));
+    g_mutex_unlock(&test_lock);
+
+    return connected;
+}
+
+static void on_new_stats(OwrMediaSession *media_session, GHashTable *stats,
+    TestReceiveStats *receive_stats)
+{
+    GValue *value;
+
+    (void) media_session;
+
+    value = g_hash_table_lookup(stats, "packets-received");
+    if (!value || !G_VALUE_HOLDS_UINT64(value))
+        return;
+
+    g_mutex_lock(&test_lock);
+    receive_stats->packets_received = MAX(receive_stats->packets_received, g_value_get_uint64(value));
+    value = g_hash_table_lookup(stats, "packets-lost");
+    if (value && G_VALUE_HOLDS_INT(value))
+        receive_stats->packets_lost = g_value_get_int(value);
+    g_cond_broadcast(&test_cond);
+    g_mutex_unlock(&test_lock);
+}
+
+/* Keeps @receive_stats up to date with the RTCP stats of the remote sender
+ * of @media_session */
+void test_watch_receive_stats(OwrMediaSession *media_session, TestReceiveStats *receive_stats)
+{
+    g_signal_connect(media_session, "on-new-stats", G_CALLBACK(on_new_stats), receive_stats);
+}
+
+TestReceiveStats test_get_receive_stats(TestReceiveStats *receive_stats)
+{
+    TestReceiveStats stats;
+
+    g_mutex_lock(&test_lock);
+    stats = *receive_stats;
+    g_mutex_unlock(&test_lock);
+
+    return stats;
+}
+
+gboolean test_wait_for_packets(TestReceiveStats *receive_stats, guint64 more_than, guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+    gboolean received;
+
+    g_mutex_lock(&test_lock);
+    while (receive_stats->packets_received <= more_than
+        && g_cond_wait_until(&test_cond, &test_lock, end_time));
+    received = receive_stats->packets_received > more_than;
+    g_mutex_unlock(&test_lock);
+
+    return received;
+}
+
+static gboolean on_main_context_synced(gpointer user_data)
+{
+    (void) user_data;
+
+    g_mutex_lock(&test_lock);
+    main_context_synced = TRUE;
+    g_cond_broadcast(&test_cond);
+    g_mutex_unlock(&test_lock);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Waits for everything scheduled on the default main context so far */
+gboolean test_sync_main_context(guint timeout)
+{
+    gint64 end_time = g_get_monotonic_time() + timeout * G_TIME_SPAN_SECOND;
+    GSource *source;
+    gboolean synced;
+
+    g_mutex_lock(&test_lock);
+    main_context_synced = FALSE;
+    g_mutex_unlock(&test_lock);
+
+    source = g_idle_source_new();
+    g_source_set_priority(source, G_PRIORITY_LOW);
+    g_source_set_callback(source, on_main_context_synced, NULL, NULL);
+    g_source_attach(source, g_main_context_default());
+    g_source_unref(source);
+
+    g_mutex_lock(&test_lock);
+    while (!main_context_synced && g_cond_wait_until(&test_cond, &test_lock, end_time));
+    synced = main_context_synced;
+    g_mutex_unlock(&test_lock);
+
+    return synced;
+}
+
+guint test_count_occurrences(const gchar *haystack, const gchar *needle)
+{
+    const gchar *walk;
+    guint count = 0;
+
+    for (walk = strstr(haystack, needle); walk; walk = strstr(walk + 1, needle))
+        count++;
+
+    return count;
+}
+
+guint test_get_uint_stat(GHashTable *stats, const gchar *key)
+{
+    GValue *value = g_hash_table_lookup(stats, key);
+
+    return value && G_VALUE_HOLDS_UINT(value) ? g_value_get_uint(value) : 0;
+}
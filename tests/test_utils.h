@@ -31,11 +31,33 @@
 #include <glib.h>
 
 #include "owr_bus.h"
+#include "owr_media_session.h"
+#include "owr_media_source.h"
 #include "owr_message_origin.h"
+#include "owr_session.h"
+
+/* Seconds a test keeps a configuration running before it looks at the
+ * result */
+#define TEST_PHASE_DURATION 5
+
+typedef struct {
+    guint64 packets_received;
+    gint packets_lost;
+} TestReceiveStats;
 
 void write_dot_file(const gchar *base_file_name, gchar *dot_data, gboolean with_timestamp);
 void bus_message_print_callback(OwrMessageOrigin *origin,
     OwrMessageType type, OwrMessageSubType sub_type, GHashTable *data,
     const gchar *(*origin_name_func)(gpointer));
 
+OwrMediaSource *test_get_capture_source(OwrMediaType media_type);
+void test_connect_sessions(OwrSession *session_a, OwrSession *session_b);
+void test_watch_receive_stats(OwrMediaSession *media_session, TestReceiveStats *receive_stats);
+TestReceiveStats test_get_receive_stats(TestReceiveStats *receive_stats);
+gboolean test_wait_for_packets(TestReceiveStats *receive_stats, guint64 more_than, guint timeout);
+gboolean test_wait_for_connected(OwrSession *session_a, OwrSession *session_b, guint timeout);
+gboolean test_sync_main_context(guint timeout);
+guint test_count_occurrences(const gchar *haystack, const gchar *needle);
+guint test_get_uint_stat(GHashTable *stats, const gchar *key);
+
 #endif /* __TEST_UTILS_H__ */
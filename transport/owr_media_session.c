@@ -49,6 +49,8 @@
 #include "owr_media_source.h"
 #include "owr_private.h"
 #include "owr_remote_media_source.h"
+#include "owr_rtp_forward.h"
+#include "owr_send_encoding.h"
 #include "owr_session_private.h"
 
 #include <string.h>
@@ -73,11 +75,18 @@ struct _OwrMediaSessionPrivate {
     OwrPayload *send_payload;
     OwrMediaSource *send_source;
     GPtrArray *receive_payloads;
+    GPtrArray *send_encodings;
     GClosure *on_send_payload;
     GClosure *on_send_source;
+    GstElement *forward_source;
+    GWeakRef forward_session;
+    GPtrArray *forward_sinks;
+    GClosure *on_forward_source;
+    GClosure *on_forward_sink;
     GSList *remote_sources;
     GMutex remote_source_lock;
     gint jitter_buffer_latency;
+    guint round_trip_time;
 };
 
 enum {
@@ -100,6 +109,7 @@ enum {
     PROP_RECEIVE_RTX_SSRC,
     PROP_CNAME,
     PROP_JITTER_BUFFER_LATENCY,
+    PROP_ROUND_TRIP_TIME,
 
     N_PROPERTIES
 };
@@ -109,8 +119,11 @@ static GParamSpec *obj_properties[N_PROPERTIES] = {NULL, };
 
 
 static gboolean add_receive_payload(GHashTable *args);
+static gboolean add_send_encoding(GHashTable *args);
 static gboolean set_send_payload(GHashTable *args);
 static gboolean set_send_source(GHashTable *args);
+static gboolean set_forward_session(GHashTable *args);
+static void remove_forward_sink(OwrMediaSession *media_session, GstElement *sink);
 
 
 static void owr_media_session_set_property(GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
@@ -200,6 +213,9 @@ static void owr_media_session_get_property(GObject *object, guint property_id, G
     case PROP_JITTER_BUFFER_LATENCY:
         g_value_set_uint(value, priv->jitter_buffer_latency);
         break;
+    case PROP_ROUND_TRIP_TIME:
+        g_value_set_uint(value, priv->round_trip_time);
+        break;
 
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
@@ -250,9 +266,22 @@ static void owr_media_session_finalize(GObject *object)
     if (priv->send_source)
         owr_media_session_set_send_source(media_session, NULL);
 
+    if (priv->forward_source) {
+        OwrMediaSession *forward_session = g_weak_ref_get(&priv->forward_session);
+
+        if (forward_session) {
+            remove_forward_sink(forward_session, _owr_rtp_forward_get_sink(priv->forward_source));
+            g_object_unref(forward_session);
+        }
+        gst_object_unref(priv->forward_source);
+    }
+    g_weak_ref_clear(&priv->forward_session);
+    g_ptr_array_unref(priv->forward_sinks);
+
     if (priv->send_payload)
         g_object_unref(priv->send_payload);
     g_ptr_array_unref(priv->receive_payloads);
+    g_ptr_array_unref(priv->send_encodings);
 
     g_rw_lock_clear(&priv->rw_lock);
 
@@ -332,6 +361,13 @@ static void owr_media_session_class_init(OwrMediaSessionClass *klass)
         0, G_MAXUINT, 50,
         G_PARAM_STATIC_STRINGS | G_PARAM_READWRITE);
 
+    obj_properties[PROP_ROUND_TRIP_TIME] = g_param_spec_uint("round-trip-time",
+        "Round trip time in ms",
+        "The smoothed round trip time measured from the RTCP reports for the sent "
+        "stream (0 until measured)",
+        0, G_MAXUINT, 0,
+        G_PARAM_STATIC_STRINGS | G_PARAM_READABLE);
+
     g_object_class_install_properties(gobject_class, N_PROPERTIES, obj_properties);
 
 }
@@ -351,10 +387,17 @@ static void owr_media_session_init(OwrMediaSession *media_session)
     priv->send_payload = NULL;
     priv->send_source = NULL;
     priv->receive_payloads = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
+    priv->send_encodings = g_ptr_array_new_with_free_func((GDestroyNotify)g_object_unref);
     priv->on_send_payload = NULL;
     priv->on_send_source = NULL;
+    priv->forward_source = NULL;
+    g_weak_ref_init(&priv->forward_session, NULL);
+    priv->forward_sinks = g_ptr_array_new_with_free_func((GDestroyNotify)gst_object_unref);
+    priv->on_forward_source = NULL;
+    priv->on_forward_sink = NULL;
     priv->remote_sources = NULL;
     priv->jitter_buffer_latency = 50;
+    priv->round_trip_time = 0;
     g_mutex_init(&priv->remote_source_lock);
     g_rw_lock_init(&priv->rw_lock);
 }
@@ -395,6 +438,31 @@ void owr_media_session_add_receive_payload(OwrMediaSession *media_session, OwrPa
     _owr_schedule_with_hash_table((GSourceFunc)add_receive_payload, args);
 }
 
+/**
+ * owr_media_session_add_send_encoding:
+ * @media_session: the media session on which to add the send encoding.
+ * @send_encoding: (transfer full): the send encoding to add
+ *
+ * Adds a simulcast layer to the video sent by the media session. Every
+ * encoding is encoded separately from the same source and sent with its own
+ * SSRC using the codec of the send payload. Encodings must be added before the
+ * send payload is set, without any encodings a single stream is sent.
+ */
+void owr_media_session_add_send_encoding(OwrMediaSession *media_session, OwrSendEncoding *send_encoding)
+{
+    GHashTable *args;
+
+    g_return_if_fail(OWR_IS_MEDIA_SESSION(media_session));
+    g_return_if_fail(OWR_IS_SEND_ENCODING(send_encoding));
+
+    args = _owr_create_schedule_table(OWR_MESSAGE_ORIGIN(media_session));
+    g_hash_table_insert(args, "media_session", media_session);
+    g_hash_table_insert(args, "send_encoding", send_encoding);
+
+    g_object_ref(media_session);
+    _owr_schedule_with_hash_table((GSourceFunc)add_send_encoding, args);
+}
+
 /**
  * owr_media_session_set_send_payload:
  * @media_session: The media session on which set the send payload.
@@ -441,6 +509,36 @@ void owr_media_session_set_send_source(OwrMediaSession *media_session, OwrMediaS
     _owr_schedule_with_hash_table((GSourceFunc)set_send_source, args);
 }
 
+/**
+ * owr_media_session_set_forward_session:
+ * @media_session: The media session on which to forward.
+ * @receive_session: (transfer none) (allow-none): the media session whose
+ * received RTP is forwarded
+ *
+ * Sends the RTP received on @receive_session, which may belong to another
+ * transport agent, as it is without decoding and encoding it again. The
+ * packets get the SSRC and send payload type of @media_session and key frame
+ * requests from the remote peer are passed on to the sender of
+ * @receive_session. While forwarding the send source is not used.
+ */
+void owr_media_session_set_forward_session(OwrMediaSession *media_session, OwrMediaSession *receive_session)
+{
+    GHashTable *args;
+
+    g_return_if_fail(OWR_IS_MEDIA_SESSION(media_session));
+    g_return_if_fail(!receive_session || OWR_IS_MEDIA_SESSION(receive_session));
+    g_return_if_fail(media_session != receive_session);
+
+    args = _owr_create_schedule_table(OWR_MESSAGE_ORIGIN(media_session));
+    g_hash_table_insert(args, "media_session", media_session);
+    g_hash_table_insert(args, "receive_session", receive_session);
+    g_object_ref(media_session);
+    if (receive_session)
+        g_object_ref(receive_session);
+
+    _owr_schedule_with_hash_table((GSourceFunc)set_forward_session, args);
+}
+
 
 /* Internal functions */
 
@@ -489,6 +587,47 @@ static gboolean add_receive_payload(GHashTable *args)
     return FALSE;
 }
 
+static gboolean add_send_encoding(GHashTable *args)
+{
+    OwrMediaSession *media_session;
+    OwrSendEncoding *send_encoding;
+    GPtrArray *send_encodings;
+    guint i, ssrc, other_ssrc;
+    gboolean found = FALSE;
+
+    g_return_val_if_fail(args, FALSE);
+
+    media_session = g_hash_table_lookup(args, "media_session");
+    send_encoding = g_hash_table_lookup(args, "send_encoding");
+
+    g_return_val_if_fail(media_session, FALSE);
+    g_return_val_if_fail(send_encoding, FALSE);
+
+    g_object_get(send_encoding, "ssrc", &ssrc, NULL);
+
+    g_rw_lock_writer_lock(&media_session->priv->rw_lock);
+    send_encodings = media_session->priv->send_encodings;
+    for (i = 0; i < send_encodings->len; i++) {
+        g_object_get(g_ptr_array_index(send_encodings, i), "ssrc", &other_ssrc, NULL);
+        if (other_ssrc == ssrc) {
+            found = TRUE;
+            break;
+        }
+    }
+
+    if (ssrc && !found)
+        g_ptr_array_add(send_encodings, send_encoding);
+    else {
+        g_warning("A send encoding without an SSRC or with an already used SSRC was added to the media session. Action aborted.\n");
+        g_object_unref(send_encoding);
+    }
+    g_rw_lock_writer_unlock(&media_session->priv->rw_lock);
+
+    g_object_unref(media_session);
+    g_hash_table_unref(args);
+    return FALSE;
+}
+
 static gboolean set_send_payload(GHashTable *args)
 {
     OwrMediaSession *media_session;
@@ -578,6 +717,134 @@ static gboolean set_send_source(GHashTable *args)
 }
 
 
+static void invoke_on_forward_sink(OwrMediaSession *media_session, GstElement *sink, gboolean added)
+{
+    GValue params[3] = { G_VALUE_INIT, };
+
+    if (!media_session->priv->on_forward_sink)
+        return;
+
+    g_value_init(&params[0], OWR_TYPE_MEDIA_SESSION);
+    g_value_set_object(&params[0], media_session);
+    g_value_init(&params[1], GST_TYPE_ELEMENT);
+    g_value_set_object(&params[1], sink);
+    g_value_init(&params[2], G_TYPE_BOOLEAN);
+    g_value_set_boolean(&params[2], added);
+    g_closure_invoke(media_session->priv->on_forward_sink, NULL, 3, (const GValue *)&params, NULL);
+    g_value_unset(&params[0]);
+    g_value_unset(&params[1]);
+    g_value_unset(&params[2]);
+}
+
+static void add_forward_sink(OwrMediaSession *media_session, GstElement *sink)
+{
+    g_rw_lock_writer_lock(&media_session->priv->rw_lock);
+    g_ptr_array_add(media_session->priv->forward_sinks, gst_object_ref(sink));
+    g_rw_lock_writer_unlock(&media_session->priv->rw_lock);
+
+    invoke_on_forward_sink(media_session, sink, TRUE);
+}
+
+static void remove_forward_sink(OwrMediaSession *media_session, GstElement *sink)
+{
+    gboolean removed;
+
+    gst_object_ref(sink);
+    g_rw_lock_writer_lock(&media_session->priv->rw_lock);
+    removed = g_ptr_array_remove(media_session->priv->forward_sinks, sink);
+    g_rw_lock_writer_unlock(&media_session->priv->rw_lock);
+
+    if (removed)
+        invoke_on_forward_sink(media_session, sink, FALSE);
+    gst_object_unref(sink);
+}
+
+static gboolean set_forward_session(GHashTable *args)
+{
+    OwrMediaSession *media_session, *receive_session, *old_session;
+    OwrMediaSessionPrivate *priv;
+    GstElement *source = NULL, *old_source, *sink = NULL, *old_sink;
+    GValue params[3] = { G_VALUE_INIT, };
+
+    g_return_val_if_fail(args, FALSE);
+
+    media_session = g_hash_table_lookup(args, "media_session");
+    receive_session = g_hash_table_lookup(args, "receive_session");
+
+    g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), FALSE);
+    g_return_val_if_fail(!receive_session || OWR_IS_MEDIA_SESSION(receive_session), FALSE);
+
+    priv = media_session->priv;
+
+    old_session = g_weak_ref_get(&priv->forward_session);
+    if (old_session == receive_session && (receive_session || !priv->forward_source))
+        goto out;
+
+    /* Switching between received streams keeps the source so that the
+     * receiver sees one continuous stream */
+    if (receive_session && priv->forward_source) {
+        old_sink = gst_object_ref(_owr_rtp_forward_get_sink(priv->forward_source));
+        sink = _owr_rtp_forward_new_sink(priv->forward_source);
+
+        g_rw_lock_writer_lock(&priv->rw_lock);
+        g_weak_ref_set(&priv->forward_session, receive_session);
+        g_rw_lock_writer_unlock(&priv->rw_lock);
+
+        if (old_session)
+            remove_forward_sink(old_session, old_sink);
+        add_forward_sink(receive_session, sink);
+
+        gst_object_unref(old_sink);
+        gst_object_unref(sink);
+        goto out;
+    }
+
+    if (receive_session)
+        source = _owr_rtp_forward_new(&sink);
+
+    g_rw_lock_writer_lock(&priv->rw_lock);
+    old_source = priv->forward_source;
+    priv->forward_source = source ? gst_object_ref(source) : NULL;
+    g_weak_ref_set(&priv->forward_session, receive_session);
+    g_rw_lock_writer_unlock(&priv->rw_lock);
+
+    if (old_session && old_source)
+        remove_forward_sink(old_session, _owr_rtp_forward_get_sink(old_source));
+    if (receive_session)
+        add_forward_sink(receive_session, sink);
+
+    if (priv->on_forward_source) {
+        g_value_init(&params[0], OWR_TYPE_MEDIA_SESSION);
+        g_value_set_object(&params[0], media_session);
+        g_value_init(&params[1], GST_TYPE_ELEMENT);
+        g_value_set_object(&params[1], old_source);
+        g_value_init(&params[2], GST_TYPE_ELEMENT);
+        g_value_set_object(&params[2], source);
+        g_closure_invoke(priv->on_forward_source, NULL, 3, (const GValue *)&params, NULL);
+        g_value_unset(&params[0]);
+        g_value_unset(&params[1]);
+        g_value_unset(&params[2]);
+    }
+
+    if (old_source)
+        gst_object_unref(old_source);
+    if (source)
+        gst_object_unref(source);
+    if (sink)
+        gst_object_unref(sink);
+
+out:
+    if (old_session)
+        g_object_unref(old_session);
+    if (receive_session)
+        g_object_unref(receive_session);
+    g_object_unref(media_session);
+    g_hash_table_unref(args);
+
+    return FALSE;
+}
+
+
 /* Private methods */
 /**
  * _owr_media_session_get_receive_payload:
@@ -605,6 +872,9 @@ OwrPayload * _owr_media_session_get_receive_payload(OwrMediaSession *media_sessi
         g_object_get(payload, "rtx-payload-type", &pt, NULL);
         if (pt == payload_type)
             break;
+        g_object_get(payload, "ulpfec-payload-type", &pt, NULL);
+        if (pt == payload_type)
+            break;
     }
     if (pt == payload_type)
         g_object_ref(payload);
@@ -615,6 +885,89 @@ OwrPayload * _owr_media_session_get_receive_payload(OwrMediaSession *media_sessi
     return NULL;
 }
 
+/**
+ * _owr_media_session_get_send_encodings:
+ * @media_session:
+ *
+ * Returns: (transfer full) (element-type OwrSendEncoding): the send encodings in the order they
+ * were added
+ */
+GList * _owr_media_session_get_send_encodings(OwrMediaSession *media_session)
+{
+    GList *send_encodings = NULL;
+    guint i;
+
+    g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), NULL);
+
+    g_rw_lock_reader_lock(&media_session->priv->rw_lock);
+    for (i = media_session->priv->send_encodings->len; i > 0; i--) {
+        send_encodings = g_list_prepend(send_encodings,
+            g_object_ref(g_ptr_array_index(media_session->priv->send_encodings, i - 1)));
+    }
+    g_rw_lock_reader_unlock(&media_session->priv->rw_lock);
+
+    return send_encodings;
+}
+
+gboolean _owr_media_session_has_send_encodings(OwrMediaSession *media_session)
+{
+    gboolean has_send_encodings;
+
+    g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), FALSE);
+
+    g_rw_lock_reader_lock(&media_session->priv->rw_lock);
+    has_send_encodings = media_session->priv->send_encodings->len > 0;
+    g_rw_lock_reader_unlock(&media_session->priv->rw_lock);
+
+    return has_send_encodings;
+}
+
+/**
+ * _owr_media_session_get_forward_source:
+ * @media_session:
+ *
+ * Returns: (transfer full): the source of the forwarded RTP or NULL when
+ * not forwarding
+ */
+GstElement * _owr_media_session_get_forward_source(OwrMediaSession *media_session)
+{
+    GstElement *forward_source;
+
+    g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), NULL);
+
+    g_rw_lock_reader_lock(&media_session->priv->rw_lock);
+    forward_source = media_session->priv->forward_source;
+    if (forward_source)
+        gst_object_ref(forward_source);
+    g_rw_lock_reader_unlock(&media_session->priv->rw_lock);
+
+    return forward_source;
+}
+
+/**
+ * _owr_media_session_get_forward_sinks:
+ * @media_session:
+ *
+ * Returns: (transfer full) (element-type GstElement): the sinks to which the
+ * received RTP is forwarded
+ */
+GList * _owr_media_session_get_forward_sinks(OwrMediaSession *media_session)
+{
+    GList *forward_sinks = NULL;
+    guint i;
+
+    g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), NULL);
+
+    g_rw_lock_reader_lock(&media_session->priv->rw_lock);
+    for (i = media_session->priv->forward_sinks->len; i > 0; i--) {
+        forward_sinks = g_list_prepend(forward_sinks,
+            gst_object_ref(g_ptr_array_index(media_session->priv->forward_sinks, i - 1)));
+    }
+    g_rw_lock_reader_unlock(&media_session->priv->rw_lock);
+
+    return forward_sinks;
+}
+
 static void append_to_pt_map(GstStructure *pt_map, guint pt, guint rtx_pt)
 {
     gchar *tmp;
@@ -673,7 +1026,7 @@ GstStructure * _owr_media_session_get_receive_rtx_pt_map(OwrMediaSession *media_
     OwrPayload *payload;
     GstStructure *pt_map;
     guint i, pt;
-    gint rtx_pt;
+    gint rtx_pt, red_pt;
 
     g_return_val_if_fail(media_session, NULL);
     g_return_val_if_fail(receive_payloads, NULL);
@@ -685,10 +1038,13 @@ GstStructure * _owr_media_session_get_receive_rtx_pt_map(OwrMediaSession *media_
     for (i = 0; i < receive_payloads->len; i++) {
         payload = g_ptr_array_index(receive_payloads, i);
 
-        g_object_get(payload, "payload-type", &pt, "rtx-payload-type", &rtx_pt, NULL);
+        g_object_get(payload, "payload-type", &pt, "rtx-payload-type", &rtx_pt,
+            "red-payload-type", &red_pt, NULL);
 
+        /* With RED everything is sent in RED packets, and those are what
+         * gets retransmitted */
         if (rtx_pt >= 0)
-            append_to_pt_map(pt_map, pt, rtx_pt);
+            append_to_pt_map(pt_map, red_pt >= 0 ? (guint) red_pt : pt, rtx_pt);
     }
 
     g_rw_lock_reader_unlock(&media_session->priv->rw_lock);
@@ -701,6 +1057,84 @@ GstStructure * _owr_media_session_get_receive_rtx_pt_map(OwrMediaSession *media_
     return pt_map;
 }
 
+static gint get_receive_fec_payload_type(OwrMediaSession *media_session,
+    const gchar *property_name)
+{
+    GPtrArray *receive_payloads = media_session->priv->receive_payloads;
+    guint i;
+    gint fec_pt = -1;
+
+    g_rw_lock_reader_lock(&media_session->priv->rw_lock);
+
+    for (i = 0; i < receive_payloads->len && fec_pt < 0; i++)
+        g_object_get(g_ptr_array_index(receive_payloads, i), property_name, &fec_pt, NULL);
+
+    g_rw_lock_reader_unlock(&media_session->priv->rw_lock);
+
+    return fec_pt;
+}
+
+/**
+ * _owr_media_session_get_receive_red_payload_type:
+ * @media_session:
+ *
+ * Returns: the RED payload type of the receive payloads, or -1
+ *
+ */
+gint _owr_media_session_get_receive_red_payload_type(OwrMediaSession *media_session)
+{
+    g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), -1);
+
+    return get_receive_fec_payload_type(media_session, "red-payload-type");
+}
+
+/**
+ * _owr_media_session_get_receive_ulpfec_payload_type:
+ * @media_session:
+ *
+ * Returns: the ULPFEC payload type of the receive payloads, or -1
+ *
+ */
+gint _owr_media_session_get_receive_ulpfec_payload_type(OwrMediaSession *media_session)
+{
+    g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), -1);
+
+    return get_receive_fec_payload_type(media_session, "ulpfec-payload-type");
+}
+
+/**
+ * _owr_media_session_want_receive_inband_fec:
+ * @media_session:
+ *
+ * Returns: %TRUE if an Opus receive payload was configured with in-band FEC,
+ * either with a non-zero fec-percentage or with adaptive-fec
+ *
+ */
+gboolean _owr_media_session_want_receive_inband_fec(OwrMediaSession *media_session)
+{
+    GPtrArray *receive_payloads;
+    OwrPayload *payload;
+    OwrCodecType codec_type;
+    guint i, fec_percentage;
+    gboolean adaptive_fec, inband_fec = FALSE;
+
+    g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), FALSE);
+
+    receive_payloads = media_session->priv->receive_payloads;
+    g_rw_lock_reader_lock(&media_session->priv->rw_lock);
+
+    for (i = 0; i < receive_payloads->len && !inband_fec; i++) {
+        payload = g_ptr_array_index(receive_payloads, i);
+        g_object_get(payload, "codec-type", &codec_type, "fec-percentage", &fec_percentage,
+            "adaptive-fec", &adaptive_fec, NULL);
+        inband_fec = codec_type == OWR_CODEC_TYPE_OPUS && (fec_percentage || adaptive_fec);
+    }
+
+    g_rw_lock_reader_unlock(&media_session->priv->rw_lock);
+
+    return inband_fec;
+}
+
 /**
  * _owr_media_session_get_send_payload:
  * @media_session:
@@ -745,6 +1179,32 @@ OwrMediaSource * _owr_media_session_get_send_source(OwrMediaSession *media_sessi
     return source;
 }
 
+/**
+ * _owr_media_session_update_round_trip_time:
+ * @media_session:
+ * @round_trip_time: a new round trip time sample in ms
+ *
+ * Folds the sample into round-trip-time the way TCP smooths its RTT
+ * estimate, so a single delayed report does not retune retransmissions.
+ */
+void _owr_media_session_update_round_trip_time(OwrMediaSession *media_session, guint round_trip_time)
+{
+    OwrMediaSessionPrivate *priv;
+    guint smoothed;
+
+    g_return_if_fail(OWR_IS_MEDIA_SESSION(media_session));
+
+    priv = media_session->priv;
+    smoothed = priv->round_trip_time ? (7 * priv->round_trip_time + round_trip_time) / 8
+        : round_trip_time;
+    smoothed = MAX(smoothed, 1);
+
+    if (smoothed != priv->round_trip_time) {
+        priv->round_trip_time = smoothed;
+        g_object_notify_by_pspec(G_OBJECT(media_session), obj_properties[PROP_ROUND_TRIP_TIME]);
+    }
+}
+
 /**
  * _owr_media_session_set_on_send_payload:
  * @media_session:
@@ -779,6 +1239,40 @@ void _owr_media_session_set_on_send_source(OwrMediaSession *media_session, GClos
     g_closure_set_marshal(media_session->priv->on_send_source, g_cclosure_marshal_generic);
 }
 
+/**
+ * _owr_media_session_set_on_forward_source:
+ * @media_session:
+ * @on_forward_source: (transfer full):
+ *
+ */
+void _owr_media_session_set_on_forward_source(OwrMediaSession *media_session, GClosure *on_forward_source)
+{
+    g_return_if_fail(OWR_IS_MEDIA_SESSION(media_session));
+    g_return_if_fail(on_forward_source);
+
+    if (media_session->priv->on_forward_source)
+        g_closure_unref(media_session->priv->on_forward_source);
+    media_session->priv->on_forward_source = on_forward_source;
+    g_closure_set_marshal(media_session->priv->on_forward_source, g_cclosure_marshal_generic);
+}
+
+/**
+ * _owr_media_session_set_on_forward_sink:
+ * @media_session:
+ * @on_forward_sink: (transfer full):
+ *
+ */
+void _owr_media_session_set_on_forward_sink(OwrMediaSession *media_session, GClosure *on_forward_sink)
+{
+    g_return_if_fail(OWR_IS_MEDIA_SESSION(media_session));
+    g_return_if_fail(on_forward_sink);
+
+    if (media_session->priv->on_forward_sink)
+        g_closure_unref(media_session->priv->on_forward_sink);
+    media_session->priv->on_forward_sink = on_forward_sink;
+    g_closure_set_marshal(media_session->priv->on_forward_sink, g_cclosure_marshal_generic);
+}
+
 void _owr_media_session_clear_closures(OwrMediaSession *media_session)
 {
     if (media_session->priv->on_send_payload) {
@@ -793,6 +1287,18 @@ void _owr_media_session_clear_closures(OwrMediaSession *media_session)
         media_session->priv->on_send_source = NULL;
     }
 
+    if (media_session->priv->on_forward_source) {
+        g_closure_invalidate(media_session->priv->on_forward_source);
+        g_closure_unref(media_session->priv->on_forward_source);
+        media_session->priv->on_forward_source = NULL;
+    }
+
+    if (media_session->priv->on_forward_sink) {
+        g_closure_invalidate(media_session->priv->on_forward_sink);
+        g_closure_unref(media_session->priv->on_forward_sink);
+        media_session->priv->on_forward_sink = NULL;
+    }
+
     _owr_session_clear_closures(OWR_SESSION(media_session));
 }
 
@@ -35,6 +35,7 @@
 #include "owr_media_source.h"
 #include "owr_payload.h"
 #include "owr_remote_media_source.h"
+#include "owr_send_encoding.h"
 #include "owr_session.h"
 
 #include <glib-object.h>
@@ -80,8 +81,10 @@ GType owr_media_session_get_type(void) G_GNUC_CONST;
 
 OwrMediaSession * owr_media_session_new(gboolean dtls_client_mode);
 void owr_media_session_add_receive_payload(OwrMediaSession *media_session, OwrPayload *payload);
+void owr_media_session_add_send_encoding(OwrMediaSession *media_session, OwrSendEncoding *send_encoding);
 void owr_media_session_set_send_payload(OwrMediaSession *media_session, OwrPayload *payload);
 void owr_media_session_set_send_source(OwrMediaSession *media_session, OwrMediaSource *source);
+void owr_media_session_set_forward_session(OwrMediaSession *media_session, OwrMediaSession *receive_session);
 
 G_END_DECLS
 
@@ -41,12 +41,22 @@ G_BEGIN_DECLS
 OwrPayload * _owr_media_session_get_receive_payload(OwrMediaSession *media_session, guint32 payload_type);
 OwrPayload * _owr_media_session_get_send_payload(OwrMediaSession *media_session);
 OwrMediaSource * _owr_media_session_get_send_source(OwrMediaSession *media_session);
+GList * _owr_media_session_get_send_encodings(OwrMediaSession *media_session);
+gboolean _owr_media_session_has_send_encodings(OwrMediaSession *media_session);
+GstElement * _owr_media_session_get_forward_source(OwrMediaSession *media_session);
+GList * _owr_media_session_get_forward_sinks(OwrMediaSession *media_session);
 
 gboolean _owr_media_session_want_receive_rtx(OwrMediaSession *media_session);
 GstStructure * _owr_media_session_get_receive_rtx_pt_map(OwrMediaSession *media_session);
+gint _owr_media_session_get_receive_red_payload_type(OwrMediaSession *media_session);
+gint _owr_media_session_get_receive_ulpfec_payload_type(OwrMediaSession *media_session);
+gboolean _owr_media_session_want_receive_inband_fec(OwrMediaSession *media_session);
+void _owr_media_session_update_round_trip_time(OwrMediaSession *media_session, guint round_trip_time);
 
 void _owr_media_session_set_on_send_payload(OwrMediaSession *media_session, GClosure *on_send_payload);
 void _owr_media_session_set_on_send_source(OwrMediaSession *media_session, GClosure *on_send_source);
+void _owr_media_session_set_on_forward_source(OwrMediaSession *media_session, GClosure *on_forward_source);
+void _owr_media_session_set_on_forward_sink(OwrMediaSession *media_session, GClosure *on_forward_sink);
 void _owr_media_session_clear_closures(OwrMediaSession *media_session);
 
 GstBuffer * _owr_media_session_get_srtp_key_buffer(OwrMediaSession *media_session, const gchar *keyname);
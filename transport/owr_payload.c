@@ -52,12 +52,25 @@ GST_DEBUG_CATEGORY_EXTERN(_owrpayload_debug);
 
 #define DEFAULT_MTU 1200
 #define DEFAULT_BITRATE 0
-#define DEFAULT_RTX_TIME 0    /* FIXME: what's a sane default here? */
+#define DEFAULT_RTX_TIME 0    /* follow the measured round trip time */
+#define DEFAULT_FEC_PERCENTAGE 0
+#define DEFAULT_ADAPTIVE_FEC FALSE
+
+#define FEC_MIN_LOSS_PERCENTAGE 1
+#define FEC_MAX_PERCENTAGE 50
+#define FEC_DECREASE_STEP 2
 
 #define LIMITED_WIDTH 640
 #define LIMITED_HEIGHT 480
 #define LIMITED_FRAMERATE 30.0
 
+/* Enhancement layers are sent while the bitrate budget leaves the frames of
+ * all sent layers at least this many bits per pixel, an enhancement layer is
+ * only taken back once the budget exceeds its need by the headroom */
+#define TEMPORAL_LAYER_MIN_BITS_PER_PIXEL 0.05
+#define TEMPORAL_LAYER_UPGRADE_HEADROOM 1.3
+#define TEMPORAL_LAYER_DROPPER_KEY "owr-temporal-layer-dropper"
+
 #define TARGET_BITS_PER_PIXEL 0.1 /* 640x360 15fps @ 768kbps =~ 0.2bpp */
 
 #define OWR_PAYLOAD_GET_PRIVATE(obj)    (G_TYPE_INSTANCE_GET_PRIVATE((obj), OWR_TYPE_PAYLOAD, OwrPayloadPrivate))
@@ -72,6 +85,10 @@ struct _OwrPayloadPrivate {
     guint bitrate;
     gint rtx_payload_type;      /* -1 => no retransmission, else payload type for rtx pt map */
     guint rtx_time;             /* milliseconds */
+    gint red_payload_type;      /* -1 => no RED encapsulation */
+    gint ulpfec_payload_type;   /* -1 => no ULPFEC */
+    guint fec_percentage;
+    gboolean adaptive_fec;
     OwrAdaptationType adaptation;
 };
 
@@ -86,6 +103,10 @@ enum {
     PROP_BITRATE,
     PROP_RTX_PAYLOAD_TYPE,
     PROP_RTX_TIME,
+    PROP_RED_PAYLOAD_TYPE,
+    PROP_ULPFEC_PAYLOAD_TYPE,
+    PROP_FEC_PERCENTAGE,
+    PROP_ADAPTIVE_FEC,
     PROP_ADAPTATION,
     N_PROPERTIES
 };
@@ -128,6 +149,22 @@ static void owr_payload_set_property(GObject *object, guint property_id, const G
     case PROP_RTX_TIME:
         priv->rtx_time = g_value_get_uint(value);
         break;
+    case PROP_RED_PAYLOAD_TYPE:
+        pt = g_value_get_int(value);
+        g_return_if_fail(pt == -1 || pt >= 96);
+        priv->red_payload_type = pt;
+        break;
+    case PROP_ULPFEC_PAYLOAD_TYPE:
+        pt = g_value_get_int(value);
+        g_return_if_fail(pt == -1 || pt >= 96);
+        priv->ulpfec_payload_type = pt;
+        break;
+    case PROP_FEC_PERCENTAGE:
+        priv->fec_percentage = g_value_get_uint(value);
+        break;
+    case PROP_ADAPTIVE_FEC:
+        priv->adaptive_fec = g_value_get_boolean(value);
+        break;
     case PROP_ADAPTATION:
         priv->adaptation = g_value_get_enum(value);
         break;
@@ -172,6 +209,18 @@ static void owr_payload_get_property(GObject *object, guint property_id, GValue
     case PROP_RTX_TIME:
         g_value_set_uint(value, priv->rtx_time);
         break;
+    case PROP_RED_PAYLOAD_TYPE:
+        g_value_set_int(value, priv->red_payload_type);
+        break;
+    case PROP_ULPFEC_PAYLOAD_TYPE:
+        g_value_set_int(value, priv->ulpfec_payload_type);
+        break;
+    case PROP_FEC_PERCENTAGE:
+        g_value_set_uint(value, priv->fec_percentage);
+        break;
+    case PROP_ADAPTIVE_FEC:
+        g_value_set_boolean(value, priv->adaptive_fec);
+        break;
     case PROP_ADAPTATION:
         g_value_set_enum(value, priv->adaptation);
         break;
@@ -220,10 +269,33 @@ static void owr_payload_class_init(OwrPayloadClass *klass)
         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
     obj_properties[PROP_RTX_TIME] = g_param_spec_uint("rtx-time", "Retransmission buffer time",
-        "How long a packet should be kept in buffers for retransmission (milliseconds, 0 means use the default)",
+        "How long a packet should be kept in buffers for retransmission (milliseconds, 0 means follow the measured round trip time)",
         0, G_MAXUINT, DEFAULT_RTX_TIME,
         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+    obj_properties[PROP_RED_PAYLOAD_TYPE] = g_param_spec_int("red-payload-type", "RED payload type",
+        "The payload type to use for RED encapsulation of media and FEC packets. Retransmissions "
+        "then protect the RED payload type (-1 means no RED)",
+        -1, 127, OWR_FEC_PAYLOAD_TYPE_DISABLED,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_ULPFEC_PAYLOAD_TYPE] = g_param_spec_int("ulpfec-payload-type", "ULPFEC payload type",
+        "The payload type to use for ULPFEC packets (-1 means no ULPFEC)",
+        -1, 127, OWR_FEC_PAYLOAD_TYPE_DISABLED,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_FEC_PERCENTAGE] = g_param_spec_uint("fec-percentage", "FEC percentage",
+        "The forward error correction overhead relative to the media (ULPFEC) or the "
+        "expected packet loss (Opus in-band FEC), in percent. On an Opus receive payload "
+        "a non-zero value or adaptive-fec enables decoding of the in-band FEC",
+        0, 100, DEFAULT_FEC_PERCENTAGE,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_ADAPTIVE_FEC] = g_param_spec_boolean("adaptive-fec", "Adaptive FEC",
+        "Whether fec-percentage follows the packet loss reported by the receiver",
+        DEFAULT_ADAPTIVE_FEC,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
     obj_properties[PROP_MTU] = g_param_spec_uint("mtu", "MTU",
         "The maximum size of one RTP packet (in bytes)",
         0, G_MAXUINT, DEFAULT_MTU,
@@ -245,6 +317,10 @@ static void owr_payload_init(OwrPayload *payload)
 
     payload->priv->rtx_payload_type = -1;
     payload->priv->rtx_time = DEFAULT_RTX_TIME;
+    payload->priv->red_payload_type = OWR_FEC_PAYLOAD_TYPE_DISABLED;
+    payload->priv->ulpfec_payload_type = OWR_FEC_PAYLOAD_TYPE_DISABLED;
+    payload->priv->fec_percentage = DEFAULT_FEC_PERCENTAGE;
+    payload->priv->adaptive_fec = DEFAULT_ADAPTIVE_FEC;
 }
 
 
@@ -254,22 +330,29 @@ static void owr_payload_init(OwrPayload *payload)
 static const gchar *OwrCodecTypePayElementName[] = { NULL, "rtppcmupay", "rtppcmapay", "rtpopuspay", "rtph264pay", "rtpvp8pay", "rtpvp9pay" };
 static const gchar *OwrCodecTypeDepayElementName[] = { NULL, "rtppcmudepay", "rtppcmadepay", "rtpopusdepay", "rtph264depay", "rtpvp8depay", "rtpvp9depay" };
 
-static guint evaluate_bitrate_from_payload(OwrPayload *payload)
+/* Pixels per second of a video payload, unset dimensions count as the
+ * limited defaults */
+static gdouble get_pixel_rate(OwrPayload *payload)
 {
-    guint bitrate;
+    guint width = 0, height = 0;
+    gdouble framerate = 0.0;
 
-    if (!payload->priv->bitrate) {
-        guint width = 0, height = 0;
-        gdouble framerate = 0.0;
+    g_object_get(payload, "width", &width, "height", &height,
+        "framerate", &framerate, NULL);
+    width = width > 0 ? width : LIMITED_WIDTH;
+    height = height > 0 ? height : LIMITED_HEIGHT;
+    framerate = framerate > 0.0 ? framerate : LIMITED_FRAMERATE;
 
-        g_object_get(payload, "width", &width, "height", &height,
-            "framerate", &framerate, NULL);
-        width = width > 0 ? width : LIMITED_WIDTH;
-        height = height > 0 ? height : LIMITED_HEIGHT;
-        framerate = framerate > 0.0 ? framerate : LIMITED_FRAMERATE;
+    return width * height * framerate;
+}
 
-        bitrate = width * height * framerate * TARGET_BITS_PER_PIXEL;
-    } else
+guint _owr_payload_evaluate_bitrate(OwrPayload *payload)
+{
+    guint bitrate;
+
+    if (!payload->priv->bitrate)
+        bitrate = get_pixel_rate(payload) * TARGET_BITS_PER_PIXEL;
+    else
         bitrate = payload->priv->bitrate;
 
     return bitrate;
@@ -288,6 +371,247 @@ static gboolean binding_transform_to_kbps(GBinding *binding, const GValue *from_
     return TRUE;
 }
 
+static gboolean binding_transform_to_inband_fec(GBinding *binding, const GValue *from_value, GValue *to_value, gpointer user_data)
+{
+    OWR_UNUSED(binding);
+    OWR_UNUSED(user_data);
+
+    g_value_set_boolean(to_value, g_value_get_uint(from_value) > 0);
+
+    return TRUE;
+}
+
+/* Applies the OwrVideoPayload encoder tuning to vp8enc/vp9enc. Threads
+ * follow the resolution and core count like webrtc.org does, partitions
+ * (VP8 token partitions, VP9 tile columns of at least 256 pixels) follow the
+ * threads so that each thread gets its own. */
+static void configure_vpx_encoder(OwrPayload *payload, GstElement *encoder, gint default_cpu_used)
+{
+    GObjectClass *encoder_class = G_OBJECT_GET_CLASS(encoder);
+    guint width = 0, height = 0, threads = 0, cores, pixels;
+    gint partitions = -1, cpu_used = 0, max_partitions;
+    gboolean cpu_used_auto = TRUE;
+    gint64 deadline = G_GINT64_CONSTANT(1); /* VPX_DL_REALTIME */
+
+    if (OWR_IS_VIDEO_PAYLOAD(payload)) {
+        g_object_get(payload, "width", &width, "height", &height,
+            "encoder-threads", &threads, "encoder-partitions", &partitions,
+            "encoder-deadline", &deadline, "encoder-cpu-used", &cpu_used,
+            "encoder-cpu-used-auto", &cpu_used_auto, NULL);
+    }
+    width = width > 0 ? width : LIMITED_WIDTH;
+    height = height > 0 ? height : LIMITED_HEIGHT;
+    pixels = width * height;
+
+    if (!threads) {
+        cores = g_get_num_processors();
+        if (pixels >= 1920 * 1080 && cores > 8)
+            threads = 8;
+        else if (pixels >= 1280 * 960 && cores >= 6)
+            threads = 3;
+        else if (pixels >= 640 * 480 && cores >= 3)
+            threads = 2;
+        else
+            threads = 1;
+    }
+
+    if (payload->priv->codec_type == OWR_CODEC_TYPE_VP8)
+        max_partitions = 3;
+    else
+        for (max_partitions = 0; (width >> (max_partitions + 1)) >= 256; max_partitions++);
+
+    if (partitions < 0)
+        for (partitions = 0; (1u << (partitions + 1)) <= threads; partitions++);
+    partitions = MIN(partitions, max_partitions);
+
+    g_object_set(encoder,
+        "threads", threads,
+        "deadline", deadline,
+        "cpu-used", cpu_used_auto ? default_cpu_used : cpu_used,
+        NULL);
+    if (payload->priv->codec_type == OWR_CODEC_TYPE_VP8) {
+        if (g_object_class_find_property(encoder_class, "token-partitions"))
+            g_object_set(encoder, "token-partitions", partitions, NULL);
+    } else if (g_object_class_find_property(encoder_class, "tile-columns"))
+        g_object_set(encoder, "tile-columns", partitions, NULL);
+
+    GST_DEBUG_OBJECT(encoder, "%ux%u: %u threads, 2^%d partitions, deadline %" G_GINT64_FORMAT,
+        width, height, threads, partitions, deadline);
+}
+
+/* Temporal layer patterns of the libvpx examples and webrtc.org. Only base
+ * layer frames update a reference (the last frame buffer) and enhancement
+ * layer frames only reference it, so any enhancement layer frame can be
+ * dropped without breaking decoding of the frames that follow. */
+static const gint temporal_layer_ids_2[] = {0, 1};
+static const gint temporal_layer_ids_3[] = {0, 2, 1, 2};
+#define TEMPORAL_BASE_LAYER_FLAGS "no-ref-golden+no-ref-alt+no-upd-golden+no-upd-alt"
+#define TEMPORAL_ENHANCEMENT_LAYER_FLAGS \
+    "no-ref-golden+no-ref-alt+no-upd-last+no-upd-golden+no-upd-alt+no-upd-entropy"
+static const gint temporal_rate_decimators_2[] = {2, 1};
+static const gint temporal_rate_decimators_3[] = {4, 2, 1};
+/* Cumulative share of the bitrate up to and including each layer, in percent */
+static const gint temporal_bitrate_shares_2[] = {60, 100};
+static const gint temporal_bitrate_shares_3[] = {40, 60, 100};
+
+/* Enhancement layers can only be dropped when the encoder can be told which
+ * frames may be used as references and marks the layer of each frame. From
+ * GStreamer 1.20 vp8enc does both, the latter with a GstVP8Meta that
+ * rtpvp8pay also uses for the TID and TL0PICIDX descriptor fields. vp9enc
+ * marks nothing, so VP9 is sent without layers. */
+static gboolean encoder_supports_layer_flags(OwrCodecType codec_type)
+{
+    static gsize support = 0;
+    GstElementFactory *factory;
+    GstPluginFeature *feature = NULL;
+    GObjectClass *encoder_class;
+    gsize result = 1;
+
+    if (codec_type != OWR_CODEC_TYPE_VP8 || !GST_CHECK_VERSION(1, 20, 0))
+        return FALSE;
+
+    if (g_once_init_enter(&support)) {
+        factory = gst_element_factory_find("vp8enc");
+        if (factory) {
+            feature = gst_plugin_feature_load(GST_PLUGIN_FEATURE(factory));
+            gst_object_unref(factory);
+        }
+        if (feature) {
+            encoder_class = g_type_class_ref(gst_element_factory_get_element_type(GST_ELEMENT_FACTORY(feature)));
+            if (g_object_class_find_property(encoder_class, "temporal-scalability-layer-flags"))
+                result = 2;
+            g_type_class_unref(encoder_class);
+            gst_object_unref(feature);
+        }
+        g_once_init_leave(&support, result);
+    }
+
+    return support == 2;
+}
+
+static guint get_temporal_layers(OwrPayload *payload)
+{
+    guint temporal_layers = 1;
+
+    if (!OWR_IS_VIDEO_PAYLOAD(payload) || payload->priv->codec_type != OWR_CODEC_TYPE_VP8)
+        return 1;
+
+    g_object_get(payload, "temporal-layers", &temporal_layers, NULL);
+    if (temporal_layers > 1 && !encoder_supports_layer_flags(payload->priv->codec_type))
+        return 1;
+
+    return temporal_layers;
+}
+
+static const gint *get_temporal_layer_ids(guint temporal_layers, guint *periodicity)
+{
+    if (temporal_layers == 2) {
+        *periodicity = G_N_ELEMENTS(temporal_layer_ids_2);
+        return temporal_layer_ids_2;
+    }
+    *periodicity = G_N_ELEMENTS(temporal_layer_ids_3);
+    return temporal_layer_ids_3;
+}
+
+static gchar *create_temporal_layer_flags(const gint *layer_ids, guint periodicity)
+{
+    GString *flags;
+    guint i;
+
+    flags = g_string_new("<");
+    for (i = 0; i < periodicity; i++) {
+        g_string_append_printf(flags, "%s%s", i ? "," : "",
+            layer_ids[i] ? TEMPORAL_ENHANCEMENT_LAYER_FLAGS : TEMPORAL_BASE_LAYER_FLAGS);
+    }
+    g_string_append_c(flags, '>');
+
+    return g_string_free(flags, FALSE);
+}
+
+static GValueArray *int_value_array_new(const gint *values, guint n_values)
+{
+    GValueArray *array = g_value_array_new(n_values);
+    GValue value = G_VALUE_INIT;
+    guint i;
+
+    g_value_init(&value, G_TYPE_INT);
+    for (i = 0; i < n_values; i++) {
+        g_value_set_int(&value, values[i]);
+        g_value_array_append(array, &value);
+    }
+    g_value_unset(&value);
+
+    return array;
+}
+
+static gboolean binding_transform_to_layer_bitrates(GBinding *binding, const GValue *from_value,
+    GValue *to_value, gpointer user_data)
+{
+    guint temporal_layers = GPOINTER_TO_UINT(user_data), bitrate, i;
+    const gint *shares;
+    gint bitrates[3];
+
+    OWR_UNUSED(binding);
+
+    bitrate = g_value_get_uint(from_value);
+    shares = temporal_layers == 2 ? temporal_bitrate_shares_2 : temporal_bitrate_shares_3;
+    for (i = 0; i < temporal_layers; i++)
+        bitrates[i] = (gint) ((guint64) bitrate * shares[i] / 100);
+    g_value_take_boxed(to_value, int_value_array_new(bitrates, temporal_layers));
+
+    return TRUE;
+}
+
+static void configure_vpx_temporal_layers(OwrPayload *payload, GstElement *encoder)
+{
+    GObjectClass *encoder_class = G_OBJECT_GET_CLASS(encoder);
+    guint temporal_layers, periodicity;
+    const gint *layer_ids;
+    GValueArray *layer_id_array, *decimator_array;
+    gchar *layer_flags;
+
+    temporal_layers = get_temporal_layers(payload);
+
+    if (!g_object_class_find_property(encoder_class, "temporal-scalability-layer-flags")) {
+        if (OWR_IS_VIDEO_PAYLOAD(payload)) {
+            g_object_get(payload, "temporal-layers", &temporal_layers, NULL);
+            if (temporal_layers > 1)
+                GST_WARNING_OBJECT(encoder, "Encoder does not support droppable temporal layers");
+        }
+        return;
+    }
+
+    /* Pooled encoders may still carry the layering of their previous user */
+    if (temporal_layers < 2) {
+        g_object_set(encoder, "temporal-scalability-number-layers", 1,
+            "temporal-scalability-periodicity", 0, NULL);
+        return;
+    }
+
+    layer_ids = get_temporal_layer_ids(temporal_layers, &periodicity);
+    layer_id_array = int_value_array_new(layer_ids, periodicity);
+    decimator_array = int_value_array_new(temporal_layers == 2 ? temporal_rate_decimators_2
+        : temporal_rate_decimators_3, temporal_layers);
+    g_object_set(encoder,
+        "temporal-scalability-number-layers", temporal_layers,
+        "temporal-scalability-periodicity", periodicity,
+        "temporal-scalability-layer-id", layer_id_array,
+        "temporal-scalability-rate-decimator", decimator_array,
+        NULL);
+    g_value_array_free(layer_id_array);
+    g_value_array_free(decimator_array);
+
+    layer_flags = create_temporal_layer_flags(layer_ids, periodicity);
+    gst_util_set_object_arg(G_OBJECT(encoder), "temporal-scalability-layer-flags", layer_flags);
+    g_free(layer_flags);
+
+    _owr_codec_pool_add_binding(encoder, g_object_bind_property_full(payload, "bitrate",
+        encoder, "temporal-scalability-target-bitrate", G_BINDING_SYNC_CREATE,
+        binding_transform_to_layer_bitrates, NULL, GUINT_TO_POINTER(temporal_layers), NULL));
+
+    GST_DEBUG_OBJECT(encoder, "Encoding %u temporal layers", temporal_layers);
+}
+
 GstElement * _owr_payload_create_encoder(OwrPayload *payload)
 {
     GstElement *encoder = NULL;
@@ -298,9 +622,12 @@ GstElement * _owr_payload_create_encoder(OwrPayload *payload)
 
     g_return_val_if_fail(payload, NULL);
 
+    encoder = _owr_codec_pool_acquire(OWR_CODEC_POOL_ENCODER, payload->priv->codec_type);
+
     switch (payload->priv->codec_type) {
     case OWR_CODEC_TYPE_H264:
-        encoder = _owr_try_codecs(_owr_get_detected_h264_encoders(), "encoder");
+        if (!encoder)
+            encoder = _owr_try_codecs(_owr_get_detected_h264_encoders(), "encoder");
         g_return_val_if_fail(encoder, NULL);
 
         factory = gst_element_get_factory(encoder);
@@ -310,15 +637,16 @@ GstElement * _owr_payload_create_encoder(OwrPayload *payload)
             g_object_set(encoder, "gop-size", 0, NULL);
             gst_util_set_object_arg(G_OBJECT(encoder), "rate-control", "bitrate");
             gst_util_set_object_arg(G_OBJECT(encoder), "complexity", "low");
-            g_object_bind_property(payload, "bitrate", encoder, "bitrate", G_BINDING_SYNC_CREATE);
+            _owr_codec_pool_add_binding(encoder, g_object_bind_property(payload, "bitrate",
+                encoder, "bitrate", G_BINDING_SYNC_CREATE));
         } else if (!strcmp(factory_name, "x264enc")) {
-            g_object_bind_property_full(payload, "bitrate", encoder, "bitrate", G_BINDING_SYNC_CREATE,
-                binding_transform_to_kbps, NULL, NULL, NULL);
+            _owr_codec_pool_add_binding(encoder, g_object_bind_property_full(payload, "bitrate",
+                encoder, "bitrate", G_BINDING_SYNC_CREATE, binding_transform_to_kbps, NULL, NULL, NULL));
             gst_util_set_object_arg(G_OBJECT(encoder), "speed-preset", "ultrafast");
             gst_util_set_object_arg(G_OBJECT(encoder), "tune", "fastdecode+zerolatency");
         } else if (!strcmp(factory_name, "vtenc_h264")) {
-            g_object_bind_property_full(payload, "bitrate", encoder, "bitrate", G_BINDING_SYNC_CREATE,
-                binding_transform_to_kbps, NULL, NULL, NULL);
+            _owr_codec_pool_add_binding(encoder, g_object_bind_property_full(payload, "bitrate",
+                encoder, "bitrate", G_BINDING_SYNC_CREATE, binding_transform_to_kbps, NULL, NULL, NULL));
             g_object_set(encoder,
                 "allow-frame-reordering", FALSE,
                 "realtime", TRUE,
@@ -331,13 +659,15 @@ GstElement * _owr_payload_create_encoder(OwrPayload *payload)
                 NULL);
         } else if (strcmp(factory_name, "omxh264enc")) {
             /* Assume bits/s instead of kbit/s */
-            g_object_bind_property(payload, "bitrate", encoder, "bitrate", G_BINDING_SYNC_CREATE);
+            _owr_codec_pool_add_binding(encoder, g_object_bind_property(payload, "bitrate",
+                encoder, "bitrate", G_BINDING_SYNC_CREATE));
         }
-        g_object_set(payload, "bitrate", evaluate_bitrate_from_payload(payload), NULL);
+        g_object_set(payload, "bitrate", _owr_payload_evaluate_bitrate(payload), NULL);
         break;
 
     case OWR_CODEC_TYPE_VP8:
-        encoder = _owr_try_codecs(_owr_get_detected_vp8_encoders(), "encoder");
+        if (!encoder)
+            encoder = _owr_try_codecs(_owr_get_detected_vp8_encoders(), "encoder");
         g_return_val_if_fail(encoder, NULL);
 
 #if (defined(__APPLE__) && TARGET_OS_IPHONE && !TARGET_IPHONE_SIMULATOR) || defined(__ANDROID__)
@@ -348,8 +678,6 @@ GstElement * _owr_payload_create_encoder(OwrPayload *payload)
         /* values are inspired by webrtc.org values in vp8_impl.cc */
         g_object_set(encoder,
             "end-usage", 1, /* VPX_CBR */
-            "deadline", G_GINT64_CONSTANT(1), /* VPX_DL_REALTIME */
-            "cpu-used", cpu_used,
             "min-quantizer", 2,
             "buffer-initial-size", 300,
             "buffer-optimal-size", 300,
@@ -360,18 +688,20 @@ GstElement * _owr_payload_create_encoder(OwrPayload *payload)
             "error-resilient", 1,
             "keyframe-mode", 0, /* VPX_KF_DISABLED */
             NULL);
+        configure_vpx_encoder(payload, encoder, cpu_used);
+        configure_vpx_temporal_layers(payload, encoder);
 
-        g_object_bind_property(payload, "bitrate", encoder, "target-bitrate", G_BINDING_SYNC_CREATE);
-        g_object_set(payload, "bitrate", evaluate_bitrate_from_payload(payload), NULL);
+        _owr_codec_pool_add_binding(encoder, g_object_bind_property(payload, "bitrate",
+            encoder, "target-bitrate", G_BINDING_SYNC_CREATE));
+        g_object_set(payload, "bitrate", _owr_payload_evaluate_bitrate(payload), NULL);
         break;
     case OWR_CODEC_TYPE_VP9:
-        encoder = _owr_try_codecs(_owr_get_detected_vp9_encoders(), "encoder");
+        if (!encoder)
+            encoder = _owr_try_codecs(_owr_get_detected_vp9_encoders(), "encoder");
         g_return_val_if_fail(encoder, NULL);
         /* values are inspired by webrtc.org values in vp9_impl.cc */
         g_object_set(encoder,
             "end-usage", 1, /* VPX_CBR */
-            "deadline", G_GINT64_CONSTANT(1), /* VPX_DL_REALTIME */
-            "cpu-used", 3,
             "min-quantizer", 2,
             "max-quantizer", 52,
             "buffer-initial-size", 500,
@@ -384,11 +714,16 @@ GstElement * _owr_payload_create_encoder(OwrPayload *payload)
             "resize-allowed", TRUE,
             "keyframe-mode", 0, /* VPX_KF_DISABLED */
             NULL);
+        configure_vpx_encoder(payload, encoder, 3);
+        configure_vpx_temporal_layers(payload, encoder);
 
-        g_object_bind_property(payload, "bitrate", encoder, "target-bitrate", G_BINDING_SYNC_CREATE);
-        g_object_set(payload, "bitrate", evaluate_bitrate_from_payload(payload), NULL);
+        _owr_codec_pool_add_binding(encoder, g_object_bind_property(payload, "bitrate",
+            encoder, "target-bitrate", G_BINDING_SYNC_CREATE));
+        g_object_set(payload, "bitrate", _owr_payload_evaluate_bitrate(payload), NULL);
         break;
     default:
+        if (encoder)
+            break;
         element_name = g_strdup_printf("encoder_%s_%u", _owr_get_encoder_name(payload->priv->codec_type), _owr_get_unique_uint_id());
         encoder = gst_element_factory_make(_owr_get_encoder_name(payload->priv->codec_type), element_name);
         g_free(element_name);
@@ -396,6 +731,18 @@ GstElement * _owr_payload_create_encoder(OwrPayload *payload)
         break;
     }
 
+    if (payload->priv->codec_type == OWR_CODEC_TYPE_OPUS) {
+        /* In-band FEC is paid for out of the Opus bitrate, so it is only
+         * switched on while the receiver reports loss */
+        _owr_codec_pool_add_binding(encoder, g_object_bind_property(payload, "fec-percentage",
+            encoder, "packet-loss-percentage", G_BINDING_SYNC_CREATE));
+        _owr_codec_pool_add_binding(encoder, g_object_bind_property_full(payload, "fec-percentage",
+            encoder, "inband-fec", G_BINDING_SYNC_CREATE, binding_transform_to_inband_fec,
+            NULL, NULL, NULL));
+    }
+
+    _owr_codec_pool_mark(encoder, OWR_CODEC_POOL_ENCODER, payload->priv->codec_type);
+
     return encoder;
 }
 
@@ -426,6 +773,11 @@ GstElement * _owr_payload_create_payload_packetizer(OwrPayload *payload)
     case OWR_MEDIA_TYPE_VIDEO:
         if (payload->priv->codec_type == OWR_CODEC_TYPE_H264)
             g_object_set(pay, "config-interval", 1, NULL);
+        else if (get_temporal_layers(payload) > 1
+            && g_object_class_find_property(G_OBJECT_GET_CLASS(pay), "picture-id-mode")) {
+            /* Lets receivers tell dropped enhancement layer frames from losses */
+            gst_util_set_object_arg(G_OBJECT(pay), "picture-id-mode", "15-bit");
+        }
         break;
 
     default:
@@ -627,37 +979,268 @@ GstCaps * _owr_payload_create_encoded_caps(OwrPayload *payload)
     return caps;
 }
 
+typedef struct {
+    guint temporal_layers;
+    guint max_layer;
+    GMutex lock;
+} TemporalLayerDropper;
+
+static void temporal_layer_dropper_free(TemporalLayerDropper *dropper)
+{
+    g_mutex_clear(&dropper->lock);
+    g_slice_free(TemporalLayerDropper, dropper);
+}
+
+/* The layers up to max_layer make up 1 / decimator of the frames */
+static guint temporal_layer_min_bitrate(TemporalLayerDropper *dropper, gdouble pixel_rate,
+    guint max_layer)
+{
+    const gint *decimators = dropper->temporal_layers == 2 ? temporal_rate_decimators_2
+        : temporal_rate_decimators_3;
+
+    return pixel_rate / decimators[max_layer] * TEMPORAL_LAYER_MIN_BITS_PER_PIXEL;
+}
+
+static void on_temporal_layer_bitrate(OwrPayload *payload, GParamSpec *pspec, GstElement *payloader)
+{
+    TemporalLayerDropper *dropper;
+    guint bitrate, max_layer;
+    gdouble pixel_rate;
+
+    OWR_UNUSED(pspec);
+
+    dropper = g_object_get_data(G_OBJECT(payloader), TEMPORAL_LAYER_DROPPER_KEY);
+    g_return_if_fail(dropper);
+
+    bitrate = _owr_payload_evaluate_bitrate(payload);
+    pixel_rate = get_pixel_rate(payload);
+
+    g_mutex_lock(&dropper->lock);
+    max_layer = dropper->max_layer;
+    while (max_layer > 0 && bitrate < temporal_layer_min_bitrate(dropper, pixel_rate, max_layer))
+        max_layer--;
+    while (max_layer + 1 < dropper->temporal_layers && bitrate
+        >= temporal_layer_min_bitrate(dropper, pixel_rate, max_layer + 1) * TEMPORAL_LAYER_UPGRADE_HEADROOM)
+        max_layer++;
+    if (max_layer != dropper->max_layer) {
+        GST_INFO_OBJECT(payloader, "Bitrate is %u, sending temporal layers up to %u", bitrate,
+            max_layer);
+        dropper->max_layer = max_layer;
+    }
+    g_mutex_unlock(&dropper->lock);
+}
+
+static GstPadProbeReturn drop_temporal_layer(GstPad *pad, GstPadProbeInfo *info,
+    TemporalLayerDropper *dropper)
+{
+#if GST_CHECK_VERSION(1, 20, 0)
+    GstCustomMeta *meta;
+    GstStructure *structure;
+    gboolean use_temporal_scaling = FALSE, drop;
+    guint layer_id = 0;
+
+    OWR_UNUSED(pad);
+
+    /* Set by vp8enc on every frame it encodes with temporal layers */
+    meta = gst_buffer_get_custom_meta(GST_PAD_PROBE_INFO_BUFFER(info), "GstVP8Meta");
+    if (!meta)
+        return GST_PAD_PROBE_OK;
+
+    structure = gst_custom_meta_get_structure(meta);
+    if (!gst_structure_get_boolean(structure, "use-temporal-scaling", &use_temporal_scaling)
+        || !use_temporal_scaling || !gst_structure_get_uint(structure, "layer-id", &layer_id))
+        return GST_PAD_PROBE_OK;
+
+    g_mutex_lock(&dropper->lock);
+    drop = layer_id > dropper->max_layer;
+    g_mutex_unlock(&dropper->lock);
+
+    return drop ? GST_PAD_PROBE_DROP : GST_PAD_PROBE_OK;
+#else
+    OWR_UNUSED(pad);
+    OWR_UNUSED(info);
+    OWR_UNUSED(dropper);
+
+    return GST_PAD_PROBE_OK;
+#endif
+}
+
+/*
+ * _owr_payload_drop_temporal_layers:
+ * @payloader: the payloader sending @payload
+ *
+ * Stops forwarding enhancement layers to @payloader while the bitrate of
+ * @payload is too low to give the frames of all layers a usable quality,
+ * which lowers the framerate at once without requiring a keyframe.
+ */
+void _owr_payload_drop_temporal_layers(OwrPayload *payload, GstElement *payloader)
+{
+    TemporalLayerDropper *dropper;
+    guint temporal_layers;
+    GstPad *pad;
+
+    g_return_if_fail(OWR_IS_PAYLOAD(payload));
+    g_return_if_fail(GST_IS_ELEMENT(payloader));
+
+    temporal_layers = get_temporal_layers(payload);
+    if (temporal_layers < 2)
+        return;
+
+    dropper = g_slice_new0(TemporalLayerDropper);
+    dropper->temporal_layers = temporal_layers;
+    dropper->max_layer = temporal_layers - 1;
+    g_mutex_init(&dropper->lock);
+    g_object_set_data_full(G_OBJECT(payloader), TEMPORAL_LAYER_DROPPER_KEY, dropper,
+        (GDestroyNotify) temporal_layer_dropper_free);
+
+    g_signal_connect_object(payload, "notify::bitrate", G_CALLBACK(on_temporal_layer_bitrate),
+        payloader, 0);
+    on_temporal_layer_bitrate(payload, NULL, payloader);
+
+    pad = gst_element_get_static_pad(payloader, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, (GstPadProbeCallback) drop_temporal_layer,
+        dropper, NULL);
+    gst_object_unref(pad);
+}
+
+/*
+ * _owr_payload_update_packet_loss:
+ * @loss_percentage: the fraction of packets lost in the last reporting
+ * interval, as reported by the receiver
+ *
+ * Moves fec-percentage towards the reported loss when adaptive FEC is on.
+ * Protection is raised as soon as loss shows up and lowered gradually, so a
+ * single clean report does not leave the next burst unprotected.
+ */
+void _owr_payload_update_packet_loss(OwrPayload *payload, guint loss_percentage)
+{
+    OwrPayloadPrivate *priv;
+    guint target, fec_percentage;
+
+    g_return_if_fail(OWR_IS_PAYLOAD(payload));
+
+    priv = payload->priv;
+    if (!priv->adaptive_fec)
+        return;
+
+    target = loss_percentage < FEC_MIN_LOSS_PERCENTAGE ? 0
+        : MIN(2 * loss_percentage, FEC_MAX_PERCENTAGE);
+
+    if (target >= priv->fec_percentage)
+        fec_percentage = target;
+    else if (priv->fec_percentage - target > FEC_DECREASE_STEP)
+        fec_percentage = priv->fec_percentage - FEC_DECREASE_STEP;
+    else
+        fec_percentage = target;
+
+    if (fec_percentage != priv->fec_percentage) {
+        GST_DEBUG("Packet loss %u%%, FEC percentage %u -> %u", loss_percentage,
+            priv->fec_percentage, fec_percentage);
+        g_object_set(payload, "fec-percentage", fec_percentage, NULL);
+    }
+}
+
+/*
+ * _owr_payload_get_media_bitrate:
+ * Returns: the part of @bitrate left for the encoder once the ULPFEC
+ * overhead of @payload is sent on top of the media
+ */
+guint _owr_payload_get_media_bitrate(OwrPayload *payload, guint bitrate)
+{
+    g_return_val_if_fail(OWR_IS_PAYLOAD(payload), bitrate);
+
+    if (payload->priv->ulpfec_payload_type < 0)
+        return bitrate;
+
+    return (guint) ((guint64) bitrate * 100 / (100 + payload->priv->fec_percentage));
+}
+
+/*
+ * _owr_payload_clone:
+ * Returns: (transfer full): a new payload of the same type with all writable
+ * properties copied from @payload
+ */
+OwrPayload * _owr_payload_clone(OwrPayload *payload)
+{
+    GObjectClass *klass;
+    GParamSpec **pspecs;
+    const gchar **names;
+    GValue *values;
+    OwrPayload *clone;
+    guint n_pspecs, n_values = 0, i;
+#if !GLIB_CHECK_VERSION(2, 54, 0)
+    GParameter *params;
+#endif
+
+    g_return_val_if_fail(OWR_IS_PAYLOAD(payload), NULL);
+
+    klass = G_OBJECT_GET_CLASS(payload);
+    pspecs = g_object_class_list_properties(klass, &n_pspecs);
+    names = g_new0(const gchar *, n_pspecs);
+    values = g_new0(GValue, n_pspecs);
+
+    for (i = 0; i < n_pspecs; i++) {
+        if ((pspecs[i]->flags & G_PARAM_READWRITE) != G_PARAM_READWRITE)
+            continue;
+        names[n_values] = pspecs[i]->name;
+        g_value_init(&values[n_values], pspecs[i]->value_type);
+        g_object_get_property(G_OBJECT(payload), pspecs[i]->name, &values[n_values]);
+        n_values++;
+    }
+
+#if GLIB_CHECK_VERSION(2, 54, 0)
+    clone = OWR_PAYLOAD(g_object_new_with_properties(G_OBJECT_TYPE(payload), n_values, names, values));
+#else
+    params = g_new0(GParameter, n_values);
+    for (i = 0; i < n_values; i++) {
+        params[i].name = names[i];
+        params[i].value = values[i];
+    }
+    clone = g_object_newv(G_OBJECT_TYPE(payload), n_values, params);
+    g_free(params);
+#endif
+
+    for (i = 0; i < n_values; i++)
+        g_value_unset(&values[i]);
+    g_free(values);
+    g_free(names);
+    g_free(pspecs);
+
+    return clone;
+}
+
 gboolean owr_payload_supported(OwrCodecType codec_type)
 {
   gboolean supported = FALSE;
-  GstElement* encoder = NULL;
+  GstElement* encoder = _owr_codec_pool_acquire(OWR_CODEC_POOL_ENCODER, codec_type);
   GstElement* decoder = _owr_create_decoder(codec_type);
 
-  switch (codec_type) {
-  case OWR_CODEC_TYPE_H264:
-      encoder = _owr_try_codecs(_owr_get_detected_h264_encoders(), NULL);
-      break;
-  case OWR_CODEC_TYPE_VP8:
-      encoder = _owr_try_codecs(_owr_get_detected_vp8_encoders(), NULL);
-      break;
-  case OWR_CODEC_TYPE_VP9:
-      encoder = _owr_try_codecs(_owr_get_detected_vp9_encoders(), NULL);
-      break;
-  default:
-      encoder = gst_element_factory_make(_owr_get_encoder_name(codec_type), NULL);
+  if (!encoder) {
+      switch (codec_type) {
+      case OWR_CODEC_TYPE_H264:
+          encoder = _owr_try_codecs(_owr_get_detected_h264_encoders(), "encoder");
+          break;
+      case OWR_CODEC_TYPE_VP8:
+          encoder = _owr_try_codecs(_owr_get_detected_vp8_encoders(), "encoder");
+          break;
+      case OWR_CODEC_TYPE_VP9:
+          encoder = _owr_try_codecs(_owr_get_detected_vp9_encoders(), "encoder");
+          break;
+      default:
+          encoder = gst_element_factory_make(_owr_get_encoder_name(codec_type), NULL);
+      }
   }
 
   supported = encoder && decoder;
 
+  /* The probed elements warm up the pool for the first sessions */
   if (encoder) {
-      gst_element_set_state(encoder, GST_STATE_NULL);
-      gst_object_unref(encoder);
+      _owr_codec_pool_mark(encoder, OWR_CODEC_POOL_ENCODER, codec_type);
+      _owr_codec_pool_release(encoder);
   }
 
-  if (decoder) {
-      gst_element_set_state(decoder, GST_STATE_NULL);
-      gst_object_unref(decoder);
-  }
+  if (decoder)
+      _owr_codec_pool_release(decoder);
 
   return supported;
 }
@@ -46,6 +46,7 @@ G_BEGIN_DECLS
 #define OWR_PAYLOAD_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj), OWR_TYPE_PAYLOAD, OwrPayloadClass))
 
 #define OWR_RTX_PAYLOAD_TYPE_DISABLED -1
+#define OWR_FEC_PAYLOAD_TYPE_DISABLED -1
 
 typedef struct _OwrPayload        OwrPayload;
 typedef struct _OwrPayloadClass   OwrPayloadClass;
@@ -29,6 +29,7 @@
 #define __OWR_PAYLOAD_PRIVATE_H__
 
 #include "owr_types.h"
+#include "owr_video_payload.h"
 
 #include <gst/gst.h>
 
@@ -45,6 +46,16 @@ OwrCodecType _owr_payload_get_codec_type(OwrPayload *payload);
 GstCaps * _owr_payload_create_rtp_caps(OwrPayload *payload);
 GstCaps * _owr_payload_create_raw_caps(OwrPayload *payload);
 GstCaps * _owr_payload_create_encoded_caps(OwrPayload *payload);
+guint _owr_payload_evaluate_bitrate(OwrPayload *payload);
+void _owr_payload_update_packet_loss(OwrPayload *payload, guint loss_percentage);
+guint _owr_payload_get_media_bitrate(OwrPayload *payload, guint bitrate);
+OwrPayload * _owr_payload_clone(OwrPayload *payload);
+void _owr_payload_drop_temporal_layers(OwrPayload *payload, GstElement *payloader);
+void _owr_video_payload_setup_degradation(OwrVideoPayload *payload, GstElement *input,
+    GstElement *capsfilter);
+void _owr_video_payload_setup_keyframe_control(OwrVideoPayload *payload, GstElement *encoder,
+    GstElement *encoder_output);
+void _owr_video_payload_count_keyframes(OwrVideoPayload *payload, GstPad *pad);
 
 G_END_DECLS
 
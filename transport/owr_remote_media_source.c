@@ -124,7 +124,7 @@ OwrMediaSource *_owr_remote_media_source_new(OwrMediaType media_type,
         pad_name = g_strdup_printf("video_src_%u_%u_%u", codec_type, session_id, stream_id);
     } else if (media_type == OWR_MEDIA_TYPE_AUDIO) {
         bin_name = g_strdup_printf("audio-src-%u-%u", codec_type, stream_id);
-        pad_name = g_strdup_printf("audio_raw_src_%u_%u", session_id, stream_id);
+        pad_name = g_strdup_printf("audio_src_%u_%u_%u", codec_type, session_id, stream_id);
     } else
         g_assert_not_reached();
 
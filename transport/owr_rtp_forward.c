@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*/
+\*\ OwrRtpForward
+/*/
+
+/*
+ * Forwards the RTP received in one transport agent to a send session of
+ * another, without depayloading or decoding:
+ *
+ * receiving agent                          sending agent
+ * +--------+   +-----+   +------------+    +------------+   +---------+   +--------+
+ * | rtpbin +---+ tee +-+-+ inter*sink +----+ inter*src  +---+ rewrite +---+ rtpbin |
+ * +--------+   +-----+ | +------------+    +------------+   +---------+   +--------+
+ *                      +---> depay/decode
+ *
+ * SSRC and payload type are replaced with the ones of the send session and
+ * sequence numbers and timestamps stay continuous when the forwarded stream
+ * changes, either because the sender changed its SSRC or because the source
+ * was retargeted to another receiving session with
+ * _owr_rtp_forward_new_sink(). Key unit requests created by the sending
+ * rtpbin for incoming PLI/FIR travel upstream through the bridge and make the
+ * receiving rtpbin ask the original sender for a key frame.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "owr_rtp_forward.h"
+
+#include "owr_inter_sink.h"
+#include "owr_inter_src.h"
+#include "owr_utils.h"
+
+#include <gst/rtp/gstrtpbuffer.h>
+#include <gst/video/video.h>
+
+GST_DEBUG_CATEGORY_EXTERN(_owrrtpforward_debug);
+#define GST_CAT_DEFAULT _owrrtpforward_debug
+
+#define FORWARD_STATE_KEY "owr-rtp-forward-state"
+#define FORWARD_SINK_KEY "owr-rtp-forward-sink"
+#define FORWARD_INTER_SRC_KEY "owr-rtp-forward-inter-src"
+
+typedef struct {
+    GMutex lock;
+
+    /* Set by the sending agent, 0 and -1 keep the received values */
+    guint32 ssrc;
+    gint payload_type;
+
+    guint clock_rate;
+    gboolean is_video;
+
+    gboolean have_input;
+    /* Set when retargeted, the next packet starts a new input */
+    gboolean new_input;
+    guint32 input_ssrc;
+    guint16 seqnum_offset;
+    guint32 timestamp_offset;
+
+    guint16 last_seqnum;
+    guint32 last_timestamp;
+    GstClockTime last_pts;
+} ForwardState;
+
+static guint unique_bin_id = 0;
+
+static void forward_state_free(ForwardState *state)
+{
+    g_mutex_clear(&state->lock);
+    g_slice_free(ForwardState, state);
+}
+
+/* call with the state lock */
+static void rebase_on_new_input(ForwardState *state, guint32 ssrc, guint16 seqnum,
+    guint32 timestamp, GstClockTime pts)
+{
+    guint32 timestamp_delta = 1;
+
+    if (state->have_input) {
+        /* Continue where the previous stream left off, advancing the
+         * timestamp by the time that passed between the two streams */
+        if (state->clock_rate && GST_CLOCK_TIME_IS_VALID(pts)
+            && GST_CLOCK_TIME_IS_VALID(state->last_pts) && pts > state->last_pts) {
+            timestamp_delta = MAX(1, gst_util_uint64_scale(pts - state->last_pts,
+                state->clock_rate, GST_SECOND));
+        }
+        state->seqnum_offset = state->last_seqnum + 1 - seqnum;
+        state->timestamp_offset = state->last_timestamp + timestamp_delta - timestamp;
+    }
+
+    GST_DEBUG("Forwarding SSRC %u (was %u), seqnum offset %u, timestamp offset %u",
+        ssrc, state->input_ssrc, state->seqnum_offset, state->timestamp_offset);
+
+    state->have_input = TRUE;
+    state->new_input = FALSE;
+    state->input_ssrc = ssrc;
+}
+
+static gboolean rewrite_buffer(ForwardState *state, GstBuffer *buffer,
+    gboolean *request_key_unit)
+{
+    GstRTPBuffer rtp_buffer = GST_RTP_BUFFER_INIT;
+    guint32 ssrc, timestamp;
+    guint16 seqnum;
+
+    if (!gst_rtp_buffer_map(buffer, GST_MAP_READWRITE, &rtp_buffer)) {
+        GST_WARNING("Dropping invalid RTP packet");
+        return FALSE;
+    }
+
+    ssrc = gst_rtp_buffer_get_ssrc(&rtp_buffer);
+    seqnum = gst_rtp_buffer_get_seq(&rtp_buffer);
+    timestamp = gst_rtp_buffer_get_timestamp(&rtp_buffer);
+
+    g_mutex_lock(&state->lock);
+
+    if (!state->have_input || state->new_input || ssrc != state->input_ssrc) {
+        rebase_on_new_input(state, ssrc, seqnum, timestamp, GST_BUFFER_PTS(buffer));
+        /* The receiver can't decode the new stream before a key frame */
+        *request_key_unit |= state->is_video;
+    }
+
+    seqnum += state->seqnum_offset;
+    timestamp += state->timestamp_offset;
+    state->last_seqnum = seqnum;
+    state->last_timestamp = timestamp;
+    state->last_pts = GST_BUFFER_PTS(buffer);
+
+    gst_rtp_buffer_set_seq(&rtp_buffer, seqnum);
+    gst_rtp_buffer_set_timestamp(&rtp_buffer, timestamp);
+    if (state->ssrc)
+        gst_rtp_buffer_set_ssrc(&rtp_buffer, state->ssrc);
+    if (state->payload_type >= 0)
+        gst_rtp_buffer_set_payload_type(&rtp_buffer, state->payload_type);
+
+    g_mutex_unlock(&state->lock);
+
+    gst_rtp_buffer_unmap(&rtp_buffer);
+
+    return TRUE;
+}
+
+typedef struct {
+    ForwardState *state;
+    gboolean request_key_unit;
+} RewriteListData;
+
+static gboolean rewrite_list_item(GstBuffer **buffer, guint idx, RewriteListData *data)
+{
+    OWR_UNUSED(idx);
+
+    *buffer = gst_buffer_make_writable(*buffer);
+    if (!rewrite_buffer(data->state, *buffer, &data->request_key_unit)) {
+        gst_buffer_unref(*buffer);
+        *buffer = NULL;
+    }
+
+    return TRUE;
+}
+
+static GstEvent *rewrite_caps_event(ForwardState *state, GstEvent *event)
+{
+    GstCaps *caps;
+    GstStructure *structure;
+    gint clock_rate = 0;
+
+    gst_event_parse_caps(event, &caps);
+    caps = gst_caps_copy(caps);
+    gst_event_unref(event);
+
+    structure = gst_caps_get_structure(caps, 0);
+    gst_structure_get_int(structure, "clock-rate", &clock_rate);
+    /* The sending rtpbin picks its own bases */
+    gst_structure_remove_fields(structure, "seqnum-offset", "timestamp-offset",
+        "seqnum-base", "clock-base", NULL);
+
+    g_mutex_lock(&state->lock);
+    state->clock_rate = clock_rate > 0 ? clock_rate : 0;
+    state->is_video = !g_strcmp0(gst_structure_get_string(structure, "media"), "video");
+    if (state->ssrc)
+        gst_structure_set(structure, "ssrc", G_TYPE_UINT, state->ssrc, NULL);
+    if (state->payload_type >= 0)
+        gst_structure_set(structure, "payload", G_TYPE_INT, state->payload_type, NULL);
+    g_mutex_unlock(&state->lock);
+
+    GST_DEBUG("Forwarding with caps %" GST_PTR_FORMAT, caps);
+
+    event = gst_event_new_caps(caps);
+    gst_caps_unref(caps);
+
+    return event;
+}
+
+static GstPadProbeReturn rewrite_probe_cb(GstPad *pad, GstPadProbeInfo *info,
+    ForwardState *state)
+{
+    gboolean request_key_unit = FALSE;
+    GstPadProbeReturn ret = GST_PAD_PROBE_OK;
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+        GstBuffer *buffer = gst_buffer_make_writable(GST_PAD_PROBE_INFO_BUFFER(info));
+
+        GST_PAD_PROBE_INFO_DATA(info) = buffer;
+        if (!rewrite_buffer(state, buffer, &request_key_unit))
+            ret = GST_PAD_PROBE_DROP;
+    } else if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = gst_buffer_list_make_writable(GST_PAD_PROBE_INFO_BUFFER_LIST(info));
+        RewriteListData data = { state, FALSE };
+
+        GST_PAD_PROBE_INFO_DATA(info) = list;
+        gst_buffer_list_foreach(list, (GstBufferListFunc) rewrite_list_item, &data);
+        request_key_unit = data.request_key_unit;
+    } else if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+
+        if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS)
+            GST_PAD_PROBE_INFO_DATA(info) = rewrite_caps_event(state, event);
+    }
+
+    if (request_key_unit) {
+        /* Sent like a request from the sending rtpbin would be */
+        gst_pad_send_event(pad, gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE,
+            TRUE, 0));
+    }
+
+    return ret;
+}
+
+static GstElement *create_sink(GstElement *source_bin, GstElement *source)
+{
+    GstElement *sink, *old_sink;
+    gchar *name;
+
+    name = g_strdup_printf("rtp-forward-sink-%u", g_atomic_int_add(&unique_bin_id, 1));
+    sink = g_object_new(OWR_TYPE_INTER_SINK, "name", name, NULL);
+    g_free(name);
+
+    /* The previous sink must stop pushing into the source before the new one
+     * takes its place */
+    old_sink = g_object_get_data(G_OBJECT(source_bin), FORWARD_SINK_KEY);
+    if (old_sink)
+        g_weak_ref_set(&OWR_INTER_SINK(old_sink)->src_srcpad, NULL);
+
+    g_weak_ref_set(&OWR_INTER_SRC(source)->sink_sinkpad, OWR_INTER_SINK(sink)->sinkpad);
+    g_weak_ref_set(&OWR_INTER_SINK(sink)->src_srcpad, OWR_INTER_SRC(source)->internal_srcpad);
+
+    g_object_set_data_full(G_OBJECT(source_bin), FORWARD_SINK_KEY, gst_object_ref(sink),
+        gst_object_unref);
+
+    return sink;
+}
+
+/**
+ * _owr_rtp_forward_new:
+ * @sink: (out) (transfer full): location for the sink to be linked to the
+ * receiving rtpbin
+ *
+ * Creates a connected sink and source pair forwarding RTP between two
+ * pipelines.
+ *
+ * Returns: (transfer full): a bin with a rewritten RTP "src" pad to be linked
+ * to the sending rtpbin.
+ */
+GstElement *_owr_rtp_forward_new(GstElement **sink)
+{
+    GstElement *source_bin, *source;
+    GstPad *pad, *ghostpad;
+    ForwardState *state;
+    gchar *name;
+    guint id;
+
+    g_return_val_if_fail(sink, NULL);
+
+    id = g_atomic_int_add(&unique_bin_id, 1);
+
+    name = g_strdup_printf("rtp-forward-source-%u", id);
+    source = g_object_new(OWR_TYPE_INTER_SRC, "name", name, NULL);
+    g_free(name);
+
+    name = g_strdup_printf("rtp-forward-source-bin-%u", id);
+    source_bin = gst_bin_new(name);
+    g_free(name);
+    gst_bin_add(GST_BIN(source_bin), source);
+    /* Owned by the bin */
+    g_object_set_data(G_OBJECT(source_bin), FORWARD_INTER_SRC_KEY, source);
+
+    *sink = create_sink(source_bin, source);
+
+    state = g_slice_new0(ForwardState);
+    g_mutex_init(&state->lock);
+    state->payload_type = -1;
+    state->last_pts = GST_CLOCK_TIME_NONE;
+    g_object_set_data_full(G_OBJECT(source_bin), FORWARD_STATE_KEY, state,
+        (GDestroyNotify) forward_state_free);
+
+    pad = gst_element_get_static_pad(source, "src");
+    ghostpad = gst_ghost_pad_new("src", pad);
+    gst_object_unref(pad);
+    gst_pad_add_probe(ghostpad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST
+        | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, (GstPadProbeCallback) rewrite_probe_cb, state, NULL);
+    gst_pad_set_active(ghostpad, TRUE);
+    gst_element_add_pad(source_bin, ghostpad);
+
+    return source_bin;
+}
+
+/**
+ * _owr_rtp_forward_new_sink:
+ * @source: a source created by _owr_rtp_forward_new()
+ *
+ * Replaces the sink forwarding to @source, so that another received stream
+ * can be forwarded without replacing @source. The sequence numbers and
+ * timestamps sent continue from the last forwarded packet.
+ *
+ * Returns: (transfer full): the new sink to be linked to the receiving
+ * rtpbin, the previous one no longer forwards to @source.
+ */
+GstElement *_owr_rtp_forward_new_sink(GstElement *source)
+{
+    ForwardState *state;
+    GstElement *inter_src;
+
+    g_return_val_if_fail(GST_IS_BIN(source), NULL);
+
+    state = g_object_get_data(G_OBJECT(source), FORWARD_STATE_KEY);
+    inter_src = g_object_get_data(G_OBJECT(source), FORWARD_INTER_SRC_KEY);
+    g_return_val_if_fail(state && inter_src, NULL);
+
+    g_mutex_lock(&state->lock);
+    state->new_input = TRUE;
+    g_mutex_unlock(&state->lock);
+
+    return create_sink(source, inter_src);
+}
+
+/**
+ * _owr_rtp_forward_get_sink:
+ * @source: a source created by _owr_rtp_forward_new()
+ *
+ * Returns: (transfer none): the sink forwarding to @source.
+ */
+GstElement *_owr_rtp_forward_get_sink(GstElement *source)
+{
+    g_return_val_if_fail(GST_IS_BIN(source), NULL);
+
+    return g_object_get_data(G_OBJECT(source), FORWARD_SINK_KEY);
+}
+
+void _owr_rtp_forward_set_ssrc(GstElement *source, guint32 ssrc)
+{
+    ForwardState *state;
+
+    g_return_if_fail(GST_IS_BIN(source));
+
+    state = g_object_get_data(G_OBJECT(source), FORWARD_STATE_KEY);
+    g_return_if_fail(state);
+
+    g_mutex_lock(&state->lock);
+    state->ssrc = ssrc;
+    g_mutex_unlock(&state->lock);
+}
+
+void _owr_rtp_forward_set_payload_type(GstElement *source, gint payload_type)
+{
+    ForwardState *state;
+
+    g_return_if_fail(GST_IS_BIN(source));
+    g_return_if_fail(payload_type < 128);
+
+    state = g_object_get_data(G_OBJECT(source), FORWARD_STATE_KEY);
+    g_return_if_fail(state);
+
+    g_mutex_lock(&state->lock);
+    state->payload_type = payload_type;
+    g_mutex_unlock(&state->lock);
+}
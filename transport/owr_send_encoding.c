@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*/
+\*\ OwrSendEncoding
+/*/
+
+/**
+ * SECTION:owr_send_encoding
+ * @short_description: OwrSendEncoding
+ * @title: OwrSendEncoding
+ *
+ * OwrSendEncoding - One simulcast layer of a video send stream.
+ *
+ * Each encoding added to an #OwrMediaSession gets its own scaler, encoder
+ * and payloader in the send pipeline and is sent with its own SSRC.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "owr_send_encoding.h"
+
+#include "owr_send_encoding_private.h"
+
+#define DEFAULT_SSRC 0
+#define DEFAULT_SCALE_DOWN_BY 1.0
+#define DEFAULT_MAX_BITRATE 0
+#define DEFAULT_MAX_FRAMERATE 0.0
+#define DEFAULT_ACTIVE TRUE
+
+#define OWR_SEND_ENCODING_GET_PRIVATE(obj)    (G_TYPE_INSTANCE_GET_PRIVATE((obj), OWR_TYPE_SEND_ENCODING, OwrSendEncodingPrivate))
+
+G_DEFINE_TYPE(OwrSendEncoding, owr_send_encoding, G_TYPE_OBJECT)
+
+struct _OwrSendEncodingPrivate {
+    guint ssrc;
+    gdouble scale_down_by;
+    guint max_bitrate;
+    gdouble max_framerate;
+    gint active;
+    OwrPayload *payload;
+    GMutex payload_lock;
+};
+
+enum {
+    PROP_0,
+
+    PROP_SSRC,
+    PROP_SCALE_DOWN_BY,
+    PROP_MAX_BITRATE,
+    PROP_MAX_FRAMERATE,
+    PROP_ACTIVE,
+    PROP_PAYLOAD,
+
+    N_PROPERTIES
+};
+
+static GParamSpec *obj_properties[N_PROPERTIES] = { NULL, };
+
+static void owr_send_encoding_set_property(GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+    OwrSendEncodingPrivate *priv = OWR_SEND_ENCODING(object)->priv;
+
+    switch (property_id) {
+    case PROP_SSRC:
+        priv->ssrc = g_value_get_uint(value);
+        break;
+
+    case PROP_SCALE_DOWN_BY:
+        priv->scale_down_by = g_value_get_double(value);
+        break;
+
+    case PROP_MAX_BITRATE:
+        priv->max_bitrate = g_value_get_uint(value);
+        break;
+
+    case PROP_MAX_FRAMERATE:
+        priv->max_framerate = g_value_get_double(value);
+        break;
+
+    case PROP_ACTIVE:
+        g_atomic_int_set(&priv->active, g_value_get_boolean(value));
+        break;
+
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+        break;
+    }
+}
+
+static void owr_send_encoding_get_property(GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+    OwrSendEncodingPrivate *priv = OWR_SEND_ENCODING(object)->priv;
+
+    switch (property_id) {
+    case PROP_SSRC:
+        g_value_set_uint(value, priv->ssrc);
+        break;
+
+    case PROP_SCALE_DOWN_BY:
+        g_value_set_double(value, priv->scale_down_by);
+        break;
+
+    case PROP_MAX_BITRATE:
+        g_value_set_uint(value, priv->max_bitrate);
+        break;
+
+    case PROP_MAX_FRAMERATE:
+        g_value_set_double(value, priv->max_framerate);
+        break;
+
+    case PROP_ACTIVE:
+        g_value_set_boolean(value, g_atomic_int_get(&priv->active));
+        break;
+
+    case PROP_PAYLOAD:
+        g_value_take_object(value, _owr_send_encoding_get_payload(OWR_SEND_ENCODING(object)));
+        break;
+
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+        break;
+    }
+}
+
+static void owr_send_encoding_finalize(GObject *object)
+{
+    OwrSendEncodingPrivate *priv = OWR_SEND_ENCODING(object)->priv;
+
+    if (priv->payload)
+        g_object_unref(priv->payload);
+    g_mutex_clear(&priv->payload_lock);
+
+    G_OBJECT_CLASS(owr_send_encoding_parent_class)->finalize(object);
+}
+
+static void owr_send_encoding_class_init(OwrSendEncodingClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+    g_type_class_add_private(klass, sizeof(OwrSendEncodingPrivate));
+
+    gobject_class->set_property = owr_send_encoding_set_property;
+    gobject_class->get_property = owr_send_encoding_get_property;
+    gobject_class->finalize = owr_send_encoding_finalize;
+
+    obj_properties[PROP_SSRC] = g_param_spec_uint("ssrc", "SSRC",
+        "The SSRC the encoding is sent with",
+        0, G_MAXUINT, DEFAULT_SSRC,
+        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_SCALE_DOWN_BY] = g_param_spec_double("scale-down-by", "Scale down by",
+        "Factor by which the width and height of the sent video are divided",
+        1.0, G_MAXDOUBLE, DEFAULT_SCALE_DOWN_BY,
+        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_MAX_BITRATE] = g_param_spec_uint("max-bitrate", "Max bitrate",
+        "Upper bound of the encoder bitrate in bits/s (0 = only limited by the congestion control)",
+        0, G_MAXUINT, DEFAULT_MAX_BITRATE,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_MAX_FRAMERATE] = g_param_spec_double("max-framerate", "Max framerate",
+        "Upper bound of the sent frames per second (0 = the source framerate)",
+        0.0, G_MAXDOUBLE, DEFAULT_MAX_FRAMERATE,
+        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_ACTIVE] = g_param_spec_boolean("active", "Active",
+        "Whether the encoding is sent, inactive encodings are paused",
+        DEFAULT_ACTIVE,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_PAYLOAD] = g_param_spec_object("payload", "Payload",
+        "The payload this encoding is encoded with, derived from the send payload once"
+        " sending starts, with the layer's own resolution, bitrate and keyframe counters",
+        OWR_TYPE_PAYLOAD,
+        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_properties(gobject_class, N_PROPERTIES, obj_properties);
+}
+
+static void owr_send_encoding_init(OwrSendEncoding *send_encoding)
+{
+    OwrSendEncodingPrivate *priv;
+
+    send_encoding->priv = priv = OWR_SEND_ENCODING_GET_PRIVATE(send_encoding);
+    priv->ssrc = DEFAULT_SSRC;
+    priv->scale_down_by = DEFAULT_SCALE_DOWN_BY;
+    priv->max_bitrate = DEFAULT_MAX_BITRATE;
+    priv->max_framerate = DEFAULT_MAX_FRAMERATE;
+    priv->active = DEFAULT_ACTIVE;
+    priv->payload = NULL;
+    g_mutex_init(&priv->payload_lock);
+}
+
+/**
+ * owr_send_encoding_new:
+ * @ssrc: the SSRC to send the encoding with
+ * @scale_down_by: the factor by which the source resolution is divided
+ * @max_bitrate: the maximum bitrate in bits/s, 0 for no limit
+ * @max_framerate: the maximum framerate, 0 to keep the source framerate
+ *
+ * Returns: a new #OwrSendEncoding
+ */
+OwrSendEncoding * owr_send_encoding_new(guint ssrc, gdouble scale_down_by, guint max_bitrate,
+    gdouble max_framerate)
+{
+    return g_object_new(OWR_TYPE_SEND_ENCODING,
+        "ssrc", ssrc,
+        "scale-down-by", scale_down_by,
+        "max-bitrate", max_bitrate,
+        "max-framerate", max_framerate,
+        NULL);
+}
+
+
+/* Private methods */
+
+gboolean _owr_send_encoding_is_active(OwrSendEncoding *send_encoding)
+{
+    g_return_val_if_fail(OWR_IS_SEND_ENCODING(send_encoding), FALSE);
+
+    return g_atomic_int_get(&send_encoding->priv->active);
+}
+
+/*
+ * _owr_send_encoding_set_payload:
+ * @payload: (transfer none) (allow-none): the payload driving this layer's encoder
+ */
+void _owr_send_encoding_set_payload(OwrSendEncoding *send_encoding, OwrPayload *payload)
+{
+    OwrSendEncodingPrivate *priv;
+
+    g_return_if_fail(OWR_IS_SEND_ENCODING(send_encoding));
+    g_return_if_fail(!payload || OWR_IS_PAYLOAD(payload));
+
+    priv = send_encoding->priv;
+    g_mutex_lock(&priv->payload_lock);
+    if (priv->payload)
+        g_object_unref(priv->payload);
+    priv->payload = payload ? g_object_ref(payload) : NULL;
+    g_mutex_unlock(&priv->payload_lock);
+
+    g_object_notify_by_pspec(G_OBJECT(send_encoding), obj_properties[PROP_PAYLOAD]);
+}
+
+/*
+ * _owr_send_encoding_get_payload:
+ * Returns: (transfer full) (allow-none): the payload driving this layer's encoder
+ */
+OwrPayload * _owr_send_encoding_get_payload(OwrSendEncoding *send_encoding)
+{
+    OwrPayload *payload;
+
+    g_return_val_if_fail(OWR_IS_SEND_ENCODING(send_encoding), NULL);
+
+    g_mutex_lock(&send_encoding->priv->payload_lock);
+    payload = send_encoding->priv->payload ? g_object_ref(send_encoding->priv->payload) : NULL;
+    g_mutex_unlock(&send_encoding->priv->payload_lock);
+
+    return payload;
+}
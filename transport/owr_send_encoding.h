@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*/
+\*\ OwrSendEncoding
+/*/
+
+#ifndef __OWR_SEND_ENCODING_H__
+#define __OWR_SEND_ENCODING_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define OWR_TYPE_SEND_ENCODING            (owr_send_encoding_get_type())
+#define OWR_SEND_ENCODING(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj), OWR_TYPE_SEND_ENCODING, OwrSendEncoding))
+#define OWR_SEND_ENCODING_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass), OWR_TYPE_SEND_ENCODING, OwrSendEncodingClass))
+#define OWR_IS_SEND_ENCODING(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj), OWR_TYPE_SEND_ENCODING))
+#define OWR_IS_SEND_ENCODING_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass), OWR_TYPE_SEND_ENCODING))
+#define OWR_SEND_ENCODING_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj), OWR_TYPE_SEND_ENCODING, OwrSendEncodingClass))
+
+typedef struct _OwrSendEncoding        OwrSendEncoding;
+typedef struct _OwrSendEncodingClass   OwrSendEncodingClass;
+typedef struct _OwrSendEncodingPrivate OwrSendEncodingPrivate;
+
+struct _OwrSendEncoding {
+    GObject parent_instance;
+
+    /*< private >*/
+    OwrSendEncodingPrivate *priv;
+};
+
+struct _OwrSendEncodingClass {
+    GObjectClass parent_class;
+
+};
+
+GType owr_send_encoding_get_type(void) G_GNUC_CONST;
+
+OwrSendEncoding * owr_send_encoding_new(guint ssrc, gdouble scale_down_by, guint max_bitrate,
+    gdouble max_framerate);
+
+G_END_DECLS
+
+#endif /* __OWR_SEND_ENCODING_H__ */
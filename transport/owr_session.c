@@ -79,6 +79,7 @@ struct _OwrSessionPrivate {
     gboolean gathering_done;
     GClosure *on_remote_candidate;
     GClosure *on_local_candidate_change;
+    GClosure *on_restart_ice;
     OwrIceState ice_state, rtp_ice_state, rtcp_ice_state;
     OwrMessageOriginBusSet *message_origin_bus_set;
     guint rtp_port, rtcp_port;
@@ -87,6 +88,8 @@ struct _OwrSessionPrivate {
 enum {
     SIGNAL_ON_NEW_CANDIDATE,
     SIGNAL_ON_CANDIDATE_GATHERING_DONE,
+    SIGNAL_ON_NEW_CANDIDATES,
+    SIGNAL_ON_ICE_RESTART,
 
     LAST_SIGNAL
 };
@@ -127,8 +130,9 @@ GType owr_ice_state_get_type(void)
     return id;
 }
 
-static gboolean add_remote_candidate(GHashTable *args);
+static gboolean add_remote_candidates(GHashTable *args);
 static gboolean add_candidate_pair(GHashTable *args);
+static gboolean restart_ice(GHashTable *args);
 static void update_local_credentials(OwrCandidate *candidate, GParamSpec *pspec, OwrSession *session);
 
 
@@ -286,6 +290,32 @@ static void owr_session_class_init(OwrSessionClass *klass)
         G_STRUCT_OFFSET(OwrSessionClass, on_candidate_gathering_done), NULL, NULL,
         NULL, G_TYPE_NONE, 0);
 
+    /**
+    * OwrSession::on-new-candidates:
+    * @session: the object which received the signal
+    * @candidates: (element-type OwrCandidate) (transfer none): the candidates gathered
+    *
+    * Notify of a batch of gathered candidates for a #OwrSession. It is
+    * emitted after #OwrSession::on-new-candidate has been emitted for each
+    * of them, so that signalling can send them in one message.
+    */
+    session_signals[SIGNAL_ON_NEW_CANDIDATES] = g_signal_new("on-new-candidates",
+        G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+        NULL, G_TYPE_NONE, 1, G_TYPE_PTR_ARRAY);
+
+    /**
+    * OwrSession::on-ice-restart:
+    * @session: the object which received the signal
+    *
+    * Notify that the transport agent restarted ICE on its own because the
+    * selected pair stopped receiving (see #OwrTransportAgent:ice-restart-timeout).
+    * The local candidates are reported again with new credentials and the
+    * peer has to restart ICE as after owr_session_restart_ice().
+    */
+    session_signals[SIGNAL_ON_ICE_RESTART] = g_signal_new("on-ice-restart",
+        G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_LAST, 0, NULL, NULL,
+        NULL, G_TYPE_NONE, 0);
+
     gobject_class->set_property = owr_session_set_property;
     gobject_class->get_property = owr_session_get_property;
     gobject_class->finalize = owr_session_finalize;
@@ -346,6 +376,7 @@ static void owr_session_init(OwrSession *session)
     priv->forced_remote_candidates = NULL;
     priv->gathering_done = FALSE;
     priv->on_remote_candidate = NULL;
+    priv->on_restart_ice = NULL;
     priv->message_origin_bus_set = owr_message_origin_bus_set_new();
 }
 
@@ -376,27 +407,42 @@ static gboolean is_multiplexing_rtcp(OwrSession *session)
     return rtcp_mux;
 }
 
-static void schedule_add_remote_candidate(OwrSession *session, OwrCandidate *candidate, gboolean f)
+static gboolean check_remote_candidate(OwrSession *session, OwrCandidate *candidate)
 {
-    GHashTable *args;
-
-    g_return_if_fail(OWR_IS_SESSION(session));
-    g_return_if_fail(OWR_IS_CANDIDATE(candidate));
+    g_return_val_if_fail(OWR_IS_CANDIDATE(candidate), FALSE);
 
     if (_owr_candidate_get_component_type(candidate) == OWR_COMPONENT_TYPE_RTCP
         && is_multiplexing_rtcp(session)) {
         g_warning("Trying to add an RTCP candidate to an RTP/RTCP multiplexing session. Aborting");
-        return;
+        return FALSE;
     }
 
+    return TRUE;
+}
+
+/* Takes ownership of the list and the candidate references in it */
+static void schedule_add_remote_candidates(OwrSession *session, GSList *candidates, gboolean f)
+{
+    GHashTable *args;
+
     args = _owr_create_schedule_table(OWR_MESSAGE_ORIGIN(session));
     g_hash_table_insert(args, "session", session);
-    g_hash_table_insert(args, "candidate", candidate);
+    g_hash_table_insert(args, "candidates", candidates);
     g_hash_table_insert(args, "forced", GINT_TO_POINTER(f));
     g_object_ref(session);
-    g_object_ref(candidate);
 
-    _owr_schedule_with_hash_table((GSourceFunc)add_remote_candidate, args);
+    _owr_schedule_with_hash_table((GSourceFunc)add_remote_candidates, args);
+}
+
+static void schedule_add_remote_candidate(OwrSession *session, OwrCandidate *candidate, gboolean f)
+{
+    g_return_if_fail(OWR_IS_SESSION(session));
+    g_return_if_fail(OWR_IS_CANDIDATE(candidate));
+
+    if (!check_remote_candidate(session, candidate))
+        return;
+
+    schedule_add_remote_candidates(session, g_slist_prepend(NULL, g_object_ref(candidate)), f);
 }
 
 /**
@@ -412,6 +458,32 @@ void owr_session_add_remote_candidate(OwrSession *session, OwrCandidate *candida
     schedule_add_remote_candidate(session, candidate, FALSE);
 }
 
+/**
+ * owr_session_add_remote_candidates:
+ * @session: the session on which the candidates will be added.
+ * @candidates: (element-type OwrCandidate) (transfer none): the candidates to add
+ *
+ * Adds several remote candidates for this session at once. This is cheaper
+ * than calling owr_session_add_remote_candidate() for each of them, the
+ * whole batch is handed to the ICE agent in one go.
+ *
+ */
+void owr_session_add_remote_candidates(OwrSession *session, GList *candidates)
+{
+    GSList *batch = NULL;
+    GList *item;
+
+    g_return_if_fail(OWR_IS_SESSION(session));
+
+    for (item = candidates; item; item = item->next) {
+        if (check_remote_candidate(session, item->data))
+            batch = g_slist_prepend(batch, g_object_ref(item->data));
+    }
+
+    if (batch)
+        schedule_add_remote_candidates(session, g_slist_reverse(batch), FALSE);
+}
+
 /**
  * owr_session_force_remote_candidate:
  * @session: The session on which the candidate will be forced.
@@ -456,52 +528,93 @@ void owr_session_force_candidate_pair(OwrSession *session, OwrComponentType ctyp
     _owr_schedule_with_hash_table((GSourceFunc)add_candidate_pair, args);
 }
 
+/**
+ * owr_session_restart_ice:
+ * @session: The session on which ICE should be restarted.
+ *
+ * Restarts ICE for this session, for example after a network change. New
+ * local credentials are generated, candidates are gathered again and
+ * reported through #OwrSession::on-new-candidate, all remote candidates are
+ * dropped and have to be added again from the peer. The DTLS association
+ * and the media pipeline are kept as they are.
+ *
+ * Sessions that share the ICE stream (bundled) are restarted together. With
+ * a libnice older than 0.1.15 every session of the transport agent is
+ * restarted.
+ */
+void owr_session_restart_ice(OwrSession *session)
+{
+    GHashTable *args;
+
+    g_return_if_fail(OWR_IS_SESSION(session));
+
+    args = _owr_create_schedule_table(OWR_MESSAGE_ORIGIN(session));
+    g_hash_table_insert(args, "session", session);
+    g_object_ref(session);
+
+    _owr_schedule_with_hash_table((GSourceFunc)restart_ice, args);
+}
+
 /* Internal functions */
 
-static gboolean add_remote_candidate(GHashTable *args)
+static gboolean add_remote_candidates(GHashTable *args)
 {
     OwrSession *session;
     OwrSessionPrivate *priv;
     OwrCandidate *candidate;
     gboolean forced;
-    GSList **candidates;
-    GValue params[2] = { G_VALUE_INIT, G_VALUE_INIT };
+    GSList **candidates, *batch, *item, *added = NULL;
+    GValue params[3] = { G_VALUE_INIT, G_VALUE_INIT, G_VALUE_INIT };
 
     g_return_val_if_fail(args, FALSE);
 
     session = g_hash_table_lookup(args, "session");
-    candidate = g_hash_table_lookup(args, "candidate");
+    batch = g_hash_table_lookup(args, "candidates");
     forced = GPOINTER_TO_INT(g_hash_table_lookup(args, "forced"));
-    g_return_val_if_fail(session && candidate, FALSE);
+    g_return_val_if_fail(session && batch, FALSE);
 
     priv = session->priv;
     candidates = forced ? &priv->forced_remote_candidates : &priv->remote_candidates;
 
-    if (g_slist_find(*candidates, candidate)) {
-        g_warning("Fail: remote candidate already added.");
-        goto end;
+    for (item = batch; item; item = item->next) {
+        candidate = item->data;
+
+        if (g_slist_find(*candidates, candidate) || g_slist_find(added, candidate)) {
+            g_warning("Fail: remote candidate already added.");
+            continue;
+        }
+
+        if (g_slist_find(priv->local_candidates, candidate)) {
+            g_warning("Fail: candidate is local.");
+            continue;
+        }
+
+        added = g_slist_prepend(added, g_object_ref(candidate));
     }
 
-    if (g_slist_find(priv->local_candidates, candidate)) {
-        g_warning("Fail: candidate is local.");
+    if (!added)
         goto end;
-    }
 
-    *candidates = g_slist_append(*candidates, candidate);
-    g_object_ref(candidate);
+    added = g_slist_reverse(added);
+    *candidates = g_slist_concat(*candidates, added);
 
+    /* Only the new candidates are handed on, the earlier ones already are
+     * with the agent */
     if (priv->on_remote_candidate) {
         g_value_init(&params[0], OWR_TYPE_SESSION);
         g_value_set_object(&params[0], session);
         g_value_init(&params[1], G_TYPE_BOOLEAN);
         g_value_set_boolean(&params[1], forced);
-        g_closure_invoke(priv->on_remote_candidate, NULL, 2, (const GValue *)&params, NULL);
+        g_value_init(&params[2], G_TYPE_POINTER);
+        g_value_set_pointer(&params[2], added);
+        g_closure_invoke(priv->on_remote_candidate, NULL, 3, (const GValue *)&params, NULL);
         g_value_unset(&params[0]);
         g_value_unset(&params[1]);
+        g_value_unset(&params[2]);
     }
 
 end:
-    g_object_unref(candidate);
+    g_slist_free_full(batch, g_object_unref);
     g_object_unref(session);
     g_hash_table_unref(args);
     return FALSE;
@@ -557,6 +670,31 @@ end:
     return FALSE;
 }
 
+static gboolean restart_ice(GHashTable *args)
+{
+    OwrSession *session;
+    OwrSessionPrivate *priv;
+    GValue params[1] = { G_VALUE_INIT };
+
+    g_return_val_if_fail(args, FALSE);
+
+    session = g_hash_table_lookup(args, "session");
+    g_return_val_if_fail(session, FALSE);
+    priv = session->priv;
+
+    if (priv->on_restart_ice) {
+        g_value_init(&params[0], OWR_TYPE_SESSION);
+        g_value_set_object(&params[0], session);
+        g_closure_invoke(priv->on_restart_ice, NULL, 1, (const GValue *)&params, NULL);
+        g_value_unset(&params[0]);
+    } else
+        GST_DEBUG_OBJECT(session, "Not added to a transport agent, nothing to restart");
+
+    g_object_unref(session);
+    g_hash_table_unref(args);
+    return FALSE;
+}
+
 void _owr_session_get_candidate_pair(OwrSession *session, OwrComponentType ctype,
         OwrCandidate **local, OwrCandidate **remote)
 {
@@ -642,6 +780,11 @@ void _owr_session_clear_closures(OwrSession *session)
         g_closure_unref(session->priv->on_local_candidate_change);
         session->priv->on_local_candidate_change = NULL;
     }
+    if (session->priv->on_restart_ice) {
+        g_closure_invalidate(session->priv->on_restart_ice);
+        g_closure_unref(session->priv->on_restart_ice);
+        session->priv->on_restart_ice = NULL;
+    }
 }
 
 /* Private methods */
@@ -705,6 +848,48 @@ void _owr_session_set_on_local_candidate_change(OwrSession *session, GClosure *o
     g_closure_set_marshal(session->priv->on_local_candidate_change, g_cclosure_marshal_generic);
 }
 
+void _owr_session_set_on_restart_ice(OwrSession *session, GClosure *on_restart_ice)
+{
+    g_return_if_fail(OWR_IS_SESSION(session));
+    g_return_if_fail(on_restart_ice);
+
+    if (session->priv->on_restart_ice)
+        g_closure_unref(session->priv->on_restart_ice);
+    session->priv->on_restart_ice = on_restart_ice;
+    g_closure_set_marshal(session->priv->on_restart_ice, g_cclosure_marshal_generic);
+}
+
+/**
+ * _owr_session_reset_ice:
+ * @session:
+ *
+ * Forgets all local and remote candidates (and any forced pair) ahead of an
+ * ICE restart. Must be called from the main thread.
+ *
+ */
+void _owr_session_reset_ice(OwrSession *session)
+{
+    OwrSessionPrivate *priv;
+    guint i;
+
+    g_return_if_fail(OWR_IS_SESSION(session));
+    priv = session->priv;
+
+    g_slist_free_full(priv->local_candidates, (GDestroyNotify)g_object_unref);
+    priv->local_candidates = NULL;
+    g_slist_free_full(priv->remote_candidates, (GDestroyNotify)g_object_unref);
+    priv->remote_candidates = NULL;
+    g_slist_free_full(priv->forced_remote_candidates, (GDestroyNotify)g_object_unref);
+    priv->forced_remote_candidates = NULL;
+
+    for (i = 0; i < OWR_COMPONENT_MAX; i++) {
+        g_clear_object(&priv->local_candidate[i]);
+        g_clear_object(&priv->remote_candidate[i]);
+    }
+
+    priv->gathering_done = FALSE;
+}
+
 void _owr_session_set_dtls_peer_certificate(OwrSession *session,
     const gchar *certificate)
 {
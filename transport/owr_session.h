@@ -88,9 +88,11 @@ GType owr_session_get_type(void) G_GNUC_CONST;
 
 
 void owr_session_add_remote_candidate(OwrSession *session, OwrCandidate *candidate);
+void owr_session_add_remote_candidates(OwrSession *session, GList *candidates);
 void owr_session_force_remote_candidate(OwrSession *session, OwrCandidate *candidate);
 void owr_session_force_candidate_pair(OwrSession *session, OwrComponentType ctype,
         OwrCandidate *local_candidate, OwrCandidate *remote_candidate);
+void owr_session_restart_ice(OwrSession *session);
 void owr_session_set_local_port(OwrSession *session, OwrComponentType ctype, guint port);
 
 void _owr_session_get_candidate_pair(OwrSession *session, OwrComponentType ctype,
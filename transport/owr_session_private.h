@@ -43,7 +43,9 @@ guint _owr_session_get_local_port(OwrSession *session, OwrComponentType ctype);
 
 void _owr_session_set_on_remote_candidate(OwrSession *session, GClosure *on_remote_candidate);
 void _owr_session_set_on_local_candidate_change(OwrSession *session, GClosure *on_local_candidate_change);
+void _owr_session_set_on_restart_ice(OwrSession *session, GClosure *on_restart_ice);
 void _owr_session_clear_closures(OwrSession *session);
+void _owr_session_reset_ice(OwrSession *session);
 
 void _owr_session_set_dtls_peer_certificate(OwrSession *, const gchar *certificate);
 
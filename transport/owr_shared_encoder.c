@@ -0,0 +1,689 @@
+/*
+ * Copyright (c) 2016, Ericsson AB. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or other
+ * materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY
+ * OF SUCH DAMAGE.
+ */
+
+/*/
+\*\ OwrSharedEncoder
+/*/
+
+/*
+ * When the same media source is sent to several peers with compatible
+ * payloads, the frames are converted and encoded once in a separate
+ * pipeline and every consumer gets its own branch after the encoder:
+ *
+ * +--------------+   +--------------------------------+   +-----+   +------------+
+ * | media source +---+ flip/queue/encoder/parser/caps +---+ tee +-+-+ inter*sink +---> consumer 1
+ * +--------------+   +--------------------------------+   +-----+ | +------------+
+ *                                                                 | +------------+
+ *                                                                 +-+ inter*sink +---> consumer 2
+ *                                                                   +------------+
+ *
+ * Consumers are grouped by source, codec, resolution, framerate, orientation,
+ * intra refresh and a bitrate tier. Within a group the encoder runs at the
+ * lowest bitrate and the shortest minimum keyframe interval any consumer asks
+ * for, and key unit requests from all consumers are coalesced. Each consumer
+ * payload still counts its own keyframe requests and the keyframes it gets.
+ *
+ * The shared pipeline is built and started without holding the
+ * shared_encoders lock, as its streaming threads take that lock.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "owr_shared_encoder.h"
+
+#include "owr_inter_sink.h"
+#include "owr_inter_src.h"
+#include "owr_media_source_private.h"
+#include "owr_payload_private.h"
+#include "owr_private.h"
+#include "owr_utils.h"
+#include "owr_video_payload.h"
+
+#include <gst/video/video.h>
+
+GST_DEBUG_CATEGORY_EXTERN(_owrsharedencoder_debug);
+#define GST_CAT_DEFAULT _owrsharedencoder_debug
+
+/* Bitrate tiers double from this value, consumers that start out in
+ * different tiers get separate encoders */
+#define BITRATE_TIER_BASE 125000
+
+#define CONSUMER_DATA_KEY "owr-shared-encoder-consumer"
+
+typedef struct {
+    gchar *key;
+    OwrMediaSource *media_source;
+    /* Private payload carrying the arbitrated encoder settings */
+    OwrPayload *payload;
+
+    GstElement *pipeline;
+    GstElement *source;
+    GstElement *tee;
+    GSource *bus_source;
+
+    GList *consumers;
+} SharedEncoder;
+
+typedef struct {
+    SharedEncoder *shared_encoder;
+    OwrPayload *payload;
+    gulong bitrate_handler_id;
+    gulong min_keyframe_interval_handler_id;
+    gulong rotation_handler_id;
+    gulong mirror_handler_id;
+    GstElement *sink_bin;
+} SharedEncoderConsumer;
+
+G_LOCK_DEFINE_STATIC(shared_encoders);
+static GHashTable *shared_encoders = NULL;
+static guint unique_bin_id = 0;
+
+#define LINK_ELEMENTS(a, b) \
+    if (!gst_element_link(a, b)) \
+        GST_ERROR("Failed to link " #a " -> " #b);
+
+static guint bitrate_tier(guint bitrate)
+{
+    guint tier = 0;
+
+    for (bitrate /= BITRATE_TIER_BASE; bitrate > 1; bitrate >>= 1)
+        tier++;
+
+    return tier;
+}
+
+static gchar *create_key(OwrMediaSource *media_source, OwrPayload *payload)
+{
+    GstCaps *raw_caps, *encoded_caps;
+    gchar *raw_caps_str, *encoded_caps_str, *key;
+    guint temporal_layers = 1, rotation = 0, encoder_threads = 0;
+    gint encoder_partitions = -1, encoder_cpu_used = 0;
+    gint64 encoder_deadline = 1;
+    gboolean mirror = FALSE, intra_refresh = FALSE, encoder_cpu_used_auto = TRUE;
+
+    raw_caps = _owr_payload_create_raw_caps(payload);
+    encoded_caps = _owr_payload_create_encoded_caps(payload);
+    raw_caps_str = gst_caps_to_string(raw_caps);
+    encoded_caps_str = gst_caps_to_string(encoded_caps);
+
+    g_object_get(payload, "temporal-layers", &temporal_layers, "rotation", &rotation,
+        "mirror", &mirror, "encoder-threads", &encoder_threads, "encoder-partitions", &encoder_partitions,
+        "encoder-deadline", &encoder_deadline, "encoder-cpu-used", &encoder_cpu_used,
+        "encoder-cpu-used-auto", &encoder_cpu_used_auto, "intra-refresh", &intra_refresh, NULL);
+    /* All automatic settings are the same whatever encoder-cpu-used says */
+    if (encoder_cpu_used_auto)
+        encoder_cpu_used = G_MININT;
+    key = g_strdup_printf("%p-%s-%s-%u-%u-%u%c-%u-%d-%" G_GINT64_FORMAT "-%d-%c", (gpointer)media_source,
+        raw_caps_str, encoded_caps_str, bitrate_tier(_owr_payload_evaluate_bitrate(payload)),
+        temporal_layers, rotation, mirror ? 'm' : 'n', encoder_threads, encoder_partitions,
+        encoder_deadline, encoder_cpu_used, intra_refresh ? 'i' : 'k');
+
+    g_free(raw_caps_str);
+    g_free(encoded_caps_str);
+    gst_caps_unref(raw_caps);
+    gst_caps_unref(encoded_caps);
+
+    return key;
+}
+
+/* call with the shared_encoders lock */
+static guint lowest_bitrate(SharedEncoder *shared_encoder)
+{
+    GList *item;
+    SharedEncoderConsumer *consumer;
+    guint bitrate = 0, consumer_bitrate;
+
+    for (item = shared_encoder->consumers; item; item = item->next) {
+        consumer = item->data;
+        consumer_bitrate = 0;
+        g_object_get(consumer->payload, "bitrate", &consumer_bitrate, NULL);
+        if (consumer_bitrate && (!bitrate || consumer_bitrate < bitrate))
+            bitrate = consumer_bitrate;
+    }
+
+    return bitrate;
+}
+
+/* call with the shared_encoders lock, the strictest consumer decides */
+static guint shortest_min_keyframe_interval(SharedEncoder *shared_encoder)
+{
+    GList *item;
+    SharedEncoderConsumer *consumer;
+    guint min_keyframe_interval = G_MAXUINT, consumer_min_keyframe_interval;
+
+    for (item = shared_encoder->consumers; item; item = item->next) {
+        consumer = item->data;
+        consumer_min_keyframe_interval = 0;
+        g_object_get(consumer->payload, "min-keyframe-interval", &consumer_min_keyframe_interval, NULL);
+        min_keyframe_interval = MIN(min_keyframe_interval, consumer_min_keyframe_interval);
+    }
+
+    return min_keyframe_interval;
+}
+
+/* The encoder settings are set without the shared_encoders lock as the
+ * encoder may block on its streaming thread */
+static void update_encoder_settings(SharedEncoder *shared_encoder)
+{
+    OwrPayload *payload;
+    guint bitrate, min_keyframe_interval;
+
+    G_LOCK(shared_encoders);
+    payload = g_object_ref(shared_encoder->payload);
+    bitrate = lowest_bitrate(shared_encoder);
+    min_keyframe_interval = shortest_min_keyframe_interval(shared_encoder);
+    G_UNLOCK(shared_encoders);
+
+    if (bitrate) {
+        GST_LOG("Setting shared encoder bitrate to %u", bitrate);
+        g_object_set(payload, "bitrate", bitrate, NULL);
+    }
+    if (min_keyframe_interval != G_MAXUINT)
+        g_object_set(payload, "min-keyframe-interval", min_keyframe_interval, NULL);
+    g_object_unref(payload);
+}
+
+static void on_consumer_settings(GObject *payload, GParamSpec *pspec, SharedEncoderConsumer *consumer)
+{
+    OWR_UNUSED(payload);
+    OWR_UNUSED(pspec);
+
+    update_encoder_settings(consumer->shared_encoder);
+}
+
+/* call with the shared_encoders lock */
+static void unlist_shared_encoder(SharedEncoder *shared_encoder)
+{
+    if (shared_encoders && g_hash_table_lookup(shared_encoders, shared_encoder->key) == shared_encoder)
+        g_hash_table_remove(shared_encoders, shared_encoder->key);
+}
+
+/* The orientation typically follows the capture device, so all consumers are
+ * expected to change it together. The encoder follows once every consumer
+ * agrees on the new orientation, and is no longer offered to new consumers as
+ * its key does not describe it anymore. */
+static void on_consumer_orientation(GObject *payload, GParamSpec *pspec, SharedEncoderConsumer *consumer)
+{
+    SharedEncoder *shared_encoder;
+    SharedEncoderConsumer *other;
+    OwrPayload *shared_payload;
+    GList *item;
+    guint rotation = 0, other_rotation = 0, current_rotation = 0;
+    gboolean mirror = FALSE, other_mirror = FALSE, current_mirror = FALSE;
+
+    OWR_UNUSED(pspec);
+
+    g_object_get(payload, "rotation", &rotation, "mirror", &mirror, NULL);
+
+    G_LOCK(shared_encoders);
+    shared_encoder = consumer->shared_encoder;
+    for (item = shared_encoder->consumers; item; item = item->next) {
+        other = item->data;
+        g_object_get(other->payload, "rotation", &other_rotation, "mirror", &other_mirror, NULL);
+        if (other_rotation != rotation || !other_mirror != !mirror) {
+            GST_DEBUG_OBJECT(shared_encoder->pipeline,
+                "Keeping the orientation until all consumers agree");
+            G_UNLOCK(shared_encoders);
+            return;
+        }
+    }
+
+    shared_payload = g_object_ref(shared_encoder->payload);
+    g_object_get(shared_payload, "rotation", &current_rotation, "mirror", &current_mirror, NULL);
+    if (current_rotation != rotation || !current_mirror != !mirror)
+        unlist_shared_encoder(shared_encoder);
+    G_UNLOCK(shared_encoders);
+
+    g_object_set(shared_payload, "rotation", rotation, "mirror", mirror, NULL);
+    g_object_unref(shared_payload);
+}
+
+static gboolean bus_call(GstBus *bus, GstMessage *msg, gpointer user_data)
+{
+    GstElement *pipeline = user_data;
+    GError *error = NULL;
+    gchar *debug = NULL;
+
+    OWR_UNUSED(bus);
+
+    switch (GST_MESSAGE_TYPE(msg)) {
+    case GST_MESSAGE_LATENCY:
+        g_warn_if_fail(gst_bin_recalculate_latency(GST_BIN(pipeline)));
+        break;
+
+    case GST_MESSAGE_WARNING:
+        gst_message_parse_warning(msg, &error, &debug);
+        GST_WARNING_OBJECT(msg->src, "%s (%s)", error->message, debug ? debug : "none");
+        g_error_free(error);
+        g_free(debug);
+        break;
+
+    case GST_MESSAGE_ERROR:
+        gst_message_parse_error(msg, &error, &debug);
+        GST_ERROR_OBJECT(msg->src, "%s (%s)", error->message, debug ? debug : "none");
+        g_error_free(error);
+        g_free(debug);
+        break;
+
+    default:
+        break;
+    }
+
+    return TRUE;
+}
+
+static void shared_encoder_free(SharedEncoder *shared_encoder)
+{
+    guint keyframe_requests = 0, keyframes_produced = 0;
+
+    g_object_get(shared_encoder->payload, "keyframe-requests", &keyframe_requests,
+        "keyframes-produced", &keyframes_produced, NULL);
+    GST_DEBUG_OBJECT(shared_encoder->pipeline, "Shutting down, %u keyframes for %u requests",
+        keyframes_produced, keyframe_requests);
+
+    if (shared_encoder->source)
+        _owr_media_source_release_source(shared_encoder->media_source, shared_encoder->source);
+    _owr_codec_pool_release_from_bin(GST_BIN(shared_encoder->pipeline));
+    gst_element_set_state(shared_encoder->pipeline, GST_STATE_NULL);
+
+    g_source_destroy(shared_encoder->bus_source);
+    g_source_unref(shared_encoder->bus_source);
+    gst_object_unref(shared_encoder->pipeline);
+
+    g_object_unref(shared_encoder->payload);
+    g_object_unref(shared_encoder->media_source);
+    g_free(shared_encoder->key);
+    g_slice_free(SharedEncoder, shared_encoder);
+}
+
+static SharedEncoder *shared_encoder_new(OwrMediaSource *media_source, OwrPayload *payload, gchar *key)
+{
+    SharedEncoder *shared_encoder;
+    OwrCodecType codec_type = OWR_CODEC_TYPE_NONE;
+    guint payload_type = 0, clock_rate = 0, width = 0, height = 0, rotation = 0;
+    gdouble framerate = 0.0;
+    gboolean mirror = FALSE, link_ok = TRUE;
+    guint encoder_threads = 0;
+    gint encoder_partitions = -1, encoder_cpu_used = 0;
+    guint temporal_layers = 1, min_keyframe_interval = 0;
+    gboolean intra_refresh = FALSE, encoder_cpu_used_auto = TRUE;
+    gint64 encoder_deadline = 1;
+    GstElement *flip, *queue, *encoder, *parser, *capsfilter;
+    GstClock *clock;
+    GstBus *bus;
+    GstCaps *caps;
+    gchar *name;
+    guint id;
+
+    shared_encoder = g_slice_new0(SharedEncoder);
+    shared_encoder->key = key;
+    shared_encoder->media_source = g_object_ref(media_source);
+
+    g_object_get(payload, "codec-type", &codec_type, "payload-type", &payload_type,
+        "clock-rate", &clock_rate, "width", &width, "height", &height,
+        "framerate", &framerate, "rotation", &rotation, "mirror", &mirror, NULL);
+    shared_encoder->payload = owr_video_payload_new(codec_type, payload_type, clock_rate, FALSE, FALSE);
+    g_object_set(shared_encoder->payload, "width", width, "height", height,
+        "framerate", framerate, "rotation", rotation, "mirror", mirror,
+        "bitrate", _owr_payload_evaluate_bitrate(payload), NULL);
+    /* The encoder tuning is part of the key, so all consumers agree on it */
+    g_object_get(payload, "encoder-threads", &encoder_threads, "encoder-partitions", &encoder_partitions,
+        "encoder-deadline", &encoder_deadline, "encoder-cpu-used", &encoder_cpu_used,
+        "encoder-cpu-used-auto", &encoder_cpu_used_auto, "temporal-layers", &temporal_layers,
+        "min-keyframe-interval", &min_keyframe_interval, "intra-refresh", &intra_refresh, NULL);
+    g_object_set(shared_encoder->payload, "encoder-threads", encoder_threads,
+        "encoder-partitions", encoder_partitions, "encoder-deadline", encoder_deadline,
+        "encoder-cpu-used", encoder_cpu_used, "encoder-cpu-used-auto", encoder_cpu_used_auto,
+        "temporal-layers", temporal_layers, "min-keyframe-interval", min_keyframe_interval,
+        "intra-refresh", intra_refresh, NULL);
+
+    id = g_atomic_int_add(&unique_bin_id, 1);
+    name = g_strdup_printf("shared-encoder-pipeline-%u", id);
+    shared_encoder->pipeline = gst_pipeline_new(name);
+    g_free(name);
+    clock = gst_system_clock_obtain();
+    gst_pipeline_use_clock(GST_PIPELINE(shared_encoder->pipeline), clock);
+    gst_object_unref(clock);
+    gst_element_set_base_time(shared_encoder->pipeline, _owr_get_base_time());
+    gst_element_set_start_time(shared_encoder->pipeline, GST_CLOCK_TIME_NONE);
+
+    bus = gst_pipeline_get_bus(GST_PIPELINE(shared_encoder->pipeline));
+    shared_encoder->bus_source = gst_bus_create_watch(bus);
+    g_source_set_callback(shared_encoder->bus_source, (GSourceFunc) bus_call, shared_encoder->pipeline, NULL);
+    g_source_attach(shared_encoder->bus_source, _owr_get_main_context());
+    gst_object_unref(bus);
+
+    caps = _owr_payload_create_raw_caps(shared_encoder->payload);
+    shared_encoder->source = _owr_media_source_request_source(media_source, caps);
+    gst_caps_unref(caps);
+    if (!shared_encoder->source) {
+        GST_ERROR("Failed to request a source for the shared encoder");
+        shared_encoder_free(shared_encoder);
+        return NULL;
+    }
+
+    name = g_strdup_printf("shared-encoder-flip-%u", id);
+    flip = gst_element_factory_make("videoflip", name);
+    g_free(name);
+    g_signal_connect_object(shared_encoder->payload, "notify::rotation", G_CALLBACK(_owr_update_flip_method), flip, 0);
+    g_signal_connect_object(shared_encoder->payload, "notify::mirror", G_CALLBACK(_owr_update_flip_method), flip, 0);
+    _owr_update_flip_method(G_OBJECT(shared_encoder->payload), NULL, flip);
+
+    name = g_strdup_printf("shared-encoder-queue-%u", id);
+    queue = gst_element_factory_make("queue", name);
+    g_free(name);
+    g_object_set(queue, "max-size-buffers", 3, "max-size-bytes", 0,
+        "max-size-time", G_GUINT64_CONSTANT(0), NULL);
+
+    encoder = _owr_payload_create_encoder(shared_encoder->payload);
+    parser = _owr_create_parser(codec_type);
+
+    name = g_strdup_printf("shared-encoder-capsfilter-%u", id);
+    capsfilter = gst_element_factory_make("capsfilter", name);
+    g_free(name);
+    caps = _owr_payload_create_encoded_caps(shared_encoder->payload);
+    g_object_set(capsfilter, "caps", caps, NULL);
+    gst_caps_unref(caps);
+
+    name = g_strdup_printf("shared-encoder-tee-%u", id);
+    shared_encoder->tee = gst_element_factory_make("tee", name);
+    g_free(name);
+    g_object_set(shared_encoder->tee, "allow-not-linked", TRUE, NULL);
+
+    gst_bin_add_many(GST_BIN(shared_encoder->pipeline), shared_encoder->source, flip, queue, encoder, NULL);
+    if (parser)
+        gst_bin_add(GST_BIN(shared_encoder->pipeline), parser);
+    gst_bin_add_many(GST_BIN(shared_encoder->pipeline), capsfilter, shared_encoder->tee, NULL);
+
+    _owr_bin_link_and_sync_elements(GST_BIN(shared_encoder->pipeline), &link_ok, NULL, NULL, NULL);
+    g_warn_if_fail(link_ok);
+
+    /* Keyframe requests of all consumers are merged in front of the tee */
+    _owr_video_payload_setup_keyframe_control(OWR_VIDEO_PAYLOAD(shared_encoder->payload), encoder,
+        capsfilter);
+
+    if (gst_element_set_state(shared_encoder->pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+        GST_ERROR_OBJECT(shared_encoder->pipeline, "Failed to start the shared encoder");
+
+    GST_DEBUG_OBJECT(shared_encoder->pipeline, "Created shared encoder for %s", key);
+
+    return shared_encoder;
+}
+
+/* call with the shared_encoders lock, registering the consumer keeps the
+ * shared encoder alive until the consumer is released */
+static SharedEncoderConsumer *register_consumer(SharedEncoder *shared_encoder, OwrPayload *payload)
+{
+    SharedEncoderConsumer *consumer;
+
+    consumer = g_slice_new0(SharedEncoderConsumer);
+    consumer->shared_encoder = shared_encoder;
+    consumer->payload = g_object_ref(payload);
+
+    shared_encoder->consumers = g_list_prepend(shared_encoder->consumers, consumer);
+
+    return consumer;
+}
+
+static GstElement *add_consumer_branch(SharedEncoderConsumer *consumer, GstPad **out_sinkpad)
+{
+    SharedEncoder *shared_encoder = consumer->shared_encoder;
+    GstElement *source_bin, *source, *sink_bin, *sink, *queue;
+    GstPad *pad, *ghostpad;
+    gchar *name;
+    guint id;
+
+    id = g_atomic_int_add(&unique_bin_id, 1);
+
+    name = g_strdup_printf("shared-encoder-source-%u", id);
+    source = g_object_new(OWR_TYPE_INTER_SRC, "name", name, NULL);
+    g_free(name);
+    name = g_strdup_printf("shared-encoder-sink-%u", id);
+    sink = g_object_new(OWR_TYPE_INTER_SINK, "name", name, NULL);
+    g_free(name);
+
+    g_weak_ref_set(&OWR_INTER_SRC(source)->sink_sinkpad, OWR_INTER_SINK(sink)->sinkpad);
+    g_weak_ref_set(&OWR_INTER_SINK(sink)->src_srcpad, OWR_INTER_SRC(source)->internal_srcpad);
+
+    /* The branch behind the tee in the shared pipeline */
+    name = g_strdup_printf("shared-encoder-sink-bin-%u", id);
+    sink_bin = gst_bin_new(name);
+    g_free(name);
+    name = g_strdup_printf("shared-encoder-sink-queue-%u", id);
+    queue = gst_element_factory_make("queue", name);
+    g_free(name);
+    gst_bin_add_many(GST_BIN(sink_bin), queue, sink, NULL);
+    LINK_ELEMENTS(queue, sink);
+    pad = gst_element_get_static_pad(queue, "sink");
+    ghostpad = gst_ghost_pad_new("sink", pad);
+    gst_object_unref(pad);
+    gst_pad_set_active(ghostpad, TRUE);
+    gst_element_add_pad(sink_bin, ghostpad);
+    /* The keyframe control sits on the shared payload, in front of the tee */
+    _owr_video_payload_count_keyframes(OWR_VIDEO_PAYLOAD(consumer->payload), ghostpad);
+    consumer->sink_bin = sink_bin;
+    gst_bin_add(GST_BIN(shared_encoder->pipeline), sink_bin);
+    gst_element_sync_state_with_parent(sink_bin);
+    LINK_ELEMENTS(shared_encoder->tee, sink_bin);
+
+    /* The consumer side, added to the pipeline of the consumer */
+    name = g_strdup_printf("shared-encoder-source-bin-%u", id);
+    source_bin = gst_bin_new(name);
+    g_free(name);
+    gst_bin_add(GST_BIN(source_bin), source);
+    pad = gst_element_get_static_pad(source, "src");
+    ghostpad = gst_ghost_pad_new("src", pad);
+    gst_object_unref(pad);
+    gst_pad_set_active(ghostpad, TRUE);
+    gst_element_add_pad(source_bin, ghostpad);
+
+    consumer->bitrate_handler_id = g_signal_connect(consumer->payload, "notify::bitrate",
+        G_CALLBACK(on_consumer_settings), consumer);
+    consumer->min_keyframe_interval_handler_id = g_signal_connect(consumer->payload,
+        "notify::min-keyframe-interval", G_CALLBACK(on_consumer_settings), consumer);
+    consumer->rotation_handler_id = g_signal_connect(consumer->payload, "notify::rotation",
+        G_CALLBACK(on_consumer_orientation), consumer);
+    consumer->mirror_handler_id = g_signal_connect(consumer->payload, "notify::mirror",
+        G_CALLBACK(on_consumer_orientation), consumer);
+    g_object_set_data(G_OBJECT(source_bin), CONSUMER_DATA_KEY, consumer);
+
+    *out_sinkpad = gst_element_get_static_pad(sink_bin, "sink");
+
+    return source_bin;
+}
+
+/**
+ * _owr_shared_encoder_request_source:
+ * @media_source: the video source to encode
+ * @payload: the send payload of the consumer
+ *
+ * Attaches a new consumer to the shared encoder matching @media_source and
+ * @payload, creating the encoder if there is none yet.
+ *
+ * Returns: (transfer full): a bin with an encoded "src" pad to be added to
+ * the consumer's pipeline, or NULL on failure. It must be released with
+ * _owr_shared_encoder_release_source().
+ */
+GstElement *_owr_shared_encoder_request_source(OwrMediaSource *media_source, OwrPayload *payload)
+{
+    SharedEncoder *shared_encoder, *new_shared_encoder = NULL;
+    SharedEncoderConsumer *consumer = NULL;
+    GstElement *source_bin = NULL;
+    GstPad *sinkpad = NULL;
+    GstEvent *event;
+    gchar *key;
+
+    g_return_val_if_fail(OWR_IS_MEDIA_SOURCE(media_source), NULL);
+    g_return_val_if_fail(OWR_IS_VIDEO_PAYLOAD(payload), NULL);
+
+    g_object_set(payload, "bitrate", _owr_payload_evaluate_bitrate(payload), NULL);
+    key = create_key(media_source, payload);
+
+    G_LOCK(shared_encoders);
+    if (!shared_encoders)
+        shared_encoders = g_hash_table_new(g_str_hash, g_str_equal);
+
+    shared_encoder = g_hash_table_lookup(shared_encoders, key);
+    if (shared_encoder)
+        consumer = register_consumer(shared_encoder, payload);
+    G_UNLOCK(shared_encoders);
+
+    if (!shared_encoder) {
+        new_shared_encoder = shared_encoder_new(media_source, payload, g_strdup(key));
+        if (!new_shared_encoder) {
+            g_free(key);
+            return NULL;
+        }
+
+        /* Another consumer may have created an encoder for the same key in
+         * the meantime, in that case ours is not needed */
+        G_LOCK(shared_encoders);
+        shared_encoder = g_hash_table_lookup(shared_encoders, key);
+        if (!shared_encoder) {
+            shared_encoder = new_shared_encoder;
+            new_shared_encoder = NULL;
+            g_hash_table_insert(shared_encoders, shared_encoder->key, shared_encoder);
+        }
+        consumer = register_consumer(shared_encoder, payload);
+        G_UNLOCK(shared_encoders);
+
+        if (new_shared_encoder)
+            shared_encoder_free(new_shared_encoder);
+    } else
+        GST_DEBUG_OBJECT(shared_encoder->pipeline, "Reusing shared encoder for %s", key);
+    g_free(key);
+
+    update_encoder_settings(shared_encoder);
+    source_bin = add_consumer_branch(consumer, &sinkpad);
+
+    /* The new consumer needs a key frame to start decoding */
+    event = gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE, TRUE, 0);
+    gst_structure_set(gst_event_writable_structure(event), "owr-new-consumer", G_TYPE_BOOLEAN, TRUE, NULL);
+    gst_pad_push_event(sinkpad, event);
+    gst_object_unref(sinkpad);
+
+    return source_bin;
+}
+
+/**
+ * _owr_shared_encoder_owns_source:
+ * @source: an element linked to a send input
+ *
+ * Returns: TRUE if @source was returned by _owr_shared_encoder_request_source()
+ */
+gboolean _owr_shared_encoder_owns_source(GstElement *source)
+{
+    g_return_val_if_fail(GST_IS_ELEMENT(source), FALSE);
+
+    return g_object_get_data(G_OBJECT(source), CONSUMER_DATA_KEY) != NULL;
+}
+
+static GstPadProbeReturn remove_branch_idle_probe_cb(GstPad *teepad, GstPadProbeInfo *info, GstElement *sink_bin)
+{
+    GstElement *tee, *pipeline;
+    GstPad *sinkpad;
+
+    OWR_UNUSED(info);
+
+    sinkpad = gst_element_get_static_pad(sink_bin, "sink");
+    g_warn_if_fail(gst_pad_unlink(teepad, sinkpad));
+    gst_object_unref(sinkpad);
+
+    tee = gst_pad_get_parent_element(teepad);
+    gst_element_release_request_pad(tee, teepad);
+    gst_object_unref(tee);
+
+    pipeline = GST_ELEMENT(gst_object_get_parent(GST_OBJECT(sink_bin)));
+    gst_bin_remove(GST_BIN(pipeline), sink_bin);
+    gst_element_set_state(sink_bin, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    return GST_PAD_PROBE_REMOVE;
+}
+
+/**
+ * _owr_shared_encoder_release_source:
+ * @source: a bin returned by _owr_shared_encoder_request_source()
+ *
+ * Detaches the consumer from its shared encoder, which is shut down when its
+ * last consumer is gone. The caller still has to remove @source from its
+ * pipeline.
+ */
+void _owr_shared_encoder_release_source(GstElement *source)
+{
+    SharedEncoderConsumer *consumer;
+    SharedEncoder *shared_encoder;
+    OwrPayload *shared_payload = NULL;
+    GstPad *sinkpad, *teepad;
+    guint bitrate = 0, min_keyframe_interval = G_MAXUINT;
+    gboolean last;
+
+    g_return_if_fail(GST_IS_ELEMENT(source));
+
+    consumer = g_object_get_data(G_OBJECT(source), CONSUMER_DATA_KEY);
+    g_return_if_fail(consumer);
+    g_object_set_data(G_OBJECT(source), CONSUMER_DATA_KEY, NULL);
+
+    G_LOCK(shared_encoders);
+    shared_encoder = consumer->shared_encoder;
+    g_signal_handler_disconnect(consumer->payload, consumer->bitrate_handler_id);
+    g_signal_handler_disconnect(consumer->payload, consumer->min_keyframe_interval_handler_id);
+    g_signal_handler_disconnect(consumer->payload, consumer->rotation_handler_id);
+    g_signal_handler_disconnect(consumer->payload, consumer->mirror_handler_id);
+    shared_encoder->consumers = g_list_remove(shared_encoder->consumers, consumer);
+    last = !shared_encoder->consumers;
+    if (last)
+        unlist_shared_encoder(shared_encoder);
+    else {
+        shared_payload = g_object_ref(shared_encoder->payload);
+        bitrate = lowest_bitrate(shared_encoder);
+        min_keyframe_interval = shortest_min_keyframe_interval(shared_encoder);
+    }
+    G_UNLOCK(shared_encoders);
+
+    if (last)
+        shared_encoder_free(shared_encoder);
+    else {
+        if (bitrate)
+            g_object_set(shared_payload, "bitrate", bitrate, NULL);
+        if (min_keyframe_interval != G_MAXUINT)
+            g_object_set(shared_payload, "min-keyframe-interval", min_keyframe_interval, NULL);
+        g_object_unref(shared_payload);
+
+        sinkpad = gst_element_get_static_pad(consumer->sink_bin, "sink");
+        teepad = gst_pad_get_peer(sinkpad);
+        gst_object_unref(sinkpad);
+        if (teepad) {
+            gst_pad_add_probe(teepad, GST_PAD_PROBE_TYPE_IDLE,
+                (GstPadProbeCallback) remove_branch_idle_probe_cb,
+                gst_object_ref(consumer->sink_bin), gst_object_unref);
+            gst_object_unref(teepad);
+        }
+    }
+
+    g_object_unref(consumer->payload);
+    g_slice_free(SharedEncoderConsumer, consumer);
+}
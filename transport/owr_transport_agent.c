@@ -53,8 +53,12 @@
 #include "owr_private.h"
 #include "owr_remote_media_source.h"
 #include "owr_remote_media_source_private.h"
+#include "owr_rtp_forward.h"
+#include "owr_send_encoding.h"
+#include "owr_send_encoding_private.h"
 #include "owr_session.h"
 #include "owr_session_private.h"
+#include "owr_shared_encoder.h"
 #include "owr_types.h"
 #include "owr_utils.h"
 #include "owr_video_payload.h"
@@ -81,12 +85,44 @@ GST_DEBUG_CATEGORY_EXTERN(_owrsession_debug);
 
 #define DEFAULT_ICE_CONTROLLING_MODE TRUE
 #define DEFAULT_BUNDLE_POLICY OWR_BUNDLE_POLICY_TYPE_BALANCED
+#define DEFAULT_ICE_TCP TRUE
+#define DEFAULT_ICE_LITE FALSE
+#define DEFAULT_CONSENT_FRESHNESS FALSE
+#define DEFAULT_ICE_RESTART_TIMEOUT 0
+#define MAX_ICE_RESTART_TIMEOUT 60000
+#define MIN_RECEIVE_CHECK_INTERVAL 50
+#define DEFAULT_ADAPTIVE_JITTER_BUFFER FALSE
+#define DEFAULT_MIN_JITTER_BUFFER_LATENCY 20
+#define DEFAULT_MAX_JITTER_BUFFER_LATENCY 500
+#define MAX_JITTER_BUFFER_LATENCY 10000
+#define JITTER_BUFFER_JITTER_FACTOR 4
+#define JITTER_BUFFER_MARGIN 10
+#define JITTER_BUFFER_DECREASE_STEP 10
+#define JITTER_BUFFER_TARGET_TIMEOUT (15 * G_USEC_PER_SEC)
+#define JITTER_BUFFER_STATE_KEY "owr-jitter-buffer-state"
 #define GST_RTCP_RTPFB_TYPE_SCREAM 18
+#define FEC_STORAGE_TIME (250 * GST_MSECOND)
+#define RTX_HISTORY_DEFAULT_TIME 1000
+#define RTX_HISTORY_MIN_TIME 250
+#define RTX_HISTORY_MAX_TIME 3000
+#define MAX_ROUND_TRIP_TIME 10000
+#define JITTERBUFFER_KEY "owr-jitterbuffer"
+#define LATE_RETRANSMISSIONS_KEY "owr-late-retransmissions"
+/* Larger gaps in the output of a jitterbuffer are a seqnum reset, not loss */
+#define MAX_GIVEN_UP_GAP 1000
+#define GIVEN_UP_BIT(seqnum) (1 << ((seqnum) & 7))
 
 enum {
     PROP_0,
     PROP_ICE_CONTROLLING_MODE,
     PROP_BUNDLE_POLICY,
+    PROP_ICE_TCP,
+    PROP_ICE_LITE,
+    PROP_CONSENT_FRESHNESS,
+    PROP_ICE_RESTART_TIMEOUT,
+    PROP_ADAPTIVE_JITTER_BUFFER,
+    PROP_MIN_JITTER_BUFFER_LATENCY,
+    PROP_MAX_JITTER_BUFFER_LATENCY,
     N_PROPERTIES
 };
 
@@ -117,6 +153,35 @@ typedef struct {
     guint ctrl_bytes_sent;
 } DataChannel;
 
+/* Receive activity of one ICE component, written from the nicesrc
+ * streaming thread and read from the main thread, times are in wrapping ms */
+typedef struct {
+    volatile gint last_receive;
+    /* Set once anything arrived on the selected pair, a peer that never
+     * sends is not a reason to restart */
+    volatile gint received;
+    volatile gint restarted;
+    OwrIceState state;
+} ComponentWatch;
+
+typedef struct {
+    ComponentWatch component[OWR_COMPONENT_MAX];
+} StreamWatch;
+
+/* Adaptive latency of the jitterbuffers of one media session, guarded by
+ * jitter_buffer_lock */
+typedef struct {
+    /* GWeakRefs to the jitterbuffers */
+    GPtrArray *jitterbuffers;
+    /* Latency the remote sender's jitter asks for and when it was estimated,
+     * in monotonic time */
+    guint target;
+    gint64 target_time;
+    /* Latency applied to the jitterbuffers, 0 while the configured
+     * jitter-buffer-latency of the media session applies */
+    guint latency;
+} JitterBufferState;
+
 typedef struct {
     GstElement *dtls_srtp_bin_rtp;
     GstElement *dtls_srtp_bin_rtcp;
@@ -141,6 +206,19 @@ struct _OwrTransportAgentPrivate {
     guint next_session_id;
     gboolean ice_controlling_mode;
     gboolean bundle_policy;
+    gboolean ice_tcp;
+    gboolean ice_lite;
+    gboolean consent_freshness;
+    guint ice_restart_timeout;
+    gboolean adaptive_jitter_buffer;
+    guint min_jitter_buffer_latency;
+    guint max_jitter_buffer_latency;
+    GMutex jitter_buffer_lock;
+
+    /* stream_id -> StreamWatch */
+    GHashTable *stream_watches;
+    GMutex stream_watches_lock;
+    GSource *receive_check_source;
 
     GMutex sessions_lock;
     GHashTable *sessions;
@@ -159,6 +237,14 @@ struct _OwrTransportAgentPrivate {
     GList *rtcp_list;
     GMutex rtcp_lock;
 
+    /* NiceCandidates gathered but not yet handed to the sessions, newest
+     * first, flushed by a single scheduled emit_new_candidates() */
+    GSList *pending_local_candidates;
+    GMutex pending_local_candidates_lock;
+    /* Stream restarted by on_restart_ice() while it gathers again */
+    guint regathering_stream_id;
+    gboolean regathered;
+
     guint local_min_port;
     guint local_max_port;
 
@@ -201,11 +287,13 @@ static void owr_transport_agent_set_property(GObject *object, guint property_id,
     const GValue *value, GParamSpec *pspec);
 static void owr_transport_agent_get_property(GObject *object, guint property_id,
     GValue *value, GParamSpec *pspec);
+static void owr_transport_agent_constructed(GObject *object);
 
 
 static void add_helper_server_info(GResolver *resolver, GAsyncResult *result, GHashTable *info);
 static void update_helper_servers(OwrTransportAgent *transport_agent, guint stream_id);
 static gboolean add_session(GHashTable *args);
+static gboolean remove_session(GHashTable *args);
 static guint get_session_id_unlocked(OwrTransportAgent *transport_agent, OwrSession *session);
 static guint get_session_id(OwrTransportAgent *transport_agent, OwrSession *session);
 static OwrSession * get_session_unlocked(OwrTransportAgent *transport_agent, guint session_id);
@@ -221,8 +309,15 @@ static void on_new_candidate(NiceAgent *nice_agent, NiceCandidate *nice_candidat
 static void on_candidate_gathering_done(NiceAgent *nice_agent, guint stream_id, OwrTransportAgent *transport_agent);
 static void on_component_state_changed(NiceAgent *nice_agent, guint stream_id, guint component_id, OwrIceState state, OwrTransportAgent *transport_agent);
 static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMediaSession *media_session, OwrPayload * payload);
-static void on_new_remote_candidate(OwrTransportAgent *transport_agent, gboolean forced, OwrSession *session);
+static void handle_new_forward_source(OwrTransportAgent *transport_agent, OwrMediaSession *media_session,
+    GstElement *forward_source);
+static void release_simulcast_layers(OwrMediaSession *media_session, GstElement *send_input_bin,
+    guint stream_id);
+static void on_new_remote_candidate(OwrTransportAgent *transport_agent, gboolean forced, GSList *candidates, OwrSession *session);
 static void on_local_candidate_change(OwrTransportAgent *transport_agent, OwrCandidate *candidate, OwrSession *session);
+static void on_restart_ice(OwrTransportAgent *transport_agent, OwrSession *session);
+static void reset_component_watch(OwrTransportAgent *transport_agent, guint stream_id, guint component_id);
+static void maybe_start_receive_check(OwrTransportAgent *transport_agent);
 
 static void on_transport_bin_pad_added(GstElement *transport_bin, GstPad *new_pad, OwrTransportAgent *transport_agent);
 static void on_rtpbin_pad_added(GstElement *rtpbin, GstPad *new_pad, OwrTransportAgent *agent);
@@ -231,6 +326,8 @@ static void setup_audio_receive_elements(GstPad *new_pad, guint32 session_id, gu
 static GstCaps * on_rtpbin_request_pt_map(GstElement *rtpbin, guint stream_id, guint pt, OwrTransportAgent *agent);
 static GstElement * on_rtpbin_request_aux_sender(GstElement *rtpbin, guint stream_id, OwrTransportAgent *transport_agent);
 static GstElement * on_rtpbin_request_aux_receiver(GstElement *rtpbin, guint stream_id, OwrTransportAgent *transport_agent);
+static GstElement * on_rtpbin_request_fec_encoder(GstElement *rtpbin, guint stream_id, OwrTransportAgent *transport_agent);
+static GstElement * on_rtpbin_request_fec_decoder(GstElement *rtpbin, guint stream_id, OwrTransportAgent *transport_agent);
 static void on_dtls_enc_key_set(GstElement *dtls_srtp_enc, AgentAndSessionIdPair *data);
 static void on_new_selected_pair(NiceAgent *nice_agent,
     guint stream_id, guint component_id,
@@ -241,11 +338,19 @@ static gboolean on_sending_rtcp(GObject *session, GstBuffer *buffer, gboolean ea
 static void on_receiving_rtcp(GObject *session, GstBuffer *buffer, OwrTransportAgent *agent);
 static void on_feedback_rtcp(GObject *session, guint type, guint fbtype, guint sender_ssrc, guint media_ssrc, GstBuffer *fci, OwrTransportAgent *transport_agent);
 static GstPadProbeReturn probe_save_ts(GstPad *srcpad, GstPadProbeInfo *info, void *user_data);
+static GstPadProbeReturn probe_stream_watch(GstPad *srcpad, GstPadProbeInfo *info, gpointer user_data);
+static StreamWatch * get_stream_watch(OwrTransportAgent *transport_agent, guint stream_id);
+static void update_stream_watch(OwrTransportAgent *transport_agent, guint stream_id,
+    OwrComponentType component_type, OwrIceState state);
 static GstPadProbeReturn probe_rtp_info(GstPad *srcpad, GstPadProbeInfo *info, ScreamRx *scream_rx);
 static void on_ssrc_active(GstElement *rtpbin, guint stream_id, guint ssrc, OwrTransportAgent *transport_agent);
 static guint on_bundled_ssrc(GstElement *rtpbin, guint ssrc, OwrTransportAgent *transport_agent);
 static void on_new_jitterbuffer(GstElement *rtpbin, GstElement *jitterbuffer, guint stream_id, guint ssrc, OwrTransportAgent *transport_agent);
 static void prepare_rtcp_stats(OwrMediaSession *media_session, GObject *rtp_source);
+static void reset_jitter_buffer_latency(OwrTransportAgent *transport_agent);
+static GstPad *add_forward_tee(OwrTransportAgent *transport_agent, OwrMediaSession *media_session,
+    GstPad *new_pad, guint session_id);
+static void insert_forward_tee(OwrTransportAgent *transport_agent, OwrMediaSession *media_session);
 
 static void data_channel_free(DataChannel *data_channel);
 static gboolean create_datachannel(OwrTransportAgent *transport_agent, guint32 session_id,
@@ -345,6 +450,16 @@ static void owr_transport_agent_finalize(GObject *object)
     priv->message_origin_bus_set = NULL;
     g_list_free_full(priv->rtcp_list, (GDestroyNotify)g_hash_table_unref);
     g_mutex_clear(&priv->rtcp_lock);
+    g_slist_free_full(priv->pending_local_candidates, (GDestroyNotify)nice_candidate_free);
+    g_mutex_clear(&priv->pending_local_candidates_lock);
+
+    if (priv->receive_check_source) {
+        g_source_destroy(priv->receive_check_source);
+        g_source_unref(priv->receive_check_source);
+    }
+    g_hash_table_destroy(priv->stream_watches);
+    g_mutex_clear(&priv->stream_watches_lock);
+    g_mutex_clear(&priv->jitter_buffer_lock);
 
     G_OBJECT_CLASS(owr_transport_agent_parent_class)->finalize(object);
 }
@@ -364,8 +479,58 @@ static void owr_transport_agent_class_init(OwrTransportAgentClass *klass)
         "Bundle policy of the data streams", "What kind of bundle policy we will use for the streams",
         OWR_TYPE_BUNDLE_POLICY_TYPE, DEFAULT_BUNDLE_POLICY, G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+    /* Every TCP candidate is another socket for each component, servers
+     * with many peers that only need UDP should turn this off */
+    obj_properties[PROP_ICE_TCP] = g_param_spec_boolean("ice-tcp",
+        "ICE TCP", "Whether TCP candidates are gathered and used (needs libnice >= 0.1.8)",
+        DEFAULT_ICE_TCP, G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    /* A lite agent only has host candidates and never sends checks of its
+     * own, it is meant for servers on public addresses talking to full
+     * agents. It is always the controlled side. */
+    obj_properties[PROP_ICE_LITE] = g_param_spec_boolean("ice-lite",
+        "ICE lite", "Whether the agent runs ICE-lite (host candidates only, answers checks)",
+        DEFAULT_ICE_LITE, G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_CONSENT_FRESHNESS] = g_param_spec_boolean("consent-freshness",
+        "Consent freshness", "Whether RFC 7675 consent checks are sent on the selected pair "
+        "(needs libnice >= 0.1.17, older versions use connectivity checks as keepalives)",
+        DEFAULT_CONSENT_FRESHNESS, G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    /* Consent only expires after 30 seconds. A selected pair that has not
+     * received anything for this long is given up earlier by restarting ICE
+     * on its stream. This is not a switch to a backup pair: the peer must
+     * restart too, so the application has to signal the new credentials and
+     * candidates as after owr_session_restart_ice() when on-ice-restart is
+     * emitted. */
+    obj_properties[PROP_ICE_RESTART_TIMEOUT] = g_param_spec_uint("ice-restart-timeout",
+        "ICE restart timeout", "Milliseconds without receiving anything on the selected pair "
+        "before ICE is restarted, which needs signalling (0 = leave it to consent freshness)",
+        0, MAX_ICE_RESTART_TIMEOUT, DEFAULT_ICE_RESTART_TIMEOUT,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    /* The latency follows the interarrival jitter the remote sources show,
+     * plus a round trip for sessions receiving retransmissions. All media
+     * sessions of the agent share the highest latency so that audio and
+     * video stay in sync. */
+    obj_properties[PROP_ADAPTIVE_JITTER_BUFFER] = g_param_spec_boolean("adaptive-jitter-buffer",
+        "Adaptive jitter buffer", "Whether the latency of the jitterbuffers follows the "
+        "measured jitter instead of the jitter-buffer-latency of their media session",
+        DEFAULT_ADAPTIVE_JITTER_BUFFER, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_MIN_JITTER_BUFFER_LATENCY] = g_param_spec_uint("min-jitter-buffer-latency",
+        "Minimum jitter buffer latency", "The lowest latency in ms the adaptive jitter buffer goes to",
+        0, MAX_JITTER_BUFFER_LATENCY, DEFAULT_MIN_JITTER_BUFFER_LATENCY,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_MAX_JITTER_BUFFER_LATENCY] = g_param_spec_uint("max-jitter-buffer-latency",
+        "Maximum jitter buffer latency", "The highest latency in ms the adaptive jitter buffer goes to",
+        0, MAX_JITTER_BUFFER_LATENCY, DEFAULT_MAX_JITTER_BUFFER_LATENCY,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
     gobject_class->set_property = owr_transport_agent_set_property;
     gobject_class->get_property = owr_transport_agent_get_property;
+    gobject_class->constructed = owr_transport_agent_constructed;
     gobject_class->finalize = owr_transport_agent_finalize;
 
     g_object_class_install_properties(gobject_class, N_PROPERTIES, obj_properties);
@@ -457,6 +622,17 @@ static void owr_transport_agent_init(OwrTransportAgent *transport_agent)
 
     priv->ice_controlling_mode = DEFAULT_ICE_CONTROLLING_MODE;
     priv->bundle_policy = DEFAULT_BUNDLE_POLICY;
+    priv->ice_tcp = DEFAULT_ICE_TCP;
+    priv->ice_lite = DEFAULT_ICE_LITE;
+    priv->consent_freshness = DEFAULT_CONSENT_FRESHNESS;
+    priv->ice_restart_timeout = DEFAULT_ICE_RESTART_TIMEOUT;
+    priv->adaptive_jitter_buffer = DEFAULT_ADAPTIVE_JITTER_BUFFER;
+    priv->min_jitter_buffer_latency = DEFAULT_MIN_JITTER_BUFFER_LATENCY;
+    priv->max_jitter_buffer_latency = DEFAULT_MAX_JITTER_BUFFER_LATENCY;
+    g_mutex_init(&priv->jitter_buffer_lock);
+    priv->stream_watches = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    g_mutex_init(&priv->stream_watches_lock);
+    priv->receive_check_source = NULL;
     priv->agent_id = next_transport_agent_id++;
     priv->nice_agent = NULL;
     priv->next_session_id = 1;
@@ -468,19 +644,12 @@ static void owr_transport_agent_init(OwrTransportAgent *transport_agent)
     priv->rtcp_list = NULL;
     g_mutex_init(&transport_agent->priv->rtcp_lock);
 
-    g_return_if_fail(_owr_is_initialized());
+    priv->pending_local_candidates = NULL;
+    g_mutex_init(&priv->pending_local_candidates_lock);
+    priv->regathering_stream_id = 0;
+    priv->regathered = FALSE;
 
-    priv->nice_agent = nice_agent_new(_owr_get_main_context(), NICE_COMPATIBILITY_RFC5245);
-    g_object_bind_property(transport_agent, "ice-controlling-mode", priv->nice_agent,
-        "controlling-mode", G_BINDING_SYNC_CREATE);
-    g_signal_connect(G_OBJECT(priv->nice_agent), "new-candidate-full",
-        G_CALLBACK(on_new_candidate), transport_agent);
-    g_signal_connect(G_OBJECT(priv->nice_agent), "candidate-gathering-done",
-        G_CALLBACK(on_candidate_gathering_done), transport_agent);
-    g_signal_connect(G_OBJECT(priv->nice_agent), "component-state-changed",
-        G_CALLBACK(on_component_state_changed), transport_agent);
-    g_signal_connect(G_OBJECT(priv->nice_agent), "new-selected-pair-full",
-        G_CALLBACK(on_new_selected_pair), transport_agent);
+    g_return_if_fail(_owr_is_initialized());
 
     pipeline_name = g_strdup_printf("transport-agent-%u", priv->agent_id);
     priv->pipeline = gst_pipeline_new(pipeline_name);
@@ -511,6 +680,11 @@ static void owr_transport_agent_init(OwrTransportAgent *transport_agent)
     g_signal_connect(priv->rtpbin, "request-pt-map", G_CALLBACK(on_rtpbin_request_pt_map), transport_agent);
     g_signal_connect(priv->rtpbin, "request-aux-sender", G_CALLBACK(on_rtpbin_request_aux_sender), transport_agent);
     g_signal_connect(priv->rtpbin, "request-aux-receiver", G_CALLBACK(on_rtpbin_request_aux_receiver), transport_agent);
+    /* FEC needs GStreamer >= 1.14, without it the sessions only use RTX */
+    if (g_signal_lookup("request-fec-encoder", G_OBJECT_TYPE(priv->rtpbin))) {
+        g_signal_connect(priv->rtpbin, "request-fec-encoder", G_CALLBACK(on_rtpbin_request_fec_encoder), transport_agent);
+        g_signal_connect(priv->rtpbin, "request-fec-decoder", G_CALLBACK(on_rtpbin_request_fec_decoder), transport_agent);
+    }
     g_signal_connect(priv->rtpbin, "on-ssrc-active", G_CALLBACK(on_ssrc_active), transport_agent);
     g_signal_connect(priv->rtpbin, "new-jitterbuffer", G_CALLBACK(on_new_jitterbuffer), transport_agent);
 
@@ -536,6 +710,61 @@ static void owr_transport_agent_init(OwrTransportAgent *transport_agent)
     priv->message_origin_bus_set = owr_message_origin_bus_set_new();
 }
 
+static void owr_transport_agent_constructed(GObject *object)
+{
+    OwrTransportAgent *transport_agent = OWR_TRANSPORT_AGENT(object);
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+    GObjectClass *nice_agent_class;
+    gboolean consent_freshness;
+
+    G_OBJECT_CLASS(owr_transport_agent_parent_class)->constructed(object);
+
+    g_return_if_fail(_owr_is_initialized());
+
+    /* "full-mode" and "consent-freshness" are construct-only on the
+     * NiceAgent, so it can only be created once we know our own settings */
+    if (priv->ice_lite)
+        priv->ice_controlling_mode = FALSE;
+    consent_freshness = priv->consent_freshness && !priv->ice_lite;
+
+    /* Older libnice doesn't have the property */
+    nice_agent_class = g_type_class_ref(NICE_TYPE_AGENT);
+    if (g_object_class_find_property(nice_agent_class, "consent-freshness")) {
+        priv->nice_agent = g_object_new(NICE_TYPE_AGENT,
+            "compatibility", NICE_COMPATIBILITY_RFC5245,
+            "main-context", _owr_get_main_context(),
+            "full-mode", !priv->ice_lite,
+            "consent-freshness", consent_freshness,
+            NULL);
+    } else {
+        priv->nice_agent = g_object_new(NICE_TYPE_AGENT,
+            "compatibility", NICE_COMPATIBILITY_RFC5245,
+            "main-context", _owr_get_main_context(),
+            "full-mode", !priv->ice_lite,
+            NULL);
+    }
+
+    /* Without RFC 7675 support, at least make the keepalives binding
+     * requests so that a dead pair is noticed */
+    if (consent_freshness && !g_object_class_find_property(nice_agent_class, "consent-freshness")
+        && g_object_class_find_property(nice_agent_class, "keepalive-conncheck"))
+        g_object_set(priv->nice_agent, "keepalive-conncheck", TRUE, NULL);
+    g_type_class_unref(nice_agent_class);
+
+    g_object_bind_property(transport_agent, "ice-controlling-mode", priv->nice_agent,
+        "controlling-mode", G_BINDING_SYNC_CREATE);
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(priv->nice_agent), "ice-tcp"))
+        g_object_set(priv->nice_agent, "ice-tcp", priv->ice_tcp, NULL);
+    g_signal_connect(G_OBJECT(priv->nice_agent), "new-candidate-full",
+        G_CALLBACK(on_new_candidate), transport_agent);
+    g_signal_connect(G_OBJECT(priv->nice_agent), "candidate-gathering-done",
+        G_CALLBACK(on_candidate_gathering_done), transport_agent);
+    g_signal_connect(G_OBJECT(priv->nice_agent), "component-state-changed",
+        G_CALLBACK(on_component_state_changed), transport_agent);
+    g_signal_connect(G_OBJECT(priv->nice_agent), "new-selected-pair-full",
+        G_CALLBACK(on_new_selected_pair), transport_agent);
+}
+
 
 static void owr_transport_agent_set_property(GObject *object, guint property_id,
     const GValue *value, GParamSpec *pspec)
@@ -549,13 +778,52 @@ static void owr_transport_agent_set_property(GObject *object, guint property_id,
 
     switch (property_id) {
     case PROP_ICE_CONTROLLING_MODE:
-        priv->ice_controlling_mode = g_value_get_boolean(value);
+        if (priv->ice_lite && g_value_get_boolean(value))
+            GST_WARNING_OBJECT(transport_agent, "An ICE-lite agent is always controlled");
+        priv->ice_controlling_mode = g_value_get_boolean(value) && !priv->ice_lite;
         break;
     case PROP_BUNDLE_POLICY:
         priv->bundle_policy = g_value_get_enum(value);
         if (priv->bundle_policy == OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE)
             g_signal_connect(priv->rtpbin, "on-bundled-ssrc", G_CALLBACK(on_bundled_ssrc), transport_agent);
         break;
+    case PROP_ICE_TCP:
+        priv->ice_tcp = g_value_get_boolean(value);
+        break;
+    case PROP_ICE_LITE:
+        priv->ice_lite = g_value_get_boolean(value);
+        break;
+    case PROP_CONSENT_FRESHNESS:
+        priv->consent_freshness = g_value_get_boolean(value);
+        break;
+    case PROP_ICE_RESTART_TIMEOUT:
+        g_mutex_lock(&priv->stream_watches_lock);
+        priv->ice_restart_timeout = g_value_get_uint(value);
+        if (priv->ice_restart_timeout && g_hash_table_size(priv->stream_watches))
+            maybe_start_receive_check(transport_agent);
+        g_mutex_unlock(&priv->stream_watches_lock);
+        break;
+    case PROP_ADAPTIVE_JITTER_BUFFER:
+        priv->adaptive_jitter_buffer = g_value_get_boolean(value);
+        if (!priv->adaptive_jitter_buffer)
+            reset_jitter_buffer_latency(transport_agent);
+        break;
+    case PROP_MIN_JITTER_BUFFER_LATENCY:
+        if (g_value_get_uint(value) > priv->max_jitter_buffer_latency) {
+            g_warning("min-jitter-buffer-latency %u ms is above max-jitter-buffer-latency %u ms. "
+                "Action aborted.", g_value_get_uint(value), priv->max_jitter_buffer_latency);
+            break;
+        }
+        priv->min_jitter_buffer_latency = g_value_get_uint(value);
+        break;
+    case PROP_MAX_JITTER_BUFFER_LATENCY:
+        if (g_value_get_uint(value) < priv->min_jitter_buffer_latency) {
+            g_warning("max-jitter-buffer-latency %u ms is below min-jitter-buffer-latency %u ms. "
+                "Action aborted.", g_value_get_uint(value), priv->min_jitter_buffer_latency);
+            break;
+        }
+        priv->max_jitter_buffer_latency = g_value_get_uint(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -580,6 +848,27 @@ static void owr_transport_agent_get_property(GObject *object, guint property_id,
     case PROP_BUNDLE_POLICY:
         g_value_set_enum(value, priv->bundle_policy);
         break;
+    case PROP_ICE_TCP:
+        g_value_set_boolean(value, priv->ice_tcp);
+        break;
+    case PROP_ICE_LITE:
+        g_value_set_boolean(value, priv->ice_lite);
+        break;
+    case PROP_CONSENT_FRESHNESS:
+        g_value_set_boolean(value, priv->consent_freshness);
+        break;
+    case PROP_ICE_RESTART_TIMEOUT:
+        g_value_set_uint(value, priv->ice_restart_timeout);
+        break;
+    case PROP_ADAPTIVE_JITTER_BUFFER:
+        g_value_set_boolean(value, priv->adaptive_jitter_buffer);
+        break;
+    case PROP_MIN_JITTER_BUFFER_LATENCY:
+        g_value_set_uint(value, priv->min_jitter_buffer_latency);
+        break;
+    case PROP_MAX_JITTER_BUFFER_LATENCY:
+        g_value_set_uint(value, priv->max_jitter_buffer_latency);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -679,6 +968,40 @@ void owr_transport_agent_add_session(OwrTransportAgent *agent, OwrSession *sessi
 }
 
 
+/**
+ * owr_transport_agent_remove_session:
+ * @agent:
+ * @session:
+ *
+ * Stops the session and releases the elements, ICE stream and bookkeeping
+ * the agent set up for it.
+ */
+void owr_transport_agent_remove_session(OwrTransportAgent *agent, OwrSession *session)
+{
+    GSList *item;
+
+    g_return_if_fail(OWR_IS_TRANSPORT_AGENT(agent));
+    g_return_if_fail(OWR_IS_MEDIA_SESSION(session) || OWR_IS_DATA_SESSION(session));
+
+    item = g_slist_find(agent->priv->unstarted_sessions, session);
+    if (item) {
+        agent->priv->unstarted_sessions = g_slist_delete_link(agent->priv->unstarted_sessions, item);
+        g_object_unref(session);
+        return;
+    }
+
+    if (GST_STATE(agent->priv->pipeline) >= GST_STATE_READY) {
+        GHashTable *args;
+        args = _owr_create_schedule_table(OWR_MESSAGE_ORIGIN(agent));
+        g_hash_table_insert(args, "transport_agent", agent);
+        g_hash_table_insert(args, "session", g_object_ref(session));
+
+        g_object_ref(agent);
+        _owr_schedule_with_hash_table((GSourceFunc) remove_session, args);
+    }
+}
+
+
 /* Internal functions */
 
 static void add_helper_server_info(GResolver *resolver, GAsyncResult *result, GHashTable *info)
@@ -774,6 +1097,10 @@ static void update_helper_servers(OwrTransportAgent *transport_agent, guint stre
     nice_agent_forget_relays(priv->nice_agent, stream_id, NICE_COMPONENT_TYPE_RTP);
     nice_agent_forget_relays(priv->nice_agent, stream_id, NICE_COMPONENT_TYPE_RTCP);
 
+    /* ICE-lite only offers host candidates */
+    if (priv->ice_lite)
+        return;
+
     for (item = priv->helper_server_infos; item; item = item->next) {
         helper_server_info = item->data;
         type = GPOINTER_TO_UINT(g_hash_table_lookup(helper_server_info, "type"));
@@ -837,6 +1164,41 @@ static gboolean link_source_to_transport_bin(GstPad *srcpad, GstElement *pipelin
     return ret;
 }
 
+/* Payloads that opt in with "shared-encoder" take their video from a shared
+ * encoder, so that a source sent to several peers is only encoded once per
+ * group of compatible payloads. The send input bin then only packetizes. */
+static gboolean uses_shared_encoder(OwrMediaSession *media_session, OwrMediaSource *media_source,
+    OwrPayload *payload)
+{
+    gboolean shared_encoder = FALSE;
+    OwrDegradationPreference degradation_preference = OWR_DEGRADATION_PREFERENCE_DISABLED;
+
+    if (!OWR_IS_VIDEO_PAYLOAD(payload))
+        return FALSE;
+
+    g_object_get(payload, "shared-encoder", &shared_encoder,
+        "degradation-preference", &degradation_preference, NULL);
+
+    /* Simulcast layers are encoded in the session's own send bin, and so is
+     * video that is scaled down or dropped for the session's own bitrate */
+    return shared_encoder
+        && degradation_preference == OWR_DEGRADATION_PREFERENCE_DISABLED
+        && !_owr_media_session_has_send_encodings(media_session)
+        && _owr_codec_type_is_raw(_owr_media_source_get_codec(media_source))
+        && !_owr_codec_type_is_raw(_owr_payload_get_codec_type(payload))
+        && !_owr_media_source_supports_interfaces(media_source, OWR_MEDIA_SOURCE_SUPPORTS_VIDEO_ORIENTATION);
+}
+
+/* Encoded sources are sent without decoding and re-encoding when their codec
+ * matches the payload */
+static gboolean uses_passthrough(OwrMediaSource *media_source, OwrPayload *payload)
+{
+    OwrCodecType source_codec_type = _owr_media_source_get_codec(media_source);
+
+    return !_owr_codec_type_is_raw(source_codec_type)
+        && source_codec_type == _owr_payload_get_codec_type(payload);
+}
+
 static void handle_new_send_source(OwrTransportAgent *transport_agent,
     OwrMediaSession *media_session, OwrMediaSource * send_source, OwrPayload * send_payload)
 {
@@ -864,10 +1226,19 @@ static void handle_new_send_source(OwrTransportAgent *transport_agent,
 
     g_object_get(send_payload, "codec-type", &codec_type, NULL);
 
-    caps = _owr_payload_create_raw_caps(send_payload);
-    src = _owr_media_source_request_source(send_source, caps);
+    if (uses_shared_encoder(media_session, send_source, send_payload))
+        src = _owr_shared_encoder_request_source(send_source, send_payload);
+    else {
+        OwrCodecType source_codec_type = _owr_media_source_get_codec(send_source);
+
+        if (_owr_codec_type_is_raw(source_codec_type))
+            caps = _owr_payload_create_raw_caps(send_payload);
+        else
+            caps = gst_caps_new_empty_simple(_owr_codec_type_to_caps_mime(media_type, source_codec_type));
+        src = _owr_media_source_request_source(send_source, caps);
+        gst_caps_unref(caps);
+    }
     g_assert(src);
-    gst_caps_unref(caps);
     srcpad = gst_element_get_static_pad(src, "src");
     g_assert(srcpad);
     transport_bin = transport_agent->priv->transport_bin;
@@ -890,10 +1261,13 @@ static void maybe_handle_new_send_source_with_payload_for_session(OwrTransportAg
 {
     OwrPayload *payload = NULL;
     OwrMediaSource *media_source = NULL;
+    GstElement *forward_source = NULL;
     GHashTable *event_data;
     GValue *value;
 
-    if (!pending &&
+    if (!pending && (forward_source = _owr_media_session_get_forward_source(media_session)))
+        handle_new_forward_source(transport_agent, media_session, forward_source);
+    else if (!pending &&
         (payload = _owr_media_session_get_send_payload(media_session)) &&
         (media_source = _owr_media_session_get_send_source(media_session))) {
 
@@ -913,6 +1287,8 @@ static void maybe_handle_new_send_source_with_payload_for_session(OwrTransportAg
         g_object_unref(payload);
     if (media_source)
         g_object_unref(media_source);
+    if (forward_source)
+        gst_object_unref(forward_source);
 }
 
 static gboolean process_pending_bundled_session(gpointer key, gpointer value, gpointer user_data)
@@ -966,6 +1342,16 @@ static void remove_existing_send_source_and_payload(OwrTransportAgent *transport
 
     g_assert(media_source);
 
+    stream_id = _owr_session_get_stream_id(OWR_SESSION(media_session));
+    session_id = get_session_id(transport_agent, OWR_SESSION(media_session));
+
+    bin_name = g_strdup_printf("send-input-bin-%u-%u", session_id, stream_id);
+    send_input_bin = gst_bin_get_by_name(GST_BIN(transport_agent->priv->transport_bin), bin_name);
+    g_free(bin_name);
+    /* Nothing is sent from the source while forwarding */
+    if (!send_input_bin)
+        return;
+
     event_data = _owr_value_table_new();
     value = _owr_value_table_add(event_data, "start_time", G_TYPE_INT64);
     g_value_set_int64(value, g_get_monotonic_time());
@@ -978,9 +1364,6 @@ static void remove_existing_send_source_and_payload(OwrTransportAgent *transport
 
     /* Setting a new, different source but have one already */
 
-    stream_id = _owr_session_get_stream_id(OWR_SESSION(media_session));
-    session_id = get_session_id(transport_agent, OWR_SESSION(media_session));
-
     /* Unlink the source bin */
     g_object_get(media_source, "media-type", &media_type, NULL);
     g_warn_if_fail(media_type != OWR_MEDIA_TYPE_UNKNOWN);
@@ -998,17 +1381,18 @@ static void remove_existing_send_source_and_payload(OwrTransportAgent *transport
     g_assert(source_bin);
 
     /* Shutting down will flush immediately */
-    _owr_media_source_release_source(media_source, source_bin);
+    if (_owr_shared_encoder_owns_source(source_bin))
+        _owr_shared_encoder_release_source(source_bin);
+    else
+        _owr_media_source_release_source(media_source, source_bin);
     gst_element_set_state(source_bin, GST_STATE_NULL);
     gst_bin_remove(GST_BIN(transport_agent->priv->pipeline), source_bin);
     gst_object_unref(bin_src_pad);
     gst_object_unref(source_bin);
 
     /* Now the payload bin */
-    bin_name = g_strdup_printf("send-input-bin-%u-%u", session_id, stream_id);
-    send_input_bin = gst_bin_get_by_name(GST_BIN(transport_agent->priv->transport_bin), bin_name);
-    g_assert(send_input_bin);
-    g_free(bin_name);
+    release_simulcast_layers(media_session, send_input_bin, stream_id);
+    _owr_codec_pool_release_from_bin(GST_BIN(send_input_bin));
     gst_element_set_state(send_input_bin, GST_STATE_NULL);
     gst_bin_remove(GST_BIN(transport_agent->priv->transport_bin), send_input_bin);
     gst_object_unref(send_input_bin);
@@ -1034,8 +1418,10 @@ static void on_new_send_payload(OwrTransportAgent *transport_agent,
 
     if (old_payload && old_payload != new_payload) {
         OwrMediaSource *media_source = _owr_media_session_get_send_source(media_session);
-        remove_existing_send_source_and_payload(transport_agent, media_source, media_session);
-        g_object_unref(media_source);
+        if (media_source) {
+            remove_existing_send_source_and_payload(transport_agent, media_source, media_session);
+            g_object_unref(media_source);
+        }
     }
 
     if (new_payload && old_payload != new_payload)
@@ -1059,6 +1445,175 @@ static void on_new_send_source(OwrTransportAgent *transport_agent,
         maybe_handle_new_send_source_with_payload(transport_agent, media_session, 0);
 }
 
+static void update_rtp_session_cname(OwrTransportAgent *transport_agent, OwrMediaSession *media_session,
+    guint stream_id)
+{
+    GObject *internal_session = NULL;
+    GstStructure *sdes = NULL;
+    gchar *cname = NULL;
+
+    g_object_get(media_session, "cname", &cname, NULL);
+    if (!cname)
+        return;
+
+    g_signal_emit_by_name(transport_agent->priv->rtpbin, "get-internal-session", stream_id, &internal_session);
+    g_warn_if_fail(internal_session);
+
+    g_object_get(internal_session, "sdes", &sdes, NULL);
+    gst_structure_set(sdes, "cname", G_TYPE_STRING, cname, NULL);
+    g_object_set(internal_session, "sdes", sdes, NULL);
+
+    gst_structure_free(sdes);
+    g_object_unref(internal_session);
+    g_free(cname);
+}
+
+/* Forwarded RTP skips the send input bin and goes straight to rtpbin */
+static void handle_new_forward_source(OwrTransportAgent *transport_agent, OwrMediaSession *media_session,
+    GstElement *forward_source)
+{
+    GstElement *transport_bin = transport_agent->priv->transport_bin;
+    guint session_id, stream_id, send_ssrc = 0;
+    gint payload_type = -1;
+    GstPad *srcpad, *rtp_sink_pad;
+    OwrPayload *payload;
+    gchar *name;
+
+    g_object_get(media_session, "send-ssrc", &send_ssrc, NULL);
+    _owr_rtp_forward_set_ssrc(forward_source, send_ssrc);
+    payload = _owr_media_session_get_send_payload(media_session);
+    if (payload) {
+        g_object_get(payload, "payload-type", &payload_type, NULL);
+        g_object_unref(payload);
+    }
+    _owr_rtp_forward_set_payload_type(forward_source, payload_type);
+
+    /* Already forwarding, only the payload type may have changed */
+    if (GST_OBJECT_PARENT(forward_source))
+        return;
+
+    stream_id = _owr_session_get_stream_id(OWR_SESSION(media_session));
+    session_id = get_session_id(transport_agent, OWR_SESSION(media_session));
+
+    name = g_strdup_printf("send_rtp_sink_%u", session_id);
+    rtp_sink_pad = gst_element_get_request_pad(transport_agent->priv->rtpbin, name);
+    g_free(name);
+
+    link_rtpbin_to_send_output_bin(transport_agent, session_id, stream_id, TRUE, TRUE);
+    update_rtp_session_cname(transport_agent, media_session, stream_id);
+
+    gst_bin_add(GST_BIN(transport_bin), forward_source);
+    srcpad = gst_element_get_static_pad(forward_source, "src");
+    g_warn_if_fail(gst_pad_link(srcpad, rtp_sink_pad) == GST_PAD_LINK_OK);
+    gst_object_unref(srcpad);
+    gst_object_unref(rtp_sink_pad);
+
+    gst_element_sync_state_with_parent(forward_source);
+
+    GST_DEBUG_OBJECT(transport_agent, "Forwarding RTP on session %u", session_id);
+}
+
+static void remove_forward_source(OwrTransportAgent *transport_agent, GstElement *forward_source)
+{
+    GstElement *transport_bin = transport_agent->priv->transport_bin;
+
+    if (GST_OBJECT_PARENT(forward_source) != GST_OBJECT(transport_bin))
+        return;
+
+    gst_element_set_state(forward_source, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(transport_bin), forward_source);
+}
+
+static void on_new_forward_source(OwrTransportAgent *transport_agent,
+    GstElement *old_forward_source, GstElement *new_forward_source,
+    OwrMediaSession *media_session)
+{
+    OwrMediaSource *media_source;
+
+    g_assert(OWR_IS_TRANSPORT_AGENT(transport_agent));
+    g_assert(OWR_IS_MEDIA_SESSION(media_session));
+
+    if (old_forward_source)
+        remove_forward_source(transport_agent, old_forward_source);
+
+    /* The forwarded stream takes the place of the send source */
+    media_source = _owr_media_session_get_send_source(media_session);
+    if (new_forward_source && media_source)
+        remove_existing_send_source_and_payload(transport_agent, media_source, media_session);
+    if (media_source)
+        g_object_unref(media_source);
+
+    maybe_handle_new_send_source_with_payload(transport_agent, media_session, 0);
+}
+
+static void attach_forward_sink(OwrTransportAgent *transport_agent, GstElement *tee, GstElement *sink)
+{
+    GstPad *srcpad, *sinkpad;
+
+    /* Attached already when the first RTP arrived */
+    if (GST_OBJECT_PARENT(sink))
+        return;
+
+    gst_bin_add(GST_BIN(transport_agent->priv->transport_bin), sink);
+    srcpad = gst_element_get_request_pad(tee, "src_%u");
+    sinkpad = gst_element_get_static_pad(sink, "sink");
+    g_warn_if_fail(gst_pad_link(srcpad, sinkpad) == GST_PAD_LINK_OK);
+    gst_object_unref(sinkpad);
+    gst_object_unref(srcpad);
+
+    gst_element_sync_state_with_parent(sink);
+}
+
+static void detach_forward_sink(OwrTransportAgent *transport_agent, GstElement *sink)
+{
+    GstElement *transport_bin = transport_agent->priv->transport_bin, *tee;
+    GstPad *srcpad, *sinkpad;
+
+    if (GST_OBJECT_PARENT(sink) != GST_OBJECT(transport_bin))
+        return;
+
+    sinkpad = gst_element_get_static_pad(sink, "sink");
+    srcpad = gst_pad_get_peer(sinkpad);
+    if (srcpad) {
+        tee = gst_pad_get_parent_element(srcpad);
+        gst_pad_unlink(srcpad, sinkpad);
+        gst_element_release_request_pad(tee, srcpad);
+        gst_object_unref(tee);
+        gst_object_unref(srcpad);
+    }
+    gst_object_unref(sinkpad);
+
+    gst_element_set_state(sink, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(transport_bin), sink);
+}
+
+static void on_new_forward_sink(OwrTransportAgent *transport_agent, GstElement *sink,
+    gboolean added, OwrMediaSession *media_session)
+{
+    GstElement *tee;
+    gchar name[OWR_OBJECT_NAME_LENGTH_MAX];
+
+    g_assert(OWR_IS_TRANSPORT_AGENT(transport_agent));
+    g_assert(OWR_IS_MEDIA_SESSION(media_session));
+
+    if (!added) {
+        detach_forward_sink(transport_agent, sink);
+        return;
+    }
+
+    g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "receive-forward-tee-%u",
+        get_session_id(transport_agent, OWR_SESSION(media_session)));
+    tee = gst_bin_get_by_name(GST_BIN(transport_agent->priv->transport_bin), name);
+    if (tee) {
+        attach_forward_sink(transport_agent, tee, sink);
+        gst_object_unref(tee);
+    } else {
+        /* The sink is attached together with the tee, which is added to the
+         * receive path when it exists or when the first RTP arrives */
+        insert_forward_tee(transport_agent, media_session);
+    }
+}
+
 static gboolean add_session(GHashTable *args)
 {
     OwrTransportAgent *transport_agent;
@@ -1124,6 +1679,8 @@ static gboolean add_session(GHashTable *args)
             g_cclosure_new_object_swap(G_CALLBACK(on_new_remote_candidate), G_OBJECT(transport_agent)));
         _owr_session_set_on_local_candidate_change(session,
             g_cclosure_new_object_swap(G_CALLBACK(on_local_candidate_change), G_OBJECT(transport_agent)));
+        _owr_session_set_on_restart_ice(session,
+            g_cclosure_new_object_swap(G_CALLBACK(on_restart_ice), G_OBJECT(transport_agent)));
     }
 
     if (OWR_IS_MEDIA_SESSION(session)) {
@@ -1136,6 +1693,12 @@ static gboolean add_session(GHashTable *args)
         _owr_media_session_set_on_send_payload(OWR_MEDIA_SESSION(session),
             g_cclosure_new_object_swap(G_CALLBACK(on_new_send_payload), G_OBJECT(transport_agent)));
 
+        _owr_media_session_set_on_forward_source(OWR_MEDIA_SESSION(session),
+            g_cclosure_new_object_swap(G_CALLBACK(on_new_forward_source), G_OBJECT(transport_agent)));
+
+        _owr_media_session_set_on_forward_sink(OWR_MEDIA_SESSION(session),
+            g_cclosure_new_object_swap(G_CALLBACK(on_new_forward_sink), G_OBJECT(transport_agent)));
+
         pending_session_info = g_new0(PendingSessionInfo, 1);
         if (((priv->bundle_policy == OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE) && (number_sessions == 0))
              || (priv->bundle_policy != OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE)) {
@@ -1213,10 +1776,11 @@ static gboolean add_session(GHashTable *args)
         maybe_handle_new_send_source_with_payload(transport_agent, OWR_MEDIA_SESSION(session), 0);
     }
 
+    /* Candidates added before the session was are all new to the agent */
     if (_owr_session_get_remote_candidates(session))
-        on_new_remote_candidate(transport_agent, FALSE, session);
+        on_new_remote_candidate(transport_agent, FALSE, _owr_session_get_remote_candidates(session), session);
     if (_owr_session_get_forced_remote_candidates(session))
-        on_new_remote_candidate(transport_agent, TRUE, session);
+        on_new_remote_candidate(transport_agent, TRUE, _owr_session_get_forced_remote_candidates(session), session);
 
 
 end:
@@ -1226,58 +1790,380 @@ end:
     return FALSE;
 }
 
-static GstElement *add_nice_element(OwrTransportAgent *transport_agent, guint session_id, guint stream_id,
-    gboolean is_sink, gboolean is_rtcp, GstElement *bin)
+static void release_peer_request_pad(const GValue *item, gpointer data)
 {
-    GstElement *nice_element = NULL;
-    gchar *element_name;
-    gboolean added_ok;
+    GstPad *pad = GST_PAD(g_value_get_object(item)), *peer;
+    GstPadTemplate *peer_template;
+    GstElement *peer_element;
+    OWR_UNUSED(data);
 
-    g_return_val_if_fail(OWR_IS_TRANSPORT_AGENT(transport_agent), NULL);
+    peer = gst_pad_get_peer(pad);
+    if (!peer)
+        return;
 
-    if ((transport_agent->priv->bundle_policy == OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE) && !is_rtcp)
-        element_name = g_strdup_printf("nice-%s-%s-%u", is_rtcp ? "rtcp" : "rtp", is_sink
-            ? "sink" : "src", stream_id);
+    if (GST_PAD_IS_SRC(pad))
+        gst_pad_unlink(pad, peer);
     else
-        element_name = g_strdup_printf("nice-%s-%s-%u-%u", is_rtcp ? "rtcp" : "rtp", is_sink
-            ? "sink" : "src", session_id, stream_id);
-    nice_element = gst_bin_get_by_name(GST_BIN(bin), element_name);
-    if (nice_element && (transport_agent->priv->bundle_policy == OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE)) {
-        gst_object_unref(nice_element);
-        return NULL;
-    }
+        gst_pad_unlink(peer, pad);
 
-    nice_element = gst_element_factory_make(is_sink ? "nicesink" : "nicesrc", element_name);
-    g_free(element_name);
+    peer_template = GST_PAD_PAD_TEMPLATE(peer);
+    peer_element = gst_pad_get_parent_element(peer);
+    if (peer_element && peer_template && GST_PAD_TEMPLATE_PRESENCE(peer_template) == GST_PAD_REQUEST)
+        gst_element_release_request_pad(peer_element, peer);
 
-    g_object_set(nice_element, "agent", transport_agent->priv->nice_agent,
-        "stream", stream_id,
-        "component", is_rtcp
-        ? NICE_COMPONENT_TYPE_RTCP : NICE_COMPONENT_TYPE_RTP, NULL);
+    if (peer_element)
+        gst_object_unref(peer_element);
+    gst_object_unref(peer);
+}
 
-    if (is_sink) {
-        g_object_set(nice_element, "enable-last-sample", FALSE, "async", FALSE, NULL);
-        if (is_rtcp) {
-            g_object_set(nice_element, "sync", FALSE, NULL);
-        }
-    } else if (!is_rtcp) {
-        GstPad *nice_src_pad = NULL;
+/* Shuts down and removes a child of bin, giving back the request pads it was
+ * linked to on its siblings */
+static void remove_element_from_bin(GstBin *bin, const gchar *name)
+{
+    GstElement *element;
+    GstIterator *iterator;
 
-        nice_src_pad = gst_element_get_static_pad(nice_element, "src");
-        gst_pad_add_probe(nice_src_pad, GST_PAD_PROBE_TYPE_BUFFER, probe_save_ts, NULL, NULL);
-        gst_object_unref(nice_src_pad);
-    }
+    element = gst_bin_get_by_name(bin, name);
+    if (!element)
+        return;
 
-    added_ok = gst_bin_add(GST_BIN(bin), nice_element);
-    g_warn_if_fail(added_ok);
+    iterator = gst_element_iterate_pads(element);
+    gst_iterator_foreach(iterator, (GstIteratorForeachFunction) release_peer_request_pad, NULL);
+    gst_iterator_free(iterator);
 
-    return nice_element;
+    gst_element_set_state(element, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(GST_OBJECT_PARENT(element)), element);
+    gst_object_unref(element);
 }
 
-static void set_srtp_key(OwrMediaSession *media_session, GParamSpec *pspec,
-    GstElement *dtls_srtp_bin)
+static void remove_ghost_pad(GstElement *bin, const gchar *name)
 {
-    GstBuffer *srtp_key_buf = _owr_media_session_get_srtp_key_buffer(media_session,
+    GstPad *pad;
+
+    pad = gst_element_get_static_pad(bin, name);
+    if (!pad)
+        return;
+
+    gst_pad_set_active(pad, FALSE);
+    gst_element_remove_pad(bin, pad);
+    gst_object_unref(pad);
+}
+
+static void collect_pad(const GValue *item, GSList **pads)
+{
+    *pads = g_slist_prepend(*pads, g_value_dup_object(item));
+}
+
+/* Removes the transport bin source pads of the session together with the
+ * remote source bins linked to them */
+static void remove_receive_pads(OwrTransportAgent *transport_agent, guint session_id, guint stream_id)
+{
+    GstElement *transport_bin = transport_agent->priv->transport_bin;
+    GstElement *source_bin;
+    GstIterator *iterator;
+    GSList *pads = NULL, *item;
+    GstPad *pad, *peer;
+    guint codec_type, pad_session_id, pad_stream_id;
+    gchar *pad_name;
+
+    iterator = gst_element_iterate_src_pads(transport_bin);
+    gst_iterator_foreach(iterator, (GstIteratorForeachFunction) collect_pad, &pads);
+    gst_iterator_free(iterator);
+
+    for (item = pads; item; item = item->next) {
+        pad = item->data;
+        pad_name = gst_pad_get_name(pad);
+        if ((sscanf(pad_name, "audio_src_%u_%u_%u", &codec_type, &pad_session_id, &pad_stream_id) == 3
+            || sscanf(pad_name, "video_src_%u_%u_%u", &codec_type, &pad_session_id, &pad_stream_id) == 3)
+            && pad_session_id == session_id && pad_stream_id == stream_id) {
+            peer = gst_pad_get_peer(pad);
+            if (peer) {
+                source_bin = gst_pad_get_parent_element(peer);
+                gst_pad_unlink(pad, peer);
+                if (source_bin) {
+                    gst_element_set_state(source_bin, GST_STATE_NULL);
+                    gst_bin_remove(GST_BIN(transport_agent->priv->pipeline), source_bin);
+                    gst_object_unref(source_bin);
+                }
+                gst_object_unref(peer);
+            }
+            remove_ghost_pad(transport_bin, pad_name);
+        }
+        g_free(pad_name);
+    }
+    g_slist_free_full(pads, gst_object_unref);
+}
+
+static void release_rtpbin_pad(OwrTransportAgent *transport_agent, const gchar *pad_name)
+{
+    GstElement *rtpbin = transport_agent->priv->rtpbin;
+    GstPad *pad;
+
+    pad = gst_element_get_static_pad(rtpbin, pad_name);
+    if (!pad)
+        return;
+
+    gst_element_release_request_pad(rtpbin, pad);
+    gst_object_unref(pad);
+}
+
+static void remove_media_session_elements(OwrTransportAgent *transport_agent,
+    OwrMediaSession *media_session, guint session_id, guint stream_id, gboolean shares_stream)
+{
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+    GstBin *transport_bin = GST_BIN(priv->transport_bin);
+    OwrMediaSource *media_source;
+    GstElement *forward_source, *send_output_bin;
+    GList *forward_sinks, *item;
+    GObject *rtp_session = NULL;
+    SendBinInfo *send_bin_info;
+    gchar name[OWR_OBJECT_NAME_LENGTH_MAX];
+
+    media_source = _owr_media_session_get_send_source(media_session);
+    if (media_source) {
+        remove_existing_send_source_and_payload(transport_agent, media_source, media_session);
+        g_object_unref(media_source);
+    }
+
+    forward_source = _owr_media_session_get_forward_source(media_session);
+    if (forward_source) {
+        remove_forward_source(transport_agent, forward_source);
+        gst_object_unref(forward_source);
+    }
+
+    forward_sinks = _owr_media_session_get_forward_sinks(media_session);
+    for (item = forward_sinks; item; item = item->next)
+        detach_forward_sink(transport_agent, item->data);
+    g_list_free_full(forward_sinks, gst_object_unref);
+
+    remove_receive_pads(transport_agent, session_id, stream_id);
+
+    g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "receive-output-bin-%u-%u", session_id, stream_id);
+    remove_element_from_bin(transport_bin, name);
+    g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "receive-forward-tee-%u", session_id);
+    remove_element_from_bin(transport_bin, name);
+    g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "send-input-bin-%u-%u", session_id, stream_id);
+    remove_element_from_bin(transport_bin, name);
+
+    /* stream_id is used as the rtpbin session id */
+    g_signal_emit_by_name(priv->rtpbin, "get-internal-session", stream_id, &rtp_session);
+    if (rtp_session) {
+        if (g_object_get_data(rtp_session, "session") == media_session)
+            g_object_set_data(rtp_session, "session", NULL);
+        if (!shares_stream)
+            g_signal_handlers_disconnect_by_data(rtp_session, transport_agent);
+        g_object_unref(rtp_session);
+    }
+
+    if (shares_stream) {
+        guint ssrc = GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(media_session), "ssrc"));
+
+        /* Only the elements of this session go, the bundled transport stays */
+        send_bin_info = g_hash_table_lookup(priv->send_bins, GUINT_TO_POINTER(stream_id));
+        send_output_bin = send_bin_info ? send_bin_info->send_output_bin : NULL;
+        if (send_output_bin) {
+            g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "screamqueue-%u-%u", session_id, stream_id);
+            remove_element_from_bin(GST_BIN(send_output_bin), name);
+            g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "rtcp-output-selector-%u-%u", session_id, stream_id);
+            remove_element_from_bin(GST_BIN(send_output_bin), name);
+            g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "rtp_sink_%u", session_id + stream_id);
+            remove_ghost_pad(send_output_bin, name);
+            g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "rtcp_sink_%u", session_id);
+            remove_ghost_pad(send_output_bin, name);
+        }
+
+        if (ssrc && g_signal_lookup("clear-ssrc", G_OBJECT_TYPE(priv->rtpbin)))
+            g_signal_emit_by_name(priv->rtpbin, "clear-ssrc", stream_id, ssrc);
+    } else {
+        g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "send-output-bin-%u", stream_id);
+        remove_element_from_bin(transport_bin, name);
+        g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "receive-input-bin-%u",
+            priv->bundle_policy == OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE ? session_id : stream_id);
+        remove_element_from_bin(transport_bin, name);
+
+        g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "recv_rtp_sink_%u", stream_id);
+        release_rtpbin_pad(transport_agent, name);
+        g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "recv_rtcp_sink_%u", stream_id);
+        release_rtpbin_pad(transport_agent, name);
+    }
+
+    g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "send_rtp_sink_%u", session_id);
+    release_rtpbin_pad(transport_agent, name);
+    g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "send_rtcp_src_%u", session_id);
+    release_rtpbin_pad(transport_agent, name);
+}
+
+static void remove_data_session_elements(OwrTransportAgent *transport_agent,
+    OwrDataSession *data_session, guint session_id, guint stream_id)
+{
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+    GHashTableIter iter;
+    DataChannel *data_channel_info;
+    OwrDataChannel *data_channel;
+    gchar name[OWR_OBJECT_NAME_LENGTH_MAX];
+
+    g_rw_lock_writer_lock(&priv->data_channels_rw_mutex);
+    g_hash_table_iter_init(&iter, priv->data_channels);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&data_channel_info)) {
+        if (data_channel_info->session_id != session_id)
+            continue;
+
+        data_channel = _owr_data_session_get_datachannel(data_session, data_channel_info->id);
+        if (data_channel) {
+            _owr_data_channel_clear_closures(data_channel);
+            _owr_data_channel_set_ready_state(data_channel, OWR_DATA_CHANNEL_READY_STATE_CLOSED);
+        }
+        g_hash_table_iter_remove(&iter);
+    }
+    g_rw_lock_writer_unlock(&priv->data_channels_rw_mutex);
+
+    /* The data channel appsrcs and appsinks live inside these bins */
+    g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "send-output-bin-%u", stream_id);
+    remove_element_from_bin(GST_BIN(priv->transport_bin), name);
+    g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "receive-input-bin-%u", stream_id);
+    remove_element_from_bin(GST_BIN(priv->transport_bin), name);
+}
+
+static gboolean remove_session(GHashTable *args)
+{
+    OwrTransportAgent *transport_agent;
+    OwrTransportAgentPrivate *priv;
+    OwrSession *session;
+    GHashTableIter iter;
+    gpointer value;
+    guint session_id, stream_id;
+    gboolean shares_stream = FALSE;
+    GList *item, *next;
+
+    g_return_val_if_fail(args, FALSE);
+
+    transport_agent = g_hash_table_lookup(args, "transport_agent");
+    session = OWR_SESSION(g_hash_table_lookup(args, "session"));
+
+    g_return_val_if_fail(transport_agent, FALSE);
+    g_return_val_if_fail(session, FALSE);
+
+    priv = transport_agent->priv;
+    stream_id = _owr_session_get_stream_id(session);
+
+    AGENT_SESSIONS_LOCK(transport_agent);
+    session_id = get_session_id_unlocked(transport_agent, session);
+    if (!session_id) {
+        AGENT_SESSIONS_UNLOCK(transport_agent);
+        g_warning("A session that was not added to the transport agent was removed. Action aborted.");
+        goto end;
+    }
+    g_hash_table_iter_init(&iter, priv->sessions);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        if (value != session && _owr_session_get_stream_id(OWR_SESSION(value)) == stream_id)
+            shares_stream = TRUE;
+    }
+    AGENT_SESSIONS_UNLOCK(transport_agent);
+
+    GST_DEBUG_OBJECT(transport_agent, "Removing session %u on stream %u", session_id, stream_id);
+
+    if (OWR_IS_MEDIA_SESSION(session)) {
+        _owr_media_session_clear_closures(OWR_MEDIA_SESSION(session));
+        remove_media_session_elements(transport_agent, OWR_MEDIA_SESSION(session), session_id,
+            stream_id, shares_stream);
+    } else if (OWR_IS_DATA_SESSION(session)) {
+        _owr_data_session_clear_closures(OWR_DATA_SESSION(session));
+        remove_data_session_elements(transport_agent, OWR_DATA_SESSION(session), session_id, stream_id);
+    }
+
+    if (!shares_stream) {
+        g_hash_table_remove(priv->send_bins, GUINT_TO_POINTER(stream_id));
+
+        g_mutex_lock(&priv->rtcp_lock);
+        for (item = priv->rtcp_list; item; item = next) {
+            next = item->next;
+            if (GPOINTER_TO_UINT(g_hash_table_lookup(item->data, "stream_id")) == stream_id) {
+                g_hash_table_unref(item->data);
+                priv->rtcp_list = g_list_delete_link(priv->rtcp_list, item);
+            }
+        }
+        g_mutex_unlock(&priv->rtcp_lock);
+
+        g_mutex_lock(&priv->stream_watches_lock);
+        g_hash_table_remove(priv->stream_watches, GUINT_TO_POINTER(stream_id));
+        g_mutex_unlock(&priv->stream_watches_lock);
+
+        nice_agent_remove_stream(priv->nice_agent, stream_id);
+    }
+
+    AGENT_SESSIONS_LOCK(transport_agent);
+    g_hash_table_remove(priv->pending_sessions, GUINT_TO_POINTER(session_id));
+    g_hash_table_remove(priv->sessions, GUINT_TO_POINTER(session_id));
+    AGENT_SESSIONS_UNLOCK(transport_agent);
+
+end:
+    g_object_unref(session);
+    g_object_unref(transport_agent);
+    g_hash_table_unref(args);
+    return FALSE;
+}
+
+static GstElement *add_nice_element(OwrTransportAgent *transport_agent, guint session_id, guint stream_id,
+    gboolean is_sink, gboolean is_rtcp, GstElement *bin)
+{
+    GstElement *nice_element = NULL;
+    gchar *element_name;
+    gboolean added_ok;
+
+    g_return_val_if_fail(OWR_IS_TRANSPORT_AGENT(transport_agent), NULL);
+
+    if ((transport_agent->priv->bundle_policy == OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE) && !is_rtcp)
+        element_name = g_strdup_printf("nice-%s-%s-%u", is_rtcp ? "rtcp" : "rtp", is_sink
+            ? "sink" : "src", stream_id);
+    else
+        element_name = g_strdup_printf("nice-%s-%s-%u-%u", is_rtcp ? "rtcp" : "rtp", is_sink
+            ? "sink" : "src", session_id, stream_id);
+    nice_element = gst_bin_get_by_name(GST_BIN(bin), element_name);
+    if (nice_element && (transport_agent->priv->bundle_policy == OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE)) {
+        gst_object_unref(nice_element);
+        return NULL;
+    }
+
+    nice_element = gst_element_factory_make(is_sink ? "nicesink" : "nicesrc", element_name);
+    g_free(element_name);
+
+    g_object_set(nice_element, "agent", transport_agent->priv->nice_agent,
+        "stream", stream_id,
+        "component", is_rtcp
+        ? NICE_COMPONENT_TYPE_RTCP : NICE_COMPONENT_TYPE_RTP, NULL);
+
+    if (is_sink) {
+        g_object_set(nice_element, "enable-last-sample", FALSE, "async", FALSE, NULL);
+        if (is_rtcp) {
+            g_object_set(nice_element, "sync", FALSE, NULL);
+        }
+    } else if (!is_rtcp) {
+        GstPad *nice_src_pad = NULL;
+
+        nice_src_pad = gst_element_get_static_pad(nice_element, "src");
+        gst_pad_add_probe(nice_src_pad, GST_PAD_PROBE_TYPE_BUFFER, probe_save_ts, NULL, NULL);
+        gst_object_unref(nice_src_pad);
+    }
+
+    if (!is_sink) {
+        GstPad *nice_src_pad = gst_element_get_static_pad(nice_element, "src");
+        StreamWatch *watch = get_stream_watch(transport_agent, stream_id);
+
+        gst_pad_add_probe(nice_src_pad, GST_PAD_PROBE_TYPE_BUFFER, probe_stream_watch,
+            &watch->component[is_rtcp ? OWR_COMPONENT_TYPE_RTCP : OWR_COMPONENT_TYPE_RTP], NULL);
+        gst_object_unref(nice_src_pad);
+    }
+
+    added_ok = gst_bin_add(GST_BIN(bin), nice_element);
+    g_warn_if_fail(added_ok);
+
+    return nice_element;
+}
+
+static void set_srtp_key(OwrMediaSession *media_session, GParamSpec *pspec,
+    GstElement *dtls_srtp_bin)
+{
+    GstBuffer *srtp_key_buf = _owr_media_session_get_srtp_key_buffer(media_session,
         g_param_spec_get_name(pspec));
     g_return_if_fail(GST_IS_BUFFER(srtp_key_buf));
 
@@ -1442,12 +2328,37 @@ static gboolean emit_bitrate_change(GHashTable *args)
 {
     OwrMediaSession *session;
     OwrPayload *payload;
-    guint bitrate;
+    GList *send_encodings, *item;
+    guint bitrate, ssrc;
 
     session = g_hash_table_lookup(args, "session");
     bitrate = GPOINTER_TO_UINT(g_hash_table_lookup(args, "bitrate"));
+    ssrc = GPOINTER_TO_UINT(g_hash_table_lookup(args, "ssrc"));
 
+    /* SCReAM paces the FEC packets too, leave room for them in the budget */
     payload = _owr_media_session_get_send_payload(session);
+    if (payload) {
+        bitrate = _owr_payload_get_media_bitrate(payload, bitrate);
+        g_object_unref(payload);
+    }
+
+    /* Simulcast layers get their own share of the congestion control budget */
+    payload = NULL;
+    send_encodings = _owr_media_session_get_send_encodings(session);
+    for (item = send_encodings; item && !payload; item = item->next) {
+        guint encoding_ssrc = 0, max_bitrate = 0;
+
+        g_object_get(item->data, "ssrc", &encoding_ssrc, "max-bitrate", &max_bitrate, NULL);
+        if (encoding_ssrc == ssrc) {
+            payload = _owr_send_encoding_get_payload(item->data);
+            if (max_bitrate)
+                bitrate = MIN(bitrate, max_bitrate);
+        }
+    }
+    g_list_free_full(send_encodings, g_object_unref);
+
+    if (!payload)
+        payload = _owr_media_session_get_send_payload(session);
 
     if (payload) {
         guint old_bitrate = 0;
@@ -1471,7 +2382,6 @@ static void on_bitrate_change(GstElement *scream_queue, guint bitrate, guint ssr
 {
     GHashTable *args;
     OWR_UNUSED(scream_queue);
-    OWR_UNUSED(ssrc);
     OWR_UNUSED(pt);
 
     g_return_if_fail(session);
@@ -1480,6 +2390,7 @@ static void on_bitrate_change(GstElement *scream_queue, guint bitrate, guint ssr
 
     g_hash_table_insert(args, "session", g_object_ref(session));
     g_hash_table_insert(args, "bitrate", GUINT_TO_POINTER(bitrate));
+    g_hash_table_insert(args, "ssrc", GUINT_TO_POINTER(ssrc));
 
     _owr_schedule_with_hash_table((GSourceFunc)emit_bitrate_change, args);
 }
@@ -1993,75 +2904,144 @@ static void set_send_ssrc_and_cname(OwrTransportAgent *transport_agent, OwrMedia
     g_object_unref(session);
 }
 
-static gboolean emit_new_candidate(GHashTable *args)
+static void fill_local_credentials(OwrTransportAgent *transport_agent, NiceCandidate *nice_candidate)
 {
-    OwrTransportAgent *transport_agent;
-    OwrTransportAgentPrivate *priv;
-    NiceCandidate *nice_candidate;
-    OwrCandidate *owr_candidate;
     gchar *ufrag = NULL, *password = NULL;
     gboolean got_credentials;
-    GSList *sessions;
-    GSList *walk;
 
-    transport_agent = OWR_TRANSPORT_AGENT(g_hash_table_lookup(args, "transport_agent"));
-    g_return_val_if_fail(OWR_IS_TRANSPORT_AGENT(transport_agent), FALSE);
-    priv = transport_agent->priv;
+    if (nice_candidate->username && nice_candidate->password)
+        return;
+
+    got_credentials = nice_agent_get_local_credentials(transport_agent->priv->nice_agent,
+        nice_candidate->stream_id, &ufrag, &password);
+    g_warn_if_fail(got_credentials);
+
+    if (!nice_candidate->username)
+        nice_candidate->username = ufrag;
+    else
+        g_free(ufrag);
+
+    if (!nice_candidate->password)
+        nice_candidate->password = password;
+    else
+        g_free(password);
+}
 
-    nice_candidate = (NiceCandidate *)g_hash_table_lookup(args, "nice_candidate");
-    g_return_val_if_fail(nice_candidate, FALSE);
+static void emit_new_candidates_for_stream(OwrTransportAgent *transport_agent, guint stream_id,
+    GSList *nice_candidates)
+{
+    GSList *sessions, *walk, *item;
+    GPtrArray *owr_candidates;
+    OwrCandidate *owr_candidate;
 
-    sessions = get_sessions_from_stream_id(transport_agent, nice_candidate->stream_id);
+    sessions = get_sessions_from_stream_id(transport_agent, stream_id);
     for (walk = sessions; walk; walk = g_slist_next(walk)) {
         OwrSession *session = OWR_SESSION(walk->data);
-        if (!nice_candidate->username || !nice_candidate->password) {
-            got_credentials = nice_agent_get_local_credentials(priv->nice_agent,
-                                                               nice_candidate->stream_id, &ufrag, &password);
-            g_warn_if_fail(got_credentials);
-
-            if (!nice_candidate->username)
-                nice_candidate->username = ufrag;
-            else
-                g_free(ufrag);
-
-            if (!nice_candidate->password)
-                nice_candidate->password = password;
-            else
-                g_free(password);
+
+        owr_candidates = g_ptr_array_new_with_free_func(g_object_unref);
+        for (item = nice_candidates; item; item = item->next) {
+            owr_candidate = _owr_candidate_new_from_nice_candidate(item->data);
+            if (!owr_candidate)
+                continue;
+
+            g_signal_emit_by_name(session, "on-new-candidate", owr_candidate);
+            g_ptr_array_add(owr_candidates, owr_candidate);
         }
 
-        owr_candidate = _owr_candidate_new_from_nice_candidate(nice_candidate);
-        if (!owr_candidate)
-            continue;
+        if (owr_candidates->len)
+            g_signal_emit_by_name(session, "on-new-candidates", owr_candidates);
+        g_ptr_array_unref(owr_candidates);
+    }
+    g_slist_free_full(sessions, g_object_unref);
+}
+
+static gboolean emit_new_candidates(GHashTable *args)
+{
+    OwrTransportAgent *transport_agent;
+    OwrTransportAgentPrivate *priv;
+    NiceCandidate *nice_candidate;
+    GSList *nice_candidates, *item, *stream_candidates = NULL;
+    guint stream_id = 0;
+
+    transport_agent = OWR_TRANSPORT_AGENT(g_hash_table_lookup(args, "transport_agent"));
+    g_return_val_if_fail(OWR_IS_TRANSPORT_AGENT(transport_agent), FALSE);
+    priv = transport_agent->priv;
 
-        g_signal_emit_by_name(session, "on-new-candidate", owr_candidate);
-        g_object_unref(owr_candidate);
+    g_mutex_lock(&priv->pending_local_candidates_lock);
+    nice_candidates = g_slist_reverse(priv->pending_local_candidates);
+    priv->pending_local_candidates = NULL;
+    g_mutex_unlock(&priv->pending_local_candidates_lock);
+
+    GST_DEBUG_OBJECT(transport_agent, "Reporting %u local candidates",
+        g_slist_length(nice_candidates));
+
+    /* Candidates arrive grouped by stream, so report each run of the same
+     * stream as one batch */
+    for (item = nice_candidates; item; item = item->next) {
+        nice_candidate = item->data;
+        fill_local_credentials(transport_agent, nice_candidate);
+
+        if (stream_candidates && nice_candidate->stream_id != stream_id) {
+            stream_candidates = g_slist_reverse(stream_candidates);
+            emit_new_candidates_for_stream(transport_agent, stream_id, stream_candidates);
+            g_slist_free(stream_candidates);
+            stream_candidates = NULL;
+        }
+        stream_id = nice_candidate->stream_id;
+        stream_candidates = g_slist_prepend(stream_candidates, nice_candidate);
+    }
+    if (stream_candidates) {
+        stream_candidates = g_slist_reverse(stream_candidates);
+        emit_new_candidates_for_stream(transport_agent, stream_id, stream_candidates);
+        g_slist_free(stream_candidates);
     }
 
-    g_slist_free_full(sessions, g_object_unref);
-    nice_candidate_free(nice_candidate);
+    g_slist_free_full(nice_candidates, (GDestroyNotify)nice_candidate_free);
     g_hash_table_destroy(args);
     g_object_unref(transport_agent);
 
     return FALSE;
 }
 
-static void on_new_candidate(NiceAgent *nice_agent, NiceCandidate *nice_candidate,
-    OwrTransportAgent *transport_agent)
+/* Takes ownership of nice_candidate */
+static void queue_local_candidate(OwrTransportAgent *transport_agent, NiceCandidate *nice_candidate)
 {
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
     GHashTable *args;
+    gboolean schedule;
 
-    g_return_if_fail(nice_agent);
-    g_return_if_fail(OWR_IS_TRANSPORT_AGENT(transport_agent));
-    g_return_if_fail(nice_candidate);
+    g_mutex_lock(&priv->pending_local_candidates_lock);
+    schedule = !priv->pending_local_candidates;
+    priv->pending_local_candidates = g_slist_prepend(priv->pending_local_candidates,
+        nice_candidate);
+    g_mutex_unlock(&priv->pending_local_candidates_lock);
+
+    if (!schedule)
+        return;
 
     g_object_ref(transport_agent);
     args = _owr_create_schedule_table(OWR_MESSAGE_ORIGIN(transport_agent));
     g_hash_table_insert(args, "transport_agent", transport_agent);
-    g_hash_table_insert(args, "nice_candidate", nice_candidate_copy(nice_candidate));
 
-    _owr_schedule_with_hash_table((GSourceFunc)emit_new_candidate, args);
+    _owr_schedule_with_hash_table((GSourceFunc)emit_new_candidates, args);
+}
+
+static void on_new_candidate(NiceAgent *nice_agent, NiceCandidate *nice_candidate,
+    OwrTransportAgent *transport_agent)
+{
+    g_return_if_fail(nice_agent);
+    g_return_if_fail(OWR_IS_TRANSPORT_AGENT(transport_agent));
+    g_return_if_fail(nice_candidate);
+
+    g_mutex_lock(&transport_agent->priv->pending_local_candidates_lock);
+    if (nice_candidate->stream_id == transport_agent->priv->regathering_stream_id)
+        transport_agent->priv->regathered = TRUE;
+    g_mutex_unlock(&transport_agent->priv->pending_local_candidates_lock);
 
+    /* libnice reports candidates one at a time while gathering, queue them
+     * up so that everything found before the main loop gets to run is
+     * reported in one go */
+    queue_local_candidate(transport_agent, nice_candidate_copy(nice_candidate));
 }
 
 static gboolean emit_candidate_gathering_done(GHashTable *args)
@@ -2140,6 +3120,8 @@ static gboolean emit_ice_state_changed(GHashTable *args)
     component_type = GPOINTER_TO_UINT(g_hash_table_lookup(args, "component-type"));
     state = GPOINTER_TO_UINT(g_hash_table_lookup(args, "ice-state"));
 
+    update_stream_watch(transport_agent, stream_id, component_type, state);
+
     sessions = get_sessions_from_stream_id(transport_agent, stream_id);
     for (walk = sessions; walk; walk = g_slist_next(walk)) {
         OwrSession *session = OWR_SESSION(walk->data);
@@ -2184,6 +3166,9 @@ static void on_new_selected_pair(NiceAgent *nice_agent,
 
     g_return_if_fail(OWR_IS_TRANSPORT_AGENT(transport_agent));
 
+    /* A new pair gets the whole ICE restart timeout to prove itself */
+    reset_component_watch(transport_agent, stream_id, component_id);
+
     sessions = get_sessions_from_stream_id(transport_agent, stream_id);
     for (walk = sessions; walk; walk = g_slist_next(walk)) {
         OwrSession *session = OWR_SESSION(walk->data);
@@ -2443,24 +3428,353 @@ static void on_caps(GstElement *sink, GParamSpec *pspec, OwrSession *session)
     }
 }
 
-static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMediaSession *media_session, OwrPayload * payload)
+/* Media from an encoded source that is sent with another codec is decoded
+ * in the send input bin before going to the encoder */
+static void add_send_decoder_elements(GstElement *send_input_bin, OwrMediaType media_type,
+    OwrCodecType source_codec_type, guint stream_id)
 {
-    guint stream_id;
-    guint session_id;
-    GstElement *send_input_bin = NULL;
-    GstElement *encoder = NULL, *parser = NULL, *payloader = NULL,
-        *rtp_capsfilter = NULL, *rtpbin = NULL;
-    GstCaps *caps = NULL, *rtp_caps = NULL;
-    gchar *name = NULL;
-    gboolean link_ok = TRUE, sync_ok = TRUE;
-    GstPad *sink_pad = NULL, *rtp_sink_pad = NULL, *rtp_capsfilter_src_pad = NULL,
-        *ghost_src_pad = NULL, *encoder_sink_pad;
-    OwrCodecType codec_type = OWR_CODEC_TYPE_NONE;
-    OwrMediaType media_type;
+    GstElement *parser, *decoder, *convert, *resample = NULL;
+    gchar *name;
+
+    parser = _owr_create_parser(source_codec_type);
+    decoder = _owr_create_decoder(source_codec_type);
+    g_return_if_fail(decoder);
+
+    if (media_type == OWR_MEDIA_TYPE_VIDEO) {
+        name = g_strdup_printf("send-input-video-convert-%u", stream_id);
+        convert = gst_element_factory_make("videoconvert", name);
+        g_free(name);
+    } else {
+        name = g_strdup_printf("send-input-audio-convert-%u", stream_id);
+        convert = gst_element_factory_make("audioconvert", name);
+        g_free(name);
+        name = g_strdup_printf("send-input-audio-resample-%u", stream_id);
+        resample = gst_element_factory_make("audioresample", name);
+        g_free(name);
+    }
+
+    if (parser)
+        gst_bin_add(GST_BIN(send_input_bin), parser);
+    gst_bin_add_many(GST_BIN(send_input_bin), decoder, convert, NULL);
+    if (resample)
+        gst_bin_add(GST_BIN(send_input_bin), resample);
+}
+
+static void update_simulcast_layer_caps(GstPad *pad, GParamSpec *pspec, GstElement *capsfilter)
+{
+    OwrSendEncoding *send_encoding;
+    GstCaps *input_caps, *caps;
+    GstStructure *structure;
+    gint width = 0, height = 0, fps_n = 0, fps_d = 1, max_fps_n, max_fps_d;
+    gdouble scale_down_by = 1.0, max_framerate = 0.0;
+
+    OWR_UNUSED(pspec);
+
+    input_caps = gst_pad_get_current_caps(pad);
+    if (!input_caps)
+        return;
+
+    structure = gst_caps_get_structure(input_caps, 0);
+    gst_structure_get_int(structure, "width", &width);
+    gst_structure_get_int(structure, "height", &height);
+    gst_structure_get_fraction(structure, "framerate", &fps_n, &fps_d);
+    gst_caps_unref(input_caps);
+    if (width <= 0 || height <= 0)
+        return;
+
+    send_encoding = g_object_get_data(G_OBJECT(capsfilter), "owr-send-encoding");
+    g_return_if_fail(OWR_IS_SEND_ENCODING(send_encoding));
+    g_object_get(send_encoding, "scale-down-by", &scale_down_by, "max-framerate", &max_framerate, NULL);
+
+    caps = gst_caps_new_simple("video/x-raw",
+        "width", G_TYPE_INT, MAX(2, (gint) (width / scale_down_by)) & ~1,
+        "height", G_TYPE_INT, MAX(2, (gint) (height / scale_down_by)) & ~1,
+        NULL);
+    if (max_framerate > 0.0 && (fps_n <= 0 || fps_d <= 0 || (gdouble) fps_n / fps_d > max_framerate)) {
+        gst_util_double_to_fraction(max_framerate, &max_fps_n, &max_fps_d);
+        gst_caps_set_simple(caps, "framerate", GST_TYPE_FRACTION, max_fps_n, max_fps_d, NULL);
+    }
+
+    GST_DEBUG_OBJECT(capsfilter, "Sending simulcast layer with caps %" GST_PTR_FORMAT, caps);
+    g_object_set(capsfilter, "caps", caps, NULL);
+    gst_caps_unref(caps);
+}
+
+static GstPadProbeReturn drop_inactive_layer(GstPad *pad, GstPadProbeInfo *info,
+    OwrSendEncoding *send_encoding)
+{
+    OWR_UNUSED(pad);
+    OWR_UNUSED(info);
+
+    return _owr_send_encoding_is_active(send_encoding) ? GST_PAD_PROBE_OK : GST_PAD_PROBE_DROP;
+}
+
+static void on_send_encoding_active(OwrSendEncoding *send_encoding, GParamSpec *pspec,
+    GstElement *encoder_capsfilter)
+{
+    OWR_UNUSED(pspec);
+
+    /* A resumed layer must start with a keyframe to be decodable */
+    if (_owr_send_encoding_is_active(send_encoding)) {
+        GstEvent *event = gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE, TRUE, 0);
+
+        gst_structure_set(gst_event_writable_structure(event), "owr-new-consumer", G_TYPE_BOOLEAN, TRUE, NULL);
+        gst_element_send_event(encoder_capsfilter, event);
+    }
+}
+
+/* The funnel that merges the layers forwards upstream events to all of them,
+ * key unit requests from the RTP session name the SSRC they are for and are
+ * only let through to the layer sending it. Layers without a configured SSRC
+ * are matched on the SSRC in their caps, once they have sent anything. */
+static GstPadProbeReturn drop_key_unit_for_other_layer(GstPad *pad, GstPadProbeInfo *info,
+    gpointer user_data)
+{
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+    const GstStructure *structure;
+    GstCaps *caps;
+    guint requested_ssrc = 0, ssrc = GPOINTER_TO_UINT(user_data);
+    gboolean other_layer = FALSE;
+
+    if (!gst_video_event_is_force_key_unit(event))
+        return GST_PAD_PROBE_OK;
+
+    structure = gst_event_get_structure(event);
+    if (!structure || !gst_structure_get_uint(structure, "ssrc", &requested_ssrc))
+        return GST_PAD_PROBE_OK;
+
+    if (ssrc)
+        other_layer = ssrc != requested_ssrc;
+    else if ((caps = gst_pad_get_current_caps(pad))) {
+        structure = gst_caps_get_structure(caps, 0);
+        if (gst_structure_get_uint(structure, "ssrc", &ssrc))
+            other_layer = ssrc != requested_ssrc;
+        gst_caps_unref(caps);
+    }
+
+    if (other_layer) {
+        GST_LOG_OBJECT(pad, "Dropping key unit request for SSRC %u", requested_ssrc);
+        return GST_PAD_PROBE_DROP;
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+/*
+ * Each simulcast layer is a bin of its own:
+ * queue ! videorate ! videoscale ! capsfilter ! encoder ! [parser !] capsfilter ! payloader ! capsfilter
+ * where the encoder bitrate follows a payload owned by the layer and the RTP
+ * caps carry the layer's SSRC.
+ */
+static GstElement *create_simulcast_layer_bin(OwrMediaSession *media_session, OwrPayload *payload,
+    OwrSendEncoding *send_encoding, guint stream_id, guint layer)
+{
+    GstElement *layer_bin, *queue, *videorate, *videoscale, *scale_capsfilter;
+    GstElement *encoder, *parser, *encoder_capsfilter, *payloader, *rtp_capsfilter;
+    OwrPayload *layer_payload;
+    GstCaps *caps;
+    GstPad *pad;
+    gchar *name;
+    guint ssrc = 0, max_bitrate = 0, width = 0, height = 0;
+    gdouble scale_down_by = 1.0, max_framerate = 0.0, framerate = 0.0;
+    gboolean link_ok = TRUE;
+
+    g_object_get(send_encoding, "ssrc", &ssrc, "scale-down-by", &scale_down_by,
+        "max-bitrate", &max_bitrate, "max-framerate", &max_framerate, NULL);
+
+    layer_payload = _owr_payload_clone(payload);
+    g_object_get(layer_payload, "width", &width, "height", &height, "framerate", &framerate, NULL);
+    if (max_framerate > 0.0 && (framerate <= 0.0 || framerate > max_framerate))
+        framerate = max_framerate;
+    g_object_set(layer_payload,
+        "width", (guint) (width / scale_down_by),
+        "height", (guint) (height / scale_down_by),
+        "framerate", framerate,
+        "bitrate", max_bitrate,
+        NULL);
+
+    encoder = _owr_payload_create_encoder(layer_payload);
+    if (!encoder) {
+        GST_ERROR("Failed to create an encoder for simulcast layer %u", layer);
+        g_object_unref(layer_payload);
+        return NULL;
+    }
+
+    name = g_strdup_printf("send-simulcast-layer-%u-%u", stream_id, layer);
+    layer_bin = gst_bin_new(name);
+    g_free(name);
+
+    name = g_strdup_printf("send-simulcast-queue-%u-%u", stream_id, layer);
+    queue = gst_element_factory_make("queue", name);
+    g_free(name);
+    g_object_set(queue, "max-size-buffers", 3, "max-size-bytes", 0,
+        "max-size-time", G_GUINT64_CONSTANT(0), NULL);
+
+    name = g_strdup_printf("send-simulcast-rate-%u-%u", stream_id, layer);
+    videorate = gst_element_factory_make("videorate", name);
+    g_free(name);
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(videorate), "drop-only"))
+        g_object_set(videorate, "drop-only", TRUE, NULL);
+
+    name = g_strdup_printf("send-simulcast-scale-%u-%u", stream_id, layer);
+    videoscale = gst_element_factory_make("videoscale", name);
+    g_free(name);
+
+    name = g_strdup_printf("send-simulcast-scale-capsfilter-%u-%u", stream_id, layer);
+    scale_capsfilter = gst_element_factory_make("capsfilter", name);
+    g_free(name);
+    g_object_set_data_full(G_OBJECT(scale_capsfilter), "owr-send-encoding",
+        g_object_ref(send_encoding), g_object_unref);
+
+    parser = _owr_create_parser(_owr_payload_get_codec_type(layer_payload));
+
+    name = g_strdup_printf("send-simulcast-encoder-capsfilter-%u-%u", stream_id, layer);
+    encoder_capsfilter = gst_element_factory_make("capsfilter", name);
+    g_free(name);
+    caps = _owr_payload_create_encoded_caps(layer_payload);
+    g_object_set(encoder_capsfilter, "caps", caps, NULL);
+    gst_caps_unref(caps);
+
+    payloader = _owr_payload_create_payload_packetizer(layer_payload);
+    g_assert(payloader);
+    _owr_payload_drop_temporal_layers(layer_payload, payloader);
+
+    name = g_strdup_printf("send-simulcast-rtp-capsfilter-%u-%u", stream_id, layer);
+    rtp_capsfilter = gst_element_factory_make("capsfilter", name);
+    g_free(name);
+    caps = _owr_payload_create_rtp_caps(layer_payload);
+    if (ssrc)
+        gst_caps_set_simple(caps, "ssrc", G_TYPE_UINT, ssrc, NULL);
+    g_object_set(rtp_capsfilter, "caps", caps, NULL);
+    gst_caps_unref(caps);
+
+    gst_bin_add_many(GST_BIN(layer_bin), queue, videorate, videoscale, scale_capsfilter, encoder, NULL);
+    if (parser)
+        gst_bin_add(GST_BIN(layer_bin), parser);
+    gst_bin_add_many(GST_BIN(layer_bin), encoder_capsfilter, payloader, rtp_capsfilter, NULL);
+    _owr_bin_link_and_sync_elements(GST_BIN(layer_bin), &link_ok, NULL, NULL, NULL);
+    g_warn_if_fail(link_ok);
+    _owr_video_payload_setup_keyframe_control(OWR_VIDEO_PAYLOAD(layer_payload), encoder,
+        encoder_capsfilter);
+
+    pad = gst_element_get_static_pad(queue, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, (GstPadProbeCallback) drop_inactive_layer,
+        g_object_ref(send_encoding), g_object_unref);
+    g_signal_connect_object(pad, "notify::caps", G_CALLBACK(update_simulcast_layer_caps),
+        scale_capsfilter, 0);
+    ghost_pad_and_add_to_bin(pad, layer_bin, "sink");
+    gst_object_unref(pad);
+
+    pad = gst_element_get_static_pad(rtp_capsfilter, "src");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+        (GstPadProbeCallback) drop_key_unit_for_other_layer, GUINT_TO_POINTER(ssrc), NULL);
+    ghost_pad_and_add_to_bin(pad, layer_bin, "src");
+    gst_object_unref(pad);
+
+    if (!layer) {
+        pad = gst_element_get_static_pad(encoder, "sink");
+        _owr_codec_pool_add_pad_handler(encoder, pad, g_signal_connect(pad, "notify::caps",
+            G_CALLBACK(on_caps), OWR_SESSION(media_session)));
+        gst_object_unref(pad);
+    }
+
+    g_signal_connect_object(send_encoding, "notify::active", G_CALLBACK(on_send_encoding_active),
+        encoder_capsfilter, 0);
+    _owr_send_encoding_set_payload(send_encoding, layer_payload);
+    g_object_unref(layer_payload);
+
+    return layer_bin;
+}
+
+/* Splits the raw video into one encoded RTP stream per send encoding and
+ * merges the streams again, each with its own SSRC, for the RTP session */
+static GstElement *create_simulcast_bin(OwrMediaSession *media_session, OwrPayload *payload,
+    guint stream_id)
+{
+    GstElement *simulcast_bin, *tee, *funnel, *layer_bin;
+    GList *send_encodings, *item;
+    GstPad *pad;
+    gchar *name;
+    guint layer = 0;
+
+    name = g_strdup_printf("send-simulcast-bin-%u", stream_id);
+    simulcast_bin = gst_bin_new(name);
+    g_free(name);
+
+    name = g_strdup_printf("send-simulcast-tee-%u", stream_id);
+    tee = gst_element_factory_make("tee", name);
+    g_free(name);
+
+    name = g_strdup_printf("send-simulcast-funnel-%u", stream_id);
+    funnel = gst_element_factory_make("funnel", name);
+    g_free(name);
+
+    gst_bin_add_many(GST_BIN(simulcast_bin), tee, funnel, NULL);
+
+    send_encodings = _owr_media_session_get_send_encodings(media_session);
+    for (item = send_encodings; item; item = item->next, layer++) {
+        layer_bin = create_simulcast_layer_bin(media_session, payload, item->data, stream_id, layer);
+        if (!layer_bin)
+            continue;
+
+        gst_bin_add(GST_BIN(simulcast_bin), layer_bin);
+        if (!gst_element_link_pads(tee, "src_%u", layer_bin, "sink")
+            || !gst_element_link_pads(layer_bin, "src", funnel, "sink_%u"))
+            GST_ERROR("Failed to link simulcast layer %u", layer);
+    }
+    g_list_free_full(send_encodings, g_object_unref);
+
+    pad = gst_element_get_static_pad(tee, "sink");
+    ghost_pad_and_add_to_bin(pad, simulcast_bin, "sink");
+    gst_object_unref(pad);
+
+    pad = gst_element_get_static_pad(funnel, "src");
+    ghost_pad_and_add_to_bin(pad, simulcast_bin, "src");
+    gst_object_unref(pad);
+
+    return simulcast_bin;
+}
+
+static void release_simulcast_layers(OwrMediaSession *media_session, GstElement *send_input_bin,
+    guint stream_id)
+{
+    GstElement *layer_bin;
+    GList *send_encodings, *item;
+    gchar *name;
+    guint layer;
+
+    send_encodings = _owr_media_session_get_send_encodings(media_session);
+    for (item = send_encodings, layer = 0; item; item = item->next, layer++) {
+        name = g_strdup_printf("send-simulcast-layer-%u-%u", stream_id, layer);
+        layer_bin = gst_bin_get_by_name(GST_BIN(send_input_bin), name);
+        g_free(name);
+        if (layer_bin) {
+            _owr_codec_pool_release_from_bin(GST_BIN(layer_bin));
+            gst_object_unref(layer_bin);
+        }
+        _owr_send_encoding_set_payload(item->data, NULL);
+    }
+    g_list_free_full(send_encodings, g_object_unref);
+}
+
+static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMediaSession *media_session, OwrPayload * payload)
+{
+    guint stream_id;
+    guint session_id;
+    GstElement *send_input_bin = NULL;
+    GstElement *encoder = NULL, *parser = NULL, *payloader = NULL,
+        *rtp_capsfilter = NULL, *rtpbin = NULL;
+    GstCaps *caps = NULL, *rtp_caps = NULL;
+    gchar *name = NULL;
+    gboolean link_ok = TRUE, sync_ok = TRUE;
+    GstPad *sink_pad = NULL, *rtp_sink_pad = NULL, *rtp_capsfilter_src_pad = NULL,
+        *ghost_src_pad = NULL, *encoder_sink_pad;
+    OwrCodecType codec_type = OWR_CODEC_TYPE_NONE, source_codec_type;
+    OwrMediaType media_type;
     guint send_ssrc = 0;
-    gchar *cname = NULL;
     OwrMediaSource *media_source = NULL;
-    GstElement *first = NULL;
+    GstElement *first = NULL, *simulcast_bin = NULL;
+    gboolean simulcast;
 
     g_return_if_fail(transport_agent);
     g_return_if_fail(media_session);
@@ -2494,32 +3808,34 @@ static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMedia
     g_free(name);
     rtp_caps = _owr_payload_create_rtp_caps(payload);
 
-    g_object_get(media_session, "send-ssrc", &send_ssrc, "cname", &cname, NULL);
-    if (cname) {
-        GObject *internal_session = NULL;
-        GstStructure *sdes = NULL;
+    g_object_get(media_session, "send-ssrc", &send_ssrc, NULL);
+    update_rtp_session_cname(transport_agent, media_session, stream_id);
 
-        g_signal_emit_by_name(rtpbin, "get-internal-session", stream_id, &internal_session);
-        g_warn_if_fail(internal_session);
-
-        g_object_get(internal_session, "sdes", &sdes, NULL);
-        gst_structure_set(sdes, "cname", G_TYPE_STRING, cname, NULL);
-        g_object_set(internal_session, "sdes", sdes, NULL);
-
-        gst_structure_free(sdes);
-        g_object_unref(internal_session);
-    }
-    if (send_ssrc)
+    media_source = _owr_media_session_get_send_source(media_session);
+    source_codec_type = _owr_media_source_get_codec(media_source);
+
+    /* Every simulcast layer carries its own SSRC */
+    simulcast = media_type == OWR_MEDIA_TYPE_VIDEO && OWR_IS_VIDEO_PAYLOAD(payload)
+        && _owr_media_session_has_send_encodings(media_session)
+        && !uses_passthrough(media_source, payload)
+        && !_owr_media_source_supports_interfaces(media_source, OWR_MEDIA_SOURCE_SUPPORTS_VIDEO_ORIENTATION);
+    if (send_ssrc && !simulcast)
         gst_caps_set_simple(rtp_caps, "ssrc", G_TYPE_UINT, send_ssrc, NULL);
 
     g_object_set(rtp_capsfilter, "caps", rtp_caps, NULL);
     gst_caps_unref(rtp_caps);
 
-    media_source = _owr_media_session_get_send_source(media_session);
-
-    if (media_type == OWR_MEDIA_TYPE_VIDEO && OWR_IS_VIDEO_PAYLOAD(payload)) {
+    if (uses_passthrough(media_source, payload)) {
+        /* The source already delivers media in the payload's codec */
+        parser = _owr_create_parser(codec_type);
+        if (parser)
+            gst_bin_add(GST_BIN(send_input_bin), parser);
+    } else if (media_type == OWR_MEDIA_TYPE_VIDEO && OWR_IS_VIDEO_PAYLOAD(payload)) {
         GstElement *gldownload;
         GstElement *flip = NULL, *queue = NULL, *encoder_capsfilter = NULL;
+        GstElement *degradation_capsfilter = NULL;
+        OwrDegradationPreference degradation_preference = OWR_DEGRADATION_PREFERENCE_DISABLED;
+
         if (_owr_codec_type_is_raw(_owr_payload_get_codec_type(payload))) {
             name = g_strdup_printf("send-input-video-gldownload-%u", stream_id);
             gldownload = gst_element_factory_make("gldownload", name);
@@ -2527,7 +3843,11 @@ static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMedia
             gst_bin_add(GST_BIN(send_input_bin), gldownload);
         }
 
-        if (!_owr_media_source_supports_interfaces(media_source, OWR_MEDIA_SOURCE_SUPPORTS_VIDEO_ORIENTATION)) {
+        if (!_owr_codec_type_is_raw(source_codec_type))
+            add_send_decoder_elements(send_input_bin, media_type, source_codec_type, stream_id);
+
+        if (!_owr_media_source_supports_interfaces(media_source, OWR_MEDIA_SOURCE_SUPPORTS_VIDEO_ORIENTATION)
+            && !uses_shared_encoder(media_session, media_source, payload)) {
             name = g_strdup_printf("send-input-video-flip-%u", stream_id);
             flip = gst_element_factory_make("videoflip", name);
             g_assert(flip);
@@ -2535,7 +3855,12 @@ static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMedia
             g_signal_connect_object(payload, "notify::rotation", G_CALLBACK(_owr_update_flip_method), flip, 0);
             g_signal_connect_object(payload, "notify::mirror", G_CALLBACK(_owr_update_flip_method), flip, 0);
             _owr_update_flip_method(G_OBJECT(payload), NULL, flip);
+        }
 
+        if (simulcast) {
+            simulcast_bin = create_simulcast_bin(media_session, payload, stream_id);
+            gst_bin_add_many(GST_BIN(send_input_bin), flip, simulcast_bin, NULL);
+        } else if (flip) {
             name = g_strdup_printf("send-input-video-queue-%u", stream_id);
             queue = gst_element_factory_make("queue", name);
             g_free(name);
@@ -2548,7 +3873,8 @@ static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMedia
             g_warn_if_fail(encoder);
 
             encoder_sink_pad = gst_element_get_static_pad(encoder, "sink");
-            g_signal_connect(encoder_sink_pad, "notify::caps", G_CALLBACK(on_caps), OWR_SESSION(media_session));
+            _owr_codec_pool_add_pad_handler(encoder, encoder_sink_pad, g_signal_connect(encoder_sink_pad,
+                "notify::caps", G_CALLBACK(on_caps), OWR_SESSION(media_session)));
             gst_object_unref(encoder_sink_pad);
 
             name = g_strdup_printf("send-input-video-encoder-capsfilter-%u", stream_id);
@@ -2558,18 +3884,52 @@ static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMedia
             g_object_set(encoder_capsfilter, "caps", caps, NULL);
             gst_caps_unref(caps);
 
-            gst_bin_add_many(GST_BIN(send_input_bin), flip, queue, encoder, NULL);
+            gst_bin_add_many(GST_BIN(send_input_bin), flip, queue, NULL);
+
+            g_object_get(payload, "degradation-preference", &degradation_preference, NULL);
+            if (degradation_preference != OWR_DEGRADATION_PREFERENCE_DISABLED) {
+                GstElement *videorate, *videoscale;
+
+                /* Drop frames before scaling so that dropped frames cost nothing */
+                name = g_strdup_printf("send-input-video-rate-%u", stream_id);
+                videorate = gst_element_factory_make("videorate", name);
+                g_free(name);
+                if (g_object_class_find_property(G_OBJECT_GET_CLASS(videorate), "drop-only"))
+                    g_object_set(videorate, "drop-only", TRUE, NULL);
+
+                name = g_strdup_printf("send-input-video-scale-%u", stream_id);
+                videoscale = gst_element_factory_make("videoscale", name);
+                g_free(name);
+
+                name = g_strdup_printf("send-input-video-degradation-capsfilter-%u", stream_id);
+                degradation_capsfilter = gst_element_factory_make("capsfilter", name);
+                g_free(name);
+
+                _owr_video_payload_setup_degradation(OWR_VIDEO_PAYLOAD(payload), videorate,
+                    degradation_capsfilter);
+                gst_bin_add_many(GST_BIN(send_input_bin), videorate, videoscale,
+                    degradation_capsfilter, NULL);
+            }
+
+            gst_bin_add(GST_BIN(send_input_bin), encoder);
 
             if (parser)
                 gst_bin_add(GST_BIN(send_input_bin), parser);
             gst_bin_add(GST_BIN(send_input_bin), encoder_capsfilter);
+
+            _owr_video_payload_setup_keyframe_control(OWR_VIDEO_PAYLOAD(payload), encoder,
+                encoder_capsfilter);
         }
     } else { /* Audio */
+        if (!_owr_codec_type_is_raw(source_codec_type))
+            add_send_decoder_elements(send_input_bin, media_type, source_codec_type, stream_id);
+
         encoder = _owr_payload_create_encoder(payload);
         parser = _owr_create_parser(_owr_payload_get_codec_type(payload));
 
         encoder_sink_pad = gst_element_get_static_pad(encoder, "sink");
-        g_signal_connect(encoder_sink_pad, "notify::caps", G_CALLBACK(on_caps), OWR_SESSION(media_session));
+        _owr_codec_pool_add_pad_handler(encoder, encoder_sink_pad, g_signal_connect(encoder_sink_pad,
+            "notify::caps", G_CALLBACK(on_caps), OWR_SESSION(media_session)));
         gst_object_unref(encoder_sink_pad);
 
         gst_bin_add(GST_BIN(send_input_bin), encoder);
@@ -2577,9 +3937,19 @@ static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMedia
             gst_bin_add(GST_BIN(send_input_bin), parser);
     }
 
-    payloader = _owr_payload_create_payload_packetizer(payload);
-    g_assert(payloader);
-    gst_bin_add_many(GST_BIN(send_input_bin), payloader, rtp_capsfilter, NULL);
+    if (!simulcast_bin) {
+        payloader = _owr_payload_create_payload_packetizer(payload);
+        g_assert(payloader);
+        _owr_payload_drop_temporal_layers(payload, payloader);
+        gst_bin_add(GST_BIN(send_input_bin), payloader);
+    }
+    gst_bin_add(GST_BIN(send_input_bin), rtp_capsfilter);
+
+    if (!encoder && payloader) {
+        encoder_sink_pad = gst_element_get_static_pad(payloader, "sink");
+        g_signal_connect(encoder_sink_pad, "notify::caps", G_CALLBACK(on_caps), OWR_SESSION(media_session));
+        gst_object_unref(encoder_sink_pad);
+    }
 
     _owr_bin_link_and_sync_elements(GST_BIN(send_input_bin), &link_ok, &sync_ok, &first, NULL);
     g_warn_if_fail(link_ok && sync_ok);
@@ -2605,7 +3975,8 @@ static void handle_new_send_payload(OwrTransportAgent *transport_agent, OwrMedia
     g_object_unref(media_source);
 }
 
-static void on_new_remote_candidate(OwrTransportAgent *transport_agent, gboolean forced, OwrSession *session)
+static void on_new_remote_candidate(OwrTransportAgent *transport_agent, gboolean forced, GSList *candidates,
+    OwrSession *session)
 {
     guint stream_id;
     NiceCandidate *nice_candidate;
@@ -2619,9 +3990,7 @@ static void on_new_remote_candidate(OwrTransportAgent *transport_agent, gboolean
 
     stream_id = _owr_session_get_stream_id(session);
 
-    item = forced ? _owr_session_get_forced_remote_candidates(session) :
-        _owr_session_get_remote_candidates(session);
-    for (; item; item = item->next) {
+    for (item = candidates; item; item = item->next) {
         nice_candidate = _owr_candidate_to_nice_candidate(OWR_CANDIDATE(item->data));
 
         if (!nice_candidate)
@@ -2642,9 +4011,9 @@ static void on_new_remote_candidate(OwrTransportAgent *transport_agent, gboolean
                 stream_id, nice_candidate->component_id, nice_candidate);
             g_warn_if_fail(forced_ok);
         } else if (nice_candidate->component_id == NICE_COMPONENT_TYPE_RTP)
-            nice_cands_rtp = g_slist_append(nice_cands_rtp, nice_candidate);
+            nice_cands_rtp = g_slist_prepend(nice_cands_rtp, nice_candidate);
         else
-            nice_cands_rtcp = g_slist_append(nice_cands_rtcp, nice_candidate);
+            nice_cands_rtcp = g_slist_prepend(nice_cands_rtcp, nice_candidate);
     }
 
     if (username && password) {
@@ -2665,6 +4034,124 @@ static void on_new_remote_candidate(OwrTransportAgent *transport_agent, gboolean
     }
 }
 
+/* Gathers again on a restarted stream and reports what was found with the
+ * new credentials */
+static void regather_stream(OwrTransportAgent *transport_agent, guint stream_id)
+{
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+    NiceCandidate *nice_candidate;
+    GSList *sessions, *walk, *nice_candidates;
+    guint component_id, n_components;
+    gboolean gathered, rtcp_mux = TRUE;
+
+    g_mutex_lock(&priv->pending_local_candidates_lock);
+    priv->regathering_stream_id = stream_id;
+    priv->regathered = FALSE;
+    g_mutex_unlock(&priv->pending_local_candidates_lock);
+
+    /* New candidates come through on_new_candidate() */
+    if (!nice_agent_gather_candidates(priv->nice_agent, stream_id)) {
+        GST_ERROR_OBJECT(transport_agent, "Failed to gather candidates on stream %u", stream_id);
+        return;
+    }
+
+    g_mutex_lock(&priv->pending_local_candidates_lock);
+    gathered = priv->regathered;
+    priv->regathering_stream_id = 0;
+    g_mutex_unlock(&priv->pending_local_candidates_lock);
+
+    /* libnice gathers a stream only once and keeps its candidates across
+     * restarts, host candidates of a new gathering are reported before
+     * nice_agent_gather_candidates() returns. Without any, report the kept
+     * candidates so the peer gets them with the new credentials. */
+    if (gathered)
+        return;
+
+    sessions = get_sessions_from_stream_id(transport_agent, stream_id);
+    if (sessions && OWR_IS_MEDIA_SESSION(sessions->data))
+        g_object_get(sessions->data, "rtcp-mux", &rtcp_mux, NULL);
+    g_slist_free_full(sessions, g_object_unref);
+
+    n_components = rtcp_mux ? 1 : 2;
+    for (component_id = NICE_COMPONENT_TYPE_RTP; component_id <= n_components; component_id++) {
+        nice_candidates = nice_agent_get_local_candidates(priv->nice_agent, stream_id, component_id);
+        for (walk = nice_candidates; walk; walk = g_slist_next(walk)) {
+            nice_candidate = walk->data;
+            g_free(nice_candidate->username);
+            nice_candidate->username = NULL;
+            g_free(nice_candidate->password);
+            nice_candidate->password = NULL;
+            queue_local_candidate(transport_agent, nice_candidate);
+        }
+        g_slist_free(nice_candidates);
+    }
+
+    on_candidate_gathering_done(priv->nice_agent, stream_id, transport_agent);
+}
+
+static void on_restart_ice(OwrTransportAgent *transport_agent, OwrSession *session)
+{
+    OwrTransportAgentPrivate *priv;
+    GSList *sessions, *walk;
+    GArray *stream_ids;
+    guint stream_id, i;
+    gboolean restarted;
+#ifndef HAVE_NICE_AGENT_RESTART_STREAM
+    GHashTableIter iter;
+    gpointer value;
+#endif
+
+    g_return_if_fail(OWR_IS_TRANSPORT_AGENT(transport_agent));
+    g_return_if_fail(OWR_IS_SESSION(session));
+    priv = transport_agent->priv;
+
+    stream_id = _owr_session_get_stream_id(session);
+    g_return_if_fail(stream_id);
+
+    stream_ids = g_array_new(FALSE, FALSE, sizeof(guint));
+
+    /* New credentials and no remote candidates, but the stream, its
+     * sockets and everything downstream of nicesrc/nicesink stay */
+#ifdef HAVE_NICE_AGENT_RESTART_STREAM
+    GST_INFO_OBJECT(transport_agent, "Restarting ICE on stream %u", stream_id);
+    g_array_append_val(stream_ids, stream_id);
+    sessions = get_sessions_from_stream_id(transport_agent, stream_id);
+    restarted = nice_agent_restart_stream(priv->nice_agent, stream_id);
+#else
+    /* Every stream is restarted, so every session has to start over */
+    GST_INFO_OBJECT(transport_agent, "libnice is too old to restart a single stream, "
+        "restarting ICE on all streams");
+    sessions = NULL;
+    AGENT_SESSIONS_LOCK(transport_agent);
+    g_hash_table_iter_init(&iter, priv->sessions);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        guint id = _owr_session_get_stream_id(OWR_SESSION(value));
+
+        sessions = g_slist_prepend(sessions, g_object_ref(value));
+        for (i = 0; i < stream_ids->len && g_array_index(stream_ids, guint, i) != id; i++);
+        if (id && i == stream_ids->len)
+            g_array_append_val(stream_ids, id);
+    }
+    AGENT_SESSIONS_UNLOCK(transport_agent);
+    restarted = nice_agent_restart(priv->nice_agent);
+#endif
+
+    if (!restarted) {
+        GST_ERROR_OBJECT(transport_agent, "Failed to restart ICE on stream %u", stream_id);
+        goto out;
+    }
+
+    for (walk = sessions; walk; walk = g_slist_next(walk))
+        _owr_session_reset_ice(OWR_SESSION(walk->data));
+
+    for (i = 0; i < stream_ids->len; i++)
+        regather_stream(transport_agent, g_array_index(stream_ids, guint, i));
+
+out:
+    g_slist_free_full(sessions, g_object_unref);
+    g_array_free(stream_ids, TRUE);
+}
+
 static void on_local_candidate_change(OwrTransportAgent *transport_agent, OwrCandidate *candidate, OwrSession *session)
 {
     guint stream_id;
@@ -2714,6 +4201,10 @@ static void signal_incoming_source(OwrMediaType type, OwrTransportAgent *transpo
 
     g_return_if_fail(source);
 
+    if (codec_type == OWR_CODEC_TYPE_OPUS)
+        _owr_media_source_set_decoder_inband_fec(source,
+            _owr_media_session_want_receive_inband_fec(media_session));
+
     args = _owr_create_schedule_table(OWR_MESSAGE_ORIGIN(media_session));
     g_hash_table_insert(args, "media_session", media_session);
     g_hash_table_insert(args, "source", source);
@@ -2736,10 +4227,9 @@ static void on_transport_bin_pad_added(GstElement *transport_bin, GstPad *new_pa
 
     new_pad_name = gst_pad_get_name(new_pad);
 
-    if (g_str_has_prefix(new_pad_name, "audio_raw_src")) {
+    if (g_str_has_prefix(new_pad_name, "audio_src_")) {
         media_type = OWR_MEDIA_TYPE_AUDIO;
-        codec_type = OWR_CODEC_TYPE_NONE;
-        sscanf(new_pad_name, "audio_raw_src_%u_%u", &session_id, &stream_id);
+        sscanf(new_pad_name, "audio_src_%u_%u_%u", &codec_type, &session_id, &stream_id);
     } else if (g_str_has_prefix(new_pad_name, "video_src_")) {
         media_type = OWR_MEDIA_TYPE_VIDEO;
         sscanf(new_pad_name, "video_src_%u_%u_%u", &codec_type, &session_id, &stream_id);
@@ -2751,6 +4241,125 @@ static void on_transport_bin_pad_added(GstElement *transport_bin, GstPad *new_pa
     g_free(new_pad_name);
 }
 
+/* The received RTP passes a tee while it is forwarded to other sessions.
+ * Returns the pad to link the receive elements to. */
+static GstPad *add_forward_tee(OwrTransportAgent *transport_agent, OwrMediaSession *media_session,
+    GstPad *new_pad, guint session_id)
+{
+    GstElement *tee;
+    GstPad *sinkpad;
+    GList *forward_sinks, *item;
+    gchar name[OWR_OBJECT_NAME_LENGTH_MAX];
+
+    g_snprintf(name, OWR_OBJECT_NAME_LENGTH_MAX, "receive-forward-tee-%u", session_id);
+    tee = gst_bin_get_by_name(GST_BIN(transport_agent->priv->transport_bin), name);
+    if (tee) {
+        /* Only the first stream received in the session is forwarded */
+        gst_object_unref(tee);
+        return gst_object_ref(new_pad);
+    }
+
+    tee = gst_element_factory_make("tee", name);
+    gst_bin_add(GST_BIN(transport_agent->priv->transport_bin), tee);
+    gst_element_sync_state_with_parent(tee);
+
+    sinkpad = gst_element_get_static_pad(tee, "sink");
+    g_warn_if_fail(gst_pad_link(new_pad, sinkpad) == GST_PAD_LINK_OK);
+    gst_object_unref(sinkpad);
+
+    forward_sinks = _owr_media_session_get_forward_sinks(media_session);
+    for (item = forward_sinks; item; item = item->next)
+        attach_forward_sink(transport_agent, tee, item->data);
+    g_list_free_full(forward_sinks, gst_object_unref);
+
+    return gst_element_get_request_pad(tee, "src_%u");
+}
+
+static GstPadProbeReturn insert_forward_tee_cb(GstPad *pad, GstPadProbeInfo *info,
+    OwrTransportAgent *transport_agent)
+{
+    OwrMediaSession *media_session;
+    GstPad *peer, *receive_pad;
+    gchar *pad_name;
+    guint session_id = 0;
+
+    OWR_UNUSED(info);
+
+    pad_name = gst_pad_get_name(pad);
+    sscanf(pad_name, "recv_rtp_src_%u_", &session_id);
+    g_free(pad_name);
+
+    media_session = OWR_MEDIA_SESSION(get_session(transport_agent, session_id));
+    peer = gst_pad_get_peer(pad);
+    if (!media_session || !peer)
+        goto out;
+
+    session_id = get_session_id(transport_agent, OWR_SESSION(media_session));
+    gst_pad_unlink(pad, peer);
+    receive_pad = add_forward_tee(transport_agent, media_session, pad, session_id);
+    g_warn_if_fail(gst_pad_link(receive_pad, peer) == GST_PAD_LINK_OK);
+    gst_object_unref(receive_pad);
+
+out:
+    if (peer)
+        gst_object_unref(peer);
+    if (media_session)
+        g_object_unref(media_session);
+
+    return GST_PAD_PROBE_REMOVE;
+}
+
+/* Puts the tee in front of the receive elements of a stream that is already
+ * being received, once no data is flowing */
+static void insert_forward_tee(OwrTransportAgent *transport_agent, OwrMediaSession *media_session)
+{
+    GstIterator *iterator;
+    GValue item = G_VALUE_INIT;
+    GstPad *pad;
+    gchar *prefix, *pad_name;
+    gboolean done = FALSE;
+
+    /* stream_id is used as the rtpbin session id */
+    prefix = g_strdup_printf("recv_rtp_src_%u_", _owr_session_get_stream_id(OWR_SESSION(media_session)));
+
+    iterator = gst_element_iterate_src_pads(transport_agent->priv->rtpbin);
+    while (!done) {
+        switch (gst_iterator_next(iterator, &item)) {
+        case GST_ITERATOR_OK:
+            pad = g_value_get_object(&item);
+            pad_name = gst_pad_get_name(pad);
+            /* Only the first stream received in the session is forwarded */
+            if (g_str_has_prefix(pad_name, prefix) && gst_pad_is_linked(pad)) {
+                gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_IDLE,
+                    (GstPadProbeCallback) insert_forward_tee_cb, transport_agent, NULL);
+                done = TRUE;
+            }
+            g_free(pad_name);
+            g_value_reset(&item);
+            break;
+        case GST_ITERATOR_RESYNC:
+            gst_iterator_resync(iterator);
+            break;
+        default:
+            done = TRUE;
+            break;
+        }
+    }
+    g_value_unset(&item);
+    gst_iterator_free(iterator);
+    g_free(prefix);
+}
+
+static gboolean media_session_has_forward_sinks(OwrMediaSession *media_session)
+{
+    GList *forward_sinks = _owr_media_session_get_forward_sinks(media_session);
+    gboolean has_forward_sinks = forward_sinks != NULL;
+
+    g_list_free_full(forward_sinks, gst_object_unref);
+
+    return has_forward_sinks;
+}
+
 static void on_rtpbin_pad_added(GstElement *rtpbin, GstPad *new_pad, OwrTransportAgent *transport_agent)
 {
     gchar *new_pad_name = NULL;
@@ -2765,6 +4374,7 @@ static void on_rtpbin_pad_added(GstElement *rtpbin, GstPad *new_pad, OwrTranspor
         OwrMediaSession *media_session = NULL;
         OwrPayload *payload = NULL;
         OwrMediaType media_type;
+        GstPad *receive_pad;
 
         sscanf(new_pad_name, "recv_rtp_src_%u_%u_%u", &session_id, &ssrc, &pt);
         g_free(new_pad_name);
@@ -2782,10 +4392,18 @@ static void on_rtpbin_pad_added(GstElement *rtpbin, GstPad *new_pad, OwrTranspor
         g_object_set_data(G_OBJECT(media_session), "ssrc", GUINT_TO_POINTER(ssrc));
         session_id = get_session_id(transport_agent, OWR_SESSION(media_session));
 
+        if (media_session_has_forward_sinks(media_session))
+            receive_pad = add_forward_tee(transport_agent, media_session, new_pad, session_id);
+        else
+            receive_pad = gst_object_ref(new_pad);
         if (media_type == OWR_MEDIA_TYPE_VIDEO)
-            setup_video_receive_elements(new_pad, session_id, stream_id, payload, transport_agent);
+            setup_video_receive_elements(receive_pad, session_id, stream_id, payload, transport_agent);
         else
-            setup_audio_receive_elements(new_pad, session_id, stream_id, payload, transport_agent);
+            setup_audio_receive_elements(receive_pad, session_id, stream_id, payload, transport_agent);
+        /* Forwarding may have been requested while setting up */
+        if (receive_pad == new_pad && media_session_has_forward_sinks(media_session))
+            insert_forward_tee(transport_agent, media_session);
+        gst_object_unref(receive_pad);
 
         /* Hook up RTCP sending if it isn't already */
         link_rtpbin_to_send_output_bin(transport_agent, session_id, stream_id, FALSE, TRUE);
@@ -2908,10 +4526,11 @@ static void setup_audio_receive_elements(GstPad *new_pad, guint32 session_id, gu
 {
     GstElement *receive_output_bin;
     gchar *pad_name = NULL;
-    GstElement *rtp_capsfilter, *rtpdepay, *parser, *decoder;
+    GstElement *rtp_capsfilter, *rtpdepay, *parser;
     GstPad *rtp_caps_sink_pad = NULL, *pad = NULL, *ghost_pad = NULL;
     gchar *element_name = NULL;
     GstCaps *rtp_caps = NULL;
+    OwrCodecType codec_type;
     gboolean link_ok = FALSE;
     gboolean sync_ok = TRUE;
 
@@ -2932,17 +4551,17 @@ static void setup_audio_receive_elements(GstPad *new_pad, guint32 session_id, gu
 
     rtpdepay = _owr_payload_create_payload_depacketizer(payload);
 
-    parser = _owr_create_parser(_owr_payload_get_codec_type(payload));
-    decoder = _owr_create_decoder(_owr_payload_get_codec_type(payload));
+    /* The remote source hands out encoded audio, it is only decoded for
+     * consumers asking for raw audio */
+    codec_type = _owr_payload_get_codec_type(payload);
+    parser = _owr_create_parser(codec_type);
 
-    gst_bin_add_many(GST_BIN(receive_output_bin), rtp_capsfilter, rtpdepay,
-        decoder, NULL);
+    gst_bin_add_many(GST_BIN(receive_output_bin), rtp_capsfilter, rtpdepay, NULL);
     link_ok = gst_element_link_many(rtp_capsfilter, rtpdepay, NULL);
     if (parser) {
         gst_bin_add(GST_BIN(receive_output_bin), parser);
-        link_ok &= gst_element_link_many(rtpdepay, parser, decoder, NULL);
-    } else
-        link_ok &= gst_element_link_many(rtpdepay, decoder, NULL);
+        link_ok &= gst_element_link_many(rtpdepay, parser, NULL);
+    }
 
     g_warn_if_fail(link_ok);
 
@@ -2955,15 +4574,14 @@ static void setup_audio_receive_elements(GstPad *new_pad, guint32 session_id, gu
     }
     ghost_pad = NULL;
 
-    sync_ok &= gst_element_sync_state_with_parent(decoder);
     if (parser)
         sync_ok &= gst_element_sync_state_with_parent(parser);
     sync_ok &= gst_element_sync_state_with_parent(rtpdepay);
     sync_ok &= gst_element_sync_state_with_parent(rtp_capsfilter);
     g_warn_if_fail(sync_ok);
 
-    pad = gst_element_get_static_pad(decoder, "src");
-    pad_name = g_strdup_printf("audio_raw_src_%u_%u", session_id, stream_id);
+    pad = gst_element_get_static_pad(parser ? parser : rtpdepay, "src");
+    pad_name = g_strdup_printf("audio_src_%u_%u_%u", codec_type, session_id, stream_id);
     add_pads_to_bin_and_transport_bin(pad, receive_output_bin,
         transport_agent->priv->transport_bin, pad_name);
     gst_object_unref(pad);
@@ -3000,29 +4618,44 @@ static GstCaps * on_rtpbin_request_pt_map(GstElement *rtpbin, guint session_id,
     return caps;
 }
 
-static GstElement * create_aux_bin(gchar *prefix, GstElement *rtx, guint session_id)
+/* Adds and links the NULL terminated list of elements in a bin named
+ * <prefix>_<session_id>, ghosting the outer pads with the names rtpbin
+ * looks up */
+static GstElement * create_aux_bin(const gchar *prefix, const gchar *pad_prefix, guint session_id,
+    GstElement *first, ...)
 {
-    GstElement *bin;
+    GstElement *bin, *element, *last;
     GstPad *pad;
     gchar *tmp;
+    va_list args;
+    gboolean link_ok = TRUE;
 
     tmp = g_strdup_printf("%s_%u", prefix, session_id);
     bin = gst_bin_new(tmp);
-    GST_DEBUG("Retransmission auxiliary bin created: %s", tmp);
+    GST_DEBUG("Auxiliary bin created: %s", tmp);
     g_free(tmp);
 
-    gst_bin_add(GST_BIN(bin), rtx);
+    gst_bin_add(GST_BIN(bin), first);
+    last = first;
+    va_start(args, first);
+    while ((element = va_arg(args, GstElement *))) {
+        gst_bin_add(GST_BIN(bin), element);
+        link_ok &= gst_element_link(last, element);
+        last = element;
+    }
+    va_end(args);
+    g_warn_if_fail(link_ok);
 
-    tmp = g_strdup_printf("src_%u", session_id);
-    pad = gst_element_get_static_pad(rtx, "src");
+    tmp = g_strdup_printf("%ssrc_%u", pad_prefix, session_id);
+    pad = gst_element_get_static_pad(last, "src");
 
     gst_element_add_pad(bin, gst_ghost_pad_new(tmp, pad));
 
     gst_object_unref(pad);
     g_free(tmp);
 
-    tmp = g_strdup_printf("sink_%u", session_id);
-    pad = gst_element_get_static_pad(rtx, "sink");
+    tmp = g_strdup_printf("%ssink_%u", pad_prefix, session_id);
+    pad = gst_element_get_static_pad(first, "sink");
 
     gst_element_add_pad(bin, gst_ghost_pad_new(tmp, pad));
 
@@ -3032,13 +4665,25 @@ static GstElement * create_aux_bin(gchar *prefix, GstElement *rtx, guint session
     return bin;
 }
 
+static void on_round_trip_time_for_rtx_history(OwrMediaSession *media_session, GParamSpec *pspec,
+    GstElement *rtxsend)
+{
+    guint round_trip_time = 0;
+
+    OWR_UNUSED(pspec);
+
+    g_object_get(media_session, "round-trip-time", &round_trip_time, NULL);
+    g_object_set(rtxsend, "max-size-time",
+        CLAMP(3 * round_trip_time, RTX_HISTORY_MIN_TIME, RTX_HISTORY_MAX_TIME), NULL);
+}
+
 static GstElement * on_rtpbin_request_aux_sender(G_GNUC_UNUSED GstElement *rtpbin, guint session_id, OwrTransportAgent *transport_agent)
 {
     OwrMediaSession *media_session;
     OwrPayload *payload;
     GstElement *rtxsend;
     GstStructure *pt_map;
-    gint rtx_pt;
+    gint rtx_pt, red_pt;
     guint pt, rtx_time;
     gchar *tmp;
 
@@ -3046,12 +4691,14 @@ static GstElement * on_rtpbin_request_aux_sender(G_GNUC_UNUSED GstElement *rtpbi
     g_return_val_if_fail(media_session, NULL);
 
     payload = _owr_media_session_get_send_payload(media_session);
-    g_object_unref(media_session);
-    if (!payload)
+    if (!payload) {
+        g_object_unref(media_session);
         goto no_retransmission;
+    }
 
     g_object_get(payload, "rtx-payload-type", &rtx_pt, NULL);
     if (rtx_pt < 0) {
+        g_object_unref(media_session);
         g_object_unref(payload);
         goto no_retransmission;
     }
@@ -3059,8 +4706,11 @@ static GstElement * on_rtpbin_request_aux_sender(G_GNUC_UNUSED GstElement *rtpbi
     rtxsend = gst_element_factory_make("rtprtxsend", NULL);
     g_return_val_if_fail(rtxsend, NULL);
 
-    /* Create and set the pt map */
-    g_object_get(payload, "payload-type", &pt, NULL);
+    /* Create and set the pt map, with RED everything leaves the session as
+     * RED packets */
+    g_object_get(payload, "payload-type", &pt, "red-payload-type", &red_pt, NULL);
+    if (red_pt >= 0)
+        pt = red_pt;
 
     pt_map = gst_structure_new_empty("application/x-rtp-pt-map");
     tmp = g_strdup_printf("%u", pt);
@@ -3073,9 +4723,17 @@ static GstElement * on_rtpbin_request_aux_sender(G_GNUC_UNUSED GstElement *rtpbi
     g_object_get(payload, "rtx-time", &rtx_time, NULL);
     if (rtx_time)
         g_object_set(rtxsend, "max-size-time", rtx_time, NULL);
+    else {
+        /* Keep packets by time rather than count, long enough for a NACK to
+         * make it back */
+        g_object_set(rtxsend, "max-size-packets", 0, "max-size-time", RTX_HISTORY_DEFAULT_TIME, NULL);
+        g_signal_connect_object(media_session, "notify::round-trip-time",
+            G_CALLBACK(on_round_trip_time_for_rtx_history), rtxsend, 0);
+    }
 
+    g_object_unref(media_session);
     g_object_unref(payload);
-    return create_aux_bin("rtprtxsend", rtxsend, session_id);
+    return create_aux_bin("rtprtxsend", "", session_id, rtxsend, NULL);
 
 no_retransmission:
     GST_DEBUG("Retransmission support disabled on sending side");
@@ -3085,13 +4743,15 @@ no_retransmission:
 static GstElement * on_rtpbin_request_aux_receiver(G_GNUC_UNUSED GstElement *rtpbin, guint session_id, OwrTransportAgent *transport_agent)
 {
     OwrMediaSession *media_session;
-    GstElement *rtxrecv = NULL;
+    GstElement *rtxrecv = NULL, *reddec = NULL;
     GstStructure *pt_map;
+    gint red_pt;
 
     media_session = OWR_MEDIA_SESSION(get_session_unlocked(transport_agent, session_id));
     g_return_val_if_fail(media_session, NULL);
 
     pt_map = _owr_media_session_get_receive_rtx_pt_map(media_session);
+    red_pt = _owr_media_session_get_receive_red_payload_type(media_session);
     g_object_unref(media_session);
 
     if ((transport_agent->priv->bundle_policy == OWR_BUNDLE_POLICY_TYPE_MAX_BUNDLE) && !pt_map) {
@@ -3108,23 +4768,117 @@ static GstElement * on_rtpbin_request_aux_receiver(G_GNUC_UNUSED GstElement *rtp
         }
     }
 
-    if (!pt_map)
-        goto no_retransmission;
+    if (pt_map) {
+        rtxrecv = gst_element_factory_make("rtprtxreceive", NULL);
+        g_return_val_if_fail(rtxrecv, NULL);
 
-    rtxrecv = gst_element_factory_make("rtprtxreceive", NULL);
-    g_return_val_if_fail(rtxrecv, NULL);
+        g_object_set(rtxrecv, "payload-type-map", pt_map, NULL);
+        gst_structure_free(pt_map);
+        /* FIXME: how do we get rtx-time? */
+    } else
+        GST_DEBUG("Retransmission support disabled on receiving side");
+
+    /* RED is unwrapped before the storage so that the ULPFEC decoder sees
+     * the media and FEC packets, retransmissions are restored first as they
+     * carry RED packets too */
+    if (red_pt >= 0) {
+        reddec = gst_element_factory_make("rtpreddec", NULL);
+        if (reddec)
+            g_object_set(reddec, "pt", red_pt, NULL);
+        else
+            GST_WARNING("rtpreddec not available, cannot receive RED");
+    }
 
-    g_object_set(rtxrecv, "payload-type-map", pt_map, NULL);
-    gst_structure_free(pt_map);
-    /* FIXME: how do we get rtx-time? */
+    if (rtxrecv)
+        return create_aux_bin("rtprtxrecv", "", session_id, rtxrecv, reddec, NULL);
+    if (reddec)
+        return create_aux_bin("rtpreddec", "", session_id, reddec, NULL);
+    return NULL;
+}
 
-    return create_aux_bin("rtprtxrecv", rtxrecv, session_id);
+static GstElement * on_rtpbin_request_fec_encoder(G_GNUC_UNUSED GstElement *rtpbin, guint session_id, OwrTransportAgent *transport_agent)
+{
+    OwrMediaSession *media_session;
+    OwrPayload *payload;
+    GstElement *fecenc = NULL, *redenc = NULL;
+    gint red_pt, ulpfec_pt;
 
-no_retransmission:
-    GST_DEBUG("Retransmission support disabled on receiving side");
+    media_session = OWR_MEDIA_SESSION(get_session_unlocked(transport_agent, session_id));
+    g_return_val_if_fail(media_session, NULL);
+
+    payload = _owr_media_session_get_send_payload(media_session);
+    g_object_unref(media_session);
+    if (!payload)
+        return NULL;
+
+    g_object_get(payload, "red-payload-type", &red_pt, "ulpfec-payload-type", &ulpfec_pt, NULL);
+
+    if (ulpfec_pt >= 0) {
+        fecenc = gst_element_factory_make("rtpulpfecenc", NULL);
+        if (fecenc) {
+            g_object_set(fecenc, "pt", ulpfec_pt, NULL);
+            g_object_bind_property(payload, "fec-percentage", fecenc, "percentage",
+                G_BINDING_SYNC_CREATE);
+        } else
+            GST_WARNING("rtpulpfecenc not available, sending without ULPFEC");
+    }
+
+    /* Without redundant blocks RED only carries the media and FEC packets
+     * in one payload type */
+    if (red_pt >= 0) {
+        redenc = gst_element_factory_make("rtpredenc", NULL);
+        if (redenc)
+            g_object_set(redenc, "pt", red_pt, "allow-no-red-blocks", TRUE, NULL);
+        else
+            GST_WARNING("rtpredenc not available, sending without RED");
+    }
+    g_object_unref(payload);
+
+    if (fecenc)
+        return create_aux_bin("rtpfecenc", "rtp_", session_id, fecenc, redenc, NULL);
+    if (redenc)
+        return create_aux_bin("rtpfecenc", "rtp_", session_id, redenc, NULL);
+
+    GST_DEBUG("FEC disabled on sending side");
     return NULL;
 }
 
+static GstElement * on_rtpbin_request_fec_decoder(GstElement *rtpbin, guint session_id, OwrTransportAgent *transport_agent)
+{
+    OwrMediaSession *media_session;
+    GstElement *fecdec;
+    GObject *storage = NULL;
+    guint64 storage_time = 0;
+    gint ulpfec_pt;
+
+    media_session = OWR_MEDIA_SESSION(get_session(transport_agent, session_id));
+    g_return_val_if_fail(media_session, NULL);
+
+    ulpfec_pt = _owr_media_session_get_receive_ulpfec_payload_type(media_session);
+    g_object_unref(media_session);
+
+    if (ulpfec_pt < 0) {
+        GST_DEBUG("FEC disabled on receiving side");
+        return NULL;
+    }
+
+    fecdec = gst_element_factory_make("rtpulpfecdec", NULL);
+    g_return_val_if_fail(fecdec, NULL);
+
+    /* The storage keeps nothing by default, the decoder recovers from the
+     * packets kept there */
+    g_signal_emit_by_name(rtpbin, "get-internal-storage", session_id, &storage);
+    g_return_val_if_fail(storage, fecdec);
+    g_object_get(storage, "size-time", &storage_time, NULL);
+    if (!storage_time)
+        g_object_set(storage, "size-time", (guint64) FEC_STORAGE_TIME, NULL);
+
+    g_object_set(fecdec, "pt", ulpfec_pt, "storage", storage, NULL);
+    g_object_unref(storage);
+
+    return fecdec;
+}
+
 static void print_rtcp_type(GObject *session, guint stream_id,
     GstRTCPType packet_type)
 {
@@ -3319,12 +5073,51 @@ static gboolean on_sending_rtcp(GObject *session, GstBuffer *buffer, gboolean ea
     media_session = OWR_MEDIA_SESSION(g_object_get_data(session, "session"));
     g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), do_not_suppress);
 
-    g_object_get(session, "sources", &sources, NULL);
-    source = g_value_get_object(g_value_array_get_nth(sources, 0));
-    prepare_rtcp_stats(media_session, source);
-    g_value_array_free(sources);
+    g_object_get(session, "sources", &sources, NULL);
+    source = g_value_get_object(g_value_array_get_nth(sources, 0));
+    prepare_rtcp_stats(media_session, source);
+    g_value_array_free(sources);
+
+    return do_not_suppress;
+}
+
+static guint get_stats_uint(GHashTable *stats_hash, const gchar *key)
+{
+    GValue *value = g_hash_table_lookup(stats_hash, key);
+
+    return value && G_VALUE_HOLDS_UINT(value) ? g_value_get_uint(value) : 0;
+}
+
+/* The report block about our stream carries the loss that drives the FEC
+ * overhead of the send payload, and the round trip time that drives the
+ * retransmission timing */
+static void handle_report_block(OwrMediaSession *media_session, GHashTable *stats_hash)
+{
+    OwrPayload *payload;
+    GValue *value;
+    guint send_ssrc = 0, round_trip_time;
+
+    value = g_hash_table_lookup(stats_hash, "have-rb");
+    if (!value || !G_VALUE_HOLDS_BOOLEAN(value) || !g_value_get_boolean(value))
+        return;
+
+    g_object_get(media_session, "send-ssrc", &send_ssrc, NULL);
+    if (send_ssrc && get_stats_uint(stats_hash, "rb-ssrc") != send_ssrc)
+        return;
 
-    return do_not_suppress;
+    payload = _owr_media_session_get_send_payload(media_session);
+    if (payload) {
+        /* fraction lost is in units of 1/256 */
+        _owr_payload_update_packet_loss(payload,
+            get_stats_uint(stats_hash, "rb-fractionlost") * 100 / 256);
+        g_object_unref(payload);
+    }
+
+    /* rtpsource computes it from LSR/DLSR when the report arrives, in
+     * units of 1/65536 s */
+    round_trip_time = (guint) (((guint64) get_stats_uint(stats_hash, "rb-round-trip") * 1000) >> 16);
+    if (round_trip_time && round_trip_time < MAX_ROUND_TRIP_TIME)
+        _owr_media_session_update_round_trip_time(media_session, round_trip_time);
 }
 
 static void on_receiving_rtcp(GObject *session, GstBuffer *buffer,
@@ -3376,12 +5169,77 @@ static gboolean emit_stats_signal(GHashTable *stats_hash)
     media_session = g_value_dup_object(value);
     g_return_val_if_fail(OWR_IS_MEDIA_SESSION(media_session), FALSE);
     g_hash_table_remove(stats_hash, "media_session");
+    handle_report_block(media_session, stats_hash);
     g_signal_emit_by_name(media_session, "on-new-stats", stats_hash, NULL);
     g_object_unref(media_session);
     g_hash_table_unref(stats_hash);
     return FALSE;
 }
 
+/* The seqnums a jitterbuffer has given up on, pushing a lost event or
+ * later packets instead, and the retransmissions that arrived for them
+ * afterwards */
+typedef struct {
+    GMutex mutex;
+    guint8 given_up[G_MAXUINT16 / 8 + 1];
+    gboolean have_next_seqnum;
+    guint16 next_seqnum;
+    guint64 late;
+} LateRetransmissions;
+
+static guint64 get_late_retransmissions(GstElement *jitterbuffer)
+{
+    LateRetransmissions *late_retransmissions;
+    guint64 late = 0;
+
+    late_retransmissions = g_object_get_data(G_OBJECT(jitterbuffer), LATE_RETRANSMISSIONS_KEY);
+    if (late_retransmissions) {
+        g_mutex_lock(&late_retransmissions->mutex);
+        late = late_retransmissions->late;
+        g_mutex_unlock(&late_retransmissions->mutex);
+    }
+
+    return late;
+}
+
+/* Retransmissions are only worth their bandwidth when they arrive before
+ * the jitterbuffer gives up on the packet */
+static void add_retransmission_stats(GHashTable *stats_hash, OwrMediaSession *media_session,
+    GObject *rtp_source)
+{
+    GWeakRef *ref;
+    GstElement *jitterbuffer;
+    GstStructure *stats;
+    GValue *value;
+    guint64 requested = 0, useful = 0, late;
+    guint round_trip_time = 0;
+
+    g_object_get(media_session, "round-trip-time", &round_trip_time, NULL);
+    value = _owr_value_table_add(stats_hash, "round-trip-time", G_TYPE_UINT);
+    g_value_set_uint(value, round_trip_time);
+
+    ref = g_object_get_data(rtp_source, JITTERBUFFER_KEY);
+    jitterbuffer = ref ? g_weak_ref_get(ref) : NULL;
+    if (!jitterbuffer)
+        return;
+
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(jitterbuffer), "stats")) {
+        g_object_get(jitterbuffer, "stats", &stats, NULL);
+        gst_structure_get_uint64(stats, "rtx-count", &requested);
+        gst_structure_get_uint64(stats, "rtx-success-count", &useful);
+        gst_structure_free(stats);
+    }
+    late = get_late_retransmissions(jitterbuffer);
+    gst_object_unref(jitterbuffer);
+
+    value = _owr_value_table_add(stats_hash, "rtx-requested", G_TYPE_UINT64);
+    g_value_set_uint64(value, requested);
+    value = _owr_value_table_add(stats_hash, "rtx-useful", G_TYPE_UINT64);
+    g_value_set_uint64(value, useful);
+    value = _owr_value_table_add(stats_hash, "rtx-too-late", G_TYPE_UINT64);
+    g_value_set_uint64(value, late);
+}
+
 static void prepare_rtcp_stats(OwrMediaSession *media_session, GObject *rtp_source)
 {
     GstStructure *stats;
@@ -3396,6 +5254,8 @@ static void prepare_rtcp_stats(OwrMediaSession *media_session, GObject *rtp_sour
         (GstStructureForeachFunc)update_stats_hash_table, stats_hash);
     gst_structure_free(stats);
 
+    add_retransmission_stats(stats_hash, media_session, rtp_source);
+
     value = _owr_value_table_add(stats_hash, "media_session", OWR_TYPE_MEDIA_SESSION);
     g_value_set_object(value, media_session);
 
@@ -3403,6 +5263,220 @@ static void prepare_rtcp_stats(OwrMediaSession *media_session, GObject *rtp_sour
 
 }
 
+static void weak_ref_free(GWeakRef *ref)
+{
+    g_weak_ref_clear(ref);
+    g_free(ref);
+}
+
+static void jitter_buffer_state_free(JitterBufferState *state)
+{
+    g_ptr_array_free(state->jitterbuffers, TRUE);
+    g_free(state);
+}
+
+/* Called with jitter_buffer_lock held */
+static void apply_jitter_buffer_latency(OwrMediaSession *media_session, JitterBufferState *state)
+{
+    GstElement *jitterbuffer;
+    guint i, latency = state->latency;
+
+    if (!latency)
+        g_object_get(media_session, "jitter-buffer-latency", &latency, NULL);
+
+    for (i = state->jitterbuffers->len; i > 0; i--) {
+        jitterbuffer = g_weak_ref_get(g_ptr_array_index(state->jitterbuffers, i - 1));
+        if (!jitterbuffer) {
+            g_ptr_array_remove_index_fast(state->jitterbuffers, i - 1);
+            continue;
+        }
+        g_object_set(jitterbuffer, "latency", latency, NULL);
+        gst_object_unref(jitterbuffer);
+    }
+}
+
+static void on_jitter_buffer_latency(OwrMediaSession *media_session, GParamSpec *pspec,
+    OwrTransportAgent *transport_agent)
+{
+    JitterBufferState *state;
+
+    OWR_UNUSED(pspec);
+
+    g_mutex_lock(&transport_agent->priv->jitter_buffer_lock);
+    state = g_object_get_data(G_OBJECT(media_session), JITTER_BUFFER_STATE_KEY);
+    if (state && !state->latency)
+        apply_jitter_buffer_latency(media_session, state);
+    g_mutex_unlock(&transport_agent->priv->jitter_buffer_lock);
+}
+
+/* Called with jitter_buffer_lock held */
+static JitterBufferState * get_jitter_buffer_state(OwrTransportAgent *transport_agent,
+    OwrMediaSession *media_session)
+{
+    JitterBufferState *state;
+
+    state = g_object_get_data(G_OBJECT(media_session), JITTER_BUFFER_STATE_KEY);
+    if (state)
+        return state;
+
+    state = g_new0(JitterBufferState, 1);
+    state->jitterbuffers = g_ptr_array_new_with_free_func((GDestroyNotify) weak_ref_free);
+    g_object_set_data_full(G_OBJECT(media_session), JITTER_BUFFER_STATE_KEY, state,
+        (GDestroyNotify) jitter_buffer_state_free);
+    g_signal_connect_object(media_session, "notify::jitter-buffer-latency",
+        G_CALLBACK(on_jitter_buffer_latency), transport_agent, 0);
+
+    return state;
+}
+
+static GList * get_media_sessions(OwrTransportAgent *transport_agent)
+{
+    GHashTableIter iter;
+    OwrSession *session;
+    GList *media_sessions = NULL;
+
+    AGENT_SESSIONS_LOCK(transport_agent);
+    g_hash_table_iter_init(&iter, transport_agent->priv->sessions);
+    while (g_hash_table_iter_next(&iter, NULL, (gpointer) &session)) {
+        if (OWR_IS_MEDIA_SESSION(session))
+            media_sessions = g_list_prepend(media_sessions, g_object_ref(session));
+    }
+    AGENT_SESSIONS_UNLOCK(transport_agent);
+
+    return media_sessions;
+}
+
+/* Puts the jitterbuffers back to the configured jitter-buffer-latency of
+ * their media sessions */
+static void reset_jitter_buffer_latency(OwrTransportAgent *transport_agent)
+{
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+    JitterBufferState *state;
+    GList *media_sessions, *item;
+
+    media_sessions = get_media_sessions(transport_agent);
+
+    g_mutex_lock(&priv->jitter_buffer_lock);
+    for (item = media_sessions; item; item = item->next) {
+        state = g_object_get_data(G_OBJECT(item->data), JITTER_BUFFER_STATE_KEY);
+        if (!state)
+            continue;
+        state->target = 0;
+        state->target_time = 0;
+        state->latency = 0;
+        apply_jitter_buffer_latency(item->data, state);
+    }
+    g_mutex_unlock(&priv->jitter_buffer_lock);
+
+    g_list_free_full(media_sessions, g_object_unref);
+}
+
+static gboolean update_jitter_buffer_latency(GHashTable *args)
+{
+    OwrTransportAgent *transport_agent;
+    OwrTransportAgentPrivate *priv;
+    OwrMediaSession *media_session;
+    JitterBufferState *state;
+    GList *media_sessions, *item;
+    guint latency, current, new_latency;
+    gint64 now;
+
+    transport_agent = g_hash_table_lookup(args, "transport_agent");
+    media_session = g_hash_table_lookup(args, "session");
+    priv = transport_agent->priv;
+
+    if (!priv->adaptive_jitter_buffer)
+        goto out;
+
+    media_sessions = get_media_sessions(transport_agent);
+    now = g_get_monotonic_time();
+
+    g_mutex_lock(&priv->jitter_buffer_lock);
+    state = get_jitter_buffer_state(transport_agent, media_session);
+    state->target = GPOINTER_TO_UINT(g_hash_table_lookup(args, "target"));
+    state->target_time = now;
+
+    /* A sender that left or went quiet no longer holds the latency up */
+    latency = priv->min_jitter_buffer_latency;
+    for (item = media_sessions; item; item = item->next) {
+        state = g_object_get_data(G_OBJECT(item->data), JITTER_BUFFER_STATE_KEY);
+        if (state && state->target_time && now - state->target_time < JITTER_BUFFER_TARGET_TIMEOUT)
+            latency = MAX(latency, state->target);
+    }
+    latency = MIN(latency, priv->max_jitter_buffer_latency);
+
+    /* Growing is immediate to stop late packets from being dropped,
+     * shrinking is gradual so that a calm moment does not leave the next
+     * burst without room */
+    for (item = media_sessions; item; item = item->next) {
+        state = g_object_get_data(G_OBJECT(item->data), JITTER_BUFFER_STATE_KEY);
+        if (!state)
+            continue;
+
+        current = state->latency;
+        if (!current)
+            g_object_get(item->data, "jitter-buffer-latency", &current, NULL);
+        if (latency >= current)
+            new_latency = latency;
+        else
+            new_latency = current - MIN(JITTER_BUFFER_DECREASE_STEP, current - latency);
+
+        if (new_latency != state->latency) {
+            GST_DEBUG_OBJECT(transport_agent, "Jitter buffer latency %u -> %u ms", current,
+                new_latency);
+            state->latency = new_latency;
+            apply_jitter_buffer_latency(item->data, state);
+        }
+    }
+    g_mutex_unlock(&priv->jitter_buffer_lock);
+
+    g_list_free_full(media_sessions, g_object_unref);
+
+out:
+    g_object_unref(media_session);
+    g_object_unref(transport_agent);
+    g_hash_table_destroy(args);
+
+    return FALSE;
+}
+
+/* The interarrival jitter of the source is already smoothed by the RTP
+ * session (RFC 3550 section 6.4.1) */
+static void estimate_jitter_buffer_latency(OwrTransportAgent *transport_agent,
+    OwrMediaSession *media_session, GObject *rtp_source)
+{
+    GstStructure *stats;
+    GHashTable *args;
+    gboolean internal = TRUE, is_sender = FALSE;
+    guint jitter = 0, round_trip_time = 0, target;
+    gint clock_rate = 0;
+
+    g_object_get(rtp_source, "stats", &stats, NULL);
+    gst_structure_get_boolean(stats, "internal", &internal);
+    gst_structure_get_boolean(stats, "is-sender", &is_sender);
+    gst_structure_get_uint(stats, "jitter", &jitter);
+    gst_structure_get_int(stats, "clock-rate", &clock_rate);
+    gst_structure_free(stats);
+
+    if (internal || !is_sender || clock_rate <= 0)
+        return;
+
+    target = (guint) ((guint64) jitter * 1000 / clock_rate) * JITTER_BUFFER_JITTER_FACTOR
+        + JITTER_BUFFER_MARGIN;
+
+    /* Leave a retransmission the time to arrive */
+    if (_owr_media_session_want_receive_rtx(media_session)) {
+        g_object_get(media_session, "round-trip-time", &round_trip_time, NULL);
+        target += round_trip_time;
+    }
+
+    args = _owr_create_schedule_table(OWR_MESSAGE_ORIGIN(transport_agent));
+    g_hash_table_insert(args, "transport_agent", g_object_ref(transport_agent));
+    g_hash_table_insert(args, "session", g_object_ref(media_session));
+    g_hash_table_insert(args, "target", GUINT_TO_POINTER(target));
+    _owr_schedule_with_hash_table((GSourceFunc)update_jitter_buffer_latency, args);
+}
+
 static void on_ssrc_active(GstElement *rtpbin, guint session_id, guint ssrc,
     OwrTransportAgent *transport_agent)
 {
@@ -3417,6 +5491,8 @@ static void on_ssrc_active(GstElement *rtpbin, guint session_id, guint ssrc,
     g_signal_emit_by_name(rtpbin, "get-internal-session", session_id, &rtp_session);
     g_signal_emit_by_name(rtp_session, "get-source-by-ssrc", ssrc, &rtp_source);
     prepare_rtcp_stats(media_session, rtp_source);
+    if (transport_agent->priv->adaptive_jitter_buffer)
+        estimate_jitter_buffer_latency(transport_agent, media_session, rtp_source);
     g_object_unref(rtp_source);
     g_object_unref(rtp_session);
     g_object_unref(media_session);
@@ -3448,18 +5524,208 @@ static guint on_bundled_ssrc(GstElement *rtpbin, guint ssrc, OwrTransportAgent *
     return found_session_id;
 }
 
-static void on_new_jitterbuffer(G_GNUC_UNUSED GstElement *rtpbin, GstElement *jitterbuffer, guint session_id, G_GNUC_UNUSED guint ssrc, OwrTransportAgent *transport_agent)
+/* Requests are not repeated before an answer could be back, and stop once
+ * the answer would arrive after the packet is due */
+static void tune_retransmission(OwrMediaSession *media_session, GParamSpec *pspec,
+    GstElement *jitterbuffer)
+{
+    guint round_trip_time = 0, latency = 0;
+
+    OWR_UNUSED(pspec);
+
+    g_object_get(media_session, "round-trip-time", &round_trip_time, NULL);
+    g_object_get(jitterbuffer, "latency", &latency, NULL);
+    if (!round_trip_time)
+        return;
+
+    if (latency <= round_trip_time) {
+        GST_DEBUG_OBJECT(jitterbuffer, "Round trip time %u ms exceeds the latency %u ms, "
+            "not requesting retransmissions", round_trip_time, latency);
+        g_object_set(jitterbuffer, "do-retransmission", FALSE, NULL);
+        return;
+    }
+
+    g_object_set(jitterbuffer, "do-retransmission", TRUE,
+        "rtx-min-retry-timeout", (gint) round_trip_time,
+        "rtx-retry-period", (gint) (latency - round_trip_time), NULL);
+}
+
+static void late_retransmissions_free(LateRetransmissions *late_retransmissions)
+{
+    g_mutex_clear(&late_retransmissions->mutex);
+    g_free(late_retransmissions);
+}
+
+static gboolean get_buffer_seqnum(GstBuffer *buffer, guint16 *seqnum)
+{
+    GstRTPBuffer rtp_buffer = GST_RTP_BUFFER_INIT;
+
+    if (!gst_rtp_buffer_map(buffer, GST_MAP_READ, &rtp_buffer))
+        return FALSE;
+    *seqnum = gst_rtp_buffer_get_seq(&rtp_buffer);
+    gst_rtp_buffer_unmap(&rtp_buffer);
+
+    return TRUE;
+}
+
+/* Must be called with the mutex held. Everything skipped since the last
+ * output was given up on, and so is @seqnum when it is reported lost. */
+static void jitterbuffer_output(LateRetransmissions *late_retransmissions, guint16 seqnum,
+    gboolean lost)
+{
+    guint16 skipped;
+
+    if (late_retransmissions->have_next_seqnum
+        && (guint16) (seqnum - late_retransmissions->next_seqnum) < MAX_GIVEN_UP_GAP) {
+        for (skipped = late_retransmissions->next_seqnum; skipped != seqnum; skipped++)
+            late_retransmissions->given_up[skipped >> 3] |= GIVEN_UP_BIT(skipped);
+    }
+
+    if (lost)
+        late_retransmissions->given_up[seqnum >> 3] |= GIVEN_UP_BIT(seqnum);
+    else
+        late_retransmissions->given_up[seqnum >> 3] &= ~GIVEN_UP_BIT(seqnum);
+    late_retransmissions->next_seqnum = seqnum + 1;
+    late_retransmissions->have_next_seqnum = TRUE;
+}
+
+static GstPadProbeReturn probe_jitterbuffer_output(GstPad *pad, GstPadProbeInfo *info,
+    LateRetransmissions *late_retransmissions)
+{
+    const GstStructure *structure;
+    guint lost_seqnum;
+    guint16 seqnum;
+
+    OWR_UNUSED(pad);
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+        if (!get_buffer_seqnum(GST_PAD_PROBE_INFO_BUFFER(info), &seqnum))
+            return GST_PAD_PROBE_OK;
+        g_mutex_lock(&late_retransmissions->mutex);
+        jitterbuffer_output(late_retransmissions, seqnum, FALSE);
+        g_mutex_unlock(&late_retransmissions->mutex);
+    } else {
+        structure = gst_event_get_structure(GST_PAD_PROBE_INFO_EVENT(info));
+        if (!structure || !gst_structure_has_name(structure, "GstRTPPacketLost")
+            || !gst_structure_get_uint(structure, "seqnum", &lost_seqnum))
+            return GST_PAD_PROBE_OK;
+        g_mutex_lock(&late_retransmissions->mutex);
+        jitterbuffer_output(late_retransmissions, (guint16) lost_seqnum, TRUE);
+        g_mutex_unlock(&late_retransmissions->mutex);
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+static void check_retransmission(LateRetransmissions *late_retransmissions, GstBuffer *buffer)
+{
+    guint16 seqnum;
+
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_RTP_BUFFER_FLAG_RETRANSMISSION)
+        || !get_buffer_seqnum(buffer, &seqnum))
+        return;
+
+    g_mutex_lock(&late_retransmissions->mutex);
+    if (late_retransmissions->given_up[seqnum >> 3] & GIVEN_UP_BIT(seqnum)) {
+        late_retransmissions->given_up[seqnum >> 3] &= ~GIVEN_UP_BIT(seqnum);
+        late_retransmissions->late++;
+    }
+    g_mutex_unlock(&late_retransmissions->mutex);
+}
+
+static gboolean check_retransmission_in_list(GstBuffer **buffer, guint idx,
+    LateRetransmissions *late_retransmissions)
+{
+    OWR_UNUSED(idx);
+
+    check_retransmission(late_retransmissions, *buffer);
+
+    return TRUE;
+}
+
+static GstPadProbeReturn probe_jitterbuffer_input(GstPad *pad, GstPadProbeInfo *info,
+    LateRetransmissions *late_retransmissions)
+{
+    OWR_UNUSED(pad);
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER)
+        check_retransmission(late_retransmissions, GST_PAD_PROBE_INFO_BUFFER(info));
+    else
+        gst_buffer_list_foreach(GST_PAD_PROBE_INFO_BUFFER_LIST(info),
+            (GstBufferListFunc) check_retransmission_in_list, late_retransmissions);
+
+    return GST_PAD_PROBE_OK;
+}
+
+/* Lets the stats of the source find the jitterbuffer, whose own stats
+ * count the requested and useful retransmissions. The late ones, which
+ * arrive after the jitterbuffer gave up on their packet, are counted
+ * here. */
+static void track_retransmissions(OwrTransportAgent *transport_agent, GstElement *jitterbuffer,
+    guint session_id, guint ssrc)
+{
+    GObject *rtp_session = NULL, *rtp_source = NULL;
+    LateRetransmissions *late_retransmissions;
+    GWeakRef *ref;
+    GstPad *pad;
+
+    late_retransmissions = g_new0(LateRetransmissions, 1);
+    g_mutex_init(&late_retransmissions->mutex);
+    g_object_set_data_full(G_OBJECT(jitterbuffer), LATE_RETRANSMISSIONS_KEY, late_retransmissions,
+        (GDestroyNotify) late_retransmissions_free);
+
+    pad = gst_element_get_static_pad(jitterbuffer, "src");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+        (GstPadProbeCallback) probe_jitterbuffer_output, late_retransmissions, NULL);
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(jitterbuffer, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+        (GstPadProbeCallback) probe_jitterbuffer_input, late_retransmissions, NULL);
+    gst_object_unref(pad);
+
+    g_signal_emit_by_name(transport_agent->priv->rtpbin, "get-internal-session", session_id, &rtp_session);
+    if (!rtp_session)
+        return;
+    g_signal_emit_by_name(rtp_session, "get-source-by-ssrc", ssrc, &rtp_source);
+    if (rtp_source) {
+        ref = g_new0(GWeakRef, 1);
+        g_weak_ref_init(ref, jitterbuffer);
+        g_object_set_data_full(rtp_source, JITTERBUFFER_KEY, ref, (GDestroyNotify) weak_ref_free);
+        g_object_unref(rtp_source);
+    }
+    g_object_unref(rtp_session);
+}
+
+static void on_new_jitterbuffer(G_GNUC_UNUSED GstElement *rtpbin, GstElement *jitterbuffer, guint session_id, guint ssrc, OwrTransportAgent *transport_agent)
 {
     OwrMediaSession *media_session;
+    JitterBufferState *state;
+    GWeakRef *ref;
 
     g_return_if_fail(OWR_IS_TRANSPORT_AGENT(transport_agent));
     media_session = OWR_MEDIA_SESSION(get_session(transport_agent, session_id));
 
-    if (_owr_media_session_want_receive_rtx(media_session))
+    if (_owr_media_session_want_receive_rtx(media_session)) {
         g_object_set(jitterbuffer, "do-retransmission", TRUE, NULL);
 
-    g_object_bind_property(media_session, "jitter-buffer-latency", jitterbuffer,
-        "latency", G_BINDING_SYNC_CREATE);
+        if (g_object_class_find_property(G_OBJECT_GET_CLASS(jitterbuffer), "rtx-min-retry-timeout")) {
+            g_signal_connect_object(media_session, "notify::round-trip-time",
+                G_CALLBACK(tune_retransmission), jitterbuffer, 0);
+            g_signal_connect_object(jitterbuffer, "notify::latency",
+                G_CALLBACK(tune_retransmission), media_session, G_CONNECT_SWAPPED);
+        }
+        track_retransmissions(transport_agent, jitterbuffer, session_id, ssrc);
+    }
+
+    /* The adaptive latency goes to the jitterbuffers directly so that the
+     * configured jitter-buffer-latency is kept for when it is turned off */
+    ref = g_new0(GWeakRef, 1);
+    g_weak_ref_init(ref, jitterbuffer);
+    g_mutex_lock(&transport_agent->priv->jitter_buffer_lock);
+    state = get_jitter_buffer_state(transport_agent, media_session);
+    g_ptr_array_add(state->jitterbuffers, ref);
+    apply_jitter_buffer_latency(media_session, state);
+    g_mutex_unlock(&transport_agent->priv->jitter_buffer_lock);
 
     g_object_unref(media_session);
 }
@@ -4567,6 +6833,165 @@ static void on_feedback_rtcp(GObject *session, guint type, guint fbtype, guint s
 }
 
 
+static guint stream_watch_now(void)
+{
+    return (guint)(g_get_monotonic_time() / 1000);
+}
+
+static GstPadProbeReturn probe_stream_watch(GstPad *srcpad, GstPadProbeInfo *info, gpointer user_data)
+{
+    ComponentWatch *watch = user_data;
+
+    OWR_UNUSED(srcpad);
+    OWR_UNUSED(info);
+
+    g_atomic_int_set(&watch->last_receive, (gint)stream_watch_now());
+    g_atomic_int_set(&watch->received, TRUE);
+
+    return GST_PAD_PROBE_OK;
+}
+
+static StreamWatch * get_stream_watch(OwrTransportAgent *transport_agent, guint stream_id)
+{
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+    StreamWatch *watch;
+
+    g_mutex_lock(&priv->stream_watches_lock);
+    watch = g_hash_table_lookup(priv->stream_watches, GUINT_TO_POINTER(stream_id));
+    if (!watch) {
+        watch = g_new0(StreamWatch, 1);
+        g_hash_table_insert(priv->stream_watches, GUINT_TO_POINTER(stream_id), watch);
+    }
+    g_mutex_unlock(&priv->stream_watches_lock);
+
+    return watch;
+}
+
+static void restart_idle_stream(OwrTransportAgent *transport_agent, guint stream_id)
+{
+    GSList *sessions, *item;
+
+    /* libnice neither exposes its valid pairs nor lets a pair be forced
+     * without stopping ICE for good, so there is no backup pair to move to.
+     * Restart ICE on the stream instead and let the checks pick a working
+     * pair again. This only recovers if the application signals the restart
+     * to the peer: it learns about it from on-ice-restart, the new
+     * credentials and candidates follow through on-new-candidates. */
+    sessions = get_sessions_from_stream_id(transport_agent, stream_id);
+    for (item = sessions; item; item = item->next)
+        g_signal_emit_by_name(item->data, "on-ice-restart");
+    if (sessions)
+        on_restart_ice(transport_agent, OWR_SESSION(sessions->data));
+    g_slist_free_full(sessions, g_object_unref);
+}
+
+static gboolean check_stream_watches(OwrTransportAgent *transport_agent)
+{
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+    GHashTableIter iter;
+    gpointer key, value;
+    ComponentWatch *watch;
+    GSList *idle_streams = NULL, *item;
+    guint now, idle, component_id;
+    gboolean active = FALSE, keep_checking;
+
+    g_mutex_lock(&priv->stream_watches_lock);
+    now = stream_watch_now();
+
+    g_hash_table_iter_init(&iter, priv->stream_watches);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        for (component_id = OWR_COMPONENT_TYPE_RTP; component_id < OWR_COMPONENT_MAX; component_id++) {
+            watch = &((StreamWatch *)value)->component[component_id];
+            if (watch->state != OWR_ICE_STATE_READY)
+                continue;
+            active = TRUE;
+
+            if (!priv->ice_restart_timeout || g_atomic_int_get(&watch->restarted)
+                || !g_atomic_int_get(&watch->received))
+                continue;
+
+            idle = now - (guint)g_atomic_int_get(&watch->last_receive);
+            if (idle < priv->ice_restart_timeout)
+                continue;
+
+            GST_WARNING_OBJECT(transport_agent, "Nothing received for %u ms on stream %u "
+                "component %u, restarting ICE", idle, GPOINTER_TO_UINT(key), component_id);
+            g_atomic_int_set(&watch->restarted, TRUE);
+            if (!g_slist_find(idle_streams, key))
+                idle_streams = g_slist_prepend(idle_streams, key);
+        }
+    }
+
+    keep_checking = active && priv->ice_restart_timeout;
+    if (!keep_checking) {
+        g_source_unref(priv->receive_check_source);
+        priv->receive_check_source = NULL;
+    }
+    g_mutex_unlock(&priv->stream_watches_lock);
+
+    /* Outside the lock, the restart ends up in on_new_selected_pair() */
+    for (item = idle_streams; item; item = item->next)
+        restart_idle_stream(transport_agent, GPOINTER_TO_UINT(item->data));
+    g_slist_free(idle_streams);
+
+    return keep_checking;
+}
+
+/* Must be called with the stream_watches_lock held */
+static void maybe_start_receive_check(OwrTransportAgent *transport_agent)
+{
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+
+    if (priv->receive_check_source || !priv->ice_restart_timeout)
+        return;
+
+    priv->receive_check_source = g_timeout_source_new(MAX(priv->ice_restart_timeout / 4,
+        MIN_RECEIVE_CHECK_INTERVAL));
+    g_source_set_callback(priv->receive_check_source, (GSourceFunc)check_stream_watches,
+        transport_agent, NULL);
+    g_source_attach(priv->receive_check_source, _owr_get_main_context());
+}
+
+static void reset_component_watch(OwrTransportAgent *transport_agent, guint stream_id, guint component_id)
+{
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+    StreamWatch *watch;
+
+    g_return_if_fail(component_id < OWR_COMPONENT_MAX);
+
+    g_mutex_lock(&priv->stream_watches_lock);
+    watch = g_hash_table_lookup(priv->stream_watches, GUINT_TO_POINTER(stream_id));
+    if (watch) {
+        g_atomic_int_set(&watch->component[component_id].last_receive, (gint)stream_watch_now());
+        g_atomic_int_set(&watch->component[component_id].received, FALSE);
+        g_atomic_int_set(&watch->component[component_id].restarted, FALSE);
+    }
+    g_mutex_unlock(&priv->stream_watches_lock);
+}
+
+static void update_stream_watch(OwrTransportAgent *transport_agent, guint stream_id,
+    OwrComponentType component_type, OwrIceState state)
+{
+    OwrTransportAgentPrivate *priv = transport_agent->priv;
+    StreamWatch *watch;
+    OwrIceState old_state = OWR_ICE_STATE_DISCONNECTED;
+
+    g_return_if_fail(component_type < OWR_COMPONENT_MAX);
+
+    g_mutex_lock(&priv->stream_watches_lock);
+    watch = g_hash_table_lookup(priv->stream_watches, GUINT_TO_POINTER(stream_id));
+    if (watch) {
+        old_state = watch->component[component_type].state;
+        watch->component[component_type].state = state;
+        if (state == OWR_ICE_STATE_READY)
+            maybe_start_receive_check(transport_agent);
+    }
+    g_mutex_unlock(&priv->stream_watches_lock);
+
+    if (watch && state == OWR_ICE_STATE_READY && old_state != OWR_ICE_STATE_READY)
+        reset_component_watch(transport_agent, stream_id, component_type);
+}
+
 static GstPadProbeReturn probe_save_ts(GstPad *srcpad, GstPadProbeInfo *info, void *user_data)
 {
     GstBuffer *buffer = NULL;
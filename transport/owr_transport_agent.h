@@ -77,6 +77,7 @@ void owr_transport_agent_add_helper_server(OwrTransportAgent *transport_agent, O
 void owr_transport_agent_add_local_address(OwrTransportAgent *transport_agent, const gchar *local_address);
 void owr_transport_agent_set_local_port_range(OwrTransportAgent *transport_agent, guint min_port, guint max_port);
 void owr_transport_agent_add_session(OwrTransportAgent *agent, OwrSession *session);
+void owr_transport_agent_remove_session(OwrTransportAgent *agent, OwrSession *session);
 gchar * owr_transport_agent_get_dot_data(OwrTransportAgent *transport_agent);
 
 void owr_transport_agent_start(OwrTransportAgent *agent);
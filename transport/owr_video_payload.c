@@ -34,9 +34,12 @@
 #endif
 #include "owr_video_payload.h"
 
+#include "owr_payload_private.h"
 #include "owr_types.h"
+#include "owr_utils.h"
 
 #include <gst/gst.h>
+#include <gst/video/video.h>
 
 GST_DEBUG_CATEGORY_EXTERN(_owrvideopayload_debug);
 #define GST_CAT_DEFAULT _owrvideopayload_debug
@@ -48,6 +51,31 @@ GST_DEBUG_CATEGORY_EXTERN(_owrvideopayload_debug);
 #define DEFAULT_FRAMERATE 0.0
 #define DEFAULT_ROTATION 0
 #define DEFAULT_MIRROR FALSE
+#define DEFAULT_ENCODER_THREADS 0
+#define DEFAULT_ENCODER_PARTITIONS -1
+#define DEFAULT_ENCODER_DEADLINE 1 /* VPX_DL_REALTIME */
+#define DEFAULT_ENCODER_CPU_USED 0
+#define DEFAULT_ENCODER_CPU_USED_AUTO TRUE
+#define DEFAULT_DEGRADATION_PREFERENCE OWR_DEGRADATION_PREFERENCE_DISABLED
+#define DEFAULT_TEMPORAL_LAYERS 1
+#define DEFAULT_MIN_KEYFRAME_INTERVAL 300
+#define DEFAULT_INTRA_REFRESH FALSE
+#define DEFAULT_SHARED_ENCODER FALSE
+
+/* An encoder stays usable down to about half of the bits per pixel that
+ * _owr_payload_evaluate_bitrate() aims for, below that the next degradation
+ * step is taken. Stepping back up requires some headroom to avoid flapping
+ * between two steps when the bitrate estimate oscillates. */
+#define DEGRADATION_MIN_BITS_PER_PIXEL 0.05
+#define DEGRADATION_UPGRADE_HEADROOM 1.3
+#define DEGRADATION_FALLBACK_FRAMERATE 30
+#define DEGRADATION_STATE_KEY "owr-degradation-state"
+
+/* With intra refresh the whole picture is refreshed once per this many
+ * seconds of frames */
+#define INTRA_REFRESH_PERIOD 1
+#define INTRA_REFRESH_FALLBACK_FRAMERATE 30
+#define KEYFRAME_CONTROLLER_KEY "owr-keyframe-controller"
 
 #define OWR_VIDEO_PAYLOAD_GET_PRIVATE(obj)    (G_TYPE_INSTANCE_GET_PRIVATE((obj), OWR_TYPE_VIDEO_PAYLOAD, OwrVideoPayloadPrivate))
 
@@ -61,6 +89,18 @@ struct _OwrVideoPayloadPrivate {
     gdouble framerate;
     gint rotation;
     gboolean mirror;
+    guint encoder_threads;
+    gint encoder_partitions;
+    gint64 encoder_deadline;
+    gint encoder_cpu_used;
+    gboolean encoder_cpu_used_auto;
+    OwrDegradationPreference degradation_preference;
+    guint temporal_layers;
+    guint min_keyframe_interval;
+    gboolean intra_refresh;
+    gboolean shared_encoder;
+    volatile gint keyframe_requests;
+    volatile gint keyframes_produced;
 };
 
 
@@ -74,6 +114,18 @@ enum {
     PROP_FRAMERATE,
     PROP_ROTATION,
     PROP_MIRROR,
+    PROP_ENCODER_THREADS,
+    PROP_ENCODER_PARTITIONS,
+    PROP_ENCODER_DEADLINE,
+    PROP_ENCODER_CPU_USED,
+    PROP_ENCODER_CPU_USED_AUTO,
+    PROP_DEGRADATION_PREFERENCE,
+    PROP_TEMPORAL_LAYERS,
+    PROP_MIN_KEYFRAME_INTERVAL,
+    PROP_INTRA_REFRESH,
+    PROP_SHARED_ENCODER,
+    PROP_KEYFRAME_REQUESTS,
+    PROP_KEYFRAMES_PRODUCED,
 
     N_PROPERTIES,
 
@@ -122,6 +174,50 @@ static void owr_video_payload_set_property(GObject *object, guint property_id, c
         priv->mirror = g_value_get_boolean(value);
         break;
 
+    case PROP_ENCODER_THREADS:
+        priv->encoder_threads = g_value_get_uint(value);
+        break;
+
+    case PROP_ENCODER_PARTITIONS:
+        priv->encoder_partitions = g_value_get_int(value);
+        break;
+
+    case PROP_ENCODER_DEADLINE:
+        priv->encoder_deadline = g_value_get_int64(value);
+        break;
+
+    case PROP_ENCODER_CPU_USED:
+        priv->encoder_cpu_used = g_value_get_int(value);
+        if (priv->encoder_cpu_used_auto) {
+            priv->encoder_cpu_used_auto = FALSE;
+            g_object_notify_by_pspec(object, obj_properties[PROP_ENCODER_CPU_USED_AUTO]);
+        }
+        break;
+
+    case PROP_ENCODER_CPU_USED_AUTO:
+        priv->encoder_cpu_used_auto = g_value_get_boolean(value);
+        break;
+
+    case PROP_DEGRADATION_PREFERENCE:
+        priv->degradation_preference = g_value_get_enum(value);
+        break;
+
+    case PROP_TEMPORAL_LAYERS:
+        priv->temporal_layers = g_value_get_uint(value);
+        break;
+
+    case PROP_MIN_KEYFRAME_INTERVAL:
+        priv->min_keyframe_interval = g_value_get_uint(value);
+        break;
+
+    case PROP_INTRA_REFRESH:
+        priv->intra_refresh = g_value_get_boolean(value);
+        break;
+
+    case PROP_SHARED_ENCODER:
+        priv->shared_encoder = g_value_get_boolean(value);
+        break;
+
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -167,6 +263,54 @@ static void owr_video_payload_get_property(GObject *object, guint property_id, G
         g_value_set_boolean(value, priv->mirror);
         break;
 
+    case PROP_ENCODER_THREADS:
+        g_value_set_uint(value, priv->encoder_threads);
+        break;
+
+    case PROP_ENCODER_PARTITIONS:
+        g_value_set_int(value, priv->encoder_partitions);
+        break;
+
+    case PROP_ENCODER_DEADLINE:
+        g_value_set_int64(value, priv->encoder_deadline);
+        break;
+
+    case PROP_ENCODER_CPU_USED:
+        g_value_set_int(value, priv->encoder_cpu_used);
+        break;
+
+    case PROP_ENCODER_CPU_USED_AUTO:
+        g_value_set_boolean(value, priv->encoder_cpu_used_auto);
+        break;
+
+    case PROP_DEGRADATION_PREFERENCE:
+        g_value_set_enum(value, priv->degradation_preference);
+        break;
+
+    case PROP_TEMPORAL_LAYERS:
+        g_value_set_uint(value, priv->temporal_layers);
+        break;
+
+    case PROP_MIN_KEYFRAME_INTERVAL:
+        g_value_set_uint(value, priv->min_keyframe_interval);
+        break;
+
+    case PROP_INTRA_REFRESH:
+        g_value_set_boolean(value, priv->intra_refresh);
+        break;
+
+    case PROP_SHARED_ENCODER:
+        g_value_set_boolean(value, priv->shared_encoder);
+        break;
+
+    case PROP_KEYFRAME_REQUESTS:
+        g_value_set_uint(value, g_atomic_int_get(&priv->keyframe_requests));
+        break;
+
+    case PROP_KEYFRAMES_PRODUCED:
+        g_value_set_uint(value, g_atomic_int_get(&priv->keyframes_produced));
+        break;
+
     case PROP_MEDIA_TYPE:
         g_value_set_enum(value, OWR_MEDIA_TYPE_VIDEO);
         break;
@@ -224,6 +368,73 @@ static void owr_video_payload_class_init(OwrVideoPayloadClass *klass)
         "(NOTE: currently only works for send payloads)", DEFAULT_MIRROR,
         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+    obj_properties[PROP_ENCODER_THREADS] = g_param_spec_uint("encoder-threads", "encoder-threads",
+        "Number of VP8/VP9 encoder threads (0 = chosen from resolution and cores)",
+        0, 64, DEFAULT_ENCODER_THREADS,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_ENCODER_PARTITIONS] = g_param_spec_int("encoder-partitions", "encoder-partitions",
+        "Log2 of the number of VP8 token partitions or VP9 tile columns"
+        " (-1 = chosen from the encoder threads)", -1, 6, DEFAULT_ENCODER_PARTITIONS,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_ENCODER_DEADLINE] = g_param_spec_int64("encoder-deadline", "encoder-deadline",
+        "VP8/VP9 encoding deadline per frame in microseconds (0 = best quality, 1 = realtime)",
+        0, G_MAXINT64, DEFAULT_ENCODER_DEADLINE,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_ENCODER_CPU_USED] = g_param_spec_int("encoder-cpu-used", "encoder-cpu-used",
+        "VP8/VP9 speed versus quality trade-off, higher is faster (setting it clears"
+        " encoder-cpu-used-auto)", -16, 16, DEFAULT_ENCODER_CPU_USED,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_ENCODER_CPU_USED_AUTO] = g_param_spec_boolean("encoder-cpu-used-auto",
+        "encoder-cpu-used-auto",
+        "Use the codec and platform default speed versus quality trade-off instead of"
+        " encoder-cpu-used", DEFAULT_ENCODER_CPU_USED_AUTO,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_DEGRADATION_PREFERENCE] = g_param_spec_enum("degradation-preference",
+        "degradation-preference",
+        "How the sent video is degraded when the bitrate is too low for its resolution"
+        " and framerate (NOTE: switching to or from disabled only applies to new send streams)",
+        OWR_TYPE_DEGRADATION_PREFERENCE, DEFAULT_DEGRADATION_PREFERENCE,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_TEMPORAL_LAYERS] = g_param_spec_uint("temporal-layers", "temporal-layers",
+        "Number of VP8 temporal layers, enhancement layers are dropped first on congestion"
+        " (1 = no temporal layering, needs GStreamer 1.20, VP9 is always sent without layers)",
+        1, 3, DEFAULT_TEMPORAL_LAYERS,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_MIN_KEYFRAME_INTERVAL] = g_param_spec_uint("min-keyframe-interval",
+        "min-keyframe-interval",
+        "Minimum time in milliseconds between requested keyframes, requests (PLI, FIR, new"
+        " receivers) arriving sooner are merged into one keyframe at the end of the interval",
+        0, 10000, DEFAULT_MIN_KEYFRAME_INTERVAL,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_INTRA_REFRESH] = g_param_spec_boolean("intra-refresh", "intra-refresh",
+        "Let the gradual refresh of the picture serve keyframe requests within min-keyframe-interval"
+        " instead of queueing them, where the encoder supports it (NOTE: only applies to new send"
+        " streams)", DEFAULT_INTRA_REFRESH,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_SHARED_ENCODER] = g_param_spec_boolean("shared-encoder", "shared-encoder",
+        "Whether the encoder may be shared with other sessions sending the same source with"
+        " compatible settings (NOTE: only applies to new send streams)", DEFAULT_SHARED_ENCODER,
+        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_KEYFRAME_REQUESTS] = g_param_spec_uint("keyframe-requests",
+        "keyframe-requests", "Number of keyframe requests received for the sent stream",
+        0, G_MAXUINT, 0,
+        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+    obj_properties[PROP_KEYFRAMES_PRODUCED] = g_param_spec_uint("keyframes-produced",
+        "keyframes-produced", "Number of keyframes produced by the encoder of the sent stream",
+        0, G_MAXUINT, 0,
+        G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
     g_object_class_install_properties(gobject_class, N_PROPERTIES, obj_properties);
 }
 
@@ -237,6 +448,18 @@ static void owr_video_payload_init(OwrVideoPayload *video_payload)
     video_payload->priv->framerate = DEFAULT_FRAMERATE;
     video_payload->priv->rotation = DEFAULT_ROTATION;
     video_payload->priv->mirror = DEFAULT_MIRROR;
+    video_payload->priv->encoder_threads = DEFAULT_ENCODER_THREADS;
+    video_payload->priv->encoder_partitions = DEFAULT_ENCODER_PARTITIONS;
+    video_payload->priv->encoder_deadline = DEFAULT_ENCODER_DEADLINE;
+    video_payload->priv->encoder_cpu_used = DEFAULT_ENCODER_CPU_USED;
+    video_payload->priv->encoder_cpu_used_auto = DEFAULT_ENCODER_CPU_USED_AUTO;
+    video_payload->priv->degradation_preference = DEFAULT_DEGRADATION_PREFERENCE;
+    video_payload->priv->temporal_layers = DEFAULT_TEMPORAL_LAYERS;
+    video_payload->priv->min_keyframe_interval = DEFAULT_MIN_KEYFRAME_INTERVAL;
+    video_payload->priv->intra_refresh = DEFAULT_INTRA_REFRESH;
+    video_payload->priv->shared_encoder = DEFAULT_SHARED_ENCODER;
+    video_payload->priv->keyframe_requests = 0;
+    video_payload->priv->keyframes_produced = 0;
 }
 
 OwrPayload * owr_video_payload_new(OwrCodecType codec_type, guint payload_type, guint clock_rate,
@@ -251,3 +474,418 @@ OwrPayload * owr_video_payload_new(OwrCodecType codec_type, guint payload_type,
         NULL);
     return payload;
 }
+
+
+typedef struct {
+    gint scale_n, scale_d;
+    gint rate_n, rate_d;
+} DegradationStep;
+
+static const DegradationStep maintain_framerate_steps[] = {
+    {1, 1, 1, 1}, {3, 4, 1, 1}, {1, 2, 1, 1}, {1, 4, 1, 1}
+};
+
+static const DegradationStep maintain_resolution_steps[] = {
+    {1, 1, 1, 1}, {1, 1, 2, 3}, {1, 1, 1, 2}, {1, 1, 1, 3}
+};
+
+static const DegradationStep balanced_steps[] = {
+    {1, 1, 1, 1}, {1, 1, 2, 3}, {3, 4, 2, 3}, {3, 4, 1, 2},
+    {1, 2, 1, 2}, {1, 2, 1, 3}, {1, 4, 1, 3}
+};
+
+typedef struct {
+    GWeakRef payload;
+    GstPad *input_pad;
+    GMutex mutex;
+    guint step;
+} DegradationState;
+
+static void degradation_state_free(DegradationState *state)
+{
+    g_weak_ref_clear(&state->payload);
+    g_mutex_clear(&state->mutex);
+    gst_object_unref(state->input_pad);
+    g_slice_free(DegradationState, state);
+}
+
+static const DegradationStep *get_degradation_steps(OwrDegradationPreference preference, guint *n_steps)
+{
+    switch (preference) {
+    case OWR_DEGRADATION_PREFERENCE_MAINTAIN_FRAMERATE:
+        *n_steps = G_N_ELEMENTS(maintain_framerate_steps);
+        return maintain_framerate_steps;
+    case OWR_DEGRADATION_PREFERENCE_MAINTAIN_RESOLUTION:
+        *n_steps = G_N_ELEMENTS(maintain_resolution_steps);
+        return maintain_resolution_steps;
+    case OWR_DEGRADATION_PREFERENCE_BALANCED:
+        *n_steps = G_N_ELEMENTS(balanced_steps);
+        return balanced_steps;
+    default:
+        *n_steps = 1;
+        return maintain_framerate_steps;
+    }
+}
+
+static gdouble degradation_step_bitrate(const DegradationStep *step, gint width, gint height,
+    gdouble framerate)
+{
+    gdouble scale = (gdouble) step->scale_n / step->scale_d;
+
+    return width * scale * height * scale * framerate * step->rate_n / step->rate_d
+        * DEGRADATION_MIN_BITS_PER_PIXEL;
+}
+
+static void update_degradation(GstElement *capsfilter)
+{
+    DegradationState *state;
+    OwrVideoPayload *payload;
+    const DegradationStep *steps;
+    guint n_steps, step, bitrate = 0;
+    GstCaps *input_caps, *caps, *current_caps = NULL;
+    GstStructure *structure;
+    gint width = 0, height = 0, fps_n = 0, fps_d = 1;
+    gdouble framerate;
+
+    state = g_object_get_data(G_OBJECT(capsfilter), DEGRADATION_STATE_KEY);
+    g_return_if_fail(state);
+
+    payload = g_weak_ref_get(&state->payload);
+    if (!payload)
+        return;
+
+    input_caps = gst_pad_get_current_caps(state->input_pad);
+    if (!input_caps) {
+        g_object_unref(payload);
+        return;
+    }
+
+    structure = gst_caps_get_structure(input_caps, 0);
+    gst_structure_get_int(structure, "width", &width);
+    gst_structure_get_int(structure, "height", &height);
+    gst_structure_get_fraction(structure, "framerate", &fps_n, &fps_d);
+    gst_caps_unref(input_caps);
+    if (width <= 0 || height <= 0) {
+        g_object_unref(payload);
+        return;
+    }
+    /* Variable framerate sources are assumed to run at a typical camera rate */
+    framerate = fps_n > 0 && fps_d > 0 ? (gdouble) fps_n / fps_d : DEGRADATION_FALLBACK_FRAMERATE;
+
+    steps = get_degradation_steps(payload->priv->degradation_preference, &n_steps);
+    g_object_get(payload, "bitrate", &bitrate, NULL);
+    g_object_unref(payload);
+
+    g_mutex_lock(&state->mutex);
+    step = MIN(state->step, n_steps - 1);
+    if (!bitrate)
+        step = 0;
+    while (step + 1 < n_steps && bitrate < degradation_step_bitrate(&steps[step], width, height, framerate))
+        step++;
+    while (step > 0 && bitrate > DEGRADATION_UPGRADE_HEADROOM
+        * degradation_step_bitrate(&steps[step - 1], width, height, framerate))
+        step--;
+
+    if (!step)
+        caps = gst_caps_new_any();
+    else {
+        caps = gst_caps_new_simple("video/x-raw",
+            "width", G_TYPE_INT, MAX(2, width * steps[step].scale_n / steps[step].scale_d) & ~1,
+            "height", G_TYPE_INT, MAX(2, height * steps[step].scale_n / steps[step].scale_d) & ~1,
+            NULL);
+        if (fps_n > 0 && fps_d > 0)
+            gst_caps_set_simple(caps, "framerate", GST_TYPE_FRACTION,
+                fps_n * steps[step].rate_n, fps_d * steps[step].rate_d, NULL);
+    }
+
+    if (step != state->step)
+        GST_INFO_OBJECT(capsfilter, "Degradation step %u -> %u at %u bps: %" GST_PTR_FORMAT,
+            state->step, step, bitrate, caps);
+    state->step = step;
+    g_mutex_unlock(&state->mutex);
+
+    /* Only touch the capsfilter on actual changes, every new caps triggers a
+     * renegotiation of the encoder */
+    g_object_get(capsfilter, "caps", &current_caps, NULL);
+    if (!current_caps || !gst_caps_is_equal(current_caps, caps))
+        g_object_set(capsfilter, "caps", caps, NULL);
+    if (current_caps)
+        gst_caps_unref(current_caps);
+    gst_caps_unref(caps);
+}
+
+static void on_degradation_input_changed(GObject *object, GParamSpec *pspec, GstElement *capsfilter)
+{
+    OWR_UNUSED(object);
+    OWR_UNUSED(pspec);
+
+    update_degradation(capsfilter);
+}
+
+/*
+ * _owr_video_payload_setup_degradation:
+ * @payload: the send payload
+ * @input: the first element of the videorate/videoscale chain
+ * @capsfilter: the capsfilter at the end of the chain
+ *
+ * Keeps the caps of @capsfilter in line with the payload's bitrate and
+ * degradation preference, stepping the resolution and/or framerate down as
+ * the bitrate drops and back up once it recovers.
+ */
+void _owr_video_payload_setup_degradation(OwrVideoPayload *payload, GstElement *input,
+    GstElement *capsfilter)
+{
+    DegradationState *state;
+
+    g_return_if_fail(OWR_IS_VIDEO_PAYLOAD(payload));
+    g_return_if_fail(GST_IS_ELEMENT(input));
+    g_return_if_fail(GST_IS_ELEMENT(capsfilter));
+
+    state = g_slice_new0(DegradationState);
+    g_weak_ref_init(&state->payload, payload);
+    g_mutex_init(&state->mutex);
+    state->input_pad = gst_element_get_static_pad(input, "sink");
+    g_object_set_data_full(G_OBJECT(capsfilter), DEGRADATION_STATE_KEY, state,
+        (GDestroyNotify) degradation_state_free);
+
+    g_signal_connect_object(payload, "notify::bitrate",
+        G_CALLBACK(on_degradation_input_changed), capsfilter, 0);
+    g_signal_connect_object(payload, "notify::degradation-preference",
+        G_CALLBACK(on_degradation_input_changed), capsfilter, 0);
+    g_signal_connect_object(state->input_pad, "notify::caps",
+        G_CALLBACK(on_degradation_input_changed), capsfilter, 0);
+}
+
+typedef struct {
+    GWeakRef payload;
+    gboolean intra_refresh;
+    GMutex mutex;
+    gint64 min_interval;
+    gint64 last_keyframe_time;
+    gboolean pending;
+    gboolean pending_all_headers;
+} KeyframeController;
+
+static void keyframe_controller_free(KeyframeController *controller)
+{
+    g_weak_ref_clear(&controller->payload);
+    g_mutex_clear(&controller->mutex);
+    g_slice_free(KeyframeController, controller);
+}
+
+static GstPadProbeReturn control_keyframe_request(GstPad *pad, GstPadProbeInfo *info,
+    KeyframeController *controller)
+{
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+    const GstStructure *structure;
+    OwrVideoPayload *payload;
+    gboolean all_headers = FALSE, forward;
+    gint64 now;
+
+    if (!gst_video_event_is_force_key_unit(event))
+        return GST_PAD_PROBE_OK;
+
+    /* Our own request sent when a merged request became due */
+    structure = gst_event_get_structure(event);
+    if (gst_structure_has_field(structure, KEYFRAME_CONTROLLER_KEY))
+        return GST_PAD_PROBE_OK;
+
+    payload = g_weak_ref_get(&controller->payload);
+    if (payload) {
+        g_atomic_int_inc(&payload->priv->keyframe_requests);
+        g_mutex_lock(&controller->mutex);
+        controller->min_interval = payload->priv->min_keyframe_interval * G_TIME_SPAN_MILLISECOND;
+        g_mutex_unlock(&controller->mutex);
+        g_object_unref(payload);
+    }
+
+    gst_video_event_parse_upstream_force_key_unit(event, NULL, &all_headers, NULL);
+    now = g_get_monotonic_time();
+
+    g_mutex_lock(&controller->mutex);
+    /* A new receiver can not start decoding without a keyframe, everyone
+     * else is served by the next keyframe. Requests within the interval
+     * wait for it, or are left to the ongoing refresh. */
+    if (gst_structure_has_field(structure, "owr-new-consumer"))
+        forward = TRUE;
+    else
+        forward = !controller->last_keyframe_time
+            || now - controller->last_keyframe_time >= controller->min_interval;
+
+    if (forward) {
+        controller->last_keyframe_time = now;
+        controller->pending = FALSE;
+        controller->pending_all_headers = FALSE;
+    } else if (!controller->intra_refresh) {
+        controller->pending = TRUE;
+        controller->pending_all_headers |= all_headers;
+    }
+    g_mutex_unlock(&controller->mutex);
+
+    GST_LOG_OBJECT(pad, "Keyframe request %s", forward ? "forwarded"
+        : controller->intra_refresh ? "served by intra refresh" : "merged");
+
+    return forward ? GST_PAD_PROBE_OK : GST_PAD_PROBE_DROP;
+}
+
+static GstPadProbeReturn count_keyframe(GstPad *pad, GstPadProbeInfo *info,
+    KeyframeController *controller)
+{
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    OwrVideoPayload *payload;
+    GstEvent *event = NULL;
+    gint64 now;
+
+    /* Parsers send stream headers as buffers of their own */
+    if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_HEADER))
+        return GST_PAD_PROBE_OK;
+
+    now = g_get_monotonic_time();
+
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        payload = g_weak_ref_get(&controller->payload);
+        if (payload) {
+            g_atomic_int_inc(&payload->priv->keyframes_produced);
+            g_object_unref(payload);
+        }
+
+        /* Whatever caused it, the keyframe also answers the merged requests */
+        g_mutex_lock(&controller->mutex);
+        controller->last_keyframe_time = now;
+        controller->pending = FALSE;
+        controller->pending_all_headers = FALSE;
+        g_mutex_unlock(&controller->mutex);
+        return GST_PAD_PROBE_OK;
+    }
+
+    g_mutex_lock(&controller->mutex);
+    if (controller->pending && now - controller->last_keyframe_time >= controller->min_interval) {
+        event = gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE,
+            controller->pending_all_headers, 0);
+        gst_structure_set(gst_event_writable_structure(event), KEYFRAME_CONTROLLER_KEY,
+            G_TYPE_BOOLEAN, TRUE, NULL);
+        controller->last_keyframe_time = now;
+        controller->pending = FALSE;
+        controller->pending_all_headers = FALSE;
+    }
+    g_mutex_unlock(&controller->mutex);
+
+    if (event) {
+        GST_LOG_OBJECT(pad, "Requesting the merged keyframe");
+        gst_pad_push_event(pad, event);
+    }
+
+    return GST_PAD_PROBE_OK;
+}
+
+static void weak_ref_free(GWeakRef *weak_ref)
+{
+    g_weak_ref_clear(weak_ref);
+    g_slice_free(GWeakRef, weak_ref);
+}
+
+static GstPadProbeReturn count_keyframes_probe(GstPad *pad, GstPadProbeInfo *info,
+    GWeakRef *weak_ref)
+{
+    OwrVideoPayload *payload;
+    GstBuffer *buffer;
+    GstEvent *event;
+
+    OWR_UNUSED(pad);
+
+    payload = g_weak_ref_get(weak_ref);
+    if (!payload)
+        return GST_PAD_PROBE_OK;
+
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+        buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+        if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_HEADER)
+            && !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT))
+            g_atomic_int_inc(&payload->priv->keyframes_produced);
+    } else {
+        event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (gst_video_event_is_force_key_unit(event))
+            g_atomic_int_inc(&payload->priv->keyframe_requests);
+    }
+    g_object_unref(payload);
+
+    return GST_PAD_PROBE_OK;
+}
+
+/*
+ * _owr_video_payload_count_keyframes:
+ * @payload: the send payload
+ * @pad: a pad the stream of @payload passes after the encoder
+ *
+ * Counts the keyframe requests going upstream and the keyframes going
+ * downstream through @pad in the keyframe-requests and keyframes-produced
+ * properties of @payload. For streams whose encoder is controlled through
+ * another payload, like a shared encoder.
+ */
+void _owr_video_payload_count_keyframes(OwrVideoPayload *payload, GstPad *pad)
+{
+    GWeakRef *weak_ref;
+
+    g_return_if_fail(OWR_IS_VIDEO_PAYLOAD(payload));
+    g_return_if_fail(GST_IS_PAD(pad));
+
+    weak_ref = g_slice_new0(GWeakRef);
+    g_weak_ref_init(weak_ref, payload);
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+        (GstPadProbeCallback) count_keyframes_probe, weak_ref, (GDestroyNotify) weak_ref_free);
+}
+
+/*
+ * _owr_video_payload_setup_keyframe_control:
+ * @payload: the send payload
+ * @encoder: the encoder of the sent stream
+ * @encoder_output: the element following the encoder (and parser)
+ *
+ * Lets keyframe requests from all sources reach @encoder at most once per
+ * minimum keyframe interval, requests in between are merged into a single one
+ * sent once the interval has passed. With intra refresh enabled and supported
+ * by @encoder the requests within the interval are dropped instead, the
+ * continuous refresh serves them.
+ */
+void _owr_video_payload_setup_keyframe_control(OwrVideoPayload *payload, GstElement *encoder,
+    GstElement *encoder_output)
+{
+    KeyframeController *controller;
+    gboolean intra_refresh;
+    gdouble framerate;
+    GstPad *pad;
+
+    g_return_if_fail(OWR_IS_VIDEO_PAYLOAD(payload));
+    g_return_if_fail(GST_IS_ELEMENT(encoder));
+    g_return_if_fail(GST_IS_ELEMENT(encoder_output));
+
+    /* Pooled encoders keep their settings, so set it either way */
+    intra_refresh = payload->priv->intra_refresh;
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(encoder), "intra-refresh")) {
+        framerate = payload->priv->framerate > 0.0 ? payload->priv->framerate
+            : INTRA_REFRESH_FALLBACK_FRAMERATE;
+        g_object_set(encoder, "intra-refresh", intra_refresh, NULL);
+        if (g_object_class_find_property(G_OBJECT_GET_CLASS(encoder), "key-int-max")) {
+            g_object_set(encoder, "key-int-max",
+                intra_refresh ? (guint) (framerate * INTRA_REFRESH_PERIOD) : 0, NULL);
+        }
+    } else if (intra_refresh) {
+        GST_INFO_OBJECT(encoder, "No intra refresh support, sending keyframes instead");
+        intra_refresh = FALSE;
+    }
+
+    controller = g_slice_new0(KeyframeController);
+    g_weak_ref_init(&controller->payload, payload);
+    g_mutex_init(&controller->mutex);
+    controller->intra_refresh = intra_refresh;
+    controller->min_interval = payload->priv->min_keyframe_interval * G_TIME_SPAN_MILLISECOND;
+    g_object_set_data_full(G_OBJECT(encoder_output), KEYFRAME_CONTROLLER_KEY, controller,
+        (GDestroyNotify) keyframe_controller_free);
+
+    pad = gst_element_get_static_pad(encoder_output, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+        (GstPadProbeCallback) control_keyframe_request, controller, NULL);
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER,
+        (GstPadProbeCallback) count_keyframe, controller, NULL);
+    gst_object_unref(pad);
+}